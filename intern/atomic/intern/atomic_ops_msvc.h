@@ -69,6 +69,17 @@ ATOMIC_INLINE uint64_t atomic_fetch_and_sub_uint64(uint64_t *p, uint64_t x)
 	return InterlockedExchangeAdd64((int64_t *)p, -((int64_t)x));
 }
 
+ATOMIC_INLINE uint64_t atomic_load_uint64(const uint64_t *v)
+{
+	/* aligned 64-bit loads are atomic on x64, the volatile read is not reordered */
+	return *(const volatile uint64_t *)v;
+}
+
+ATOMIC_INLINE void atomic_store_uint64(uint64_t *p, uint64_t v)
+{
+	InterlockedExchange64((int64_t *)p, (int64_t)v);
+}
+
 /* Signed */
 ATOMIC_INLINE int64_t atomic_add_and_fetch_int64(int64_t *p, int64_t x)
 {
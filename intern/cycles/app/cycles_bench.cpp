@@ -0,0 +1,556 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Headless Benchmark
+ *
+ * Renders a set of XML scenes on the CPU with a fixed number of samples and
+ * reports the time spent loading the scene, updating the device and building
+ * the BVH, the render speed in samples per second and the peak device memory
+ * of every scene. Results are written as JSON, and can be compared against a
+ * previous run to catch performance regressions.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "device/device.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_args.h"
+#include "util/util_debug.h"
+#include "util/util_foreach.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
+#include "util/util_path.h"
+#include "util/util_progress.h"
+#include "util/util_string.h"
+#include "util/util_system.h"
+#include "util/util_time.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Scenes rendered when none are given on the command line. */
+static const char *bench_default_scenes[] = {
+	"instancing.xml",
+	"hair.xml",
+	"volume.xml",
+	"subsurface.xml",
+	"many_lights.xml",
+	"textures.xml",
+	"images.xml",
+	NULL
+};
+
+/* Measured values, times in seconds and memory in bytes. Lower is better for
+ * all of them except samples_per_second. */
+struct BenchMetric {
+	const char *name;
+	bool higher_is_better;
+	bool is_time;
+};
+
+static const BenchMetric bench_metrics[] = {
+	{"scene_load_time", false, true},
+	{"sync_time", false, true},
+	{"bvh_build_time", false, true},
+	{"render_time", false, true},
+	{"samples_per_second", true, false},
+	{"peak_memory", false, false},
+};
+
+static const int bench_num_metrics = sizeof(bench_metrics) / sizeof(*bench_metrics);
+
+/* Times shorter than this are dominated by noise and not compared. */
+static const double bench_min_compare_time = 0.01;
+
+struct BenchResult {
+	string name;
+	double values[bench_num_metrics];
+};
+
+struct BenchOptions {
+	vector<string> filepaths;
+	string scenes_dir;
+	string output_path;
+	string baseline_path;
+	string bvh_layout;
+	int width, height;
+	int repeat;
+	float tolerance;
+	SessionParams session_params;
+	SceneParams scene_params;
+	bool ray_stream;
+	bool quiet;
+} options;
+
+static int bench_files_parse(int argc, const char *argv[])
+{
+	for(int i = 0; i < argc; i++)
+		options.filepaths.push_back(argv[i]);
+
+	return 0;
+}
+
+static void bench_print(const char *format, ...)
+{
+	if(options.quiet)
+		return;
+
+	va_list args;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	fflush(stdout);
+}
+
+/* Render */
+
+static bool bench_render_scene(const string& filepath, BenchResult& result)
+{
+	Session *session = new Session(options.session_params);
+
+	/* load scene */
+	scoped_timer load_timer;
+
+	Scene *scene = new Scene(options.scene_params, session->device);
+	xml_read_file(scene, filepath.c_str());
+
+	if(!(options.width == 0 || options.height == 0)) {
+		scene->camera->width = options.width;
+		scene->camera->height = options.height;
+	}
+	scene->camera->compute_auto_viewplane();
+
+	double load_time = load_timer.get_time();
+
+	BufferParams buffer_params;
+	buffer_params.width = scene->camera->width;
+	buffer_params.height = scene->camera->height;
+	buffer_params.full_width = scene->camera->width;
+	buffer_params.full_height = scene->camera->height;
+
+	/* render */
+	session->scene = scene;
+	session->reset(buffer_params, options.session_params.samples);
+	session->start();
+	session->wait();
+
+	string status, substatus;
+	session->progress.get_status(status, substatus);
+	bool cancelled = session->progress.get_cancel();
+	string error = session->progress.get_error_message();
+
+	double total_time, render_time;
+	session->progress.get_time(total_time, render_time);
+
+	uint64_t pixel_samples = (uint64_t)buffer_params.width *
+	                         (uint64_t)buffer_params.height *
+	                         (uint64_t)options.session_params.samples;
+
+	result.name = path_filename(filepath);
+	result.values[0] = load_time;
+	result.values[1] = scene->update_stats.get_time("Device Update");
+	result.values[2] = scene->update_stats.get_time("BVH Build");
+	result.values[3] = render_time;
+	result.values[4] = (render_time > 0.0)? pixel_samples / render_time: 0.0;
+	result.values[5] = (double)session->stats.mem_peak;
+
+	/* session owns the scene */
+	delete session;
+
+	if(cancelled || error != "") {
+		fprintf(stderr, "%s: %s\n", filepath.c_str(),
+		        (error != "")? error.c_str(): status.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* Keep the best value of every metric over repeated runs. */
+static void bench_result_merge(BenchResult& best, const BenchResult& result)
+{
+	for(int i = 0; i < bench_num_metrics; i++) {
+		if(bench_metrics[i].higher_is_better)
+			best.values[i] = max(best.values[i], result.values[i]);
+		else
+			best.values[i] = min(best.values[i], result.values[i]);
+	}
+}
+
+/* JSON */
+
+static string bench_results_to_json(const vector<BenchResult>& results)
+{
+	string json = "{\n";
+
+	json += string_printf("\t\"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+	json += string_printf("\t\"cpu\": \"%s\",\n", system_cpu_brand_string().c_str());
+	json += string_printf("\t\"threads\": %d,\n", options.session_params.threads);
+	json += string_printf("\t\"samples\": %d,\n", options.session_params.samples);
+	json += string_printf("\t\"bvh_layout\": \"%s\",\n", options.bvh_layout.c_str());
+	json += string_printf("\t\"ray_stream\": %s,\n", options.ray_stream ? "true" : "false");
+	json += "\t\"scenes\": [\n";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		const BenchResult& result = results[i];
+
+		json += "\t\t{\n";
+		json += string_printf("\t\t\t\"name\": \"%s\"", result.name.c_str());
+
+		for(int j = 0; j < bench_num_metrics; j++) {
+			if(bench_metrics[j].is_time)
+				json += string_printf(",\n\t\t\t\"%s\": %.6f", bench_metrics[j].name, result.values[j]);
+			else
+				json += string_printf(",\n\t\t\t\"%s\": %.1f", bench_metrics[j].name, result.values[j]);
+		}
+
+		json += (i + 1 < results.size())? "\n\t\t},\n": "\n\t\t}\n";
+	}
+
+	json += "\t]\n}\n";
+
+	return json;
+}
+
+/* Reads the per scene values from a file written by bench_results_to_json.
+ * This is not a general JSON parser, it only looks for the "name" key which
+ * starts a scene and the numeric metric keys that follow it. */
+static bool bench_results_from_json(const string& json, vector<BenchResult>& results)
+{
+	size_t scenes = json.find("\"scenes\"");
+	if(scenes == string::npos)
+		return false;
+
+	BenchResult *result = NULL;
+	/* closing quote of "scenes" */
+	size_t pos = scenes + 7;
+
+	while((pos = json.find('"', pos + 1)) != string::npos) {
+		size_t end = json.find('"', pos + 1);
+		if(end == string::npos)
+			break;
+
+		string key = json.substr(pos + 1, end - pos - 1);
+		size_t colon = json.find_first_not_of(" \t\r\n", end + 1);
+
+		if(colon == string::npos || json[colon] != ':') {
+			pos = end;
+			continue;
+		}
+
+		size_t value = json.find_first_not_of(" \t\r\n", colon + 1);
+		if(value == string::npos)
+			break;
+
+		if(key == "name" && json[value] == '"') {
+			size_t value_end = json.find('"', value + 1);
+			if(value_end == string::npos)
+				break;
+
+			BenchResult new_result;
+			new_result.name = json.substr(value + 1, value_end - value - 1);
+			for(int i = 0; i < bench_num_metrics; i++)
+				new_result.values[i] = 0.0;
+
+			results.push_back(new_result);
+			result = &results.back();
+			pos = value_end;
+			continue;
+		}
+
+		if(result) {
+			for(int i = 0; i < bench_num_metrics; i++) {
+				if(key == bench_metrics[i].name) {
+					result->values[i] = atof(json.c_str() + value);
+					break;
+				}
+			}
+		}
+
+		pos = end;
+	}
+
+	return results.size() > 0;
+}
+
+/* Compare */
+
+static int bench_compare(const vector<BenchResult>& results, const vector<BenchResult>& baseline)
+{
+	map<string, const BenchResult*> baseline_map;
+	foreach(const BenchResult& result, baseline)
+		baseline_map[result.name] = &result;
+
+	int num_regressions = 0;
+
+	printf("\n%-20s %-20s %14s %14s %9s\n", "Scene", "Metric", "Baseline", "Current", "Change");
+
+	foreach(const BenchResult& result, results) {
+		map<string, const BenchResult*>::iterator it = baseline_map.find(result.name);
+
+		if(it == baseline_map.end()) {
+			printf("%-20s not in baseline\n", result.name.c_str());
+			continue;
+		}
+
+		const BenchResult& base = *it->second;
+
+		for(int i = 0; i < bench_num_metrics; i++) {
+			const BenchMetric& metric = bench_metrics[i];
+			double base_value = base.values[i];
+			double value = result.values[i];
+
+			if(base_value <= 0.0)
+				continue;
+			if(metric.is_time && max(base_value, value) < bench_min_compare_time)
+				continue;
+
+			double change = value / base_value - 1.0;
+			bool regression = (metric.higher_is_better)?
+			                  (change < -options.tolerance):
+			                  (change > options.tolerance);
+
+			if(regression)
+				num_regressions++;
+
+			printf("%-20s %-20s %14.4f %14.4f %+8.1f%%%s\n",
+			       result.name.c_str(),
+			       metric.name,
+			       base_value,
+			       value,
+			       change * 100.0,
+			       (regression)? "  REGRESSION": "");
+		}
+	}
+
+	if(num_regressions)
+		printf("\n%d regression(s) beyond %.1f%% tolerance.\n", num_regressions, (double)options.tolerance * 100.0);
+	else
+		printf("\nNo regressions beyond %.1f%% tolerance.\n", (double)options.tolerance * 100.0);
+
+	return num_regressions;
+}
+
+/* Options */
+
+static void bench_options_parse(int argc, const char **argv)
+{
+	options.width = 0;
+	options.height = 0;
+	options.repeat = 1;
+	options.tolerance = 0.05f;
+	options.quiet = false;
+	options.ray_stream = false;
+	options.bvh_layout = "obvh";
+#ifdef CYCLES_BENCH_SCENES_DIR
+	options.scenes_dir = CYCLES_BENCH_SCENES_DIR;
+#endif
+
+	options.session_params.samples = 16;
+	options.session_params.threads = 0;
+
+	bool help = false, debug = false, version = false;
+	int verbosity = 1;
+
+	ArgParse ap;
+	ap.options ("Usage: cycles_bench [options] [file.xml ...]",
+		"%*", bench_files_parse, "",
+		"--scenes-dir %s", &options.scenes_dir, "Directory of the default benchmark scenes, used when no files are given",
+		"--samples %d", &options.session_params.samples, "Number of samples to render",
+		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--width  %d", &options.width, "Override image width in pixel",
+		"--height %d", &options.height, "Override image height in pixel",
+		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
+		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+		"--bvh-layout %s", &options.bvh_layout, "BVH layout to compare: binary, qbvh or obvh (default, QBVH without the AVX2 kernel)",
+		"--ray-stream", &options.ray_stream, "Trace camera and shadow rays in streams, to compare against single ray traversal (disables OBVH)",
+		"--repeat %d", &options.repeat, "Render every scene this many times and keep the best values",
+		"--output %s", &options.output_path, "File path to write the results as JSON",
+		"--baseline %s", &options.baseline_path, "Results of a previous run to compare against, exits with an error on regressions",
+		"--tolerance %f", &options.tolerance, "Relative change allowed before a difference counts as regression",
+		"--quiet", &options.quiet, "Only print the comparison against the baseline",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, "Print help message",
+		"--version", &version, "Print version number",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(help) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+	else if(version) {
+		printf("%s\n", CYCLES_VERSION_STRING);
+		exit(EXIT_SUCCESS);
+	}
+
+	if(options.filepaths.size() == 0) {
+		if(options.scenes_dir == "") {
+			fprintf(stderr, "No scene files or scenes directory specified\n");
+			exit(EXIT_FAILURE);
+		}
+
+		for(int i = 0; bench_default_scenes[i]; i++)
+			options.filepaths.push_back(path_join(options.scenes_dir, bench_default_scenes[i]));
+	}
+
+	if(options.session_params.samples <= 0) {
+		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.repeat <= 0) {
+		fprintf(stderr, "Invalid number of repetitions: %d\n", options.repeat);
+		exit(EXIT_FAILURE);
+	}
+
+	if(options.bvh_layout == "binary") {
+		options.scene_params.use_qbvh = false;
+		options.scene_params.use_obvh = false;
+	}
+	else if(options.bvh_layout == "qbvh") {
+		options.scene_params.use_qbvh = true;
+		options.scene_params.use_obvh = false;
+	}
+	else if(options.bvh_layout == "obvh") {
+		options.scene_params.use_qbvh = true;
+		options.scene_params.use_obvh = true;
+	}
+	else {
+		fprintf(stderr, "Unknown BVH layout: %s\n", options.bvh_layout.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	/* Must be set before the devices are queried, the CPU device decides on
+	 * OBVH support and stream traversal when it is created. */
+	DebugFlags().cpu.ray_stream = options.ray_stream;
+
+	/* Results are only comparable on the same device, always use the CPU. */
+	bool device_available = false;
+	foreach(DeviceInfo& device, Device::available_devices()) {
+		if(device.type == DEVICE_CPU) {
+			options.session_params.device = device;
+			device_available = true;
+			break;
+		}
+	}
+
+	if(!device_available) {
+		fprintf(stderr, "CPU device not available\n");
+		exit(EXIT_FAILURE);
+	}
+
+	options.session_params.background = true;
+	options.session_params.progressive = false;
+	options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+	bench_options_parse(argc, argv);
+
+	/* Read the baseline first so a wrong path does not waste a full run. */
+	vector<BenchResult> baseline;
+
+	if(options.baseline_path != "") {
+		string json;
+
+		if(!path_read_text(options.baseline_path, json) ||
+		   !bench_results_from_json(json, baseline))
+		{
+			fprintf(stderr, "Failed to read baseline %s\n", options.baseline_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	vector<BenchResult> results;
+
+	foreach(const string& filepath, options.filepaths) {
+		if(!path_exists(filepath)) {
+			fprintf(stderr, "Scene file not found: %s\n", filepath.c_str());
+			return EXIT_FAILURE;
+		}
+
+		BenchResult best;
+
+		for(int i = 0; i < options.repeat; i++) {
+			BenchResult result;
+
+			bench_print("Rendering %s (%d/%d)\n", path_filename(filepath).c_str(), i + 1, options.repeat);
+
+			if(!bench_render_scene(filepath, result))
+				return EXIT_FAILURE;
+
+			if(i == 0)
+				best = result;
+			else
+				bench_result_merge(best, result);
+		}
+
+		bench_print("  load %.3fs  sync %.3fs  bvh %.3fs  render %.3fs  %.0f samples/s  %.2fM peak\n",
+		            best.values[0],
+		            best.values[1],
+		            best.values[2],
+		            best.values[3],
+		            best.values[4],
+		            best.values[5] / (1024.0 * 1024.0));
+
+		results.push_back(best);
+	}
+
+	string json = bench_results_to_json(results);
+
+	if(options.output_path != "") {
+		if(!path_write_text(options.output_path, json)) {
+			fprintf(stderr, "Failed to write %s\n", options.output_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	else if(!options.quiet) {
+		printf("\n%s", json.c_str());
+	}
+
+	if(baseline.size() && bench_compare(results, baseline) > 0)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
@@ -21,6 +21,7 @@
 #include "util/util_args.h"
 #include "util/util_foreach.h"
 #include "util/util_path.h"
+#include "util/util_profiling.h"
 #include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_task.h"
@@ -102,7 +103,8 @@ int main(int argc, const char **argv)
 
 	while(1) {
 		Stats stats;
-		Device *device = Device::create(device_info, stats, true);
+		Profiler profiler;
+		Device *device = Device::create(device_info, stats, profiler, true);
 		printf("Cycles Server with device: %s\n", device->info.description.c_str());
 		device->server_run();
 		delete device;
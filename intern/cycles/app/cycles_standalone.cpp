@@ -24,6 +24,7 @@
 #include "render/integrator.h"
 
 #include "util/util_args.h"
+#include "util/util_debug.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
 #include "util/util_logging.h"
@@ -140,6 +141,12 @@ static void session_init()
 static void session_exit()
 {
 	if(options.session) {
+		if(options.session->params.use_profiling) {
+			RenderStats stats;
+			options.session->collect_statistics(&stats);
+			printf("Render statistics:\n%s\n", stats.full_report().c_str());
+		}
+
 		delete options.session;
 		options.session = NULL;
 	}
@@ -353,6 +360,8 @@ static void options_parse(int argc, const char **argv)
 	/* parse options */
 	ArgParse ap;
 	bool help = false, debug = false, version = false;
+	bool no_obvh = false;
+	bool ray_stream = false;
 	int verbosity = 1;
 
 	ap.options ("Usage: cycles [options] file.xml",
@@ -371,6 +380,11 @@ static void options_parse(int argc, const char **argv)
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
 		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
 		"--list-devices", &list, "List information about all available devices",
+		"--no-obvh", &no_obvh, "Use 4 wide BVH instead of 8 wide one with the AVX2 kernel",
+		"--ray-stream", &ray_stream, "Trace coherent camera and shadow rays together in streams on the CPU",
+		"--profile", &options.session_params.use_profiling, "Sample the render time spent in kernel phases, shaders and objects on the CPU and print it at the end",
+		"--compact-geometry", &options.scene_params.use_compact_geometry, "Quantize BVH nodes, compress normals and share vertices between triangles to save memory",
+		"--texture-cache-size %d", &options.scene_params.texture_cache_size, "Memory limit of the CPU texture cache in megabytes, 0 loads images fully",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
 		"--verbose %d", &verbosity, "Set verbosity of the logger",
@@ -417,6 +431,9 @@ static void options_parse(int argc, const char **argv)
 	else if(ssname == "svm")
 		options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
 
+	options.scene_params.use_obvh = !no_obvh;
+	DebugFlags().cpu.ray_stream = ray_stream;
+
 #ifndef WITH_CYCLES_STANDALONE_GUI
 	options.session_params.background = true;
 #endif
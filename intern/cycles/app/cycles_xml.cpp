@@ -391,6 +391,11 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
 	mesh->used_shaders.push_back(state.shader);
 
+	/* name for instancing */
+	string name;
+	if(xml_read_string(&name, node, "name"))
+		mesh->name = ustring(name);
+
 	/* read state */
 	int shader = 0;
 	bool smooth = state.smooth;
@@ -529,6 +534,90 @@ static void xml_read_mesh(const XMLReadState& state, xml_node node)
 	}
 }
 
+/* Curves */
+
+static void xml_read_curves(const XMLReadState& state, xml_node node)
+{
+	/* read keys and curves, radius is given per key or once for all keys */
+	vector<float3> P;
+	vector<float> radius;
+	vector<int> nkeys;
+
+	xml_read_float3_array(P, node, "P");
+	xml_read_float_array(radius, node, "radius");
+	xml_read_int_array(nkeys, node, "nkeys");
+
+	if(radius.size() == 0)
+		radius.push_back(0.01f);
+
+	/* validate before adding anything to the scene */
+	size_t num_keys = 0;
+
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		if(nkeys[i] < 2) {
+			fprintf(stderr, "Curve %d has %d keys, at least 2 are needed.\n", (int)i, nkeys[i]);
+			return;
+		}
+		num_keys += nkeys[i];
+	}
+
+	if(num_keys != P.size()) {
+		fprintf(stderr, "Curves use %d keys but %d positions are given.\n", (int)num_keys, (int)P.size());
+		return;
+	}
+	else if(radius.size() != 1 && radius.size() != P.size()) {
+		fprintf(stderr, "Curves have %d radii, expected 1 or %d.\n", (int)radius.size(), (int)P.size());
+		return;
+	}
+
+	/* add mesh */
+	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
+	mesh->used_shaders.push_back(state.shader);
+
+	string name;
+	if(xml_read_string(&name, node, "name"))
+		mesh->name = ustring(name);
+
+	mesh->reserve_curves(nkeys.size(), P.size());
+
+	int first_key = 0;
+
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		for(int j = 0; j < nkeys[i]; j++) {
+			int key = first_key + j;
+			mesh->add_curve_key(P[key], (radius.size() == 1)? radius[0]: radius[key]);
+		}
+
+		mesh->add_curve(first_key, 0);
+		first_key += nkeys[i];
+	}
+}
+
+/* Instance */
+
+static void xml_read_instance(const XMLReadState& state, xml_node node)
+{
+	/* add object using a previously read mesh */
+	string meshname;
+
+	if(!xml_read_string(&meshname, node, "mesh")) {
+		fprintf(stderr, "Instance without \"mesh\" attribute.\n");
+		return;
+	}
+
+	foreach(Mesh *mesh, state.scene->meshes) {
+		if(mesh->name == meshname) {
+			Object *object = new Object();
+			object->mesh = mesh;
+			object->tfm = state.tfm;
+			state.scene->objects.push_back(object);
+			return;
+		}
+	}
+
+	fprintf(stderr, "Unknown mesh \"%s\".\n", meshname.c_str());
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState& state, xml_node node)
@@ -626,6 +715,12 @@ static void xml_read_scene(XMLReadState& state, xml_node scene_node)
 		else if(string_iequals(node.name(), "mesh")) {
 			xml_read_mesh(state, node);
 		}
+		else if(string_iequals(node.name(), "curves")) {
+			xml_read_curves(state, node);
+		}
+		else if(string_iequals(node.name(), "instance")) {
+			xml_read_instance(state, node);
+		}
 		else if(string_iequals(node.name(), "light")) {
 			xml_read_light(state, node);
 		}
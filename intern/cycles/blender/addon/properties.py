@@ -290,6 +290,33 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights by their estimated contribution to the shading point rather than by their area, "
+                            "improves sampling of scenes with many lights (not used when sampling all lights)",
+                default=False,
+                )
+
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling pixels once their noise is below the threshold, "
+                            "only used for final renders without progressive refine",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level at which pixels stop being sampled, lower values reduce noise but take longer",
+                min=0.0, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Minimum number of samples taken for every pixel before testing for convergence, "
+                            "zero to use the square root of the number of samples",
+                min=0, max=4096,
+                default=0,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -506,6 +533,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use special type BVH optimized for hair (uses more ram but renders faster)",
                 default=True,
                 )
+        cls.debug_use_two_level_bvh = BoolProperty(
+                name="Use Two Level BVH",
+                description="Keep separate BVHs for meshes in final renders, so moving objects only rebuild the "
+                            "scene level BVH (renders slightly slower, mesh BVHs are reused between frames with "
+                            "Persistent Images)",
+                default=False,
+                )
+        cls.debug_use_compact_geometry = BoolProperty(
+                name="Use Compact Geometry",
+                description="Store BVH nodes quantized, vertex normals compressed and vertices shared between "
+                            "triangles, for scenes which would not fit in memory otherwise (renders slower)",
+                default=False,
+                )
         cls.debug_bvh_time_steps = IntProperty(
                 name="BVH Time Steps",
                 description="Split BVH primitives by this number of time steps to speed up render time in cost of memory",
@@ -616,6 +656,21 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
             )
 
+        cls.use_texture_cache = BoolProperty(
+            name="Texture Cache",
+            description="Load image textures in tiles on demand for final rendering on the CPU, "
+                        "limiting memory usage and reading only the detail that is needed",
+            default=False,
+            )
+
+        cls.texture_cache_size = IntProperty(
+            name="Cache Size",
+            description="Maximum memory used by the texture cache, in megabytes",
+            default=1024,
+            min=16, max=1048576,
+            subtype='UNSIGNED',
+            )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -643,7 +698,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_use_cpu_sse3 = BoolProperty(name="SSE3", default=True)
         cls.debug_use_cpu_sse2 = BoolProperty(name="SSE2", default=True)
         cls.debug_use_qbvh = BoolProperty(name="QBVH", default=True)
+        cls.debug_use_obvh = BoolProperty(name="OBVH", default=True)
         cls.debug_use_cpu_split_kernel = BoolProperty(name="Split Kernel", default=False)
+        cls.debug_use_cpu_ray_stream = BoolProperty(
+                name="Ray Stream",
+                description="Trace coherent camera and shadow rays together in streams",
+                default=False,
+                )
+        cls.debug_use_cpu_profiling = BoolProperty(
+                name="Profiling",
+                description="Sample the render time spent in kernel phases, shaders and objects, "
+                            "and print it after the render (background rendering only)",
+                default=False,
+                )
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
         cls.debug_use_cuda_split_kernel = BoolProperty(name="Split Kernel", default=False)
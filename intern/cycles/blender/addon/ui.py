@@ -173,6 +173,16 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
 
+        subsub = sub.row(align=True)
+        subsub.active = not (use_branched_path(context) and use_sample_all_lights(context))
+        subsub.prop(cscene, "use_light_tree")
+
+        sub.prop(cscene, "use_adaptive_sampling")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_adaptive_sampling
+        subsub.prop(cscene, "adaptive_threshold", text="Noise Threshold")
+        subsub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
             sub = col.column(align=True)
@@ -417,12 +427,18 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
         col.label(text="Final Render:")
         col.prop(rd, "use_save_buffers")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache and not cscene.shading_system
+        sub.prop(cscene, "texture_cache_size")
 
         col.separator()
 
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
         col.prop(cscene, "debug_use_hair_bvh")
+        col.prop(cscene, "debug_use_two_level_bvh")
+        col.prop(cscene, "debug_use_compact_geometry")
 
         row = col.row()
         row.active = not cscene.debug_use_spatial_splits
@@ -1602,7 +1618,10 @@ class CYCLES_RENDER_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_use_qbvh")
+        col.prop(cscene, "debug_use_obvh")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        col.prop(cscene, "debug_use_cpu_ray_stream")
+        col.prop(cscene, "debug_use_cpu_profiling")
 
         col.separator()
 
@@ -30,6 +30,7 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_math.h"
+#include "util/util_time.h"
 
 #include "mikktspace.h"
 
@@ -873,17 +874,19 @@ static void create_mesh(Scene *scene,
 	}
 }
 
+static bool object_subdivide_uvs(BL::Object& b_ob)
+{
+	BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
+	return subsurf_mod.use_subsurf_uv();
+}
+
+/* Only reads b_mesh, which is owned by the caller, so it can run in a thread. */
 static void create_subd_mesh(Scene *scene,
                              Mesh *mesh,
-                             BL::Object& b_ob,
                              BL::Mesh& b_mesh,
                              const vector<Shader*>& used_shaders,
-                             float dicing_rate,
-                             int max_subdivisions)
+                             bool subdivide_uvs)
 {
-	BL::SubsurfModifier subsurf_mod(b_ob.modifiers[b_ob.modifiers.length()-1]);
-	bool subdivide_uvs = subsurf_mod.use_subsurf_uv();
-
 	create_mesh(scene, mesh, b_mesh, used_shaders, true, subdivide_uvs);
 
 	/* export creases */
@@ -908,7 +911,17 @@ static void create_subd_mesh(Scene *scene,
 			crease++;
 		}
 	}
+}
 
+/* Needs to run on the main thread, since it changes the camera and might
+ * create the Cycles settings of the object.
+ */
+static void sync_subd_params(Scene *scene,
+                             Mesh *mesh,
+                             BL::Object& b_ob,
+                             float dicing_rate,
+                             int max_subdivisions)
+{
 	/* set subd params */
 	if(!mesh->subd_params) {
 		mesh->subd_params = new SubdParams(mesh);
@@ -927,6 +940,35 @@ static void create_subd_mesh(Scene *scene,
 
 /* Sync */
 
+static bool mesh_need_rebuild(Mesh *mesh,
+                              const array<int>& oldtriangle,
+                              const array<float3>& oldcurve_keys,
+                              const array<float>& oldcurve_radius)
+{
+	if(oldtriangle.size() != mesh->triangles.size())
+		return true;
+	else if(oldtriangle.size()) {
+		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
+			return true;
+	}
+
+	if(oldcurve_keys.size() != mesh->curve_keys.size())
+		return true;
+	else if(oldcurve_keys.size()) {
+		if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
+			return true;
+	}
+
+	if(oldcurve_radius.size() != mesh->curve_radius.size())
+		return true;
+	else if(oldcurve_radius.size()) {
+		if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
+			return true;
+	}
+
+	return false;
+}
+
 static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
 {
 	if(scene->need_motion() == Scene::MOTION_NONE)
@@ -966,7 +1008,9 @@ static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
 
 Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
                              bool object_updated,
-                             bool hide_tris)
+                             bool hide_tris,
+                             bool use_motion_blur,
+                             uint motion_steps)
 {
 	/* When viewport display is not needed during render we can force some
 	 * caches to be releases from blender side in order to reduce peak memory
@@ -1051,6 +1095,15 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	mesh->used_shaders = used_shaders;
 	mesh->name = ustring(b_ob_data.name().c_str());
 
+	/* The conversion threads read these, sync_object() must not change
+	 * them while the mesh is converted. */
+	if(scene->need_motion() == Scene::MOTION_BLUR) {
+		mesh->use_motion_blur = use_motion_blur;
+		if(use_motion_blur) {
+			mesh->motion_steps = motion_steps;
+		}
+	}
+
 	if(requested_geometry_flags != Mesh::GEOMETRY_NONE) {
 		/* mesh objects does have special handle in the dependency graph,
 		 * they're ensured to have properly updated.
@@ -1081,25 +1134,39 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 		                                 mesh->subdivision_type);
 
 		if(b_mesh) {
-			if(render_layer.use_surfaces && !hide_tris) {
-				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders, false);
+			/* Convert the derived mesh in the task pool, the remaining
+			 * work is done in sync_mesh_finish().
+			 */
+			MeshSyncTask *task = new MeshSyncTask(b_ob, b_mesh, mesh);
+			task->use_surfaces = render_layer.use_surfaces && !hide_tris;
+			/* Blender objects are only accessed on the main thread. */
+			if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE) {
+				task->subdivide_uvs = object_subdivide_uvs(b_ob);
+			}
+			task->can_free_caches = can_free_caches;
+			task->oldtriangle.steal_data(oldtriangle);
+			task->oldcurve_keys.steal_data(oldcurve_keys);
+			task->oldcurve_radius.steal_data(oldcurve_radius);
+
+			mesh->geometry_flags = requested_geometry_flags;
 
-				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
+			if(task->use_surfaces) {
+				mesh_sync_pool.push(function_bind(&BlenderSync::sync_mesh_convert,
+				                                  this,
+				                                  task));
 			}
+			mesh_sync_tasks.push_back(task);
 
-			if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
-				sync_curves(mesh, b_mesh, b_ob, false);
+			/* Objects check this to see if they need an update, rebuild is
+			 * tagged once the conversion finished. */
+			mesh->tag_update(scene, false);
 
-			if(can_free_caches) {
-				b_ob.cache_release();
+			/* Limit the number of derived meshes kept in memory. */
+			if(mesh_sync_tasks.size() >= (size_t)max(TaskScheduler::num_threads(), 1) * 4) {
+				sync_mesh_finish();
 			}
 
-			/* free derived mesh */
-			b_data.meshes.remove(b_mesh, false, true, false);
+			return mesh;
 		}
 	}
 	mesh->geometry_flags = requested_geometry_flags;
@@ -1108,32 +1175,78 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	sync_mesh_fluid_motion(b_ob, scene, mesh);
 
 	/* tag update */
-	bool rebuild = false;
+	bool rebuild = mesh_need_rebuild(mesh, oldtriangle, oldcurve_keys, oldcurve_radius);
+	mesh->tag_update(scene, rebuild);
 
-	if(oldtriangle.size() != mesh->triangles.size())
-		rebuild = true;
-	else if(oldtriangle.size()) {
-		if(memcmp(&oldtriangle[0], &mesh->triangles[0], sizeof(int)*oldtriangle.size()) != 0)
-			rebuild = true;
-	}
+	return mesh;
+}
 
-	if(oldcurve_keys.size() != mesh->curve_keys.size())
-		rebuild = true;
-	else if(oldcurve_keys.size()) {
-		if(memcmp(&oldcurve_keys[0], &mesh->curve_keys[0], sizeof(float3)*oldcurve_keys.size()) != 0)
-			rebuild = true;
+void BlenderSync::sync_mesh_convert(MeshSyncTask *task)
+{
+	scoped_timer timer(&task->time);
+	Mesh *mesh = task->mesh;
+
+	if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+		create_subd_mesh(scene, mesh, task->b_mesh, mesh->used_shaders, task->subdivide_uvs);
+	else
+		create_mesh(scene, mesh, task->b_mesh, mesh->used_shaders, false);
+}
+
+bool BlenderSync::sync_mesh_pending(Mesh *mesh)
+{
+	foreach(MeshSyncTask *task, mesh_sync_tasks) {
+		if(task->mesh == mesh) {
+			return true;
+		}
 	}
+	return false;
+}
 
-	if(oldcurve_radius.size() != mesh->curve_radius.size())
-		rebuild = true;
-	else if(oldcurve_radius.size()) {
-		if(memcmp(&oldcurve_radius[0], &mesh->curve_radius[0], sizeof(float)*oldcurve_radius.size()) != 0)
-			rebuild = true;
+void BlenderSync::sync_mesh_finish()
+{
+	mesh_sync_pool.wait_work();
+
+	double time = 0.0;
+
+	foreach(MeshSyncTask *task, mesh_sync_tasks) {
+		Mesh *mesh = task->mesh;
+		time += task->time;
+
+		if(task->use_surfaces) {
+			if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+				sync_subd_params(scene, mesh, task->b_ob, dicing_rate, max_subdivisions);
+
+			create_mesh_volume_attributes(scene, task->b_ob, mesh, b_scene.frame_current());
+		}
+
+		if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
+			sync_curves(mesh, task->b_mesh, task->b_ob, false);
+
+		if(task->can_free_caches) {
+			task->b_ob.cache_release();
+		}
+
+		/* free derived mesh */
+		b_data.meshes.remove(task->b_mesh, false, true, false);
+
+		/* fluid motion */
+		sync_mesh_fluid_motion(task->b_ob, scene, mesh);
+
+		/* tag update */
+		bool rebuild = mesh_need_rebuild(mesh,
+		                                 task->oldtriangle,
+		                                 task->oldcurve_keys,
+		                                 task->oldcurve_radius);
+		mesh->tag_update(scene, rebuild);
+
+		delete task;
 	}
 
-	mesh->tag_update(scene, rebuild);
+	mesh_sync_tasks.clear();
 
-	return mesh;
+	if(time > 0.0) {
+		sync_stats.add("Mesh conversion", time);
+	}
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
@@ -359,8 +359,20 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 	if(object_map.sync(&object, b_ob, b_parent, key))
 		object_updated = true;
 	
+	/* motion blur of the mesh, set before it is converted in threads */
+	bool use_mesh_motion_blur = false;
+	uint mesh_motion_steps = 0;
+
+	if(scene->need_motion() == Scene::MOTION_BLUR &&
+	   object_use_motion(b_parent, b_ob) &&
+	   object_use_deform_motion(b_parent, b_ob))
+	{
+		use_mesh_motion_blur = true;
+		mesh_motion_steps = object_motion_steps(b_ob);
+	}
+
 	/* mesh sync */
-	object->mesh = sync_mesh(b_ob, object_updated, hide_tris);
+	object->mesh = sync_mesh(b_ob, object_updated, hide_tris, use_mesh_motion_blur, mesh_motion_steps);
 
 	/* special case not tracked by object update flags */
 
@@ -397,14 +409,23 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 		if(scene->need_motion() == Scene::MOTION_BLUR && object->mesh) {
 			Mesh *mesh = object->mesh;
 
-			mesh->use_motion_blur = false;
+			if(mesh->use_motion_blur != use_mesh_motion_blur ||
+			   (use_mesh_motion_blur && mesh->motion_steps != mesh_motion_steps))
+			{
+				/* Instances of a mesh with other settings than the object
+				 * which synced it, wait until the conversion reading them
+				 * is done. */
+				if(sync_mesh_pending(mesh)) {
+					sync_mesh_finish();
+				}
 
-			if(object_use_motion(b_parent, b_ob)) {
-				if(object_use_deform_motion(b_parent, b_ob)) {
-					mesh->motion_steps = object_motion_steps(b_ob);
-					mesh->use_motion_blur = true;
+				mesh->use_motion_blur = use_mesh_motion_blur;
+				if(use_mesh_motion_blur) {
+					mesh->motion_steps = mesh_motion_steps;
 				}
+			}
 
+			if(object_use_motion(b_parent, b_ob)) {
 				vector<float> times = object->motion_times();
 				foreach(float time, times)
 					motion_times.insert(time);
@@ -628,6 +649,9 @@ void BlenderSync::sync_objects(float motion_time)
 		}
 	}
 
+	/* wait for meshes which are still being converted */
+	sync_mesh_finish();
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
@@ -142,7 +142,7 @@ void BlenderSession::create_session()
 	session->scene = scene;
 
 	/* create sync */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, session->sync_stats);
 	BL::Object b_camera_override(b_engine.camera_override());
 	if(b_v3d) {
 		if(session_pause == false) {
@@ -211,7 +211,7 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	session->stats.mem_peak = session->stats.mem_used;
 
 	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, session->sync_stats);
 
 	/* for final render we will do full data sync per render layer, only
 	 * do some basic syncing here, no objects or materials for speed */
@@ -499,6 +499,19 @@ void BlenderSession::render()
 	VLOG(1) << "Total render time: " << total_time;
 	VLOG(1) << "Render time (without synchronization): " << render_time;
 
+	if(session_params.adaptive_sampling) {
+		uint64_t skipped_samples, total_samples;
+		session->progress.get_skipped_samples(skipped_samples, total_samples);
+		VLOG(1) << "Pixel samples skipped by adaptive sampling: "
+		        << skipped_samples << " of " << total_samples;
+	}
+
+	if(session->params.use_profiling) {
+		RenderStats stats;
+		session->collect_statistics(&stats);
+		printf("Render statistics:\n%s\n", stats.full_report().c_str());
+	}
+
 	/* clear callback */
 	session->write_render_tile_cb = function_null;
 	session->update_render_tile_cb = function_null;
@@ -937,6 +950,15 @@ void BlenderSession::update_status_progress()
 
 	timestatus += string_printf("Mem:%.2fM, Peak:%.2fM", (double)mem_used, (double)mem_peak);
 
+	if(session->params.adaptive_sampling) {
+		uint64_t skipped_samples, total_samples;
+		session->progress.get_skipped_samples(skipped_samples, total_samples);
+		if(skipped_samples > 0 && total_samples > 0) {
+			timestatus += string_printf(" | Saved:%.1f%%",
+			                            100.0 * (double)skipped_samples / (double)total_samples);
+		}
+	}
+
 	if(status.size() > 0)
 		status = " | " + status;
 	if(substatus.size() > 0)
@@ -37,6 +37,8 @@
 #include "util/util_foreach.h"
 #include "util/util_opengl.h"
 #include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -47,7 +49,8 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
                          BL::Scene& b_scene,
                          Scene *scene,
                          bool preview,
-                         Progress &progress)
+                         Progress &progress,
+                         SyncStats &sync_stats)
 : b_engine(b_engine),
   b_data(b_data),
   b_scene(b_scene),
@@ -63,7 +66,8 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
   experimental(false),
   dicing_rate(1.0f),
   max_subdivisions(12),
-  progress(progress)
+  progress(progress),
+  sync_stats(sync_stats)
 {
 	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
 	dicing_rate = preview ? RNA_float_get(&cscene, "preview_dicing_rate") : RNA_float_get(&cscene, "dicing_rate");
@@ -72,6 +76,8 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
 
 BlenderSync::~BlenderSync()
 {
+	/* In case synchronization was interrupted. */
+	sync_mesh_finish();
 }
 
 /* Sync */
@@ -195,11 +201,21 @@ void BlenderSync::sync_data(BL::RenderSettings& b_render,
                             void **python_thread_state,
                             const char *layer)
 {
+	double time;
+
 	sync_render_layers(b_v3d, layer);
 	sync_integrator();
 	sync_film();
-	sync_shaders();
-	sync_images();
+	{
+		scoped_timer timer(&time);
+		sync_shaders();
+	}
+	sync_stats.add("Shaders", time);
+	{
+		scoped_timer timer(&time);
+		sync_images();
+	}
+	sync_stats.add("Images", time);
 	sync_curve_settings();
 
 	mesh_synced.clear(); /* use for objects and motion sync */
@@ -208,14 +224,24 @@ void BlenderSync::sync_data(BL::RenderSettings& b_render,
 	   scene->need_motion() == Scene::MOTION_NONE ||
 	   scene->camera->motion_position == Camera::MOTION_POSITION_CENTER)
 	{
-		sync_objects();
+		{
+			scoped_timer timer(&time);
+			sync_objects();
+		}
+		sync_stats.add("Objects", time);
+	}
+	{
+		scoped_timer timer(&time);
+		sync_motion(b_render,
+		            b_override,
+		            width, height,
+		            python_thread_state);
 	}
-	sync_motion(b_render,
-	            b_override,
-	            width, height,
-	            python_thread_state);
+	sync_stats.add("Motion", time);
 
 	mesh_synced.clear();
+
+	VLOG(1) << "Synchronization times:\n" << sync_stats.full_report();
 }
 
 /* Integrator */
@@ -288,6 +314,10 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -328,6 +358,9 @@ void BlenderSync::sync_integrator()
 		integrator->ao_bounces = 0;
 	}
 
+	if(integrator->use_light_tree_sampling() != previntegrator.use_light_tree_sampling())
+		scene->light_manager->tag_update(scene);
+
 	if(integrator->modified(previntegrator))
 		integrator->tag_update(scene);
 }
@@ -620,6 +653,12 @@ array<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 		Pass::add(PASS_VOLUME_INDIRECT, passes);
 	}
 
+	/* Internal passes used by adaptive sampling, not exposed to Blender. */
+	if(session_params.adaptive_sampling) {
+		Pass::add(PASS_SAMPLE_COUNT, passes);
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+	}
+
 	return passes;
 }
 
@@ -638,7 +677,17 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	else if(shadingsystem == 1)
 		params.shadingsystem = SHADINGSYSTEM_OSL;
 	
-	if(background || DebugFlags().viewport_static_bvh)
+	/* Two level BVH for final renders, so only the top level BVH needs to be
+	 * rebuilt when objects are moving between frames.
+	 */
+	const bool use_two_level_bvh = background &&
+	        RNA_boolean_get(&cscene, "debug_use_two_level_bvh");
+
+	if(background) {
+		params.bvh_type = (use_two_level_bvh)? SceneParams::BVH_DYNAMIC:
+		                                       SceneParams::BVH_STATIC;
+	}
+	else if(DebugFlags().viewport_static_bvh)
 		params.bvh_type = SceneParams::BVH_STATIC;
 	else
 		params.bvh_type = SceneParams::BVH_DYNAMIC;
@@ -646,12 +695,16 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
+	params.use_compact_geometry = RNA_boolean_get(&cscene, "debug_use_compact_geometry");
 
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
 		params.persistent_data = false;
 
+	/* Mesh BVHs can only be reused when the scene itself is kept. */
+	params.use_bvh_cache = use_two_level_bvh && params.persistent_data;
+
 	int texture_limit;
 	if(background) {
 		texture_limit = RNA_enum_get(&cscene, "texture_limit_render");
@@ -666,7 +719,19 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	/* Page image textures in on demand for final renders on the CPU. */
+	if(background &&
+	   params.shadingsystem == SHADINGSYSTEM_SVM &&
+	   RNA_boolean_get(&cscene, "use_texture_cache"))
+	{
+		params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+	}
+	else {
+		params.texture_cache_size = 0;
+	}
+
 	params.use_qbvh = DebugFlags().cpu.qbvh;
+	params.use_obvh = DebugFlags().cpu.obvh;
 
 	return params;
 }
@@ -700,6 +765,10 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine& b_engine,
 	/* Background */
 	params.background = background;
 
+	/* Profiling, only for final renders since the statistics are printed
+	 * when the render is done. */
+	params.use_profiling = background && get_boolean(cscene, "debug_use_cpu_profiling");
+
 	/* device type */
 	vector<DeviceInfo>& devices = Device::available_devices();
 	
@@ -854,6 +923,22 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine& b_engine,
 		}
 	}
 
+	/* adaptive sampling, only for final renders that take all samples of a
+	 * tile at once and are not denoised */
+	params.adaptive_sampling = background &&
+	                           !params.progressive_refine &&
+	                           get_boolean(cscene, "use_adaptive_sampling");
+
+	if(params.adaptive_sampling) {
+		BL::RenderSettings::layers_iterator b_rlay;
+		for(b_r.layers.begin(b_rlay); b_rlay != b_r.layers.end(); ++b_rlay) {
+			PointerRNA crl = RNA_pointer_get(&b_rlay->ptr, "cycles");
+			if(get_boolean(crl, "use_denoising")) {
+				params.adaptive_sampling = false;
+			}
+		}
+	}
+
 	if(background) {
 		if(params.progressive_refine)
 			params.progressive = true;
@@ -29,6 +29,8 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_stats.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -54,7 +56,8 @@ public:
 	            BL::Scene& b_scene,
 	            Scene *scene,
 	            bool preview,
-	            Progress &progress);
+	            Progress &progress,
+	            SyncStats &sync_stats);
 	~BlenderSync();
 
 	/* sync */
@@ -113,7 +116,13 @@ private:
 	void sync_curve_settings();
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
-	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
+	Mesh *sync_mesh(BL::Object& b_ob,
+	                bool object_updated,
+	                bool hide_tris,
+	                bool use_motion_blur,
+	                uint motion_steps);
+	void sync_mesh_finish();
+	bool sync_mesh_pending(Mesh *mesh);
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
 	                 BL::Object& b_ob,
@@ -168,6 +177,32 @@ private:
 	id_map<ObjectKey, Light> light_map;
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
+
+	/* Meshes which are being converted in the task pool. Blender data is
+	 * only accessed for reading there, everything else is done on the main
+	 * thread once the conversion finished.
+	 */
+	struct MeshSyncTask {
+		MeshSyncTask(BL::Object& b_ob, BL::Mesh& b_mesh, Mesh *mesh)
+		: b_ob(b_ob), b_mesh(b_mesh), mesh(mesh),
+		  use_surfaces(false), subdivide_uvs(false), can_free_caches(false), time(0.0)
+		{}
+
+		BL::Object b_ob;
+		BL::Mesh b_mesh;
+		Mesh *mesh;
+		bool use_surfaces;
+		bool subdivide_uvs;
+		bool can_free_caches;
+		array<int> oldtriangle;
+		array<float3> oldcurve_keys;
+		array<float> oldcurve_radius;
+		double time;
+	};
+	void sync_mesh_convert(MeshSyncTask *task);
+
+	vector<MeshSyncTask*> mesh_sync_tasks;
+	TaskPool mesh_sync_pool;
 	set<Mesh*> mesh_motion_synced;
 	set<float> motion_times;
 	void *world_map;
@@ -209,6 +244,7 @@ private:
 	} render_layer;
 
 	Progress &progress;
+	SyncStats &sync_stats;
 };
 
 CCL_NAMESPACE_END
@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -51,7 +52,9 @@ BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 {
-	if(params.use_qbvh)
+	if(params.use_obvh)
+		return new BVH8(params, objects);
+	else if(params.use_qbvh)
 		return new BVH4(params, objects);
 	else
 		return new BVH2(params, objects);
@@ -198,6 +201,9 @@ void BVH::pack_triangle(int idx, float4 tri_verts[3])
 void BVH::pack_primitives()
 {
 	const size_t tidx_size = pack.prim_index.size();
+	/* With compact storage the kernel reads triangle vertices through the
+	 * vertex index buffer, so no copy of them is stored in BVH order. */
+	const bool use_triangle_storage = !params.use_compact_storage;
 	size_t num_prim_triangles = 0;
 	/* Count number of triangles primitives in BVH. */
 	for(unsigned int i = 0; i < tidx_size; i++) {
@@ -209,9 +215,11 @@ void BVH::pack_primitives()
 	}
 	/* Reserve size for arrays. */
 	pack.prim_tri_index.clear();
-	pack.prim_tri_index.resize(tidx_size);
 	pack.prim_tri_verts.clear();
-	pack.prim_tri_verts.resize(num_prim_triangles * 3);
+	if(use_triangle_storage) {
+		pack.prim_tri_index.resize(tidx_size);
+		pack.prim_tri_verts.resize(num_prim_triangles * 3);
+	}
 	pack.prim_visibility.clear();
 	pack.prim_visibility.resize(tidx_size);
 	/* Fill in all the arrays. */
@@ -220,13 +228,15 @@ void BVH::pack_primitives()
 		if(pack.prim_index[i] != -1) {
 			int tob = pack.prim_object[i];
 			Object *ob = objects[tob];
-			if((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
-				pack_triangle(i, (float4*)&pack.prim_tri_verts[3 * prim_triangle_index]);
-				pack.prim_tri_index[i] = 3 * prim_triangle_index;
-				++prim_triangle_index;
-			}
-			else {
-				pack.prim_tri_index[i] = -1;
+			if(use_triangle_storage) {
+				if((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
+					pack_triangle(i, (float4*)&pack.prim_tri_verts[3 * prim_triangle_index]);
+					pack.prim_tri_index[i] = 3 * prim_triangle_index;
+					++prim_triangle_index;
+				}
+				else {
+					pack.prim_tri_index[i] = -1;
+				}
 			}
 			pack.prim_visibility[i] = ob->visibility_for_tracing();
 			if(pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
@@ -234,7 +244,9 @@ void BVH::pack_primitives()
 			}
 		}
 		else {
-			pack.prim_tri_index[i] = -1;
+			if(use_triangle_storage) {
+				pack.prim_tri_index[i] = -1;
+			}
 			pack.prim_visibility[i] = 0;
 		}
 	}
@@ -249,6 +261,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
 	const bool use_qbvh = params.use_qbvh;
+	const bool use_obvh = params.use_obvh;
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -304,7 +317,9 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	pack.prim_object.resize(prim_index_size);
 	pack.prim_visibility.resize(prim_index_size);
 	pack.prim_tri_verts.resize(prim_tri_verts_size);
-	pack.prim_tri_index.resize(prim_index_size);
+	if(!params.use_compact_storage) {
+		pack.prim_tri_index.resize(prim_index_size);
+	}
 	pack.nodes.resize(nodes_size);
 	pack.leaf_nodes.resize(leaf_nodes_size);
 	pack.object_node.resize(objects.size());
@@ -366,18 +381,22 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 			int *bvh_prim_index = &bvh->pack.prim_index[0];
 			int *bvh_prim_type = &bvh->pack.prim_type[0];
 			uint *bvh_prim_visibility = &bvh->pack.prim_visibility[0];
-			uint *bvh_prim_tri_index = &bvh->pack.prim_tri_index[0];
+			uint *bvh_prim_tri_index = bvh->pack.prim_tri_index.size()? &bvh->pack.prim_tri_index[0]: NULL;
 			float2 *bvh_prim_time = bvh->pack.prim_time.size()? &bvh->pack.prim_time[0]: NULL;
 
 			for(size_t i = 0; i < bvh_prim_index_size; i++) {
 				if(bvh->pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
 					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_curve_offset;
-					pack_prim_tri_index[pack_prim_index_offset] = -1;
+					if(pack_prim_tri_index != NULL) {
+						pack_prim_tri_index[pack_prim_index_offset] = -1;
+					}
 				}
 				else {
 					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_tri_offset;
-					pack_prim_tri_index[pack_prim_index_offset] =
-					        bvh_prim_tri_index[i] + pack_prim_tri_verts_offset;
+					if(pack_prim_tri_index != NULL) {
+						pack_prim_tri_index[pack_prim_index_offset] =
+						        bvh_prim_tri_index[i] + pack_prim_tri_verts_offset;
+					}
 				}
 
 				pack_prim_type[pack_prim_index_offset] = bvh_prim_type[i];
@@ -425,39 +444,60 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
 				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-					nsize = use_qbvh
-					            ? BVH_UNALIGNED_QNODE_SIZE
-					            : BVH_UNALIGNED_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 13: 0;
+					if(use_obvh) {
+						nsize = BVH_UNALIGNED_ONODE_SIZE;
+						nsize_bbox = BVH_UNALIGNED_ONODE_CHILD_OFFSET;
+					}
+					else {
+						nsize = use_qbvh
+						            ? BVH_UNALIGNED_QNODE_SIZE
+						            : BVH_UNALIGNED_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 13: 0;
+					}
+				}
+				else if(bvh_nodes[i].x & PATH_RAY_NODE_QUANTIZED) {
+					/* Only used by BVH2 nodes. */
+					nsize = BVH_QUANTIZED_NODE_SIZE;
+					nsize_bbox = 0;
 				}
 				else {
-					nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 7: 0;
+					if(use_obvh) {
+						nsize = BVH_ONODE_SIZE;
+						nsize_bbox = BVH_ONODE_CHILD_OFFSET;
+					}
+					else {
+						nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 7: 0;
+					}
 				}
+				/* Number of int4 holding child indices. */
+				const size_t nsize_child = (use_obvh)? 2: 1;
 
 				memcpy(pack_nodes + pack_nodes_offset,
 				       bvh_nodes + i,
 				       nsize_bbox*sizeof(int4));
 
 				/* Modify offsets into arrays */
-				int4 data = bvh_nodes[i + nsize_bbox];
+				for(size_t k = 0; k < nsize_child; k++) {
+					int4 data = bvh_nodes[i + nsize_bbox + k];
 
-				data.z += (data.z < 0)? -noffset_leaf: noffset;
-				data.w += (data.w < 0)? -noffset_leaf: noffset;
+					data.z += (data.z < 0)? -noffset_leaf: noffset;
+					data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
-					data.x += (data.x < 0)? -noffset_leaf: noffset;
-					data.y += (data.y < 0)? -noffset_leaf: noffset;
-				}
+					if(use_qbvh) {
+						data.x += (data.x < 0)? -noffset_leaf: noffset;
+						data.y += (data.y < 0)? -noffset_leaf: noffset;
+					}
 
-				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
+					pack_nodes[pack_nodes_offset + nsize_bbox + k] = data;
+				}
 
 				/* Usually this copies nothing, but we better
 				 * be prepared for possible node size extension.
 				 */
-				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox+1],
-				       &bvh_nodes[i + nsize_bbox+1],
-				       sizeof(int4) * (nsize - (nsize_bbox+1)));
+				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + nsize_child],
+				       &bvh_nodes[i + nsize_bbox + nsize_child],
+				       sizeof(int4) * (nsize - (nsize_bbox + nsize_child)));
 
 				pack_nodes_offset += nsize;
 				i += nsize;
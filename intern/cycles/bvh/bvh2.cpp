@@ -23,6 +23,8 @@
 #include "bvh/bvh_node.h"
 #include "bvh/bvh_unaligned.h"
 
+#include "util/util_math_quantize.h"
+
 CCL_NAMESPACE_BEGIN
 
 static bool node_bvh_is_unaligned(const BVHNode *node)
@@ -76,10 +78,18 @@ void BVH2::pack_aligned_inner(const BVHStackEntry& e,
                               const BVHStackEntry& e0,
                               const BVHStackEntry& e1)
 {
-	pack_aligned_node(e.idx,
-	                  e0.node->bounds, e1.node->bounds,
-	                  e0.encodeIdx(), e1.encodeIdx(),
-	                  e0.node->visibility, e1.node->visibility);
+	if(params.use_compact_storage) {
+		pack_quantized_node(e.idx,
+		                    e0.node->bounds, e1.node->bounds,
+		                    e0.encodeIdx(), e1.encodeIdx(),
+		                    e0.node->visibility, e1.node->visibility);
+	}
+	else {
+		pack_aligned_node(e.idx,
+		                  e0.node->bounds, e1.node->bounds,
+		                  e0.encodeIdx(), e1.encodeIdx(),
+		                  e0.node->visibility, e1.node->visibility);
+	}
 }
 
 void BVH2::pack_aligned_node(int idx,
@@ -113,6 +123,54 @@ void BVH2::pack_aligned_node(int idx,
 	memcpy(&pack.nodes[idx], data, sizeof(int4)*BVH_NODE_SIZE);
 }
 
+void BVH2::pack_quantized_node(int idx,
+                               const BoundBox& b0,
+                               const BoundBox& b1,
+                               int c0, int c1,
+                               uint visibility0, uint visibility1)
+{
+	assert(idx + BVH_QUANTIZED_NODE_SIZE <= pack.nodes.size());
+	assert(c0 < 0 || c0 < pack.nodes.size());
+	assert(c1 < 0 || c1 < pack.nodes.size());
+
+	/* Empty children, which are never visible, are stored as a point. */
+	BoundBox bounds = BoundBox::empty;
+	if(b0.valid()) bounds.grow(b0);
+	if(b1.valid()) bounds.grow(b1);
+	if(!bounds.valid()) {
+		bounds = BoundBox(make_float3(0.0f, 0.0f, 0.0f));
+	}
+	const BoundBox child0 = (b0.valid())? b0: BoundBox(bounds.min);
+	const BoundBox child1 = (b1.valid())? b1: BoundBox(bounds.min);
+
+	/* Per axis the bytes are laid out like the float bounds of aligned
+	 * nodes, {child0 min, child1 min, child0 max, child1 max}. */
+	const float3 origin = bounds.min;
+	const float3 extent = bounds.size();
+	int4 data[BVH_QUANTIZED_NODE_SIZE];
+	uint exponents = 0;
+
+	for(int axis = 0; axis < 3; axis++) {
+		const uint exponent = quantize_step_exponent(extent[axis]);
+		const float4 axis_bounds = make_float4(child0.min[axis], child1.min[axis],
+		                                       child0.max[axis], child1.max[axis]);
+
+		exponents |= exponent << (axis*8);
+		data[2][axis] = (int)quantize_bounds(axis_bounds, origin[axis], exponent);
+	}
+
+	data[0] = make_int4(visibility0 | PATH_RAY_NODE_QUANTIZED,
+	                    visibility1 | PATH_RAY_NODE_QUANTIZED,
+	                    c0, c1);
+	data[1] = make_int4(__float_as_int(origin.x),
+	                    __float_as_int(origin.y),
+	                    __float_as_int(origin.z),
+	                    0);
+	data[2].w = (int)exponents;
+
+	memcpy(&pack.nodes[idx], data, sizeof(int4)*BVH_QUANTIZED_NODE_SIZE);
+}
+
 void BVH2::pack_unaligned_inner(const BVHStackEntry& e,
                                 const BVHStackEntry& e0,
                                 const BVHStackEntry& e1)
@@ -164,15 +222,18 @@ void BVH2::pack_nodes(const BVHNode *root)
 	const size_t num_leaf_nodes = root->getSubtreeSize(BVH_STAT_LEAF_COUNT);
 	assert(num_leaf_nodes <= num_nodes);
 	const size_t num_inner_nodes = num_nodes - num_leaf_nodes;
+	const size_t aligned_node_size = (params.use_compact_storage)
+	                                         ? BVH_QUANTIZED_NODE_SIZE
+	                                         : BVH_NODE_SIZE;
 	size_t node_size;
 	if(params.use_unaligned_nodes) {
 		const size_t num_unaligned_nodes =
 		        root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_COUNT);
 		node_size = (num_unaligned_nodes * BVH_UNALIGNED_NODE_SIZE) +
-		            (num_inner_nodes - num_unaligned_nodes) * BVH_NODE_SIZE;
+		            (num_inner_nodes - num_unaligned_nodes) * aligned_node_size;
 	}
 	else {
-		node_size = num_inner_nodes * BVH_NODE_SIZE;
+		node_size = num_inner_nodes * aligned_node_size;
 	}
 	/* Resize arrays */
 	pack.nodes.clear();
@@ -197,7 +258,7 @@ void BVH2::pack_nodes(const BVHNode *root)
 		stack.push_back(BVHStackEntry(root, nextNodeIdx));
 		nextNodeIdx += node_bvh_is_unaligned(root)
 		                       ? BVH_UNALIGNED_NODE_SIZE
-		                       : BVH_NODE_SIZE;
+		                       : aligned_node_size;
 	}
 
 	while(stack.size()) {
@@ -220,7 +281,7 @@ void BVH2::pack_nodes(const BVHNode *root)
 					idx[i] = nextNodeIdx;
 					nextNodeIdx += node_bvh_is_unaligned(e.node->get_child(i))
 					                       ? BVH_UNALIGNED_NODE_SIZE
-					                       : BVH_NODE_SIZE;
+					                       : aligned_node_size;
 				}
 			}
 
@@ -264,10 +325,16 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4)*BVH_NODE_LEAF_SIZE);
 	}
 	else {
-		assert(idx + BVH_NODE_SIZE <= pack.nodes.size());
+		assert(idx < pack.nodes.size());
 
 		const int4 *data = &pack.nodes[idx];
 		const bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+		const bool is_quantized = (data[0].x & PATH_RAY_NODE_QUANTIZED) != 0;
+		/* Aligned nodes are quantized exactly when using compact storage. */
+		assert(is_unaligned || is_quantized == params.use_compact_storage);
+		assert(idx + (is_unaligned? BVH_UNALIGNED_NODE_SIZE:
+		              is_quantized? BVH_QUANTIZED_NODE_SIZE:
+		                            BVH_NODE_SIZE) <= pack.nodes.size());
 		const int c0 = data[0].z;
 		const int c1 = data[0].w;
 		/* refit inner node, set bbox from children */
@@ -286,6 +353,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 			                    visibility0,
 			                    visibility1);
 		}
+		else if(is_quantized) {
+			pack_quantized_node(idx,
+			                    bbox0, bbox1,
+			                    c0, c1,
+			                    visibility0,
+			                    visibility1);
+		}
 		else {
 			pack_aligned_node(idx,
 			                  bbox0, bbox1,
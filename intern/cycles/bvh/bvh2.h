@@ -37,6 +37,7 @@ class Progress;
 #define BVH_NODE_SIZE           4
 #define BVH_NODE_LEAF_SIZE      1
 #define BVH_UNALIGNED_NODE_SIZE 7
+#define BVH_QUANTIZED_NODE_SIZE 3
 
 /* BVH2
  *
@@ -66,6 +67,12 @@ protected:
 	                       int c0, int c1,
 	                       uint visibility0, uint visibility1);
 
+	void pack_quantized_node(int idx,
+	                         const BoundBox& b0,
+	                         const BoundBox& b1,
+	                         int c0, int c1,
+	                         uint visibility0, uint visibility1);
+
 	void pack_unaligned_inner(const BVHStackEntry& e,
 	                          const BVHStackEntry& e0,
 	                          const BVHStackEntry& e1);
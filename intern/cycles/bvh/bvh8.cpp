@@ -0,0 +1,454 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh/bvh8.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "bvh/bvh_node.h"
+#include "bvh/bvh_unaligned.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Gather up to eight children of the given inner node.
+ *
+ * Starts with the two children of the binary node and keeps replacing the
+ * inner child with the largest surface area by its own two children, so the
+ * resulting node tightly encloses the most expensive parts of the subtree.
+ */
+static int node_obvh_children(const BVHNode *node, const BVHNode *children[8])
+{
+	int num_children = 2;
+	children[0] = node->get_child(0);
+	children[1] = node->get_child(1);
+	while(num_children < 8) {
+		int best_child = -1;
+		float best_area = -FLT_MAX;
+		for(int i = 0; i < num_children; ++i) {
+			if(children[i]->is_leaf()) {
+				continue;
+			}
+			const float area = children[i]->bounds.safe_area();
+			if(area > best_area) {
+				best_child = i;
+				best_area = area;
+			}
+		}
+		if(best_child == -1) {
+			break;
+		}
+		const BVHNode *split_node = children[best_child];
+		children[best_child] = split_node->get_child(0);
+		children[num_children++] = split_node->get_child(1);
+	}
+	return num_children;
+}
+
+static bool node_obvh_is_unaligned(const BVHNode *node)
+{
+	const BVHNode *children[8];
+	const int num_children = node_obvh_children(node, children);
+	for(int i = 0; i < num_children; ++i) {
+		if(children[i]->is_unaligned) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Count inner and leaf nodes of the collapsed tree, required to allocate
+ * the node arrays before packing.
+ */
+static void node_obvh_count(const BVHNode *node,
+                            size_t *num_aligned_nodes,
+                            size_t *num_unaligned_nodes,
+                            size_t *num_leaf_nodes)
+{
+	if(node->is_leaf()) {
+		++(*num_leaf_nodes);
+		return;
+	}
+	const BVHNode *children[8];
+	const int num_children = node_obvh_children(node, children);
+	bool has_unaligned = false;
+	for(int i = 0; i < num_children; ++i) {
+		has_unaligned |= children[i]->is_unaligned;
+		node_obvh_count(children[i],
+		                num_aligned_nodes,
+		                num_unaligned_nodes,
+		                num_leaf_nodes);
+	}
+	if(has_unaligned) {
+		++(*num_unaligned_nodes);
+	}
+	else {
+		++(*num_aligned_nodes);
+	}
+}
+
+/* Children data is stored in 8 wide components which span two float4. */
+static inline void node_obvh_set(float4 *data, int offset, int i, float value)
+{
+	data[offset + (i >> 2)][i & 3] = value;
+}
+
+BVH8::BVH8(const BVHParams& params_, const vector<Object*>& objects_)
+: BVH(params_, objects_)
+{
+	params.use_qbvh = true;
+	params.use_obvh = true;
+}
+
+void BVH8::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
+{
+	float4 data[BVH_ONODE_LEAF_SIZE];
+	memset(data, 0, sizeof(data));
+	if(leaf->num_triangles() == 1 && pack.prim_index[leaf->lo] == -1) {
+		/* object */
+		data[0].x = __int_as_float(~(leaf->lo));
+		data[0].y = __int_as_float(0);
+	}
+	else {
+		/* triangle */
+		data[0].x = __int_as_float(leaf->lo);
+		data[0].y = __int_as_float(leaf->hi);
+	}
+	data[0].z = __uint_as_float(leaf->visibility);
+	if(leaf->num_triangles() != 0) {
+		data[0].w = __uint_as_float(pack.prim_type[leaf->lo]);
+	}
+
+	memcpy(&pack.leaf_nodes[e.idx], data, sizeof(float4)*BVH_ONODE_LEAF_SIZE);
+}
+
+void BVH8::pack_inner(const BVHStackEntry& e,
+                      const BVHStackEntry *en,
+                      int num)
+{
+	bool has_unaligned = false;
+	if(params.use_unaligned_nodes) {
+		for(int i = 0; i < num; i++) {
+			if(en[i].node->is_unaligned) {
+				has_unaligned = true;
+				break;
+			}
+		}
+	}
+	if(has_unaligned) {
+		pack_unaligned_inner(e, en, num);
+	}
+	else {
+		pack_aligned_inner(e, en, num);
+	}
+}
+
+void BVH8::pack_aligned_inner(const BVHStackEntry& e,
+                              const BVHStackEntry *en,
+                              int num)
+{
+	BoundBox bounds[8];
+	int child[8];
+	for(int i = 0; i < num; ++i) {
+		bounds[i] = en[i].node->bounds;
+		child[i] = en[i].encodeIdx();
+	}
+	pack_aligned_node(e.idx,
+	                  bounds,
+	                  child,
+	                  e.node->visibility,
+	                  e.node->time_from,
+	                  e.node->time_to,
+	                  num);
+}
+
+void BVH8::pack_aligned_node(int idx,
+                             const BoundBox *bounds,
+                             const int *child,
+                             const uint visibility,
+                             const float time_from,
+                             const float time_to,
+                             const int num)
+{
+	float4 data[BVH_ONODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	for(int i = 0; i < num; i++) {
+		float3 bb_min = bounds[i].min;
+		float3 bb_max = bounds[i].max;
+
+		node_obvh_set(data, 2, i, bb_min.x);
+		node_obvh_set(data, 4, i, bb_max.x);
+		node_obvh_set(data, 6, i, bb_min.y);
+		node_obvh_set(data, 8, i, bb_max.y);
+		node_obvh_set(data, 10, i, bb_min.z);
+		node_obvh_set(data, 12, i, bb_max.z);
+
+		node_obvh_set(data, BVH_ONODE_CHILD_OFFSET, i, __int_as_float(child[i]));
+	}
+
+	for(int i = num; i < 8; i++) {
+		/* We store BB which would never be recorded as intersection
+		 * so kernel might safely assume there are always 8 child nodes.
+		 */
+		node_obvh_set(data, 2, i, FLT_MAX);
+		node_obvh_set(data, 4, i, -FLT_MAX);
+		node_obvh_set(data, 6, i, FLT_MAX);
+		node_obvh_set(data, 8, i, -FLT_MAX);
+		node_obvh_set(data, 10, i, FLT_MAX);
+		node_obvh_set(data, 12, i, -FLT_MAX);
+
+		node_obvh_set(data, BVH_ONODE_CHILD_OFFSET, i, __int_as_float(0));
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_ONODE_SIZE);
+}
+
+void BVH8::pack_unaligned_inner(const BVHStackEntry& e,
+                                const BVHStackEntry *en,
+                                int num)
+{
+	Transform aligned_space[8];
+	BoundBox bounds[8];
+	int child[8];
+	for(int i = 0; i < num; ++i) {
+		aligned_space[i] = en[i].node->get_aligned_space();
+		bounds[i] = en[i].node->bounds;
+		child[i] = en[i].encodeIdx();
+	}
+	pack_unaligned_node(e.idx,
+	                    aligned_space,
+	                    bounds,
+	                    child,
+	                    e.node->visibility,
+	                    e.node->time_from,
+	                    e.node->time_to,
+	                    num);
+}
+
+void BVH8::pack_unaligned_node(int idx,
+                               const Transform *aligned_space,
+                               const BoundBox *bounds,
+                               const int *child,
+                               const uint visibility,
+                               const float time_from,
+                               const float time_to,
+                               const int num)
+{
+	float4 data[BVH_UNALIGNED_ONODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float(visibility | PATH_RAY_NODE_UNALIGNED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	for(int i = 0; i < num; i++) {
+		Transform space = BVHUnaligned::compute_node_transform(
+		        bounds[i],
+		        aligned_space[i]);
+
+		node_obvh_set(data, 2, i, space.x.x);
+		node_obvh_set(data, 4, i, space.x.y);
+		node_obvh_set(data, 6, i, space.x.z);
+
+		node_obvh_set(data, 8, i, space.y.x);
+		node_obvh_set(data, 10, i, space.y.y);
+		node_obvh_set(data, 12, i, space.y.z);
+
+		node_obvh_set(data, 14, i, space.z.x);
+		node_obvh_set(data, 16, i, space.z.y);
+		node_obvh_set(data, 18, i, space.z.z);
+
+		node_obvh_set(data, 20, i, space.x.w);
+		node_obvh_set(data, 22, i, space.y.w);
+		node_obvh_set(data, 24, i, space.z.w);
+
+		node_obvh_set(data, BVH_UNALIGNED_ONODE_CHILD_OFFSET, i, __int_as_float(child[i]));
+	}
+
+	for(int i = num; i < 8; i++) {
+		/* We store BB which would never be recorded as intersection
+		 * so kernel might safely assume there are always 8 child nodes.
+		 */
+		for(int offset = 2; offset < BVH_UNALIGNED_ONODE_CHILD_OFFSET; offset += 2) {
+			node_obvh_set(data, offset, i, NAN);
+		}
+
+		node_obvh_set(data, BVH_UNALIGNED_ONODE_CHILD_OFFSET, i, __int_as_float(0));
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_UNALIGNED_ONODE_SIZE);
+}
+
+/* Octo SIMD Nodes */
+
+void BVH8::pack_nodes(const BVHNode *root)
+{
+	/* Calculate size of the arrays required. */
+	size_t num_aligned_nodes = 0,
+	       num_unaligned_nodes = 0,
+	       num_leaf_nodes = 0;
+	node_obvh_count(root,
+	                &num_aligned_nodes,
+	                &num_unaligned_nodes,
+	                &num_leaf_nodes);
+	const size_t node_size = num_unaligned_nodes * BVH_UNALIGNED_ONODE_SIZE +
+	                         num_aligned_nodes * BVH_ONODE_SIZE;
+	/* Resize arrays. */
+	pack.nodes.clear();
+	pack.leaf_nodes.clear();
+	/* For top level BVH, first merge existing BVH's so we know the offsets. */
+	if(params.top_level) {
+		pack_instances(node_size, num_leaf_nodes*BVH_ONODE_LEAF_SIZE);
+	}
+	else {
+		pack.nodes.resize(node_size);
+		pack.leaf_nodes.resize(num_leaf_nodes*BVH_ONODE_LEAF_SIZE);
+	}
+
+	int nextNodeIdx = 0, nextLeafNodeIdx = 0;
+
+	vector<BVHStackEntry> stack;
+	stack.reserve(BVHParams::MAX_DEPTH*8);
+	if(root->is_leaf()) {
+		stack.push_back(BVHStackEntry(root, nextLeafNodeIdx++));
+	}
+	else {
+		stack.push_back(BVHStackEntry(root, nextNodeIdx));
+		nextNodeIdx += node_obvh_is_unaligned(root)
+		                       ? BVH_UNALIGNED_ONODE_SIZE
+		                       : BVH_ONODE_SIZE;
+	}
+
+	while(stack.size()) {
+		BVHStackEntry e = stack.back();
+		stack.pop_back();
+
+		if(e.node->is_leaf()) {
+			/* leaf node */
+			const LeafNode *leaf = reinterpret_cast<const LeafNode*>(e.node);
+			pack_leaf(e, leaf);
+		}
+		else {
+			/* Inner node, collect collapsed children. */
+			const BVHNode *nodes[8];
+			const int numnodes = node_obvh_children(e.node, nodes);
+			/* Push entries on the stack. */
+			for(int i = 0; i < numnodes; ++i) {
+				int idx;
+				if(nodes[i]->is_leaf()) {
+					idx = nextLeafNodeIdx++;
+				}
+				else {
+					idx = nextNodeIdx;
+					nextNodeIdx += node_obvh_is_unaligned(nodes[i])
+					                       ? BVH_UNALIGNED_ONODE_SIZE
+					                       : BVH_ONODE_SIZE;
+				}
+				stack.push_back(BVHStackEntry(nodes[i], idx));
+			}
+			/* Set node. */
+			pack_inner(e, &stack[stack.size()-numnodes], numnodes);
+		}
+	}
+	assert(node_size == nextNodeIdx);
+	/* Root index to start traversal at, to handle case of single leaf node. */
+	pack.root_index = (root->is_leaf())? -1: 0;
+}
+
+void BVH8::refit_nodes()
+{
+	assert(!params.top_level);
+
+	BoundBox bbox = BoundBox::empty;
+	uint visibility = 0;
+	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
+}
+
+void BVH8::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
+{
+	if(leaf) {
+		/* Refit leaf node. */
+		int4 *data = &pack.leaf_nodes[idx];
+		int4 c = data[0];
+
+		BVH::refit_primitives(c.x, c.y, bbox, visibility);
+
+		float4 leaf_data[BVH_ONODE_LEAF_SIZE];
+		leaf_data[0].x = __int_as_float(c.x);
+		leaf_data[0].y = __int_as_float(c.y);
+		leaf_data[0].z = __uint_as_float(visibility);
+		leaf_data[0].w = __uint_as_float(c.w);
+		memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4)*BVH_ONODE_LEAF_SIZE);
+	}
+	else {
+		int4 *data = &pack.nodes[idx];
+		bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+		const int child_offset = is_unaligned
+		                                 ? BVH_UNALIGNED_ONODE_CHILD_OFFSET
+		                                 : BVH_ONODE_CHILD_OFFSET;
+		int c[8];
+		for(int i = 0; i < 8; ++i) {
+			c[i] = data[child_offset + (i >> 2)][i & 3];
+		}
+		/* Refit inner node, set bbox from children. Used children are always
+		 * packed first, unused slots have zero index.
+		 */
+		BoundBox child_bbox[8];
+		uint child_visibility[8] = {0};
+		int num_nodes = 0;
+		for(int i = 0; i < 8; ++i) {
+			child_bbox[i] = BoundBox::empty;
+			if(c[i] != 0) {
+				refit_node((c[i] < 0)? -c[i]-1: c[i], (c[i] < 0),
+				           child_bbox[i], child_visibility[i]);
+				++num_nodes;
+				bbox.grow(child_bbox[i]);
+				visibility |= child_visibility[i];
+			}
+		}
+
+		if(is_unaligned) {
+			Transform aligned_space[8];
+			for(int i = 0; i < 8; ++i) {
+				aligned_space[i] = transform_identity();
+			}
+			pack_unaligned_node(idx,
+			                    aligned_space,
+			                    child_bbox,
+			                    c,
+			                    visibility,
+			                    0.0f,
+			                    1.0f,
+			                    num_nodes);
+		}
+		else {
+			pack_aligned_node(idx,
+			                  child_bbox,
+			                  c,
+			                  visibility,
+			                  0.0f,
+			                  1.0f,
+			                  num_nodes);
+		}
+	}
+}
+
+CCL_NAMESPACE_END
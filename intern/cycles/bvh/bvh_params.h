@@ -53,6 +53,14 @@ public:
 	/* QBVH */
 	bool use_qbvh;
 
+	/* OBVH, 8 wide nodes for AVX2 traversal, takes precedence over QBVH. */
+	bool use_obvh;
+
+	/* Compact storage, quantized bounds in BVH2 nodes and no per triangle
+	 * copy of the vertices, the kernel reads them through the vertex index
+	 * buffer instead. */
+	bool use_compact_storage;
+
 	/* Mask of primitives to be included into the BVH. */
 	int primitive_mask;
 
@@ -99,7 +107,9 @@ public:
 
 		top_level = false;
 		use_qbvh = false;
+		use_obvh = false;
 		use_unaligned_nodes = false;
+		use_compact_storage = false;
 
 		primitive_mask = PRIMITIVE_ALL;
 
@@ -23,6 +23,7 @@
 #include "device/device_task.h"
 
 #include "util/util_list.h"
+#include "util/util_profiling.h"
 #include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_thread.h"
@@ -58,6 +59,7 @@ public:
 	bool has_half_images;        /* Support half-float textures. */
 	bool has_volume_decoupled;   /* Decoupled volume shading. */
 	bool has_qbvh;               /* Supports both BVH2 and BVH4 raytracing. */
+	bool has_obvh;               /* Supports BVH8 raytracing as well. */
 	bool has_osl;                /* Support Open Shading Language. */
 	bool use_split_kernel;       /* Use split or mega kernel. */
 	int cpu_threads;
@@ -75,6 +77,7 @@ public:
 		has_half_images = false;
 		has_volume_decoupled = false;
 		has_qbvh = false;
+		has_obvh = false;
 		has_osl = false;
 		use_split_kernel = false;
 	}
@@ -249,7 +252,7 @@ struct DeviceDrawParams {
 class Device {
 	friend class device_sub_ptr;
 protected:
-	Device(DeviceInfo& info_, Stats &stats_, bool background) : background(background), vertex_buffer(0), info(info_), stats(stats_) {}
+	Device(DeviceInfo& info_, Stats &stats_, Profiler &profiler_, bool background) : background(background), vertex_buffer(0), info(info_), stats(stats_), profiler(profiler_) {}
 
 	bool background;
 	string error_msg;
@@ -284,6 +287,7 @@ public:
 
 	/* statistics */
 	Stats &stats;
+	Profiler &profiler;
 
 	/* memory alignment */
 	virtual int mem_address_alignment() { return 16; }
@@ -322,7 +326,7 @@ public:
 	virtual void unmap_neighbor_tiles(Device * /*sub_device*/, RenderTile * /*tiles*/) {}
 
 	/* static */
-	static Device *create(DeviceInfo& info, Stats &stats, bool background = true);
+	static Device *create(DeviceInfo& info, Stats &stats, Profiler &profiler, bool background = true);
 
 	static DeviceType type_from_string(const char *name);
 	static string string_from_type(DeviceType type);
@@ -51,6 +51,7 @@
 #include "util/util_optimization.h"
 #include "util/util_progress.h"
 #include "util/util_system.h"
+#include "util/util_texture_cache.h"
 #include "util/util_thread.h"
 
 CCL_NAMESPACE_BEGIN
@@ -171,10 +172,14 @@ public:
 #endif
 
 	bool use_split_kernel;
+	bool use_ray_stream;
 
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        path_trace_stream_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_stopping_kernel;
+	KernelFunctions<int(*)(KernelGlobals *, float *, int, int, int, int, int)>              adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, int, int, int, int, int)>   shader_kernel;
@@ -207,11 +212,14 @@ public:
 	      KERNEL_NAME_EVAL(cpu_avx, name), \
 	      KERNEL_NAME_EVAL(cpu_avx2, name)
 
-	CPUDevice(DeviceInfo& info_, Stats &stats_, bool background_)
-	: Device(info_, stats_, background_),
+	CPUDevice(DeviceInfo& info_, Stats &stats_, Profiler &profiler_, bool background_)
+	: Device(info_, stats_, profiler_, background_),
 	  texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_stream),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -234,13 +242,26 @@ public:
 			info.cpu_threads = TaskScheduler::num_threads();
 		}
 
+		/* Debug flags might have disabled the AVX2 kernel after devices were
+		 * enumerated, OBVH can only be used when it is selected. Ray streams
+		 * are traced through the QBVH.
+		 */
+		info.has_obvh = info.has_obvh && system_cpu_support_avx2() && !DebugFlags().cpu.ray_stream;
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
+		kernel_globals.texture_cache_thread = NULL;
 		use_split_kernel = DebugFlags().cpu.split_kernel;
 		if(use_split_kernel) {
 			VLOG(1) << "Will be using split kernel.";
 		}
+		use_ray_stream = DebugFlags().cpu.ray_stream && !use_split_kernel;
+		if(use_ray_stream) {
+			VLOG(1) << "Will be tracing rays in streams of " << RAY_STREAM_SIZE << ".";
+		}
+		kernel_globals.use_ray_stream = use_ray_stream;
+		kernel_globals.shadow_stream = NULL;
 		need_texture_info = false;
 
 #define REGISTER_SPLIT_KERNEL(name) split_kernels[#name] = KernelFunctions<void(*)(KernelGlobals*, KernelData*)>(KERNEL_FUNCTIONS(name))
@@ -411,6 +432,18 @@ public:
 			info.width = mem.data_width;
 			info.height = mem.data_height;
 			info.depth = mem.data_depth;
+			info.use_cache = 0;
+
+			if(mem.texture_cache_image) {
+				/* Pixels are loaded on demand, host memory only has a
+				 * placeholder. */
+				TextureCacheImage *image = mem.texture_cache_image;
+				info.data = (uint64_t)image;
+				info.width = image->width;
+				info.height = image->height;
+				info.depth = 1;
+				info.use_cache = 1;
+			}
 
 			need_texture_info = true;
 		}
@@ -699,6 +732,15 @@ public:
 			}
 
 			for(int y = tile.y; y < tile.y + tile.h; y++) {
+				if(use_ray_stream) {
+					for(int x = tile.x; x < tile.x + tile.w; x += RAY_STREAM_SIZE) {
+						int num_pixels = min(RAY_STREAM_SIZE, tile.x + tile.w - x);
+						path_trace_stream_kernel()(kg, render_buffer,
+						                           sample, x, y, num_pixels, tile.offset, tile.stride);
+					}
+					continue;
+				}
+
 				for(int x = tile.x; x < tile.x + tile.w; x++) {
 					path_trace_kernel()(kg, render_buffer,
 					                    sample, x, y, tile.offset, tile.stride);
@@ -708,6 +750,59 @@ public:
 			tile.sample = sample + 1;
 
 			task.update_progress(&tile, tile.w*tile.h);
+
+			if(task.adaptive_sampling && adaptive_stopping(task, tile, kg)) {
+				/* Retire the tile early, counting the samples it skips. */
+				task.update_progress(&tile, (end_sample - tile.sample)*tile.w*tile.h);
+				tile.sample = end_sample;
+				break;
+			}
+		}
+
+		if(task.adaptive_sampling && tile.sample == end_sample) {
+			adaptive_adjust_samples(task, tile, kg);
+		}
+	}
+
+	/* Tests convergence of the pixels of the tile, returns true when all of
+	 * them have converged. */
+	bool adaptive_stopping(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
+	{
+		int num_samples = tile.sample - tile.start_sample;
+
+		if(num_samples < task.adaptive_min_samples || num_samples % task.adaptive_step != 0) {
+			return false;
+		}
+
+		float *render_buffer = (float*)tile.buffer;
+		bool converged = true;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				converged &= adaptive_stopping_kernel()(kg, render_buffer,
+				                                        num_samples, x, y, tile.offset, tile.stride);
+			}
+		}
+
+		return converged;
+	}
+
+	/* Scales pixels which stopped early to the sample count of the tile. */
+	void adaptive_adjust_samples(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		int num_samples = tile.num_samples;
+		uint64_t skipped_samples = 0;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				skipped_samples += adaptive_adjust_samples_kernel()(kg, render_buffer,
+				                                                    num_samples, x, y, tile.offset, tile.stride);
+			}
+		}
+
+		if(task.update_skipped_samples) {
+			task.update_skipped_samples(skipped_samples);
 		}
 	}
 
@@ -754,10 +849,13 @@ public:
 
 		KernelGlobals *kg = new ((void*) kgbuffer.device_pointer) KernelGlobals(thread_kernel_globals_init());
 
+		profiler.add_state(&kg->profiler);
+
 		CPUSplitKernel *split_kernel = NULL;
 		if(use_split_kernel) {
 			split_kernel = new CPUSplitKernel(this);
 			if(!split_kernel->load_kernels(requested_features)) {
+				profiler.remove_state(&kg->profiler);
 				thread_kernel_globals_free((KernelGlobals*)kgbuffer.device_pointer);
 				kgbuffer.free();
 				delete split_kernel;
@@ -790,6 +888,8 @@ public:
 			}
 		}
 
+		profiler.remove_state(&kg->profiler);
+
 		thread_kernel_globals_free((KernelGlobals*)kgbuffer.device_pointer);
 		kg->~KernelGlobals();
 		kgbuffer.free();
@@ -818,6 +918,7 @@ public:
 	void thread_shader(DeviceTask& task)
 	{
 		KernelGlobals kg = kernel_globals;
+		kg.texture_cache_thread = new TextureCacheThread();
 
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
@@ -840,6 +941,8 @@ public:
 
 		}
 
+		delete kg.texture_cache_thread;
+
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
@@ -891,6 +994,7 @@ protected:
 			kg.decoupled_volume_steps[i] = NULL;
 		}
 		kg.decoupled_volume_steps_index = 0;
+		kg.texture_cache_thread = new TextureCacheThread();
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
@@ -913,6 +1017,7 @@ protected:
 				free(kg->decoupled_volume_steps[i]);
 			}
 		}
+		delete kg->texture_cache_thread;
 #ifdef WITH_OSL
 		OSLShader::thread_free(kg);
 #endif
@@ -1032,9 +1137,9 @@ uint64_t CPUSplitKernel::state_buffer_size(device_memory& kernel_globals, device
 	return split_data_buffer_size(kg, num_threads);
 }
 
-Device *device_cpu_create(DeviceInfo& info, Stats &stats, bool background)
+Device *device_cpu_create(DeviceInfo& info, Stats &stats, Profiler &profiler, bool background)
 {
-	return new CPUDevice(info, stats, background);
+	return new CPUDevice(info, stats, profiler, background);
 }
 
 void device_cpu_info(vector<DeviceInfo>& devices)
@@ -1047,6 +1152,10 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.num = 0;
 	info.advanced_shading = true;
 	info.has_qbvh = system_cpu_support_sse2();
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	/* Only the AVX2 kernel is compiled with OBVH traversal. */
+	info.has_obvh = system_cpu_support_avx2();
+#endif
 	info.has_volume_decoupled = true;
 	info.has_osl = true;
 	info.has_half_images = true;
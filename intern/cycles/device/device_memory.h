@@ -30,6 +30,7 @@
 CCL_NAMESPACE_BEGIN
 
 class Device;
+class TextureCacheImage;
 
 enum MemoryType {
 	MEM_READ_ONLY,
@@ -193,6 +194,9 @@ public:
 	InterpolationType interpolation;
 	ExtensionType extension;
 
+	/* Image loaded on demand by the texture cache, CPU only. */
+	TextureCacheImage *texture_cache_image;
+
 	/* Pointers. */
 	Device *device;
 	device_ptr device_pointer;
@@ -45,13 +45,13 @@ public:
 	list<SubDevice> devices;
 	device_ptr unique_key;
 
-	MultiDevice(DeviceInfo& info, Stats &stats, bool background_)
-	: Device(info, stats, background_), unique_key(1)
+	MultiDevice(DeviceInfo& info, Stats &stats, Profiler &profiler, bool background_)
+	: Device(info, stats, profiler, background_), unique_key(1)
 	{
 		Device *device;
 
 		foreach(DeviceInfo& subinfo, info.multi_devices) {
-			device = Device::create(subinfo, sub_stats_, background);
+			device = Device::create(subinfo, sub_stats_, profiler, background);
 			devices.push_back(SubDevice(device));
 		}
 
@@ -63,7 +63,7 @@ public:
 		vector<string> servers = discovery.get_server_list();
 
 		foreach(string& server, servers) {
-			device = device_network_create(info, stats, server.c_str());
+			device = device_network_create(info, stats, profiler, server.c_str());
 			if(device)
 				devices.push_back(SubDevice(device));
 		}
@@ -382,9 +382,9 @@ protected:
 	Stats sub_stats_;
 };
 
-Device *device_multi_create(DeviceInfo& info, Stats &stats, bool background)
+Device *device_multi_create(DeviceInfo& info, Stats &stats, Profiler &profiler, bool background)
 {
-	return new MultiDevice(info, stats, background);
+	return new MultiDevice(info, stats, profiler, background);
 }
 
 CCL_NAMESPACE_END
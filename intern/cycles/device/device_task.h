@@ -62,6 +62,7 @@ public:
 
 	function<bool(Device *device, RenderTile&)> acquire_tile;
 	function<void(long, int)> update_progress_sample;
+	function<void(uint64_t)> update_skipped_samples;
 	function<void(RenderTile&)> update_tile_sample;
 	function<void(RenderTile&)> release_tile;
 	function<bool(void)> get_cancel;
@@ -76,6 +77,12 @@ public:
 	int pass_denoising_data;
 	int pass_denoising_clean;
 
+	/* Adaptive sampling: convergence of pixels is tested every adaptive_step
+	 * samples once adaptive_min_samples were taken. */
+	bool adaptive_sampling;
+	int adaptive_min_samples;
+	int adaptive_step;
+
 	bool need_finish_queue;
 	bool integrator_branched;
 	int2 requested_tile_size;
@@ -34,6 +34,16 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
+/* Ray stream traversal. */
+#ifdef __RAY_STREAM__
+#  include "kernel/bvh/qbvh_stream.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -201,6 +211,39 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __RAY_STREAM__
+/* Whether streams of rays can be traced together, otherwise they are traced
+ * one by one. */
+ccl_device_inline bool scene_intersect_stream_supported(KernelGlobals *kg)
+{
+	return kernel_data.bvh.use_qbvh &&
+	       !kernel_data.bvh.use_obvh &&
+	       !kernel_data.bvh.have_motion &&
+	       !kernel_data.bvh.have_curves;
+}
+
+/* Intersects a stream of up to RAY_STREAM_SIZE rays, returns the mask of the
+ * rays which hit anything. */
+ccl_device_intersect uint scene_intersect_stream(KernelGlobals *kg,
+                                                 const Ray *rays,
+                                                 Intersection *isects,
+                                                 const int num_rays,
+                                                 const uint visibility)
+{
+	if(scene_intersect_stream_supported(kg)) {
+		return qbvh_intersect_stream(kg, rays, isects, num_rays, visibility);
+	}
+
+	uint hit_mask = 0;
+	for(int i = 0; i < num_rays; i++) {
+		if(scene_intersect(kg, rays[i], visibility, &isects[i], NULL, 0.0f, 0.0f)) {
+			hit_mask |= (1u << i);
+		}
+	}
+	return hit_mask;
+}
+#endif  /* __RAY_STREAM__ */
+
 #ifdef __BVH_LOCAL__
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect void scene_intersect_local(KernelGlobals *kg,
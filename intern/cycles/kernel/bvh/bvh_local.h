@@ -17,14 +17,38 @@
  * limitations under the License.
  */
 
-#ifdef __QBVH__
-#  include "kernel/bvh/qbvh_local.h"
+#ifndef BVH_QUANTIZED_NODES
+#  ifdef __QBVH__
+#    include "kernel/bvh/qbvh_local.h"
+#  endif
+
+#  ifdef __OBVH__
+#    include "kernel/bvh/obvh_local.h"
+#  endif
+
+/* Separate variation for quantized nodes of compact storage, see
+ * bvh_nodes.h. */
+#  ifdef __KERNEL_SSE2__
+#    define BVH_QUANTIZED_NODES
+#    include "kernel/bvh/bvh_local.h"
+#    undef BVH_QUANTIZED_NODES
+#  endif
 #endif
 
-#if BVH_FEATURE(BVH_HAIR)
-#  define NODE_INTERSECT bvh_node_intersect
+#ifdef BVH_QUANTIZED_NODES
+#  define BVH2_FUNCTION_PREFIX COMPACT_BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect_quantized
+#  else
+#    define NODE_INTERSECT bvh_quantized_node_intersect
+#  endif
 #else
-#  define NODE_INTERSECT bvh_aligned_node_intersect
+#  define BVH2_FUNCTION_PREFIX BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect
+#  else
+#    define NODE_INTERSECT bvh_aligned_node_intersect
+#  endif
 #endif
 
 /* This is a template BVH traversal function for finding local intersections
@@ -41,12 +65,12 @@ ccl_device
 #else
 ccl_device_inline
 #endif
-void BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
-                                 const Ray *ray,
-                                 LocalIntersection *local_isect,
-                                 int local_object,
-                                 uint *lcg_state,
-                                 int max_hits)
+void BVH_FUNCTION_FULL_NAME(BVH2_FUNCTION_PREFIX)(KernelGlobals *kg,
+                                                  const Ray *ray,
+                                                  LocalIntersection *local_isect,
+                                                  int local_object,
+                                                  uint *lcg_state,
+                                                  int max_hits)
 {
 	/* todo:
 	 * - test if pushing distance on the stack helps (for non shadow rays)
@@ -236,6 +260,7 @@ void BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
 	} while(node_addr != ENTRYPOINT_SENTINEL);
 }
 
+#ifndef BVH_QUANTIZED_NODES
 ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const Ray *ray,
                                          LocalIntersection *local_isect,
@@ -243,6 +268,17 @@ ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          uint *lcg_state,
                                          int max_hits)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_obvh) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    local_isect,
+		                                    local_object,
+		                                    lcg_state,
+		                                    max_hits);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -253,6 +289,17 @@ ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
 		                                    max_hits);
 	}
 	else
+#endif
+#ifdef __KERNEL_SSE2__
+	if(kernel_data.bvh.use_compact_geometry) {
+		return BVH_FUNCTION_FULL_NAME(COMPACT_BVH)(kg,
+		                                           ray,
+		                                           local_isect,
+		                                           local_object,
+		                                           lcg_state,
+		                                           max_hits);
+	}
+	else
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
@@ -267,4 +314,7 @@ ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
 
 #undef BVH_FUNCTION_NAME
 #undef BVH_FUNCTION_FEATURES
+#endif  /* BVH_QUANTIZED_NODES */
+
+#undef BVH2_FUNCTION_PREFIX
 #undef NODE_INTERSECT
@@ -29,7 +29,50 @@ ccl_device_forceinline Transform bvh_unaligned_node_fetch_space(KernelGlobals *k
 	return space;
 }
 
+/* Quantized nodes store the child bounds per axis as 8 bit steps from the
+ * node origin, in the same order as the float bounds of aligned nodes, and
+ * the power of two step size per axis as float exponents. */
+ccl_device_forceinline void bvh_quantized_node_decode(KernelGlobals *kg,
+                                                      const int node_addr,
+                                                      float4 *node0,
+                                                      float4 *node1,
+                                                      float4 *node2)
+{
+	const float4 origin = kernel_tex_fetch(__bvh_nodes, node_addr+1);
+	const float4 quantized = kernel_tex_fetch(__bvh_nodes, node_addr+2);
+	const uint exponents = __float_as_uint(quantized.w);
+
+	*node0 = dequantize_bounds(__float_as_uint(quantized.x),
+	                           origin.x,
+	                           exponents & 0xff);
+	*node1 = dequantize_bounds(__float_as_uint(quantized.y),
+	                           origin.y,
+	                           (exponents >> 8) & 0xff);
+	*node2 = dequantize_bounds(__float_as_uint(quantized.z),
+	                           origin.z,
+	                           (exponents >> 16) & 0xff);
+}
+
 #if !defined(__KERNEL_SSE2__)
+/* Without SSE the node layout is checked per node, to avoid compiling extra
+ * variations of the traversal functions for GPUs. */
+ccl_device_forceinline void bvh_aligned_node_fetch_bounds(KernelGlobals *kg,
+                                                          const int node_addr,
+                                                          const float4 cnodes,
+                                                          float4 *node0,
+                                                          float4 *node1,
+                                                          float4 *node2)
+{
+	if(__float_as_uint(cnodes.x) & PATH_RAY_NODE_QUANTIZED) {
+		bvh_quantized_node_decode(kg, node_addr, node0, node1, node2);
+	}
+	else {
+		*node0 = kernel_tex_fetch(__bvh_nodes, node_addr+1);
+		*node1 = kernel_tex_fetch(__bvh_nodes, node_addr+2);
+		*node2 = kernel_tex_fetch(__bvh_nodes, node_addr+3);
+	}
+}
+
 ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
                                                       const float3 P,
                                                       const float3 idir,
@@ -41,9 +84,8 @@ ccl_device_forceinline int bvh_aligned_node_intersect(KernelGlobals *kg,
 
 	/* fetch node data */
 	float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
-	float4 node0 = kernel_tex_fetch(__bvh_nodes, node_addr+1);
-	float4 node1 = kernel_tex_fetch(__bvh_nodes, node_addr+2);
-	float4 node2 = kernel_tex_fetch(__bvh_nodes, node_addr+3);
+	float4 node0, node1, node2;
+	bvh_aligned_node_fetch_bounds(kg, node_addr, cnodes, &node0, &node1, &node2);
 
 	/* intersect ray against child nodes */
 	float c0lox = (node0.x - P.x) * idir.x;
@@ -90,9 +132,8 @@ ccl_device_forceinline int bvh_aligned_node_intersect_robust(KernelGlobals *kg,
 
 	/* fetch node data */
 	float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
-	float4 node0 = kernel_tex_fetch(__bvh_nodes, node_addr+1);
-	float4 node1 = kernel_tex_fetch(__bvh_nodes, node_addr+2);
-	float4 node2 = kernel_tex_fetch(__bvh_nodes, node_addr+3);
+	float4 node0, node1, node2;
+	bvh_aligned_node_fetch_bounds(kg, node_addr, cnodes, &node0, &node1, &node2);
 
 	/* intersect ray against child nodes */
 	float c0lox = (node0.x - P.x) * idir.x;
@@ -333,10 +374,39 @@ ccl_device_forceinline int bvh_node_intersect_robust(KernelGlobals *kg,
 }
 #else  /* !defined(__KERNEL_SSE2__) */
 
-int ccl_device_forceinline bvh_aligned_node_intersect(
+/* With SSE, a BVH2 with quantized nodes is traversed by separate variations
+ * of the traversal functions, so the bounds of aligned nodes are read without
+ * checking the node layout. */
+
+ccl_device_forceinline void bvh_quantized_node_fetch_bounds(KernelGlobals *kg,
+                                                            const int node_addr,
+                                                            ssef bounds[3])
+{
+#  ifdef __KERNEL_SSE41__
+	const ssef *bvh_nodes = (ssef*)kg->__bvh_nodes.data + node_addr;
+	const ssef origin = bvh_nodes[1];
+	const ssei quantized = cast(bvh_nodes[2]);
+	const uint exponents = (uint)extract<3>(quantized);
+	for(int axis = 0; axis < 3; axis++) {
+		const ssef steps = ssef(_mm_cvtepi32_ps(
+		        _mm_cvtepu8_epi32(_mm_cvtsi32_si128(quantized[axis]))));
+		const float scale = quantize_step_size((exponents >> (axis*8)) & 0xff);
+		bounds[axis] = madd(steps, ssef(scale), ssef(origin[axis]));
+	}
+#  else
+	bvh_quantized_node_decode(kg,
+	                          node_addr,
+	                          (float4*)&bounds[0],
+	                          (float4*)&bounds[1],
+	                          (float4*)&bounds[2]);
+#  endif
+}
+
+/* Intersect two child bounding boxes given in the layout of aligned nodes,
+ * SSE3 version adapted from Embree. */
+ccl_device_forceinline int bvh_node_bounds_intersect(
         KernelGlobals *kg,
-        const float3& P,
-        const float3& dir,
+        const ssef bounds[3],
         const ssef& tsplat,
         const ssef Psplat[3],
         const ssef idirsplat[3],
@@ -345,16 +415,12 @@ int ccl_device_forceinline bvh_aligned_node_intersect(
         const uint visibility,
         float dist[2])
 {
-	/* Intersect two child bounding boxes, SSE3 version adapted from Embree */
 	const ssef pn = cast(ssei(0, 0, 0x80000000, 0x80000000));
 
-	/* fetch node data */
-	const ssef *bvh_nodes = (ssef*)kg->__bvh_nodes.data + node_addr;
-
 	/* intersect ray against child nodes */
-	const ssef tminmaxx = (shuffle_swap(bvh_nodes[1], shufflexyz[0]) - Psplat[0]) * idirsplat[0];
-	const ssef tminmaxy = (shuffle_swap(bvh_nodes[2], shufflexyz[1]) - Psplat[1]) * idirsplat[1];
-	const ssef tminmaxz = (shuffle_swap(bvh_nodes[3], shufflexyz[2]) - Psplat[2]) * idirsplat[2];
+	const ssef tminmaxx = (shuffle_swap(bounds[0], shufflexyz[0]) - Psplat[0]) * idirsplat[0];
+	const ssef tminmaxy = (shuffle_swap(bounds[1], shufflexyz[1]) - Psplat[1]) * idirsplat[1];
+	const ssef tminmaxz = (shuffle_swap(bounds[2], shufflexyz[2]) - Psplat[2]) * idirsplat[2];
 
 	/* calculate { c0min, c1min, -c0max, -c1max} */
 	ssef minmax = max(max(tminmaxx, tminmaxy), max(tminmaxz, tsplat));
@@ -377,10 +443,9 @@ int ccl_device_forceinline bvh_aligned_node_intersect(
 #  endif
 }
 
-ccl_device_forceinline int bvh_aligned_node_intersect_robust(
+ccl_device_forceinline int bvh_node_bounds_intersect_robust(
         KernelGlobals *kg,
-        const float3& P,
-        const float3& dir,
+        const ssef bounds[3],
         const ssef& tsplat,
         const ssef Psplat[3],
         const ssef idirsplat[3],
@@ -391,16 +456,12 @@ ccl_device_forceinline int bvh_aligned_node_intersect_robust(
         const uint visibility,
         float dist[2])
 {
-	/* Intersect two child bounding boxes, SSE3 version adapted from Embree */
 	const ssef pn = cast(ssei(0, 0, 0x80000000, 0x80000000));
 
-	/* fetch node data */
-	const ssef *bvh_nodes = (ssef*)kg->__bvh_nodes.data + nodeAddr;
-
 	/* intersect ray against child nodes */
-	const ssef tminmaxx = (shuffle_swap(bvh_nodes[1], shufflexyz[0]) - Psplat[0]) * idirsplat[0];
-	const ssef tminmaxy = (shuffle_swap(bvh_nodes[2], shufflexyz[1]) - Psplat[1]) * idirsplat[1];
-	const ssef tminmaxz = (shuffle_swap(bvh_nodes[3], shufflexyz[2]) - Psplat[2]) * idirsplat[2];
+	const ssef tminmaxx = (shuffle_swap(bounds[0], shufflexyz[0]) - Psplat[0]) * idirsplat[0];
+	const ssef tminmaxy = (shuffle_swap(bounds[1], shufflexyz[1]) - Psplat[1]) * idirsplat[1];
+	const ssef tminmaxz = (shuffle_swap(bounds[2], shufflexyz[2]) - Psplat[2]) * idirsplat[2];
 
 	/* calculate { c0min, c1min, -c0max, -c1max} */
 	ssef minmax = max(max(tminmaxx, tminmaxy), max(tminmaxz, tsplat));
@@ -441,6 +502,118 @@ ccl_device_forceinline int bvh_aligned_node_intersect_robust(
 #  endif
 }
 
+int ccl_device_forceinline bvh_aligned_node_intersect(
+        KernelGlobals *kg,
+        const float3& P,
+        const float3& dir,
+        const ssef& tsplat,
+        const ssef Psplat[3],
+        const ssef idirsplat[3],
+        const shuffle_swap_t shufflexyz[3],
+        const int node_addr,
+        const uint visibility,
+        float dist[2])
+{
+	/* fetch node data */
+	const ssef *bvh_nodes = (ssef*)kg->__bvh_nodes.data + node_addr;
+
+	return bvh_node_bounds_intersect(kg,
+	                                 bvh_nodes + 1,
+	                                 tsplat,
+	                                 Psplat,
+	                                 idirsplat,
+	                                 shufflexyz,
+	                                 node_addr,
+	                                 visibility,
+	                                 dist);
+}
+
+ccl_device_forceinline int bvh_aligned_node_intersect_robust(
+        KernelGlobals *kg,
+        const float3& P,
+        const float3& dir,
+        const ssef& tsplat,
+        const ssef Psplat[3],
+        const ssef idirsplat[3],
+        const shuffle_swap_t shufflexyz[3],
+        const float difl,
+        const float extmax,
+        const int nodeAddr,
+        const uint visibility,
+        float dist[2])
+{
+	/* fetch node data */
+	const ssef *bvh_nodes = (ssef*)kg->__bvh_nodes.data + nodeAddr;
+
+	return bvh_node_bounds_intersect_robust(kg,
+	                                        bvh_nodes + 1,
+	                                        tsplat,
+	                                        Psplat,
+	                                        idirsplat,
+	                                        shufflexyz,
+	                                        difl,
+	                                        extmax,
+	                                        nodeAddr,
+	                                        visibility,
+	                                        dist);
+}
+
+ccl_device_forceinline int bvh_quantized_node_intersect(
+        KernelGlobals *kg,
+        const float3& P,
+        const float3& dir,
+        const ssef& tsplat,
+        const ssef Psplat[3],
+        const ssef idirsplat[3],
+        const shuffle_swap_t shufflexyz[3],
+        const int node_addr,
+        const uint visibility,
+        float dist[2])
+{
+	ssef bounds[3];
+	bvh_quantized_node_fetch_bounds(kg, node_addr, bounds);
+
+	return bvh_node_bounds_intersect(kg,
+	                                 bounds,
+	                                 tsplat,
+	                                 Psplat,
+	                                 idirsplat,
+	                                 shufflexyz,
+	                                 node_addr,
+	                                 visibility,
+	                                 dist);
+}
+
+ccl_device_forceinline int bvh_quantized_node_intersect_robust(
+        KernelGlobals *kg,
+        const float3& P,
+        const float3& dir,
+        const ssef& tsplat,
+        const ssef Psplat[3],
+        const ssef idirsplat[3],
+        const shuffle_swap_t shufflexyz[3],
+        const float difl,
+        const float extmax,
+        const int nodeAddr,
+        const uint visibility,
+        float dist[2])
+{
+	ssef bounds[3];
+	bvh_quantized_node_fetch_bounds(kg, nodeAddr, bounds);
+
+	return bvh_node_bounds_intersect_robust(kg,
+	                                        bounds,
+	                                        tsplat,
+	                                        Psplat,
+	                                        idirsplat,
+	                                        shufflexyz,
+	                                        difl,
+	                                        extmax,
+	                                        nodeAddr,
+	                                        visibility,
+	                                        dist);
+}
+
 ccl_device_forceinline int bvh_unaligned_node_intersect(KernelGlobals *kg,
                                                         const float3 P,
                                                         const float3 dir,
@@ -653,4 +826,84 @@ ccl_device_forceinline int bvh_node_intersect_robust(KernelGlobals *kg,
 		                                         dist);
 	}
 }
+ccl_device_forceinline int bvh_node_intersect_quantized(KernelGlobals *kg,
+                                                        const float3& P,
+                                                        const float3& dir,
+                                                        const ssef& isect_near,
+                                                        const ssef& isect_far,
+                                                        const ssef& tsplat,
+                                                        const ssef Psplat[3],
+                                                        const ssef idirsplat[3],
+                                                        const shuffle_swap_t shufflexyz[3],
+                                                        const int node_addr,
+                                                        const uint visibility,
+                                                        float dist[2])
+{
+	float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return bvh_unaligned_node_intersect(kg,
+		                                    P,
+		                                    dir,
+		                                    isect_near,
+		                                    isect_far,
+		                                    node_addr,
+		                                    visibility,
+		                                    dist);
+	}
+	else {
+		return bvh_quantized_node_intersect(kg,
+		                                    P,
+		                                    dir,
+		                                    tsplat,
+		                                    Psplat,
+		                                    idirsplat,
+		                                    shufflexyz,
+		                                    node_addr,
+		                                    visibility,
+		                                    dist);
+	}
+}
+
+ccl_device_forceinline int bvh_node_intersect_quantized_robust(KernelGlobals *kg,
+                                                               const float3& P,
+                                                               const float3& dir,
+                                                               const ssef& isect_near,
+                                                               const ssef& isect_far,
+                                                               const ssef& tsplat,
+                                                               const ssef Psplat[3],
+                                                               const ssef idirsplat[3],
+                                                               const shuffle_swap_t shufflexyz[3],
+                                                               const float difl,
+                                                               const float extmax,
+                                                               const int node_addr,
+                                                               const uint visibility,
+                                                               float dist[2])
+{
+	float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return bvh_unaligned_node_intersect_robust(kg,
+		                                           P,
+		                                           dir,
+		                                           isect_near,
+		                                           isect_far,
+		                                           difl,
+		                                           node_addr,
+		                                           visibility,
+		                                           dist);
+	}
+	else {
+		return bvh_quantized_node_intersect_robust(kg,
+		                                           P,
+		                                           dir,
+		                                           tsplat,
+		                                           Psplat,
+		                                           idirsplat,
+		                                           shufflexyz,
+		                                           difl,
+		                                           extmax,
+		                                           node_addr,
+		                                           visibility,
+		                                           dist);
+	}
+}
 #endif  /* !defined(__KERNEL_SSE2__) */
@@ -17,14 +17,38 @@
  * limitations under the License.
  */
 
-#ifdef __QBVH__
-#  include "kernel/bvh/qbvh_shadow_all.h"
+#ifndef BVH_QUANTIZED_NODES
+#  ifdef __QBVH__
+#    include "kernel/bvh/qbvh_shadow_all.h"
+#  endif
+
+#  ifdef __OBVH__
+#    include "kernel/bvh/obvh_shadow_all.h"
+#  endif
+
+/* Separate variation for quantized nodes of compact storage, see
+ * bvh_nodes.h. */
+#  ifdef __KERNEL_SSE2__
+#    define BVH_QUANTIZED_NODES
+#    include "kernel/bvh/bvh_shadow_all.h"
+#    undef BVH_QUANTIZED_NODES
+#  endif
 #endif
 
-#if BVH_FEATURE(BVH_HAIR)
-#  define NODE_INTERSECT bvh_node_intersect
+#ifdef BVH_QUANTIZED_NODES
+#  define BVH2_FUNCTION_PREFIX COMPACT_BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect_quantized
+#  else
+#    define NODE_INTERSECT bvh_quantized_node_intersect
+#  endif
 #else
-#  define NODE_INTERSECT bvh_aligned_node_intersect
+#  define BVH2_FUNCTION_PREFIX BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect
+#  else
+#    define NODE_INTERSECT bvh_aligned_node_intersect
+#  endif
 #endif
 
 /* This is a template BVH traversal function, where various features can be
@@ -42,12 +66,12 @@ ccl_device
 #else
 ccl_device_inline
 #endif
-bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
-                                 const Ray *ray,
-                                 Intersection *isect_array,
-                                 const uint visibility,
-                                 const uint max_hits,
-                                 uint *num_hits)
+bool BVH_FUNCTION_FULL_NAME(BVH2_FUNCTION_PREFIX)(KernelGlobals *kg,
+                                                  const Ray *ray,
+                                                  Intersection *isect_array,
+                                                  const uint visibility,
+                                                  const uint max_hits,
+                                                  uint *num_hits)
 {
 	/* todo:
 	 * - likely and unlikely for if() statements
@@ -388,6 +412,7 @@ bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
 	return false;
 }
 
+#ifndef BVH_QUANTIZED_NODES
 ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const Ray *ray,
                                          Intersection *isect_array,
@@ -395,6 +420,17 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const uint max_hits,
                                          uint *num_hits)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_obvh) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect_array,
+		                                    visibility,
+		                                    max_hits,
+		                                    num_hits);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -405,6 +441,17 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 		                                    num_hits);
 	}
 	else
+#endif
+#ifdef __KERNEL_SSE2__
+	if(kernel_data.bvh.use_compact_geometry) {
+		return BVH_FUNCTION_FULL_NAME(COMPACT_BVH)(kg,
+		                                           ray,
+		                                           isect_array,
+		                                           visibility,
+		                                           max_hits,
+		                                           num_hits);
+	}
+	else
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
@@ -419,4 +466,7 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 
 #undef BVH_FUNCTION_NAME
 #undef BVH_FUNCTION_FEATURES
+#endif  /* BVH_QUANTIZED_NODES */
+
+#undef BVH2_FUNCTION_PREFIX
 #undef NODE_INTERSECT
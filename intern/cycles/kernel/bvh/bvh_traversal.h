@@ -17,16 +17,42 @@
  * limitations under the License.
  */
 
-#ifdef __QBVH__
-#  include "kernel/bvh/qbvh_traversal.h"
+#ifndef BVH_QUANTIZED_NODES
+#  ifdef __QBVH__
+#    include "kernel/bvh/qbvh_traversal.h"
+#  endif
+
+#  ifdef __OBVH__
+#    include "kernel/bvh/obvh_traversal.h"
+#  endif
+
+/* Separate variation for quantized nodes of compact storage, see
+ * bvh_nodes.h. */
+#  ifdef __KERNEL_SSE2__
+#    define BVH_QUANTIZED_NODES
+#    include "kernel/bvh/bvh_traversal.h"
+#    undef BVH_QUANTIZED_NODES
+#  endif
 #endif
 
-#if BVH_FEATURE(BVH_HAIR)
-#  define NODE_INTERSECT bvh_node_intersect
-#  define NODE_INTERSECT_ROBUST bvh_node_intersect_robust
+#ifdef BVH_QUANTIZED_NODES
+#  define BVH2_FUNCTION_PREFIX COMPACT_BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect_quantized
+#    define NODE_INTERSECT_ROBUST bvh_node_intersect_quantized_robust
+#  else
+#    define NODE_INTERSECT bvh_quantized_node_intersect
+#    define NODE_INTERSECT_ROBUST bvh_quantized_node_intersect_robust
+#  endif
 #else
-#  define NODE_INTERSECT bvh_aligned_node_intersect
-#  define NODE_INTERSECT_ROBUST bvh_aligned_node_intersect_robust
+#  define BVH2_FUNCTION_PREFIX BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect
+#    define NODE_INTERSECT_ROBUST bvh_node_intersect_robust
+#  else
+#    define NODE_INTERSECT bvh_aligned_node_intersect
+#    define NODE_INTERSECT_ROBUST bvh_aligned_node_intersect_robust
+#  endif
 #endif
 
 /* This is a template BVH traversal function, where various features can be
@@ -40,16 +66,16 @@
  *
  */
 
-ccl_device_noinline bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
-                                                     const Ray *ray,
-                                                     Intersection *isect,
-                                                     const uint visibility
+ccl_device_noinline bool BVH_FUNCTION_FULL_NAME(BVH2_FUNCTION_PREFIX)(KernelGlobals *kg,
+                                                                      const Ray *ray,
+                                                                      Intersection *isect,
+                                                                      const uint visibility
 #if BVH_FEATURE(BVH_HAIR_MINIMUM_WIDTH)
-                                                     , uint *lcg_state,
-                                                     float difl,
-                                                     float extmax
+                                                                      , uint *lcg_state,
+                                                                      float difl,
+                                                                      float extmax
 #endif
-                                                     )
+                                                                      )
 {
 	/* todo:
 	 * - test if pushing distance on the stack helps (for non shadow rays)
@@ -415,6 +441,7 @@ ccl_device_noinline bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
 	return (isect->prim != PRIM_NONE);
 }
 
+#ifndef BVH_QUANTIZED_NODES
 ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const Ray *ray,
                                          Intersection *isect,
@@ -426,6 +453,21 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
                                          )
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_obvh) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect,
+		                                    visibility
+#if BVH_FEATURE(BVH_HAIR_MINIMUM_WIDTH)
+		                                    , lcg_state,
+		                                    difl,
+		                                    extmax
+#endif
+		                                    );
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -440,6 +482,21 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 		                                    );
 	}
 	else
+#endif
+#ifdef __KERNEL_SSE2__
+	if(kernel_data.bvh.use_compact_geometry) {
+		return BVH_FUNCTION_FULL_NAME(COMPACT_BVH)(kg,
+		                                           ray,
+		                                           isect,
+		                                           visibility
+#if BVH_FEATURE(BVH_HAIR_MINIMUM_WIDTH)
+		                                           , lcg_state,
+		                                           difl,
+		                                           extmax
+#endif
+		                                           );
+	}
+	else
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
@@ -458,5 +515,8 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 
 #undef BVH_FUNCTION_NAME
 #undef BVH_FUNCTION_FEATURES
+#endif  /* BVH_QUANTIZED_NODES */
+
+#undef BVH2_FUNCTION_PREFIX
 #undef NODE_INTERSECT
 #undef NODE_INTERSECT_ROBUST
@@ -17,14 +17,38 @@
  * limitations under the License.
  */
 
-#ifdef __QBVH__
-#  include "kernel/bvh/qbvh_volume.h"
+#ifndef BVH_QUANTIZED_NODES
+#  ifdef __QBVH__
+#    include "kernel/bvh/qbvh_volume.h"
+#  endif
+
+#  ifdef __OBVH__
+#    include "kernel/bvh/obvh_volume.h"
+#  endif
+
+/* Separate variation for quantized nodes of compact storage, see
+ * bvh_nodes.h. */
+#  ifdef __KERNEL_SSE2__
+#    define BVH_QUANTIZED_NODES
+#    include "kernel/bvh/bvh_volume.h"
+#    undef BVH_QUANTIZED_NODES
+#  endif
 #endif
 
-#if BVH_FEATURE(BVH_HAIR)
-#  define NODE_INTERSECT bvh_node_intersect
+#ifdef BVH_QUANTIZED_NODES
+#  define BVH2_FUNCTION_PREFIX COMPACT_BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect_quantized
+#  else
+#    define NODE_INTERSECT bvh_quantized_node_intersect
+#  endif
 #else
-#  define NODE_INTERSECT bvh_aligned_node_intersect
+#  define BVH2_FUNCTION_PREFIX BVH
+#  if BVH_FEATURE(BVH_HAIR)
+#    define NODE_INTERSECT bvh_node_intersect
+#  else
+#    define NODE_INTERSECT bvh_aligned_node_intersect
+#  endif
 #endif
 
 /* This is a template BVH traversal function for volumes, where
@@ -41,10 +65,10 @@ ccl_device
 #else
 ccl_device_inline
 #endif
-bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
-                                 const Ray *ray,
-                                 Intersection *isect,
-                                 const uint visibility)
+bool BVH_FUNCTION_FULL_NAME(BVH2_FUNCTION_PREFIX)(KernelGlobals *kg,
+                                                  const Ray *ray,
+                                                  Intersection *isect,
+                                                  const uint visibility)
 {
 	/* todo:
 	 * - test if pushing distance on the stack helps (for non shadow rays)
@@ -304,11 +328,21 @@ bool BVH_FUNCTION_FULL_NAME(BVH)(KernelGlobals *kg,
 	return (isect->prim != PRIM_NONE);
 }
 
+#ifndef BVH_QUANTIZED_NODES
 ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const Ray *ray,
                                          Intersection *isect,
                                          const uint visibility)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_obvh) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect,
+		                                    visibility);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -317,6 +351,15 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 		                                    visibility);
 	}
 	else
+#endif
+#ifdef __KERNEL_SSE2__
+	if(kernel_data.bvh.use_compact_geometry) {
+		return BVH_FUNCTION_FULL_NAME(COMPACT_BVH)(kg,
+		                                           ray,
+		                                           isect,
+		                                           visibility);
+	}
+	else
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
@@ -329,4 +372,7 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 
 #undef BVH_FUNCTION_NAME
 #undef BVH_FUNCTION_FEATURES
+#endif  /* BVH_QUANTIZED_NODES */
+
+#undef BVH2_FUNCTION_PREFIX
 #undef NODE_INTERSECT
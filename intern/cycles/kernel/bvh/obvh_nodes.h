@@ -0,0 +1,314 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Eight-wide nodes intersection AVX code, follows the same scheme as the
+ * QBVH nodes but keeps every bounds component in a single 256 bit register.
+ *
+ * Node layout (in float4 units, see BVH8::pack_aligned_node):
+ *
+ *   0       visibility, time_from, time_to
+ *   1       unused
+ *   2..13   min.x, max.x, min.y, max.y, min.z, max.z for 8 children
+ *   14..15  child node indices
+ *
+ * Unaligned nodes store 12 transform components instead of the bounds,
+ * and child indices follow at 26..27.
+ */
+
+/* Offset of bounds component (as returned by qbvh_near_far_idx_calc) in an
+ * aligned node.
+ */
+#define OBVH_COMPONENT_OFFSET(idx) (2 + (idx)*2)
+
+/* Push all hit children of a node onto the traversal stack and return the
+ * closest one. Pushed children are kept sorted by distance, so they are
+ * popped from the closest to the furthest. Distance of the returned node is
+ * stored in node_dist, unless it is NULL.
+ */
+ccl_device_forceinline int obvh_node_children_push(
+        QBVHStackItem *ccl_restrict traversal_stack,
+        int *ccl_restrict stack_ptr,
+        int child_mask,
+        const avxf& dist,
+        const avxf& cnodes,
+        float *ccl_restrict node_dist)
+{
+	int r = __bscf(child_mask);
+	if(child_mask == 0) {
+		/* Only one child is hit, continue with it without touching the stack. */
+		if(node_dist != NULL) {
+			*node_dist = dist.f[r];
+		}
+		return __float_as_int(cnodes.f[r]);
+	}
+
+	const int stack_base = *stack_ptr;
+	while(true) {
+		QBVHStackItem item;
+		item.addr = __float_as_int(cnodes.f[r]);
+		item.dist = dist.f[r];
+
+		int i = ++(*stack_ptr);
+		kernel_assert(i < BVH_OSTACK_SIZE);
+		while(i > stack_base + 1 && traversal_stack[i - 1].dist < item.dist) {
+			traversal_stack[i] = traversal_stack[i - 1];
+			--i;
+		}
+		traversal_stack[i] = item;
+
+		if(child_mask == 0) {
+			break;
+		}
+		r = __bscf(child_mask);
+	}
+
+	const int node_addr = traversal_stack[*stack_ptr].addr;
+	if(node_dist != NULL) {
+		*node_dist = traversal_stack[*stack_ptr].dist;
+	}
+	--(*stack_ptr);
+	return node_addr;
+}
+
+ccl_device_inline avxf obvh_child_nodes(KernelGlobals *ccl_restrict kg,
+                                        const float4& inodes,
+                                        const int node_addr)
+{
+	if(__float_as_uint(inodes.x) & PATH_RAY_NODE_UNALIGNED) {
+		return kernel_tex_fetch_avxf(__bvh_nodes, node_addr+26);
+	}
+	return kernel_tex_fetch_avxf(__bvh_nodes, node_addr+14);
+}
+
+/* Axis-aligned nodes intersection */
+
+ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const avxf& isect_near,
+                                                  const avxf& isect_far,
+                                                  const avx3f& org_idir,
+                                                  const avx3f& idir,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_x)), idir.x, org_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_y)), idir.y, org_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_z)), idir.z, org_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_x)), idir.x, org_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_y)), idir.y, org_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_z)), idir.z, org_idir.z);
+
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_aligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_x)), idir.x, P_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_y)), idir.y, P_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(near_z)), idir.z, P_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_x)), idir.x, P_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_y)), idir.y, P_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+OBVH_COMPONENT_OFFSET(far_z)), idir.z, P_idir.z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = round_down*tnear <= round_up*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Unaligned nodes intersection */
+
+ccl_device_inline int obvh_unaligned_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org,
+        const avx3f& dir,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 2;
+	const avxf tfm_x_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+0);
+	const avxf tfm_x_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+2);
+	const avxf tfm_x_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+4);
+
+	const avxf tfm_y_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+6);
+	const avxf tfm_y_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+8);
+	const avxf tfm_y_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+10);
+
+	const avxf tfm_z_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+12);
+	const avxf tfm_z_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+14);
+	const avxf tfm_z_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+16);
+
+	const avxf tfm_t_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+18);
+	const avxf tfm_t_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+20);
+	const avxf tfm_t_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+22);
+
+	const avxf aligned_dir_x = madd(dir.x, tfm_x_x, madd(dir.y, tfm_x_y, dir.z*tfm_x_z)),
+	           aligned_dir_y = madd(dir.x, tfm_y_x, madd(dir.y, tfm_y_y, dir.z*tfm_y_z)),
+	           aligned_dir_z = madd(dir.x, tfm_z_x, madd(dir.y, tfm_z_y, dir.z*tfm_z_z));
+
+	const avxf aligned_P_x = madd(org.x, tfm_x_x, madd(org.y, tfm_x_y, madd(org.z, tfm_x_z, tfm_t_x))),
+	           aligned_P_y = madd(org.x, tfm_y_x, madd(org.y, tfm_y_y, madd(org.z, tfm_y_z, tfm_t_y))),
+	           aligned_P_z = madd(org.x, tfm_z_x, madd(org.y, tfm_z_y, madd(org.z, tfm_z_z, tfm_t_z)));
+
+	const avxf neg_one(-1.0f);
+	const avxf nrdir_x = neg_one / aligned_dir_x,
+	           nrdir_y = neg_one / aligned_dir_y,
+	           nrdir_z = neg_one / aligned_dir_z;
+
+	const avxf tlower_x = aligned_P_x * nrdir_x,
+	           tlower_y = aligned_P_y * nrdir_y,
+	           tlower_z = aligned_P_z * nrdir_z;
+
+	const avxf tupper_x = tlower_x - nrdir_x,
+	           tupper_y = tlower_y - nrdir_y,
+	           tupper_z = tlower_z - nrdir_z;
+
+	const avxf tnear_x = min(tlower_x, tupper_x);
+	const avxf tnear_y = min(tlower_y, tupper_y);
+	const avxf tnear_z = min(tlower_z, tupper_z);
+	const avxf tfar_x = max(tlower_x, tupper_x);
+	const avxf tfar_y = max(tlower_y, tupper_y);
+	const avxf tfar_z = max(tlower_z, tupper_z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = round_down*tnear <= round_up*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Intersectors wrappers.
+ *
+ * They'll check node type and call appropriate intersection code.
+ */
+
+ccl_device_inline int obvh_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org_idir,
+        const avx3f& org,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect(kg,
+		                                     isect_near,
+		                                     isect_far,
+		                                     org,
+		                                     dir,
+		                                     node_addr,
+		                                     0.0f,
+		                                     dist);
+	}
+	else {
+		return obvh_aligned_node_intersect(kg,
+		                                   isect_near,
+		                                   isect_far,
+		                                   org_idir,
+		                                   idir,
+		                                   near_x, near_y, near_z,
+		                                   far_x, far_y, far_z,
+		                                   node_addr,
+		                                   dist);
+	}
+}
+
+ccl_device_inline int obvh_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& P,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect(kg,
+		                                     isect_near,
+		                                     isect_far,
+		                                     P,
+		                                     dir,
+		                                     node_addr,
+		                                     difl,
+		                                     dist);
+	}
+	else {
+		return obvh_aligned_node_intersect_robust(kg,
+		                                          isect_near,
+		                                          isect_far,
+		                                          P_idir,
+		                                          idir,
+		                                          near_x, near_y, near_z,
+		                                          far_x, far_y, far_z,
+		                                          node_addr,
+		                                          difl,
+		                                          dist);
+	}
+}
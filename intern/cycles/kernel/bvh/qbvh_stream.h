@@ -0,0 +1,279 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Ray Stream Traversal
+ *
+ * Traces a stream of up to RAY_STREAM_SIZE coherent rays through the QBVH at
+ * once. The rays share the traversal: every node is fetched once and tested
+ * against all rays which are still active in it, and the vertices of every
+ * triangle are fetched once for all rays reaching the leaf. Each stack entry
+ * carries the mask of the rays which have to visit the node.
+ *
+ * Only static triangle geometry is handled here, scenes with motion blur or
+ * curves go through the single ray traversal. Instanced objects are entered
+ * by all rays of the stream which reached them together.
+ */
+
+struct QBVHStreamStackItem {
+	int addr;
+	uint ray_mask;
+};
+
+/* Per ray data used by the node intersection. */
+struct QBVHStreamRay {
+	float3 P;
+	float3 dir;
+	sse3f org4;
+	sse3f idir4;
+	int near_x, near_y, near_z;
+	int far_x, far_y, far_z;
+};
+
+ccl_device_inline void qbvh_stream_ray_setup(QBVHStreamRay *sray,
+                                             const float3 P,
+                                             const float3 dir,
+                                             const float3 idir)
+{
+	sray->P = P;
+	sray->dir = dir;
+	sray->org4 = sse3f(ssef(P.x), ssef(P.y), ssef(P.z));
+	sray->idir4 = sse3f(ssef(idir.x), ssef(idir.y), ssef(idir.z));
+	qbvh_near_far_idx_calc(idir,
+	                       &sray->near_x, &sray->near_y, &sray->near_z,
+	                       &sray->far_x, &sray->far_y, &sray->far_z);
+}
+
+/* Intersects one ray with the four children of a node, whose bounds were
+ * already fetched. */
+ccl_device_inline int qbvh_stream_node_intersect(const ssef bounds[6],
+                                                 const QBVHStreamRay *sray,
+                                                 const float isect_t,
+                                                 ssef *ccl_restrict dist)
+{
+	const ssef tnear_x = (bounds[sray->near_x] - sray->org4.x) * sray->idir4.x;
+	const ssef tnear_y = (bounds[sray->near_y] - sray->org4.y) * sray->idir4.y;
+	const ssef tnear_z = (bounds[sray->near_z] - sray->org4.z) * sray->idir4.z;
+	const ssef tfar_x = (bounds[sray->far_x] - sray->org4.x) * sray->idir4.x;
+	const ssef tfar_y = (bounds[sray->far_y] - sray->org4.y) * sray->idir4.y;
+	const ssef tfar_z = (bounds[sray->far_z] - sray->org4.z) * sray->idir4.z;
+
+	const ssef tnear = max4(ssef(0.0f), tnear_x, tnear_y, tnear_z);
+	const ssef tfar = min4(ssef(isect_t), tfar_x, tfar_y, tfar_z);
+	const sseb vmask = tnear <= tfar;
+	*dist = tnear;
+	return (int)movemask(vmask);
+}
+
+/* Returns the mask of the rays which hit anything. With opaque shadow
+ * visibility rays stop at their first hit. */
+ccl_device_noinline uint qbvh_intersect_stream(KernelGlobals *kg,
+                                               const Ray *rays,
+                                               Intersection *isects,
+                                               const int num_rays,
+                                               const uint visibility)
+{
+	kernel_assert(num_rays <= RAY_STREAM_SIZE);
+
+	QBVHStreamStackItem traversal_stack[BVH_QSTACK_SIZE];
+	QBVHStreamRay srays[RAY_STREAM_SIZE];
+
+	const bool is_shadow = (visibility & PATH_RAY_SHADOW_OPAQUE) != 0;
+	uint active_mask = 0;
+	uint hit_mask = 0;
+
+	for(int i = 0; i < num_rays; i++) {
+		const float3 dir = bvh_clamp_direction(rays[i].D);
+		qbvh_stream_ray_setup(&srays[i], rays[i].P, dir, bvh_inverse_direction(dir));
+
+		isects[i].t = rays[i].t;
+		isects[i].u = 0.0f;
+		isects[i].v = 0.0f;
+		isects[i].prim = PRIM_NONE;
+		isects[i].object = OBJECT_NONE;
+
+		if(isfinite(rays[i].P.x) && rays[i].t > 0.0f) {
+			active_mask |= (1u << i);
+		}
+	}
+
+	int stack_ptr = -1;
+	int node_addr = kernel_data.bvh.root;
+	uint ray_mask = active_mask;
+	int object = OBJECT_NONE;
+	uint instance_mask = 0;
+
+	for(;;) {
+		if(node_addr == ENTRYPOINT_SENTINEL) {
+			/* Instance pop, back to world space for the rays which entered. */
+			kernel_assert(object != OBJECT_NONE);
+			for(uint mask = instance_mask; mask != 0; ) {
+				const int i = __bscf(mask);
+				float3 P, dir, idir;
+				isects[i].t = bvh_instance_pop(kg, object, &rays[i], &P, &dir, &idir, isects[i].t);
+				qbvh_stream_ray_setup(&srays[i], P, dir, idir);
+			}
+			object = OBJECT_NONE;
+			instance_mask = 0;
+			ray_mask = 0;
+		}
+
+		/* Shadow rays which found a blocker leave the stream. */
+		ray_mask &= active_mask;
+
+		if(ray_mask != 0 && node_addr >= 0) {
+			/* Inner node, fetched once for all rays. */
+			const float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+			kernel_assert((__float_as_uint(inodes.x) & PATH_RAY_NODE_UNALIGNED) == 0);
+
+			if((__float_as_uint(inodes.x) & visibility) != 0) {
+				ssef bounds[6];
+				for(int j = 0; j < 6; j++) {
+					bounds[j] = kernel_tex_fetch_ssef(__bvh_nodes, node_addr+1+j);
+				}
+				const float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+
+				/* Rays hitting each child, and the distances of the leading
+				 * ray which decide the traversal order. */
+				uint child_ray_mask[4] = {0, 0, 0, 0};
+				float child_dist[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+				const int leading_ray = __bsf(ray_mask);
+
+				for(uint mask = ray_mask; mask != 0; ) {
+					const int i = __bscf(mask);
+					ssef dist;
+					int child_mask = qbvh_stream_node_intersect(bounds,
+					                                            &srays[i],
+					                                            isects[i].t,
+					                                            &dist);
+					while(child_mask != 0) {
+						const int c = __bscf(child_mask);
+						child_ray_mask[c] |= (1u << i);
+						if(i == leading_ray) {
+							child_dist[c] = ((float*)&dist)[c];
+						}
+					}
+				}
+
+				/* Push the children from far to near, so the nearest one is
+				 * traversed first. */
+				int order[4] = {0, 1, 2, 3};
+				for(int j = 1; j < 4; j++) {
+					for(int k = j; k > 0 && child_dist[order[k]] > child_dist[order[k-1]]; k--) {
+						int tmp = order[k];
+						order[k] = order[k-1];
+						order[k-1] = tmp;
+					}
+				}
+
+				for(int j = 0; j < 4; j++) {
+					const int c = order[j];
+					if(child_ray_mask[c] != 0) {
+						++stack_ptr;
+						kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+						traversal_stack[stack_ptr].addr = __float_as_int(cnodes[c]);
+						traversal_stack[stack_ptr].ray_mask = child_ray_mask[c];
+					}
+				}
+			}
+		}
+		else if(ray_mask != 0) {
+			/* Leaf node. */
+			const float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+			int prim_addr = __float_as_int(leaf.x);
+
+			if((__float_as_uint(leaf.z) & visibility) != 0) {
+				if(prim_addr >= 0) {
+					const int prim_addr2 = __float_as_int(leaf.y);
+					kernel_assert((__float_as_int(leaf.w) & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+
+					for(; prim_addr < prim_addr2 && ray_mask != 0; prim_addr++) {
+						/* Vertices are fetched once for all rays. */
+#if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+						ssef compact_verts[3];
+						const ssef *ssef_verts = triangle_intersect_ssef_vertices(kg, prim_addr, compact_verts);
+#else
+						float4 verts[3];
+						triangle_intersect_vertices(kg, prim_addr, verts);
+#endif
+						const uint prim_visibility = kernel_tex_fetch(__prim_visibility, prim_addr);
+
+						for(uint mask = ray_mask; mask != 0; ) {
+							const int i = __bscf(mask);
+							float t, u, v;
+							if(ray_triangle_intersect(srays[i].P,
+							                          srays[i].dir,
+							                          isects[i].t,
+#if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+							                          ssef_verts,
+#else
+							                          float4_to_float3(verts[0]),
+							                          float4_to_float3(verts[1]),
+							                          float4_to_float3(verts[2]),
+#endif
+							                          &u, &v, &t) &&
+							   (prim_visibility & visibility))
+							{
+								isects[i].prim = prim_addr;
+								isects[i].object = object;
+								isects[i].type = PRIMITIVE_TRIANGLE;
+								isects[i].u = u;
+								isects[i].v = v;
+								isects[i].t = t;
+								hit_mask |= (1u << i);
+
+								if(is_shadow) {
+									active_mask &= ~(1u << i);
+									ray_mask &= ~(1u << i);
+								}
+							}
+						}
+					}
+				}
+				else {
+					/* Instance push, the rays enter object space together. */
+					kernel_assert(object == OBJECT_NONE);
+					object = kernel_tex_fetch(__prim_object, -prim_addr-1);
+					instance_mask = ray_mask;
+
+					for(uint mask = ray_mask; mask != 0; ) {
+						const int i = __bscf(mask);
+						float3 P, dir, idir;
+						isects[i].t = bvh_instance_push(kg, object, &rays[i], &P, &dir, &idir, isects[i].t);
+						qbvh_stream_ray_setup(&srays[i], P, dir, idir);
+					}
+
+					++stack_ptr;
+					kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+					traversal_stack[stack_ptr].addr = ENTRYPOINT_SENTINEL;
+					traversal_stack[stack_ptr].ray_mask = ray_mask;
+
+					node_addr = kernel_tex_fetch(__object_node, object);
+					continue;
+				}
+			}
+		}
+
+		/* Pop. */
+		if(stack_ptr < 0) {
+			break;
+		}
+		node_addr = traversal_stack[stack_ptr].addr;
+		ray_mask = traversal_stack[stack_ptr].ray_mask;
+		--stack_ptr;
+	}
+
+	return hit_mask;
+}
@@ -18,18 +18,46 @@
  *
  * Basic triangle with 3 vertices is used to represent mesh surfaces. For BVH
  * ray intersection we use a precomputed triangle storage to accelerate
- * intersection at the cost of more memory usage */
+ * intersection at the cost of more memory usage. With compact geometry the
+ * vertices are instead shared between triangles through the vertex index
+ * buffer, and vertex normals are octahedral encoded. */
 
 CCL_NAMESPACE_BEGIN
 
+/* Vertex fetching for triangle storage and compact geometry */
+
+ccl_device_inline void triangle_vertices_from_vindex(KernelGlobals *kg, const uint4 tri_vindex, float3 P[3])
+{
+	if(kernel_data.bvh.use_compact_geometry) {
+		P[0] = float4_to_float3(kernel_tex_fetch(__tri_verts, tri_vindex.x));
+		P[1] = float4_to_float3(kernel_tex_fetch(__tri_verts, tri_vindex.y));
+		P[2] = float4_to_float3(kernel_tex_fetch(__tri_verts, tri_vindex.z));
+	}
+	else {
+		P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
+		P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
+		P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	}
+}
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vert)
+{
+	if(kernel_data.bvh.use_compact_geometry) {
+		return oct16_decode_unit_vector(kernel_tex_fetch(__tri_vnormal_oct, vert));
+	}
+	else {
+		return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vert));
+	}
+}
+
 /* normal on triangle  */
 ccl_device_inline float3 triangle_normal(KernelGlobals *kg, ShaderData *sd)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
-	const float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	const float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	const float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 verts[3];
+	triangle_vertices_from_vindex(kg, tri_vindex, verts);
+	const float3 v0 = verts[0], v1 = verts[1], v2 = verts[2];
 
 	/* return normal */
 	if(sd->object_flag & SD_OBJECT_NEGATIVE_SCALE_APPLIED) {
@@ -45,9 +73,9 @@ ccl_device_inline void triangle_point_normal(KernelGlobals *kg, int object, int
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 verts[3];
+	triangle_vertices_from_vindex(kg, tri_vindex, verts);
+	const float3 v0 = verts[0], v1 = verts[1], v2 = verts[2];
 	/* compute point */
 	float t = 1.0f - u - v;
 	*P = (u*v0 + v*v1 + t*v2);
@@ -69,9 +97,7 @@ ccl_device_inline void triangle_point_normal(KernelGlobals *kg, int object, int
 ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3])
 {
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	triangle_vertices_from_vindex(kg, tri_vindex, P);
 }
 
 /* Interpolate smooth vertex normal from vertices */
@@ -80,9 +106,9 @@ ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, in
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-	float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-	float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+	float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+	float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
 	float3 N = safe_normalize((1.0f - u - v)*n2 + u*n0 + v*n1);
 
@@ -95,9 +121,9 @@ ccl_device_inline void triangle_dPdudv(KernelGlobals *kg, int prim, ccl_addr_spa
 {
 	/* fetch triangle vertex coordinates */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	const float3 p0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	const float3 p1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	const float3 p2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 verts[3];
+	triangle_vertices_from_vindex(kg, tri_vindex, verts);
+	const float3 p0 = verts[0], p1 = verts[1], p2 = verts[2];
 
 	/* compute derivatives of P w.r.t. uv */
 	*dPdu = (p0 - p2);
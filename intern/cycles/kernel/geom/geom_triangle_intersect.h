@@ -22,6 +22,43 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Fetch vertices of the triangle at a BVH primitive address, from the
+ * triangle storage or through the vertex index buffer for compact geometry. */
+ccl_device_inline void triangle_intersect_vertices(KernelGlobals *kg,
+                                                   int prim_addr,
+                                                   float4 verts[3])
+{
+	if(kernel_data.bvh.use_compact_geometry) {
+		const int prim = kernel_tex_fetch(__prim_index, prim_addr);
+		const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+		verts[0] = kernel_tex_fetch(__tri_verts, tri_vindex.x);
+		verts[1] = kernel_tex_fetch(__tri_verts, tri_vindex.y);
+		verts[2] = kernel_tex_fetch(__tri_verts, tri_vindex.z);
+	}
+	else {
+		const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
+		verts[0] = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0);
+		verts[1] = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1);
+		verts[2] = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
+	}
+}
+
+#if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+/* Vertices for SSE intersection, read in place from the triangle storage and
+ * gathered into compact_verts for compact geometry. */
+ccl_device_inline const ssef *triangle_intersect_ssef_vertices(KernelGlobals *kg,
+                                                               int prim_addr,
+                                                               ssef compact_verts[3])
+{
+	if(kernel_data.bvh.use_compact_geometry) {
+		triangle_intersect_vertices(kg, prim_addr, (float4*)compact_verts);
+		return compact_verts;
+	}
+	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
+	return (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+}
+#endif
+
 ccl_device_inline bool triangle_intersect(KernelGlobals *kg,
                                           Intersection *isect,
                                           float3 P,
@@ -30,13 +67,13 @@ ccl_device_inline bool triangle_intersect(KernelGlobals *kg,
                                           int object,
                                           int prim_addr)
 {
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const ssef *ssef_verts = (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+	ssef compact_verts[3];
+	const ssef *ssef_verts = triangle_intersect_ssef_vertices(kg, prim_addr, compact_verts);
 #else
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
+	float4 verts[3];
+	triangle_intersect_vertices(kg, prim_addr, verts);
+	const float4 tri_a = verts[0], tri_b = verts[1], tri_c = verts[2];
 #endif
 	float t, u, v;
 	if(ray_triangle_intersect(P,
@@ -96,13 +133,15 @@ ccl_device_inline void triangle_intersect_local(
 		}
 	}
 
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const ssef *ssef_verts = (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+	ssef compact_verts[3];
+	const ssef *ssef_verts = triangle_intersect_ssef_vertices(kg, prim_addr, compact_verts);
 #else
-	const float3 tri_a = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+0)),
-	             tri_b = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+1)),
-	             tri_c = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+2));
+	float4 verts[3];
+	triangle_intersect_vertices(kg, prim_addr, verts);
+	const float3 tri_a = float4_to_float3(verts[0]),
+	             tri_b = float4_to_float3(verts[1]),
+	             tri_c = float4_to_float3(verts[2]);
 #endif
 	float t, u, v;
 	if(!ray_triangle_intersect(P,
@@ -150,9 +189,9 @@ ccl_device_inline void triangle_intersect_local(
 
 	/* Record geometric normal. */
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const float3 tri_a = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+0)),
-	             tri_b = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+1)),
-	             tri_c = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+2));
+	const float3 tri_a = float4_to_float3(float4(ssef_verts[0])),
+	             tri_b = float4_to_float3(float4(ssef_verts[1])),
+	             tri_c = float4_to_float3(float4(ssef_verts[2]));
 #endif
 	local_isect->Ng[hit] = normalize(cross(tri_b - tri_a, tri_c - tri_a));
 }
@@ -196,10 +235,9 @@ ccl_device_inline float3 triangle_refine(KernelGlobals *kg,
 
 	P = P + D*t;
 
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, isect->prim);
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
+	float4 verts[3];
+	triangle_intersect_vertices(kg, isect->prim, verts);
+	const float4 tri_a = verts[0], tri_b = verts[1], tri_c = verts[2];
 	float3 edge1 = make_float3(tri_a.x - tri_c.x, tri_a.y - tri_c.y, tri_a.z - tri_c.z);
 	float3 edge2 = make_float3(tri_b.x - tri_c.x, tri_b.y - tri_c.y, tri_b.z - tri_c.z);
 	float3 tvec = make_float3(P.x - tri_c.x, P.y - tri_c.y, P.z - tri_c.z);
@@ -261,10 +299,9 @@ ccl_device_inline float3 triangle_refine_local(KernelGlobals *kg,
 	P = P + D*t;
 
 #ifdef __INTERSECTION_REFINE__
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, isect->prim);
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
+	float4 verts[3];
+	triangle_intersect_vertices(kg, isect->prim, verts);
+	const float4 tri_a = verts[0], tri_b = verts[1], tri_c = verts[2];
 	float3 edge1 = make_float3(tri_a.x - tri_c.x, tri_a.y - tri_c.y, tri_a.z - tri_c.z);
 	float3 edge2 = make_float3(tri_b.x - tri_c.x, tri_b.y - tri_c.y, tri_b.z - tri_c.z);
 	float3 tvec = make_float3(P.x - tri_c.x, P.y - tri_c.y, P.z - tri_c.z);
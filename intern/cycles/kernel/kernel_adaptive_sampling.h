@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Pixels stop being sampled once their estimated error is below the noise
+ * threshold. The auxiliary buffer accumulates every second sample with twice
+ * the weight, its difference to the combined pass estimates the error of the
+ * pixel, and its last component marks the pixel as converged. Samples taken
+ * per pixel are counted in the sample count pass. */
+
+/* Returns false when the pixel has converged, otherwise counts the sample. */
+ccl_device_inline bool kernel_adaptive_begin_sample(KernelGlobals *kg, ccl_global float *buffer)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer) {
+		if(buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f) {
+			return false;
+		}
+		kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+	}
+	return true;
+}
+
+/* Tests whether the pixel has converged after taking num_samples samples and
+ * marks it as converged. Error metric from "A Hierarchical Automatic Stopping
+ * Condition for Monte Carlo Global Illumination", Dammertz et al. 2010. */
+ccl_device bool kernel_adaptive_stopping(KernelGlobals *kg, ccl_global float *buffer, int num_samples)
+{
+	ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+
+	if(aux[3] != 0.0f) {
+		return true;
+	}
+
+	float3 I = make_float3(buffer[0], buffer[1], buffer[2]);
+	float3 A = make_float3(aux[0], aux[1], aux[2]);
+	float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	              (num_samples * 0.0001f + sqrtf(max(I.x + I.y + I.z, 0.0f)));
+
+	if(error < kernel_data.integrator.adaptive_threshold * (float)num_samples) {
+		aux[3] = 1.0f;
+		return true;
+	}
+
+	return false;
+}
+
+/* Scales the passes of a pixel which stopped early as if it had taken all
+ * num_samples samples, so the buffer can be normalized as a whole. Returns
+ * the number of samples the pixel skipped. */
+ccl_device int kernel_adaptive_adjust_samples(KernelGlobals *kg, ccl_global float *buffer, int num_samples)
+{
+	int pass_sample_count = kernel_data.film.pass_sample_count;
+	int pass_aux = kernel_data.film.pass_adaptive_aux_buffer;
+	int sample_count = (int)buffer[pass_sample_count];
+
+	if(sample_count == 0 || sample_count >= num_samples) {
+		return 0;
+	}
+
+	float scale = (float)num_samples / (float)sample_count;
+	int pass_stride = kernel_data.film.pass_stride;
+
+	for(int i = 0; i < pass_stride; i++) {
+		if(i != pass_sample_count && (i < pass_aux || i >= pass_aux + 4)) {
+			buffer[i] *= scale;
+		}
+	}
+
+	buffer[pass_sample_count] = (float)num_samples;
+
+	return num_samples - sample_count;
+}
+
+CCL_NAMESPACE_END
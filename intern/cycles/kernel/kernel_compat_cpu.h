@@ -148,6 +148,10 @@ ccl_device_inline void print_sse3i(const char *label, sse3i& a)
 	print_ssei(label, a.z);
 }
 
+#  ifdef __KERNEL_AVX__
+typedef vector3<avxf> avx3f;
+#  endif
+
 #endif
 
 CCL_NAMESPACE_END
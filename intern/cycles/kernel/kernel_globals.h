@@ -19,6 +19,8 @@
 #ifndef __KERNEL_GLOBALS_H__
 #define __KERNEL_GLOBALS_H__
 
+#include "kernel/kernel_profiling.h"
+
 #ifdef __KERNEL_CPU__
 #  include "util/util_vector.h"
 #endif
@@ -43,6 +45,7 @@ struct OSLShadingSystem;
 #  endif
 
 struct Intersection;
+struct TextureCacheThread;
 struct VolumeStep;
 
 typedef struct KernelGlobals {
@@ -69,6 +72,19 @@ typedef struct KernelGlobals {
 	VolumeStep *decoupled_volume_steps[2];
 	int decoupled_volume_steps_index;
 
+	/* Texture cache tiles used by this thread. */
+	TextureCacheThread *texture_cache_thread;
+
+	/* Trace coherent shadow rays in streams. */
+	bool use_ray_stream;
+
+	/* Shadow rays of the paths of the pixel span being traced, NULL when
+	 * shadow rays are traced right away. */
+	struct ShadowRayStream *shadow_stream;
+
+	/* Phase, shader and object sampled by the profiler. */
+	ProfilingState profiler;
+
 	/* split kernel */
 	SplitData split_data;
 	SplitParams split_param_data;
@@ -33,6 +33,225 @@ typedef struct LightSample {
 	LightType type;		/* type of light */
 } LightSample;
 
+/* Light Tree
+ *
+ * Picks local lights proportional to an estimate of their contribution to
+ * the shading point, see render/light_tree.h. Infinite lights are not in the
+ * tree and are picked uniformly, with the tree as a whole counting as one
+ * more light. */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, float3 P, int node)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float energy = data0.w;
+	float theta_o = data1.w;
+	float3 axis = make_float3(data2.x, data2.y, data2.z);
+	float theta_e = data2.w;
+
+	float3 centroid = 0.5f*(bbox_min + bbox_max);
+	float radius_sq = 0.25f*len_squared(bbox_max - bbox_min);
+	float dist_sq = len_squared(P - centroid);
+
+	if(P.x >= bbox_min.x && P.y >= bbox_min.y && P.z >= bbox_min.z &&
+	   P.x <= bbox_max.x && P.y <= bbox_max.y && P.z <= bbox_max.z)
+	{
+		/* Any direction may be lit inside of the bounds. */
+		return energy / max(dist_sq, radius_sq);
+	}
+
+	/* Angle between the emission axis and the shading point, minus the angle
+	 * subtended by the bounds and the angle of the emission cone. */
+	float dist = sqrtf(dist_sq);
+	float theta = safe_acosf(dot(axis, P - centroid) / dist);
+	float theta_u = (dist_sq > radius_sq)? safe_asinf(sqrtf(radius_sq) / dist): M_PI_F;
+	float theta_p = max(theta - theta_o - theta_u, 0.0f);
+
+	if(theta_p > theta_e) {
+		return 0.0f;
+	}
+
+	return energy * cosf(theta_p) / max(dist_sq, radius_sq);
+}
+
+/* Picks an emitter for the shading point and returns its index in the light
+ * distribution, or -1 when no emitter contributes. randu is rescaled to be
+ * reused for sampling the emitter. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu, float *pdf)
+{
+	int num_emitters = kernel_data.integrator.light_tree_num_emitters;
+	int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+	float infinite_pdf = kernel_data.integrator.light_tree_infinite_pdf;
+	float tree_pdf = 1.0f - num_infinite*infinite_pdf;
+	float r = *randu;
+
+	if(r >= tree_pdf) {
+		/* Infinite light. */
+		float u = (r - tree_pdf) / infinite_pdf;
+		int i = min((int)u, num_infinite - 1);
+		*randu = clamp(u - i, 0.0f, 1.0f);
+		*pdf = infinite_pdf;
+		return kernel_tex_fetch(__light_tree_emitters, num_emitters + i);
+	}
+
+	if(num_emitters == 0) {
+		return -1;
+	}
+
+	r /= tree_pdf;
+	*pdf = tree_pdf;
+
+	int node = 0;
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	int right = __float_as_int(data3.x);
+
+	while(right != 0) {
+		float importance_left = light_tree_node_importance(kg, P, node + 1);
+		float importance_right = light_tree_node_importance(kg, P, right);
+		float importance = importance_left + importance_right;
+
+		if(importance == 0.0f) {
+			return -1;
+		}
+
+		float prob_left = importance_left / importance;
+
+		if(r < prob_left) {
+			node = node + 1;
+			r = r / prob_left;
+			*pdf *= prob_left;
+		}
+		else {
+			node = right;
+			r = (r - prob_left) / (1.0f - prob_left);
+			*pdf *= 1.0f - prob_left;
+		}
+
+		/* Rescaling may round r up to one. */
+		r = min(r, 1.0f - 1e-6f);
+
+		data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		right = __float_as_int(data3.x);
+	}
+
+	*randu = r;
+	return kernel_tex_fetch(__light_tree_emitters, __float_as_int(data3.y));
+}
+
+/* Probability of light_tree_sample picking the emitter with given index in
+ * the light distribution. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int index)
+{
+	int num_emitters = kernel_data.integrator.light_tree_num_emitters;
+	int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+	float infinite_pdf = kernel_data.integrator.light_tree_infinite_pdf;
+	int position = (int)kernel_tex_fetch(__light_tree_positions, index);
+
+	if(position < 0) {
+		return 0.0f;
+	}
+	else if(position >= num_emitters) {
+		return infinite_pdf;
+	}
+
+	float pdf = 1.0f - num_infinite*infinite_pdf;
+	int node = 0;
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	int right = __float_as_int(data3.x);
+
+	while(right != 0) {
+		float importance_left = light_tree_node_importance(kg, P, node + 1);
+		float importance_right = light_tree_node_importance(kg, P, right);
+		float importance = importance_left + importance_right;
+
+		if(importance == 0.0f) {
+			return 0.0f;
+		}
+
+		/* Inner nodes store the first position of the right child. */
+		if(position < __float_as_int(data3.y)) {
+			node = node + 1;
+			pdf *= importance_left / importance;
+		}
+		else {
+			node = right;
+			pdf *= importance_right / importance;
+		}
+
+		data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		right = __float_as_int(data3.x);
+	}
+
+	return pdf;
+}
+
+/* Index of an emissive triangle in the light distribution, in which triangles
+ * are sorted by object and primitive, or -1 if it is not in there. */
+ccl_device int light_distribution_triangle_index(KernelGlobals *kg, int object, int prim)
+{
+	int num_triangles = kernel_data.integrator.num_distribution - kernel_data.integrator.num_all_lights;
+	int first = 0;
+	int len = num_triangles;
+
+	while(len > 0) {
+		int half_len = len >> 1;
+		int middle = first + half_len;
+		float4 l = kernel_tex_fetch(__light_distribution, middle);
+		int middle_object = __float_as_int(l.w);
+		int middle_prim = __float_as_int(l.y);
+
+		if(middle_object < object || (middle_object == object && middle_prim < prim)) {
+			first = middle + 1;
+			len = len - half_len - 1;
+		}
+		else {
+			len = half_len;
+		}
+	}
+
+	if(first < num_triangles) {
+		float4 l = kernel_tex_fetch(__light_distribution, first);
+		if(__float_as_int(l.w) == object && __float_as_int(l.y) == prim) {
+			return first;
+		}
+	}
+
+	return -1;
+}
+
+/* Probability of picking a lamp, with the light tree or uniformly. */
+ccl_device_inline float light_select_lamp_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		int index = kernel_data.integrator.num_distribution - kernel_data.integrator.num_all_lights + lamp;
+		return light_tree_pdf(kg, P, index);
+	}
+	return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of picking the background light. */
+ccl_device_inline float light_select_background_pdf(KernelGlobals *kg)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		return kernel_data.integrator.light_tree_infinite_pdf;
+	}
+	return kernel_data.integrator.pdf_lights;
+}
+
+/* Probability of picking a triangle, given its area and the probability of
+ * the light tree picking it. */
+ccl_device_inline float triangle_light_select_pdf(KernelGlobals *kg, float area, float tree_pdf)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		return tree_pdf;
+	}
+	return area * kernel_data.integrator.pdf_triangles;
+}
+
 /* Area light sampling */
 
 /* Uses the following paper:
@@ -441,7 +660,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
 			/* Portal sampling is not possible here because all portals point to the wrong side.
 			 * If map sampling is possible, it would be used instead, otherwise fallback sampling is used. */
 			if(portal_sampling_pdf == 1.0f) {
-				return kernel_data.integrator.pdf_lights / M_4PI_F;
+				return light_select_background_pdf(kg) / M_4PI_F;
 			}
 			else {
 				/* Force map sampling. */
@@ -453,7 +672,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
 		/* Evaluate PDF of sampling this direction by map sampling. */
 		map_pdf = background_map_pdf(kg, direction) * (1.0f - portal_sampling_pdf);
 	}
-	return (portal_pdf + map_pdf) * kernel_data.integrator.pdf_lights;
+	return (portal_pdf + map_pdf) * light_select_background_pdf(kg);
 }
 #endif
 
@@ -623,7 +842,7 @@ ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
 		}
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
 	return (ls->pdf > 0.0f);
 }
@@ -760,7 +979,7 @@ ccl_device bool lamp_light_eval(KernelGlobals *kg, int lamp, float3 P, float3 D,
 		return false;
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
 	return true;
 }
@@ -797,9 +1016,9 @@ ccl_device_inline bool triangle_world_space_vertices(KernelGlobals *kg, int obje
 	return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t)
+/* Converts a pdf over the triangle area to solid angle. */
+ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t, float pdf)
 {
-	float pdf = kernel_data.integrator.pdf_triangles;
 	float cos_pi = fabsf(dot(Ng, I));
 
 	if(cos_pi == 0.0f)
@@ -814,6 +1033,18 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 	 * and simple area sampling, comparing the distance to the triangle plane
 	 * to the length of the edges of the triangle. */
 
+	float tree_pdf = 1.0f;
+	if(kernel_data.integrator.use_light_tree) {
+		const int index = light_distribution_triangle_index(kg, sd->object, sd->prim);
+		if(index == -1) {
+			return 0.0f;
+		}
+		tree_pdf = light_tree_pdf(kg, sd->P + sd->I * t, index);
+		if(tree_pdf == 0.0f) {
+			return 0.0f;
+		}
+	}
+
 	float3 V[3];
 	bool has_motion = triangle_world_space_vertices(kg, sd->object, sd->prim, sd->time, V);
 
@@ -855,30 +1086,31 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 			else {
 				area = 0.5f * len(N);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = triangle_light_select_pdf(kg, area, tree_pdf);
 			return pdf / solid_angle;
 		}
 	}
 	else {
-		float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+		const float area = 0.5f * len(N);
+		if(UNLIKELY(area == 0.0f)) {
+			return 0.0f;
+		}
+		float area_pre = area;
 		if(has_motion) {
-			const float	area = 0.5f * len(N);
-			if(UNLIKELY(area == 0.0f)) {
-				return 0.0f;
-			}
-			/* scale the PDF.
-			 * area = the area the sample was taken from
-			 * area_pre = the are from which pdf_triangles was calculated from */
+			/* get the center frame vertices, this is what the PDF was calculated from */
 			triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			pdf = pdf * area_pre / area;
+			area_pre = triangle_area(V[0], V[1], V[2]);
 		}
-		return pdf;
+		/* scale the PDF.
+		 * area = the area the sample was taken from
+		 * area_pre = the area from which the selection pdf was calculated from */
+		const float pdf = triangle_light_select_pdf(kg, area_pre, tree_pdf) / area;
+		return triangle_light_pdf_area(kg, sd->Ng, sd->I, t, pdf);
 	}
 }
 
 ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, int object,
-	float randu, float randv, float time, LightSample *ls, const float3 P)
+	float randu, float randv, float time, LightSample *ls, const float3 P, float tree_pdf)
 {
 	/* A naive heuristic to decide between costly solid angle sampling
 	 * and simple area sampling, comparing the distance to the triangle plane
@@ -996,7 +1228,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 				triangle_world_space_vertices(kg, object, prim, -1.0f, V);
 				area = triangle_area(V[0], V[1], V[2]);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = triangle_light_select_pdf(kg, area, tree_pdf);
 			ls->pdf = pdf / solid_angle;
 		}
 	}
@@ -1010,15 +1242,20 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 		ls->P = u * V[0] + v * V[1] + t * V[2];
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-		if(has_motion && area != 0.0f) {
+		if(UNLIKELY(area == 0.0f)) {
+			ls->pdf = 0.0f;
+			return;
+		}
+		float area_pre = area;
+		if(has_motion) {
 			/* scale the PDF.
 			 * area = the area the sample was taken from
-			 * area_pre = the are from which pdf_triangles was calculated from */
+			 * area_pre = the area from which the selection pdf was calculated from */
 			triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			ls->pdf = ls->pdf * area_pre / area;
+			area_pre = triangle_area(V[0], V[1], V[2]);
 		}
+		const float pdf = triangle_light_select_pdf(kg, area_pre, tree_pdf) / area;
+		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t, pdf);
 		ls->u = u;
 		ls->v = v;
 	}
@@ -1079,7 +1316,18 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, &randu);
+	int index;
+	float tree_pdf = 1.0f;
+
+	if(kernel_data.integrator.use_light_tree) {
+		index = light_tree_sample(kg, P, &randu, &tree_pdf);
+		if(index == -1) {
+			return false;
+		}
+	}
+	else {
+		index = light_distribution_sample(kg, &randu);
+	}
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -1089,7 +1337,7 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 		int object = __float_as_int(l.w);
 		int shader_flag = __float_as_int(l.z);
 
-		triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+		triangle_light_sample(kg, prim, object, randu, randv, time, ls, P, tree_pdf);
 		ls->shader |= shader_flag;
 		return (ls->pdf > 0.0f);
 	}
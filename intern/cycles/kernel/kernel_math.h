@@ -21,6 +21,7 @@
 #include "util/util_math.h"
 #include "util/util_math_fast.h"
 #include "util/util_math_intersect.h"
+#include "util/util_math_quantize.h"
 #include "util/util_texture.h"
 #include "util/util_transform.h"
 
@@ -342,6 +342,12 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 
 	kernel_write_pass_float4(buffer, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
+	if(kernel_data.film.pass_adaptive_aux_buffer && (sample & 1)) {
+		/* Every second sample with twice the weight, for adaptive sampling. */
+		kernel_write_pass_float3(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+		                         L_sum * 2.0f);
+	}
+
 	kernel_write_light_passes(kg, buffer, L);
 
 #ifdef __DENOISING_FEATURES__
@@ -31,6 +31,7 @@
 #include "kernel/kernel_shader.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #ifdef __SUBSURFACE__
 #  include "kernel/kernel_subsurface.h"
@@ -57,6 +58,8 @@ ccl_device_forceinline bool kernel_path_scene_intersect(
 	Intersection *isect,
 	PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_SCENE_INTERSECT);
+
 	uint visibility = path_state_ray_visibility(kg, state);
 
 	if(path_state_ao_bounce(kg, state)) {
@@ -105,6 +108,8 @@ ccl_device_forceinline void kernel_path_lamp_emission(
 	ShaderData *emission_sd,
 	PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_INDIRECT_EMISSION);
+
 #ifdef __LAMP_MIS__
 	if(kernel_data.integrator.use_lamp_mis && !(state->flag & PATH_RAY_CAMERA)) {
 		/* ray starting from previous non-transparent bounce */
@@ -135,6 +140,8 @@ ccl_device_forceinline void kernel_path_background(
 	ShaderData *sd,
 	PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_INDIRECT_EMISSION);
+
 	/* eval background shader if nothing hit */
 	if(kernel_data.background.transparent && (state->flag & PATH_RAY_CAMERA)) {
 		L->transparent += average(throughput);
@@ -172,6 +179,8 @@ ccl_device_forceinline VolumeIntegrateResult kernel_path_volume(
 	ShaderData *emission_sd,
 	PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_VOLUME);
+
 	/* Sanitize volume stack. */
 	if(!hit) {
 		kernel_volume_clean_stack(kg, state->volume_stack);
@@ -278,6 +287,8 @@ ccl_device_forceinline bool kernel_path_shader_apply(
 	PathRadiance *L,
 	ccl_global float *buffer)
 {
+	PROFILING_INIT(kg, PROFILING_SHADER_APPLY);
+
 #ifdef __SHADOW_TRICKS__
 	if((sd->object_flag & SD_OBJECT_SHADOW_CATCHER)) {
 		if(state->flag & PATH_RAY_CAMERA) {
@@ -355,6 +366,8 @@ ccl_device_noinline void kernel_path_ao(KernelGlobals *kg,
                                         float3 throughput,
                                         float3 ao_alpha)
 {
+	PROFILING_INIT(kg, PROFILING_AO);
+
 	/* todo: solve correlation */
 	float bsdf_u, bsdf_v;
 
@@ -379,6 +392,14 @@ ccl_device_noinline void kernel_path_ao(KernelGlobals *kg,
 		light_ray.dP = sd->dP;
 		light_ray.dD = differential3_zero();
 
+#ifdef __RAY_STREAM__
+		ShadowRayStream *stream = shadow_ray_stream_get(kg, state);
+		if(stream != NULL) {
+			shadow_ray_stream_queue_ao(stream, state, L, throughput, &light_ray, ao_alpha, ao_bsdf);
+			return;
+		}
+#endif
+
 		if(!shadow_blocked(kg, sd, emission_sd, state, &light_ray, &ao_shadow)) {
 			path_radiance_accum_ao(L, state, throughput, ao_alpha, ao_bsdf, ao_shadow);
 		}
@@ -542,8 +563,11 @@ ccl_device_forceinline void kernel_path_integrate(
 	Ray *ray,
 	PathRadiance *L,
 	ccl_global float *buffer,
-	ShaderData *emission_sd)
+	ShaderData *emission_sd,
+	const Intersection *camera_isect)
 {
+	PROFILING_INIT(kg, PROFILING_PATH_INTEGRATE);
+
 	/* Shader data memory used for both volumes and surfaces, saves stack space. */
 	ShaderData sd;
 
@@ -556,9 +580,22 @@ ccl_device_forceinline void kernel_path_integrate(
 
 	/* path iteration */
 	for(;;) {
-		/* Find intersection with objects in scene. */
+		/* Find intersection with objects in scene, unless the camera ray was
+		 * already traced as part of a ray stream. */
 		Intersection isect;
-		bool hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		bool hit;
+
+		if(camera_isect != NULL) {
+			isect = *camera_isect;
+			hit = (isect.prim != PRIM_NONE);
+			camera_isect = NULL;
+#ifdef __KERNEL_DEBUG__
+			L->debug_data.num_ray_bounces++;
+#endif
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		}
 
 		/* Find intersection with lamps and compute emission for MIS. */
 		kernel_path_lamp_emission(kg, state, ray, throughput, &isect, &sd, L);
@@ -684,12 +721,18 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	ccl_global float *buffer,
 	int sample, int x, int y, int offset, int stride)
 {
+	PROFILING_INIT(kg, PROFILING_RAY_SETUP);
+
 	/* buffer offset */
 	int index = offset + x + y*stride;
 	int pass_stride = kernel_data.film.pass_stride;
 
 	buffer += index*pass_stride;
 
+	if(!kernel_adaptive_begin_sample(kg, buffer)) {
+		return;
+	}
+
 	/* Initialize random numbers and sample ray. */
 	uint rng_hash;
 	Ray ray;
@@ -719,11 +762,104 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	                      &ray,
 	                      &L,
 	                      buffer,
-	                      emission_sd);
+	                      emission_sd,
+	                      NULL);
 
+	PROFILING_EVENT(PROFILING_WRITE_RESULT);
 	kernel_write_result(kg, buffer, sample, &L);
 }
 
+#ifdef __RAY_STREAM__
+/* Path trace a span of num_pixels pixels starting at x, with the camera rays
+ * of the pixels traced together as a ray stream. The shadow rays of all paths
+ * are queued and traced in streams as well. */
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int num_pixels, int offset, int stride)
+{
+	kernel_assert(num_pixels <= RAY_STREAM_SIZE);
+
+	/* Hair needs the ray differentials during traversal, trace it per ray. */
+	if(!scene_intersect_stream_supported(kg)) {
+		for(int i = 0; i < num_pixels; i++) {
+			kernel_path_trace(kg, buffer, sample, x + i, y, offset, stride);
+		}
+		return;
+	}
+
+	PROFILING_INIT(kg, PROFILING_RAY_SETUP);
+
+	int pass_stride = kernel_data.film.pass_stride;
+
+	uint rng_hash[RAY_STREAM_SIZE];
+	Ray rays[RAY_STREAM_SIZE];
+	Intersection isects[RAY_STREAM_SIZE];
+	ccl_global float *buffers[RAY_STREAM_SIZE];
+	int num_rays = 0;
+
+	/* Initialize random numbers and sample rays of all pixels. */
+	for(int i = 0; i < num_pixels; i++) {
+		ccl_global float *pixel_buffer = buffer + (offset + x + i + y*stride)*pass_stride;
+
+		if(!kernel_adaptive_begin_sample(kg, pixel_buffer)) {
+			continue;
+		}
+
+		kernel_path_trace_setup(kg, sample, x + i, y, &rng_hash[num_rays], &rays[num_rays]);
+
+		if(rays[num_rays].t == 0.0f) {
+			continue;
+		}
+
+		buffers[num_rays] = pixel_buffer;
+		num_rays++;
+	}
+
+	/* Camera rays start with camera visibility only. */
+	PROFILING_EVENT(PROFILING_SCENE_INTERSECT);
+	scene_intersect_stream(kg, rays, isects, num_rays, PATH_RAY_CAMERA);
+
+	/* Radiance of the paths is kept until their queued shadow rays are
+	 * traced. */
+	PathRadiance L[RAY_STREAM_SIZE];
+	ShadowRayStream shadow_stream;
+	shadow_stream.num_rays = 0;
+	kg->shadow_stream = &shadow_stream;
+
+	/* Integrate every path from its first hit. */
+	for(int i = 0; i < num_rays; i++) {
+		PROFILING_EVENT(PROFILING_RAY_SETUP);
+
+		float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+
+		path_radiance_init(&L[i], kernel_data.film.use_light_pass);
+
+		ShaderDataTinyStorage emission_sd_storage;
+		ShaderData *emission_sd = AS_SHADER_DATA(&emission_sd_storage);
+
+		PathState state;
+		path_state_init(kg, emission_sd, &state, rng_hash[i], sample, &rays[i]);
+
+		kernel_path_integrate(kg,
+		                      &state,
+		                      throughput,
+		                      &rays[i],
+		                      &L[i],
+		                      buffers[i],
+		                      emission_sd,
+		                      &isects[i]);
+	}
+
+	shadow_ray_stream_flush(kg, &shadow_stream);
+	kg->shadow_stream = NULL;
+
+	for(int i = 0; i < num_rays; i++) {
+		PROFILING_EVENT(PROFILING_WRITE_RESULT);
+		kernel_write_result(kg, buffers[i], sample, &L[i]);
+	}
+}
+#endif  /* __RAY_STREAM__ */
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
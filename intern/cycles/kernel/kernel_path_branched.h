@@ -18,6 +18,64 @@ CCL_NAMESPACE_BEGIN
 
 #ifdef __BRANCHED_PATH__
 
+#ifdef __RAY_STREAM__
+/* Same as kernel_branched_path_ao, with the AO rays traced in streams. */
+ccl_device_noinline void kernel_branched_path_ao_stream(KernelGlobals *kg,
+                                                        ShaderData *sd,
+                                                        ShaderData *emission_sd,
+                                                        PathRadiance *L,
+                                                        ccl_addr_space PathState *state,
+                                                        float3 throughput)
+{
+	int num_samples = kernel_data.integrator.ao_samples;
+	float num_samples_inv = 1.0f/num_samples;
+	float ao_factor = kernel_data.background.ao_factor;
+	float3 ao_N;
+	float3 ao_bsdf = shader_bsdf_ao(kg, sd, ao_factor, &ao_N);
+	float3 ao_alpha = shader_bsdf_alpha(kg, sd);
+
+	Ray light_rays[RAY_STREAM_SIZE];
+	float3 ao_shadows[RAY_STREAM_SIZE];
+
+	for(int start = 0; start < num_samples; start += RAY_STREAM_SIZE) {
+		int end = min(start + RAY_STREAM_SIZE, num_samples);
+		int num_rays = 0;
+
+		for(int j = start; j < end; j++) {
+			float bsdf_u, bsdf_v;
+			path_branched_rng_2D(kg, state->rng_hash, state, j, num_samples, PRNG_BSDF_U, &bsdf_u, &bsdf_v);
+
+			float3 ao_D;
+			float ao_pdf;
+
+			sample_cos_hemisphere(ao_N, bsdf_u, bsdf_v, &ao_D, &ao_pdf);
+
+			if(dot(sd->Ng, ao_D) > 0.0f && ao_pdf != 0.0f) {
+				Ray *light_ray = &light_rays[num_rays++];
+
+				light_ray->P = ray_offset(sd->P, sd->Ng);
+				light_ray->D = ao_D;
+				light_ray->t = kernel_data.background.ao_distance;
+				light_ray->time = sd->time;
+				light_ray->dP = sd->dP;
+				light_ray->dD = differential3_zero();
+			}
+		}
+
+		uint blocked = shadow_blocked_stream(kg, sd, emission_sd, state, light_rays, num_rays, ao_shadows);
+
+		for(int i = 0; i < num_rays; i++) {
+			if(!(blocked & (1u << i))) {
+				path_radiance_accum_ao(L, state, throughput*num_samples_inv, ao_alpha, ao_bsdf, ao_shadows[i]);
+			}
+			else {
+				path_radiance_accum_total_ao(L, state, throughput*num_samples_inv, ao_bsdf);
+			}
+		}
+	}
+}
+#endif  /* __RAY_STREAM__ */
+
 ccl_device_inline void kernel_branched_path_ao(KernelGlobals *kg,
                                                ShaderData *sd,
                                                ShaderData *emission_sd,
@@ -25,6 +83,13 @@ ccl_device_inline void kernel_branched_path_ao(KernelGlobals *kg,
                                                ccl_addr_space PathState *state,
                                                float3 throughput)
 {
+#ifdef __RAY_STREAM__
+	if(kg->use_ray_stream) {
+		kernel_branched_path_ao_stream(kg, sd, emission_sd, L, state, throughput);
+		return;
+	}
+#endif
+
 	int num_samples = kernel_data.integrator.ao_samples;
 	float num_samples_inv = 1.0f/num_samples;
 	float ao_factor = kernel_data.background.ao_factor;
@@ -428,6 +493,8 @@ ccl_device void kernel_branched_path_integrate(KernelGlobals *kg,
                                                ccl_global float *buffer,
                                                PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_PATH_INTEGRATE);
+
 	/* initialize */
 	float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
 
@@ -576,12 +643,18 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	ccl_global float *buffer,
 	int sample, int x, int y, int offset, int stride)
 {
+	PROFILING_INIT(kg, PROFILING_RAY_SETUP);
+
 	/* buffer offset */
 	int index = offset + x + y*stride;
 	int pass_stride = kernel_data.film.pass_stride;
 
 	buffer += index*pass_stride;
 
+	if(!kernel_adaptive_begin_sample(kg, buffer)) {
+		return;
+	}
+
 	/* initialize random numbers and ray */
 	uint rng_hash;
 	Ray ray;
@@ -593,6 +666,8 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 
 	if(ray.t != 0.0f) {
 		kernel_branched_path_integrate(kg, rng_hash, sample, ray, buffer, &L);
+
+		PROFILING_EVENT(PROFILING_WRITE_RESULT);
 		kernel_write_result(kg, buffer, sample, &L);
 	}
 }
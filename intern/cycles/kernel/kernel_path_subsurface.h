@@ -32,6 +32,8 @@ bool kernel_path_subsurface_scatter(
         ccl_addr_space float3 *throughput,
         ccl_addr_space SubsurfaceIndirectRays *ss_indirect)
 {
+	PROFILING_INIT(kg, PROFILING_SUBSURFACE);
+
 	float bssrdf_u, bssrdf_v;
 	path_state_rng_2D(kg, state, PRNG_BSDF_U, &bssrdf_u, &bssrdf_v);
 
@@ -139,6 +141,13 @@ ccl_device void kernel_path_subsurface_setup_indirect(
 	/* Setup state, ray and throughput for indirect SSS rays. */
 	ss_indirect->num_rays--;
 
+#ifdef __RAY_STREAM__
+	/* Queued shadow rays add to the indirect light summed here. */
+	if(kg->shadow_stream != NULL) {
+		shadow_ray_stream_flush(kg, kg->shadow_stream);
+	}
+#endif
+
 	path_radiance_sum_indirect(L);
 	path_radiance_reset_indirect(L);
 
@@ -17,6 +17,138 @@
 CCL_NAMESPACE_BEGIN
 
 #if defined(__BRANCHED_PATH__) || defined(__SUBSURFACE__) || defined(__SHADOW_TRICKS__) || defined(__BAKING__)
+
+#  if defined(__RAY_STREAM__) && defined(__EMISSION__)
+/* Light samples waiting for their shadow rays to be traced as a stream. */
+typedef struct LightSampleStream {
+	Ray rays[RAY_STREAM_SIZE];
+	BsdfEval evals[RAY_STREAM_SIZE];
+	bool is_lamp[RAY_STREAM_SIZE];
+	int num_rays;
+} LightSampleStream;
+
+ccl_device_inline void kernel_branched_path_light_stream_flush(
+        KernelGlobals *kg,
+        ShaderData *sd,
+        ShaderData *emission_sd,
+        ccl_addr_space PathState *state,
+        float3 throughput,
+        float num_samples_inv,
+        PathRadiance *L,
+        LightSampleStream *stream)
+{
+	if(stream->num_rays == 0) {
+		return;
+	}
+
+	float3 shadows[RAY_STREAM_SIZE];
+	uint blocked = shadow_blocked_stream(kg, sd, emission_sd, state, stream->rays, stream->num_rays, shadows);
+
+	for(int i = 0; i < stream->num_rays; i++) {
+		if(!(blocked & (1u << i))) {
+			/* accumulate */
+			path_radiance_accum_light(L, state, throughput*num_samples_inv, &stream->evals[i], shadows[i], num_samples_inv, stream->is_lamp[i]);
+		}
+		else {
+			path_radiance_accum_total_light(L, state, throughput*num_samples_inv, &stream->evals[i]);
+		}
+	}
+
+	stream->num_rays = 0;
+}
+
+/* Same as sampling all lights in kernel_branched_path_surface_connect_light,
+ * with the shadow rays of the samples of each light traced in streams. */
+ccl_device_noinline void kernel_branched_path_surface_connect_all_lights_stream(
+        KernelGlobals *kg,
+        ShaderData *sd,
+        ShaderData *emission_sd,
+        ccl_addr_space PathState *state,
+        float3 throughput,
+        float num_samples_adjust,
+        PathRadiance *L)
+{
+	LightSampleStream stream;
+	stream.num_rays = 0;
+
+	/* lamp sampling */
+	for(int i = 0; i < kernel_data.integrator.num_all_lights; i++) {
+		if(UNLIKELY(light_select_reached_max_bounces(kg, i, state->bounce)))
+			continue;
+
+		int num_samples = ceil_to_int(num_samples_adjust*light_select_num_samples(kg, i));
+		float num_samples_inv = num_samples_adjust/(num_samples*kernel_data.integrator.num_all_lights);
+		uint lamp_rng_hash = cmj_hash(state->rng_hash, i);
+
+		for(int j = 0; j < num_samples; j++) {
+			float light_u, light_v;
+			path_branched_rng_2D(kg, lamp_rng_hash, state, j, num_samples, PRNG_LIGHT_U, &light_u, &light_v);
+			float terminate = path_branched_rng_light_termination(kg, lamp_rng_hash, state, j, num_samples);
+
+			LightSample ls;
+			if(lamp_light_sample(kg, i, light_u, light_v, sd->P, &ls)) {
+				if(kernel_data.integrator.pdf_triangles != 0.0f)
+					ls.pdf *= 2.0f;
+
+				Ray *light_ray = &stream.rays[stream.num_rays];
+#    ifdef __OBJECT_MOTION__
+				light_ray->time = sd->time;
+#    endif
+				if(direct_emission(kg, sd, emission_sd, &ls, state, light_ray,
+				                   &stream.evals[stream.num_rays], &stream.is_lamp[stream.num_rays], terminate))
+				{
+					stream.num_rays++;
+				}
+			}
+
+			if(stream.num_rays == RAY_STREAM_SIZE) {
+				kernel_branched_path_light_stream_flush(kg, sd, emission_sd, state, throughput, num_samples_inv, L, &stream);
+			}
+		}
+
+		kernel_branched_path_light_stream_flush(kg, sd, emission_sd, state, throughput, num_samples_inv, L, &stream);
+	}
+
+	/* mesh light sampling */
+	if(kernel_data.integrator.pdf_triangles != 0.0f) {
+		int num_samples = ceil_to_int(num_samples_adjust*kernel_data.integrator.mesh_light_samples);
+		float num_samples_inv = num_samples_adjust/num_samples;
+
+		for(int j = 0; j < num_samples; j++) {
+			float light_u, light_v;
+			path_branched_rng_2D(kg, state->rng_hash, state, j, num_samples, PRNG_LIGHT_U, &light_u, &light_v);
+			float terminate = path_branched_rng_light_termination(kg, state->rng_hash, state, j, num_samples);
+
+			/* only sample triangle lights */
+			if(kernel_data.integrator.num_all_lights)
+				light_u = 0.5f*light_u;
+
+			LightSample ls;
+			if(light_sample(kg, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+				if(kernel_data.integrator.num_all_lights)
+					ls.pdf *= 2.0f;
+
+				Ray *light_ray = &stream.rays[stream.num_rays];
+#    ifdef __OBJECT_MOTION__
+				light_ray->time = sd->time;
+#    endif
+				if(direct_emission(kg, sd, emission_sd, &ls, state, light_ray,
+				                   &stream.evals[stream.num_rays], &stream.is_lamp[stream.num_rays], terminate))
+				{
+					stream.num_rays++;
+				}
+			}
+
+			if(stream.num_rays == RAY_STREAM_SIZE) {
+				kernel_branched_path_light_stream_flush(kg, sd, emission_sd, state, throughput, num_samples_inv, L, &stream);
+			}
+		}
+
+		kernel_branched_path_light_stream_flush(kg, sd, emission_sd, state, throughput, num_samples_inv, L, &stream);
+	}
+}
+#  endif  /* __RAY_STREAM__ && __EMISSION__ */
+
 /* branched path tracing: connect path directly to position on one or more lights and add it to L */
 ccl_device_noinline void kernel_branched_path_surface_connect_light(
         KernelGlobals *kg,
@@ -28,6 +160,8 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
         PathRadiance *L,
         int sample_all_lights)
 {
+	PROFILING_INIT(kg, PROFILING_CONNECT_LIGHT);
+
 #ifdef __EMISSION__
 	/* sample illumination from lights to find path contribution */
 	if(!(sd->flag & SD_BSDF_HAS_EVAL))
@@ -42,6 +176,13 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
 #  endif
 
 	if(sample_all_lights) {
+#  ifdef __RAY_STREAM__
+		if(kg->use_ray_stream) {
+			kernel_branched_path_surface_connect_all_lights_stream(kg, sd, emission_sd, state, throughput, num_samples_adjust, L);
+			return;
+		}
+#  endif
+
 		/* lamp sampling */
 		for(int i = 0; i < kernel_data.integrator.num_all_lights; i++) {
 			if(UNLIKELY(light_select_reached_max_bounces(kg, i, state->bounce)))
@@ -217,6 +358,8 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg,
 	ShaderData *sd, ShaderData *emission_sd, float3 throughput, ccl_addr_space PathState *state,
 	PathRadiance *L)
 {
+	PROFILING_INIT(kg, PROFILING_CONNECT_LIGHT);
+
 #ifdef __EMISSION__
 	if(!(kernel_data.integrator.use_direct_light && (sd->flag & SD_BSDF_HAS_EVAL)))
 		return;
@@ -251,6 +394,15 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg,
 	if(light_sample(kg, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
 		float terminate = path_state_rng_light_termination(kg, state);
 		if(direct_emission(kg, sd, emission_sd, &ls, state, &light_ray, &L_light, &is_lamp, terminate)) {
+#ifdef __RAY_STREAM__
+			/* queue shadow ray to be traced with the ones of other paths */
+			ShadowRayStream *stream = shadow_ray_stream_get(kg, state);
+			if(stream != NULL) {
+				shadow_ray_stream_queue_light(stream, state, L, throughput, &light_ray, &L_light, is_lamp);
+				return;
+			}
+#endif
+
 			/* trace shadow ray */
 			float3 shadow;
 
@@ -274,6 +426,8 @@ ccl_device bool kernel_path_surface_bounce(KernelGlobals *kg,
                                            PathRadianceState *L_state,
                                            ccl_addr_space Ray *ray)
 {
+	PROFILING_INIT(kg, PROFILING_SURFACE_BOUNCE);
+
 	/* no BSDF? we can stop here */
 	if(sd->flag & SD_BSDF) {
 		/* sample BSDF */
@@ -54,6 +54,8 @@ ccl_device_noinline void shader_setup_from_ray(KernelGlobals *kg,
                                                const Intersection *isect,
                                                const Ray *ray)
 {
+	PROFILING_INIT(kg, PROFILING_SHADER_SETUP);
+
 #ifdef __INSTANCING__
 	sd->object = (isect->object == PRIM_NONE)? kernel_tex_fetch(__prim_object, isect->prim): isect->object;
 #endif
@@ -116,6 +118,9 @@ ccl_device_noinline void shader_setup_from_ray(KernelGlobals *kg,
 
 	sd->flag |= kernel_tex_fetch(__shader_flag, (sd->shader & SHADER_MASK)*SHADER_SIZE);
 
+	PROFILING_SHADER(sd->shader);
+	PROFILING_OBJECT(sd->object);
+
 #ifdef __INSTANCING__
 	if(isect->object != OBJECT_NONE) {
 		/* instance transform */
@@ -962,6 +967,8 @@ ccl_device float3 shader_holdout_eval(KernelGlobals *kg, ShaderData *sd)
 ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	ccl_addr_space PathState *state, int path_flag, int max_closure)
 {
+	PROFILING_INIT(kg, PROFILING_SHADER_EVAL);
+
 	sd->num_closure = 0;
 	sd->num_closure_left = max_closure;
 
@@ -992,6 +999,8 @@ ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 ccl_device float3 shader_eval_background(KernelGlobals *kg, ShaderData *sd,
 	ccl_addr_space PathState *state, int path_flag)
 {
+	PROFILING_INIT(kg, PROFILING_SHADER_EVAL);
+
 	sd->num_closure = 0;
 	sd->num_closure_left = 0;
 
@@ -1137,6 +1146,8 @@ ccl_device_inline void shader_eval_volume(KernelGlobals *kg,
                                           int path_flag,
                                           int max_closure)
 {
+	PROFILING_INIT(kg, PROFILING_SHADER_EVAL);
+
 	/* reset closures once at the start, we will be accumulating the closures
 	 * for all volumes in the stack into a single array of closures */
 	sd->num_closure = 0;
@@ -1155,6 +1166,9 @@ ccl_device_inline void shader_eval_volume(KernelGlobals *kg,
 		sd->flag |= kernel_tex_fetch(__shader_flag, (sd->shader & SHADER_MASK)*SHADER_SIZE);
 		sd->object_flag &= ~SD_OBJECT_FLAGS;
 
+		PROFILING_SHADER(sd->shader);
+		PROFILING_OBJECT(sd->object);
+
 		if(sd->object != OBJECT_NONE) {
 			sd->object_flag |= kernel_tex_fetch(__object_flag, sd->object);
 
@@ -456,6 +456,8 @@ ccl_device_inline bool shadow_blocked(KernelGlobals *kg,
                                       Ray *ray_input,
                                       float3 *shadow)
 {
+	PROFILING_INIT(kg, PROFILING_SHADOW);
+
 	Ray *ray = ray_input;
 	Intersection isect;
 	/* Some common early checks. */
@@ -552,6 +554,194 @@ ccl_device_inline bool shadow_blocked(KernelGlobals *kg,
 #endif  /* __TRANSPARENT_SHADOWS__ */
 }
 
+#ifdef __RAY_STREAM__
+/* Only opaque shadows outside of volumes can be traced as a stream. */
+ccl_device_inline bool shadow_stream_supported(KernelGlobals *kg,
+                                               ccl_addr_space PathState *state)
+{
+	bool use_stream = scene_intersect_stream_supported(kg);
+#  ifdef __TRANSPARENT_SHADOWS__
+	use_stream = use_stream && !kernel_data.integrator.transparent_shadows;
+#  endif
+#  ifdef __VOLUME__
+	/* Volume attenuation is computed per ray. */
+	use_stream = use_stream && (state->volume_stack[0].shader == SHADER_NONE);
+#  endif
+	return use_stream;
+}
+
+/* Shadow test for a stream of up to RAY_STREAM_SIZE rays leaving the same
+ * shading point, returns the mask of the blocked rays. Opaque shadows are
+ * traced together, otherwise the rays are traced one by one.
+ */
+ccl_device_inline uint shadow_blocked_stream(KernelGlobals *kg,
+                                             ShaderData *sd,
+                                             ShaderData *shadow_sd,
+                                             ccl_addr_space PathState *state,
+                                             Ray *rays,
+                                             int num_rays,
+                                             float3 *shadows)
+{
+	PROFILING_INIT(kg, PROFILING_SHADOW);
+
+	uint blocked_mask = 0;
+
+	if(!shadow_stream_supported(kg, state)) {
+		for(int i = 0; i < num_rays; i++) {
+			if(shadow_blocked(kg, sd, shadow_sd, state, &rays[i], &shadows[i])) {
+				blocked_mask |= (1u << i);
+			}
+		}
+		return blocked_mask;
+	}
+
+#  ifdef __SHADOW_TRICKS__
+	const uint visibility = (state->flag & PATH_RAY_SHADOW_CATCHER)
+		? PATH_RAY_SHADOW_NON_CATCHER
+		: PATH_RAY_SHADOW;
+#  else
+	const uint visibility = PATH_RAY_SHADOW;
+#  endif
+
+	for(int i = 0; i < num_rays; i++) {
+		shadows[i] = make_float3(1.0f, 1.0f, 1.0f);
+	}
+
+	/* Rays with zero length are left inactive by the traversal. */
+	Intersection isects[RAY_STREAM_SIZE];
+	return scene_intersect_stream(kg,
+	                              rays,
+	                              isects,
+	                              num_rays,
+	                              visibility & PATH_RAY_SHADOW_OPAQUE);
+}
+
+/* Shadow rays of the path integrator, collected from all paths of a pixel
+ * span and traced as one stream. Whether a shadow ray is blocked only
+ * decides what is added to the radiance of its path, so the path goes on
+ * and the result is accumulated when the stream is traced.
+ */
+typedef struct ShadowRayStream {
+	Ray rays[RAY_STREAM_SIZE];
+	PathRadiance *L[RAY_STREAM_SIZE];
+	/* Path state and throughput at the shading point. */
+	PathState state[RAY_STREAM_SIZE];
+	float3 throughput[RAY_STREAM_SIZE];
+	/* Light samples. */
+	BsdfEval eval[RAY_STREAM_SIZE];
+	bool is_lamp[RAY_STREAM_SIZE];
+	/* AO samples. */
+	bool is_ao[RAY_STREAM_SIZE];
+	float3 ao_alpha[RAY_STREAM_SIZE];
+	float3 ao_bsdf[RAY_STREAM_SIZE];
+	int num_rays;
+} ShadowRayStream;
+
+ccl_device_inline void shadow_ray_stream_flush(KernelGlobals *kg,
+                                               ShadowRayStream *stream)
+{
+	if(stream->num_rays == 0) {
+		return;
+	}
+
+	PROFILING_INIT(kg, PROFILING_SHADOW);
+
+	/* Shadow catcher paths are not queued, all rays have the same
+	 * visibility. */
+	Intersection isects[RAY_STREAM_SIZE];
+	uint blocked = scene_intersect_stream(kg,
+	                                      stream->rays,
+	                                      isects,
+	                                      stream->num_rays,
+	                                      PATH_RAY_SHADOW & PATH_RAY_SHADOW_OPAQUE);
+
+	const float3 shadow = make_float3(1.0f, 1.0f, 1.0f);
+
+	for(int i = 0; i < stream->num_rays; i++) {
+		PathRadiance *L = stream->L[i];
+		PathState *state = &stream->state[i];
+		float3 throughput = stream->throughput[i];
+
+		if(stream->is_ao[i]) {
+			if(!(blocked & (1u << i))) {
+				path_radiance_accum_ao(L, state, throughput, stream->ao_alpha[i], stream->ao_bsdf[i], shadow);
+			}
+			else {
+				path_radiance_accum_total_ao(L, state, throughput, stream->ao_bsdf[i]);
+			}
+		}
+		else {
+			if(!(blocked & (1u << i))) {
+				path_radiance_accum_light(L, state, throughput, &stream->eval[i], shadow, 1.0f, stream->is_lamp[i]);
+			}
+			else {
+				path_radiance_accum_total_light(L, state, throughput, &stream->eval[i]);
+			}
+		}
+	}
+
+	stream->num_rays = 0;
+}
+
+/* Returns the stream to queue a shadow ray of the path in, or NULL when it
+ * has to be traced right away. */
+ccl_device_inline ShadowRayStream *shadow_ray_stream_get(KernelGlobals *kg,
+                                                         ccl_addr_space PathState *state)
+{
+	ShadowRayStream *stream = kg->shadow_stream;
+
+	if(stream == NULL || !shadow_stream_supported(kg, state)) {
+		return NULL;
+	}
+#  ifdef __SHADOW_TRICKS__
+	if(state->flag & PATH_RAY_SHADOW_CATCHER) {
+		return NULL;
+	}
+#  endif
+
+	if(stream->num_rays == RAY_STREAM_SIZE) {
+		shadow_ray_stream_flush(kg, stream);
+	}
+	return stream;
+}
+
+ccl_device_inline void shadow_ray_stream_queue_light(ShadowRayStream *stream,
+                                                     ccl_addr_space PathState *state,
+                                                     PathRadiance *L,
+                                                     float3 throughput,
+                                                     Ray *ray,
+                                                     BsdfEval *eval,
+                                                     bool is_lamp)
+{
+	int i = stream->num_rays++;
+	stream->rays[i] = *ray;
+	stream->L[i] = L;
+	stream->state[i] = *state;
+	stream->throughput[i] = throughput;
+	stream->eval[i] = *eval;
+	stream->is_lamp[i] = is_lamp;
+	stream->is_ao[i] = false;
+}
+
+ccl_device_inline void shadow_ray_stream_queue_ao(ShadowRayStream *stream,
+                                                  ccl_addr_space PathState *state,
+                                                  PathRadiance *L,
+                                                  float3 throughput,
+                                                  Ray *ray,
+                                                  float3 ao_alpha,
+                                                  float3 ao_bsdf)
+{
+	int i = stream->num_rays++;
+	stream->rays[i] = *ray;
+	stream->L[i] = L;
+	stream->state[i] = *state;
+	stream->throughput[i] = throughput;
+	stream->ao_alpha[i] = ao_alpha;
+	stream->ao_bsdf[i] = ao_bsdf;
+	stream->is_ao[i] = true;
+}
+#endif  /* __RAY_STREAM__ */
+
 #undef SHADOW_STACK_MAX_HITS
 
 CCL_NAMESPACE_END
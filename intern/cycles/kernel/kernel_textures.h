@@ -42,6 +42,8 @@ KERNEL_TEX(float4, __objects_vector)
 KERNEL_TEX(uint, __tri_shader)
 KERNEL_TEX(float4, __tri_vnormal)
 KERNEL_TEX(uint4, __tri_vindex)
+KERNEL_TEX(float4, __tri_verts)
+KERNEL_TEX(uint, __tri_vnormal_oct)
 KERNEL_TEX(uint, __tri_patch)
 KERNEL_TEX(float2, __tri_patch_uv)
 
@@ -63,6 +65,9 @@ KERNEL_TEX(float4, __light_distribution)
 KERNEL_TEX(float4, __light_data)
 KERNEL_TEX(float2, __light_background_marginal_cdf)
 KERNEL_TEX(float2, __light_background_conditional_cdf)
+KERNEL_TEX(float4, __light_tree_nodes)
+KERNEL_TEX(uint, __light_tree_emitters)
+KERNEL_TEX(uint, __light_tree_positions)
 
 /* particles */
 KERNEL_TEX(float4, __particles)
@@ -38,6 +38,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		12
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE		11
+#define LIGHT_TREE_NODE_SIZE	4
 #define FILTER_TABLE_SIZE	1024
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
@@ -57,6 +58,9 @@ CCL_NAMESPACE_BEGIN
 
 #define VOLUME_STACK_SIZE		16
 
+/* Number of rays traced together by the CPU ray stream traversal. */
+#define RAY_STREAM_SIZE			16
+
 /* Split kernel constants */
 #define WORK_POOL_SIZE_GPU 64
 #define WORK_POOL_SIZE_CPU 1
@@ -82,6 +86,10 @@ CCL_NAMESPACE_BEGIN
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
+#    define __RAY_STREAM__
+#  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
 #  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
@@ -346,6 +354,9 @@ enum PathRayFlag {
 
 	PATH_RAY_ALL_VISIBILITY = ((1 << 14)-1),
 
+	/* Special flag to tag BVH nodes with quantized child bounds. */
+	PATH_RAY_NODE_QUANTIZED = (1 << 14),
+
 	PATH_RAY_MIS_SKIP            = (1 << 15),
 	PATH_RAY_DIFFUSE_ANCESTOR    = (1 << 16),
 	PATH_RAY_SINGLE_PASS_DONE    = (1 << 17),
@@ -394,6 +405,8 @@ typedef enum PassType {
 	PASS_RAY_BOUNCES,
 #endif
 	PASS_RENDER_TIME,
+	PASS_SAMPLE_COUNT,
+	PASS_ADAPTIVE_AUX_BUFFER,
 	PASS_CATEGORY_MAIN_END = 31,
 
 	PASS_MIST = 32,
@@ -1243,7 +1256,9 @@ typedef struct KernelFilm {
 	int pass_denoising_clean;
 	int denoising_flags;
 
-	int pad1, pad2, pad3;
+	int pass_sample_count;
+	int pass_adaptive_aux_buffer;
+	int pad1;
 
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversed_nodes;
@@ -1285,6 +1300,12 @@ typedef struct KernelIntegrator {
 	int num_portals;
 	int portal_offset;
 
+	/* light tree */
+	int use_light_tree;
+	int light_tree_num_emitters;
+	int light_tree_num_infinite;
+	float light_tree_infinite_pdf;
+
 	/* bounces */
 	int max_bounce;
 
@@ -1339,6 +1360,10 @@ typedef struct KernelIntegrator {
 	int start_sample;
 
 	int max_closures;
+
+	/* adaptive sampling */
+	float adaptive_threshold;
+	int pad1, pad2, pad3;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1349,8 +1374,11 @@ typedef struct KernelBVH {
 	int have_curves;
 	int have_instancing;
 	int use_qbvh;
+	int use_obvh;
 	int use_bvh_steps;
-	int pad1, pad2;
+	/* Vertices shared through the vertex index buffer and octahedral
+	 * encoded normals, instead of per triangle storage. */
+	int use_compact_geometry;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
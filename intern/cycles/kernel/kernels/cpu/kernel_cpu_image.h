@@ -17,6 +17,8 @@
 #ifndef __KERNEL_CPU_IMAGE_H__
 #define __KERNEL_CPU_IMAGE_H__
 
+#include "util/util_texture_cache.h"
+
 CCL_NAMESPACE_BEGIN
 
 template<typename T> struct TextureInterpolator  {
@@ -242,6 +244,110 @@ template<typename T> struct TextureInterpolator  {
 		}
 	}
 
+	/* ********  2D texture cache interpolation ******** */
+
+	static ccl_always_inline bool cache_wrap(int *x, int width, uint extension)
+	{
+		switch(extension) {
+			case EXTENSION_REPEAT:
+				*x = wrap_periodic(*x, width);
+				return true;
+			case EXTENSION_CLIP:
+				return (*x >= 0 && *x < width);
+			case EXTENSION_EXTEND:
+			default:
+				*x = wrap_clamp(*x, width);
+				return true;
+		}
+	}
+
+	static ccl_always_inline float4 cache_read(KernelGlobals *kg,
+	                                           TextureCacheImage *image,
+	                                           const TextureCacheImage::Level& level,
+	                                           int level_index,
+	                                           uint extension,
+	                                           int x, int y)
+	{
+		if(!cache_wrap(&x, level.width, extension) ||
+		   !cache_wrap(&y, level.height, extension))
+		{
+			return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+		}
+		const void *pixel = texture_cache_lookup(kg->texture_cache_thread,
+		                                         image,
+		                                         level_index,
+		                                         x, y);
+		return read(*(const T*)pixel);
+	}
+
+	/* Images which are loaded in tiles on demand. The mip level is chosen so
+	 * texels have about the size of the filter width, given in texture space.
+	 */
+	static float4 interp_cache(KernelGlobals *kg,
+	                           const TextureInfo& info,
+	                           float x, float y,
+	                           float filter_width)
+	{
+		TextureCacheImage *image = (TextureCacheImage*)info.data;
+		const uint extension = info.extension;
+
+		int level_index = 0;
+		const float texels = filter_width * (float)max((int)info.width, (int)info.height);
+		if(texels > 1.0f) {
+			level_index = min(float_to_int(log2f(texels)),
+			                  (int)image->levels.size() - 1);
+		}
+		const TextureCacheImage::Level& level = image->levels[level_index];
+		const int width = level.width;
+		const int height = level.height;
+
+		int ix, iy;
+		switch(info.interpolation) {
+			case INTERPOLATION_CLOSEST: {
+				if(extension == EXTENSION_CLIP) {
+					if(x < 0.0f || y < 0.0f || x > 1.0f || y > 1.0f) {
+						return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+					}
+				}
+				frac(x*(float)width, &ix);
+				frac(y*(float)height, &iy);
+				if(extension == EXTENSION_CLIP) {
+					ix = wrap_clamp(ix, width);
+					iy = wrap_clamp(iy, height);
+				}
+				return cache_read(kg, image, level, level_index, extension, ix, iy);
+			}
+			case INTERPOLATION_LINEAR: {
+				const float tx = frac(x*(float)width - 0.5f, &ix);
+				const float ty = frac(y*(float)height - 0.5f, &iy);
+#define DATA(dx, dy) cache_read(kg, image, level, level_index, extension, ix + dx, iy + dy)
+				return (1.0f - ty) * (1.0f - tx) * DATA(0, 0) +
+				       (1.0f - ty) * tx * DATA(1, 0) +
+				       ty * (1.0f - tx) * DATA(0, 1) +
+				       ty * tx * DATA(1, 1);
+#undef DATA
+			}
+			default: {
+				const float tx = frac(x*(float)width - 0.5f, &ix);
+				const float ty = frac(y*(float)height - 0.5f, &iy);
+				float u[4], v[4];
+#define DATA(dx, dy) cache_read(kg, image, level, level_index, extension, ix + dx - 1, iy + dy - 1)
+#define TERM(col) \
+				(v[col] * (u[0] * DATA(0, col) + \
+				           u[1] * DATA(1, col) + \
+				           u[2] * DATA(2, col) + \
+				           u[3] * DATA(3, col)))
+
+				SET_CUBIC_SPLINE_WEIGHTS(u, tx);
+				SET_CUBIC_SPLINE_WEIGHTS(v, ty);
+
+				return TERM(0) + TERM(1) + TERM(2) + TERM(3);
+#undef TERM
+#undef DATA
+			}
+		}
+	}
+
 	/* ********  3D interpolation ******** */
 
 	static ccl_always_inline float4 interp_3d_closest(const TextureInfo& info,
@@ -472,10 +578,35 @@ template<typename T> struct TextureInterpolator  {
 #undef SET_CUBIC_SPLINE_WEIGHTS
 };
 
-ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
+ccl_device float4 kernel_tex_image_interp_cache(KernelGlobals *kg, int id, const TextureInfo& info, float x, float y, float filter_width)
+{
+	switch(kernel_tex_type(id)) {
+		case IMAGE_DATA_TYPE_HALF:
+			return TextureInterpolator<half>::interp_cache(kg, info, x, y, filter_width);
+		case IMAGE_DATA_TYPE_BYTE:
+			return TextureInterpolator<uchar>::interp_cache(kg, info, x, y, filter_width);
+		case IMAGE_DATA_TYPE_FLOAT:
+			return TextureInterpolator<float>::interp_cache(kg, info, x, y, filter_width);
+		case IMAGE_DATA_TYPE_HALF4:
+			return TextureInterpolator<half4>::interp_cache(kg, info, x, y, filter_width);
+		case IMAGE_DATA_TYPE_BYTE4:
+			return TextureInterpolator<uchar4>::interp_cache(kg, info, x, y, filter_width);
+		case IMAGE_DATA_TYPE_FLOAT4:
+		default:
+			return TextureInterpolator<float4>::interp_cache(kg, info, x, y, filter_width);
+	}
+}
+
+/* Filter width is the size of the lookup footprint in texture space, used to
+ * select the mip level of images in the texture cache. */
+ccl_device float4 kernel_tex_image_interp_filtered(KernelGlobals *kg, int id, float x, float y, float filter_width)
 {
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
 
+	if(info.use_cache) {
+		return kernel_tex_image_interp_cache(kg, id, info, x, y, filter_width);
+	}
+
 	switch(kernel_tex_type(id)) {
 		case IMAGE_DATA_TYPE_HALF:
 			return TextureInterpolator<half>::interp(info, x, y);
@@ -493,10 +624,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 	}
 }
 
+ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
+{
+	return kernel_tex_image_interp_filtered(kg, id, x, y, 0.0f);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg, int id, float x, float y, float z, InterpolationType interp)
 {
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
 
+	if(UNLIKELY(info.use_cache)) {
+		/* Only 2D images are stored in the texture cache. */
+		return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
 	switch(kernel_tex_type(id)) {
 		case IMAGE_DATA_TYPE_HALF:
 			return TextureInterpolator<half>::interp_3d(info, x, y, z, interp);
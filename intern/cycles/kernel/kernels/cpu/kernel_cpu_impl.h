@@ -100,6 +100,81 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_stream)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int num_pixels,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_stream);
+#else
+#  ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		/* Shadow and AO rays are streamed per shading point instead. */
+		for(int i = 0; i < num_pixels; i++) {
+			kernel_branched_path_trace(kg,
+			                           buffer,
+			                           sample,
+			                           x + i, y,
+			                           offset,
+			                           stride);
+		}
+	}
+	else
+#  endif
+	{
+#  ifdef __RAY_STREAM__
+		kernel_path_trace_stream(kg, buffer, sample, x, y, num_pixels, offset, stride);
+#  else
+		for(int i = 0; i < num_pixels; i++) {
+			kernel_path_trace(kg, buffer, sample, x + i, y, offset, stride);
+		}
+#  endif
+	}
+#endif /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int num_samples,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+	return false;
+#else
+	int index = offset + x + y*stride;
+	return kernel_adaptive_stopping(kg,
+	                                buffer + index*kernel_data.film.pass_stride,
+	                                num_samples);
+#endif /* KERNEL_STUB */
+}
+
+int KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                       float *buffer,
+                                                       int num_samples,
+                                                       int x, int y,
+                                                       int offset,
+                                                       int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+	return 0;
+#else
+	int index = offset + x + y*stride;
+	return kernel_adaptive_adjust_samples(kg,
+	                                      buffer + index*kernel_data.film.pass_stride,
+	                                      num_samples);
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
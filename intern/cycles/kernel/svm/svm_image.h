@@ -16,9 +16,13 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float filter_width, uint srgb, uint use_alpha)
 {
+#ifdef __KERNEL_CPU__
+	float4 r = kernel_tex_image_interp_filtered(kg, id, x, y, filter_width);
+#else
 	float4 r = kernel_tex_image_interp(kg, id, x, y);
+#endif
 	const float alpha = r.w;
 
 	if(use_alpha && alpha != 1.0f && alpha != 0.0f) {
@@ -39,6 +43,22 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 	return r;
 }
 
+/* Size of the ray footprint in the default UV map. */
+ccl_device float svm_image_uv_filter_width(KernelGlobals *kg, ShaderData *sd)
+{
+#if defined(__KERNEL_CPU__) && defined(__RAY_DIFFERENTIALS__)
+	const AttributeDescriptor desc = find_attribute(kg, sd, ATTR_STD_UV);
+
+	if(desc.offset != ATTR_STD_NOT_FOUND) {
+		float3 dx, dy;
+		primitive_attribute_float3(kg, sd, desc, &dx, &dy);
+		return max(len(make_float2(dx.x, dx.y)), len(make_float2(dy.x, dy.y)));
+	}
+#endif
+
+	return 0.0f;
+}
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
@@ -48,9 +68,9 @@ ccl_device_inline float3 texco_remap_square(float3 co)
 ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
 {
 	uint id = node.y;
-	uint co_offset, out_offset, alpha_offset, srgb;
+	uint co_offset, out_offset, alpha_offset, flags;
 
-	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
+	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &flags);
 
 	float3 co = stack_load_float3(stack, co_offset);
 	float2 tex_co;
@@ -66,7 +86,15 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 	else {
 		tex_co = make_float2(co.x, co.y);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+	float filter_width = 0.0f;
+	if(flags & NODE_IMAGE_UV_FILTER) {
+		filter_width = svm_image_uv_filter_width(kg, sd);
+	}
+	float4 f = svm_image_texture(kg, id,
+	                             tex_co.x, tex_co.y,
+	                             filter_width,
+	                             flags & NODE_IMAGE_SRGB,
+	                             use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -157,15 +185,15 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
 	/* Map so that no textures are flipped, rotation is somewhat arbitrary. */
 	if(weight.x > 0.0f) {
 		float2 uv = make_float2((signed_N.x < 0.0f)? 1.0f - co.y: co.y, co.z);
-		f += weight.x*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		f += weight.x*svm_image_texture(kg, id, uv.x, uv.y, 0.0f, srgb, use_alpha);
 	}
 	if(weight.y > 0.0f) {
 		float2 uv = make_float2((signed_N.y > 0.0f)? 1.0f - co.x: co.x, co.z);
-		f += weight.y*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		f += weight.y*svm_image_texture(kg, id, uv.x, uv.y, 0.0f, srgb, use_alpha);
 	}
 	if(weight.z > 0.0f) {
 		float2 uv = make_float2((signed_N.z > 0.0f)? 1.0f - co.y: co.y, co.x);
-		f += weight.z*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		f += weight.z*svm_image_texture(kg, id, uv.x, uv.y, 0.0f, srgb, use_alpha);
 	}
 
 	if(stack_valid(out_offset))
@@ -193,7 +221,7 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, floa
 		uv = direction_to_mirrorball(co);
 
 	uint use_alpha = stack_valid(alpha_offset);
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, 0.0f, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -363,6 +363,14 @@ typedef enum NodeImageProjection {
 	NODE_IMAGE_PROJ_TUBE   = 3,
 } NodeImageProjection;
 
+/* Flags packed together with the color space of image texture nodes. */
+typedef enum NodeImageFlags {
+	NODE_IMAGE_SRGB        = (1 << 0),
+	/* Texture coordinate is the default UV map, so its derivatives give the
+	 * filter width for mip level selection. */
+	NODE_IMAGE_UV_FILTER   = (1 << 1),
+} NodeImageFlags;
+
 typedef enum NodeEnvironmentProjection {
 	NODE_ENVIRONMENT_EQUIRECTANGULAR = 0,
 	NODE_ENVIRONMENT_MIRROR_BALL = 1,
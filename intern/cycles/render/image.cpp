@@ -19,10 +19,12 @@
 #include "render/scene.h"
 
 #include "util/util_foreach.h"
+#include "util/util_list.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -40,12 +42,402 @@ static bool isfinite(half /*value*/)
 	return false;
 }
 
+/* Converts a pixel with given number of components read from an image to the
+ * layout of the texture, which has four channels for RGBA textures. Pixels
+ * can be converted in place when out does not start before in.
+ */
+template<TypeDesc::BASETYPE FileFormat, typename StorageType>
+static void image_convert_pixel(const StorageType *in,
+                                StorageType *out,
+                                int components,
+                                bool is_rgba,
+                                bool cmyk,
+                                bool use_alpha)
+{
+	const StorageType alpha_one = (FileFormat == TypeDesc::UINT8)? 255 : 1;
+
+	if(!is_rgba) {
+		out[0] = in[0];
+		if(FileFormat == TypeDesc::FLOAT && !isfinite(out[0])) {
+			out[0] = 0;
+		}
+		return;
+	}
+
+	StorageType r, g, b, a;
+	if(cmyk) {
+		r = (in[0]*in[3])/255;
+		g = (in[1]*in[3])/255;
+		b = (in[2]*in[3])/255;
+		a = alpha_one;
+	}
+	else if(components == 1) {
+		/* grayscale */
+		r = g = b = in[0];
+		a = alpha_one;
+	}
+	else if(components == 2) {
+		/* grayscale + alpha */
+		r = g = b = in[0];
+		a = in[1];
+	}
+	else if(components == 3) {
+		/* RGB */
+		r = in[0];
+		g = in[1];
+		b = in[2];
+		a = alpha_one;
+	}
+	else {
+		r = in[0];
+		g = in[1];
+		b = in[2];
+		a = in[3];
+	}
+
+	if(!use_alpha) {
+		a = alpha_one;
+	}
+
+	/* Make sure we don't have buggy values. All channels are set to 0 if
+	 * either of them is not finite, this way we avoid possible artifacts
+	 * caused by fully changed hue.
+	 */
+	if(FileFormat == TypeDesc::FLOAT) {
+		if(!isfinite(r) || !isfinite(g) || !isfinite(b) || !isfinite(a)) {
+			r = g = b = a = 0;
+		}
+	}
+
+	out[0] = r;
+	out[1] = g;
+	out[2] = b;
+	out[3] = a;
+}
+
+/* Maximum number of image files kept open by texture cache readers. Files of
+ * the least recently read images are closed when more are needed, and opened
+ * again when their tiles are read.
+ */
+#define IMAGE_CACHE_MAX_OPEN_FILES 64
+
+/* Image file read by the texture cache, which is closed while not being read
+ * when too many files are open.
+ */
+class ImageCacheFile {
+public:
+	ImageCacheFile(ImageCacheFiles *files,
+	               ImageInput *in,
+	               const string& filename,
+	               bool use_alpha);
+	virtual ~ImageCacheFile();
+
+	/* Both must be called with file_mutex locked. */
+	bool open_file();
+	void close_file();
+
+	thread_mutex file_mutex;
+
+protected:
+	friend class ImageCacheFiles;
+
+	/* Called when the file was closed, to free data kept for reading. */
+	virtual void file_closed() {}
+
+	ImageCacheFiles *files;
+	ImageInput *in;
+	string filename;
+	bool use_alpha;
+	int width, height, components;
+
+	/* Position in the list of open files, protected by its mutex. */
+	list<ImageCacheFile*>::iterator files_it;
+	bool in_files;
+};
+
+/* Open files of all texture cache readers of an image manager, most
+ * recently read first.
+ */
+class ImageCacheFiles {
+public:
+	ImageCacheFiles() {}
+
+	~ImageCacheFiles()
+	{
+		assert(files.empty());
+	}
+
+	/* Marks the file as most recently read and closes files of other images
+	 * when there are too many open ones. Files being read are skipped. */
+	void touch(ImageCacheFile *file)
+	{
+		thread_scoped_lock lock(mutex);
+
+		if(file->in_files) {
+			files.erase(file->files_it);
+		}
+		files.push_front(file);
+		file->files_it = files.begin();
+		file->in_files = true;
+
+		list<ImageCacheFile*>::iterator it = files.end();
+		while(files.size() > IMAGE_CACHE_MAX_OPEN_FILES && it != files.begin()) {
+			--it;
+			ImageCacheFile *other = *it;
+			if(other == file || !other->file_mutex.try_lock()) {
+				continue;
+			}
+
+			it = files.erase(it);
+			other->in_files = false;
+			other->close_file();
+			other->file_mutex.unlock();
+		}
+	}
+
+	void remove(ImageCacheFile *file)
+	{
+		thread_scoped_lock lock(mutex);
+
+		if(file->in_files) {
+			files.erase(file->files_it);
+			file->in_files = false;
+		}
+	}
+
+protected:
+	thread_mutex mutex;
+	list<ImageCacheFile*> files;
+};
+
+ImageCacheFile::ImageCacheFile(ImageCacheFiles *files,
+                               ImageInput *in,
+                               const string& filename,
+                               bool use_alpha)
+: files(files),
+  in(in),
+  filename(filename),
+  use_alpha(use_alpha),
+  in_files(false)
+{
+	const ImageSpec& spec = in->spec();
+	width = spec.width;
+	height = spec.height;
+	components = spec.nchannels;
+
+	files->touch(this);
+}
+
+ImageCacheFile::~ImageCacheFile()
+{
+	files->remove(this);
+	if(in) {
+		in->close();
+		delete in;
+	}
+}
+
+bool ImageCacheFile::open_file()
+{
+	if(!in) {
+		in = ImageInput::create(filename);
+		if(!in) {
+			return false;
+		}
+
+		ImageSpec spec = ImageSpec();
+		ImageSpec config = ImageSpec();
+
+		if(use_alpha == false)
+			config.attribute("oiio:UnassociatedAlpha", 1);
+
+		/* The file might have been changed since it was added to the cache. */
+		if(!in->open(filename, spec, config) ||
+		   spec.width != width ||
+		   spec.height != height ||
+		   spec.nchannels != components)
+		{
+			VLOG(1) << "Failed to open " << filename << " again for the texture cache.";
+			delete in;
+			in = NULL;
+			return false;
+		}
+	}
+
+	files->touch(this);
+	return true;
+}
+
+void ImageCacheFile::close_file()
+{
+	if(in) {
+		in->close();
+		delete in;
+		in = NULL;
+	}
+	file_closed();
+}
+
+/* Reads tiles of an image file for the texture cache, converting pixels the
+ * same way as file_load_image().
+ *
+ * Tiled files are read in whole tiles of the file. Scanline files are decoded
+ * in full width bands, the last band is kept for the other tiles in the same
+ * row.
+ */
+template<TypeDesc::BASETYPE FileFormat, typename StorageType>
+class ImageCacheReader : public TextureCacheReader, public ImageCacheFile {
+public:
+	ImageCacheReader(ImageCacheFiles *files,
+	                 ImageInput *in,
+	                 const string& filename,
+	                 bool is_rgba,
+	                 bool use_alpha)
+	: ImageCacheFile(files, in, filename, use_alpha),
+	  is_rgba(is_rgba),
+	  region_level(-1)
+	{
+		cmyk = strcmp(in->format_name(), "jpeg") == 0 && components == 4;
+	}
+
+	~ImageCacheReader()
+	{
+		/* Before members are freed, so the file can't be closed anymore. */
+		files->remove(this);
+	}
+
+	bool has_level(int level)
+	{
+		if(level == 0) {
+			return true;
+		}
+
+		thread_scoped_lock file_lock(file_mutex);
+		if(!open_file()) {
+			return false;
+		}
+
+		/* Use mip levels stored in the file, when they match ours. */
+		ImageSpec spec;
+		if(!in->seek_subimage(0, level, spec)) {
+			return false;
+		}
+
+		return spec.width == max(width >> level, 1) &&
+		       spec.height == max(height >> level, 1) &&
+		       spec.nchannels == components;
+	}
+
+	bool read(int level, int x, int y, int w, int h, void *pixels)
+	{
+		thread_scoped_lock file_lock(file_mutex);
+		if(!open_file()) {
+			return false;
+		}
+
+		ImageSpec spec;
+		if(!in->seek_subimage(0, level, spec)) {
+			return false;
+		}
+
+		/* Rows in the file are ordered from top to bottom. */
+		const bool tiled = (spec.tile_width > 0 && spec.tile_height > 0);
+		int xbegin, xend, ybegin, yend;
+
+		if(tiled) {
+			xbegin = (x / spec.tile_width) * spec.tile_width;
+			xend = min((int)round_up(x + w, spec.tile_width), spec.width);
+			ybegin = ((spec.height - (y + h)) / spec.tile_height) * spec.tile_height;
+			yend = min((int)round_up(spec.height - y, spec.tile_height), spec.height);
+		}
+		else {
+			xbegin = 0;
+			xend = spec.width;
+			ybegin = spec.height - (y + h);
+			yend = spec.height - y;
+		}
+
+		if(region_level != level ||
+		   region_xbegin != xbegin || region_xend != xend ||
+		   region_ybegin != ybegin || region_yend != yend)
+		{
+			region_level = -1;
+			region.resize(((size_t)(xend - xbegin)) * (yend - ybegin) * components);
+
+			bool ok;
+			if(tiled) {
+				ok = in->read_tiles(spec.x + xbegin, spec.x + xend,
+				                    spec.y + ybegin, spec.y + yend,
+				                    spec.z, spec.z + 1,
+				                    FileFormat,
+				                    &region[0]);
+			}
+			else {
+				ok = in->read_scanlines(spec.y + ybegin, spec.y + yend,
+				                        spec.z,
+				                        FileFormat,
+				                        &region[0]);
+			}
+			if(!ok) {
+				return false;
+			}
+
+			region_level = level;
+			region_xbegin = xbegin;
+			region_xend = xend;
+			region_ybegin = ybegin;
+			region_yend = yend;
+		}
+
+		const size_t region_row_size = ((size_t)(xend - xbegin)) * components;
+		const int channels = is_rgba? 4: 1;
+		StorageType *out = (StorageType*)pixels;
+
+		for(int j = 0; j < h; j++) {
+			const int file_y = spec.height - 1 - (y + j);
+			const StorageType *row = &region[(file_y - ybegin) * region_row_size +
+			                                 (x - xbegin) * components];
+			for(int i = 0; i < w; i++) {
+				image_convert_pixel<FileFormat>(row + i * components,
+				                                out + (j * w + i) * channels,
+				                                components,
+				                                is_rgba,
+				                                cmyk,
+				                                use_alpha);
+			}
+		}
+
+		return true;
+	}
+
+protected:
+	void file_closed()
+	{
+		region_level = -1;
+		vector<StorageType>().swap(region);
+	}
+
+	bool is_rgba;
+	bool cmyk;
+
+	/* Pixels of the last read region of the file. */
+	vector<StorageType> region;
+	int region_level;
+	int region_xbegin, region_xend;
+	int region_ybegin, region_yend;
+};
+
 ImageManager::ImageManager(const DeviceInfo& info)
 {
 	need_update = true;
 	osl_texture_system = NULL;
 	animation_frame = 0;
 
+	texture_cache_supported = (info.type == DEVICE_CPU);
+	texture_cache_size = 0;
+	texture_cache = NULL;
+	texture_cache_files = new ImageCacheFiles();
+
 	/* Set image limits */
 	max_num_images = TEX_NUM_MAX;
 	has_half_images = info.has_half_images;
@@ -62,6 +454,9 @@ ImageManager::~ImageManager()
 		for(size_t slot = 0; slot < images[type].size(); slot++)
 			assert(!images[type][slot]);
 	}
+
+	delete texture_cache;
+	delete texture_cache_files;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -69,6 +464,32 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache_size(size_t size)
+{
+	texture_cache_size = size;
+}
+
+bool ImageManager::get_image_use_cache(int flat_slot)
+{
+	ImageDataType type;
+	int slot = flattened_slot_to_type_index(flat_slot, &type);
+
+	Image *img = images[type][slot];
+	return img && img->use_cache;
+}
+
+bool ImageManager::get_texture_cache_stats(TextureCacheStats& stats)
+{
+	thread_scoped_lock device_lock(device_mutex);
+
+	if(!texture_cache) {
+		return false;
+	}
+
+	stats = texture_cache->get_stats();
+	return true;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
 	if(frame != animation_frame) {
@@ -342,6 +763,11 @@ int ImageManager::add_image(const string& filename,
 	img->extension = extension;
 	img->users = 1;
 	img->use_alpha = use_alpha;
+	/* Only image files can be paged in, and OSL uses its own texture cache. */
+	img->use_cache = texture_cache_supported &&
+	                 texture_cache_size > 0 &&
+	                 !builtin_data &&
+	                 !osl_texture_system;
 	img->mem = NULL;
 
 	images[type][slot] = img;
@@ -491,12 +917,41 @@ bool ImageManager::file_load_image(Image *img,
                                    int texture_limit,
                                    device_vector<DeviceType>& tex_img)
 {
-	const StorageType alpha_one = (FileFormat == TypeDesc::UINT8)? 255 : 1;
 	ImageInput *in = NULL;
 	int width, height, depth, components;
 	if(!file_load_image_generic(img, &in, width, height, depth, components)) {
 		return false;
 	}
+	/* Check if we actually have a float4 slot, in case components == 1,
+	 * but device doesn't support single channel textures.
+	 */
+	bool is_rgba = (type == IMAGE_DATA_TYPE_FLOAT4 ||
+	                type == IMAGE_DATA_TYPE_HALF4 ||
+	                type == IMAGE_DATA_TYPE_BYTE4);
+	/* Let the texture cache page in tiles during rendering. */
+	if(img->use_cache && in && depth <= 1 && width > 0 && height > 0 &&
+	   (texture_limit <= 0 || max(width, height) <= texture_limit))
+	{
+		TextureCacheReader *reader =
+			new ImageCacheReader<FileFormat, StorageType>(texture_cache_files,
+			                                              in,
+			                                              img->filename,
+			                                              is_rgba,
+			                                              img->use_alpha);
+
+		thread_scoped_lock device_lock(device_mutex);
+		if(!texture_cache) {
+			texture_cache = new TextureCache(texture_cache_size);
+		}
+		tex_img.texture_cache_image = texture_cache->add_image(img->filename,
+		                                                       type,
+		                                                       width,
+		                                                       height,
+		                                                       reader);
+		/* Device only gets a placeholder, pixels stay in the cache. */
+		tex_img.alloc(1, 1);
+		return true;
+	}
 	/* Read RGBA pixels. */
 	vector<StorageType> pixels_storage;
 	StorageType *pixels;
@@ -570,83 +1025,19 @@ bool ImageManager::file_load_image(Image *img,
 			/* TODO(dingto): Support half for ImBuf. */
 		}
 	}
-	/* Check if we actually have a float4 slot, in case components == 1,
-	 * but device doesn't support single channel textures.
-	 */
-	bool is_rgba = (type == IMAGE_DATA_TYPE_FLOAT4 ||
-	                type == IMAGE_DATA_TYPE_HALF4 ||
-	                type == IMAGE_DATA_TYPE_BYTE4);
-	if(is_rgba) {
-		if(cmyk) {
-			/* CMYK */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+2] = (pixels[i*4+2]*pixels[i*4+3])/255;
-				pixels[i*4+1] = (pixels[i*4+1]*pixels[i*4+3])/255;
-				pixels[i*4+0] = (pixels[i*4+0]*pixels[i*4+3])/255;
-				pixels[i*4+3] = alpha_one;
-			}
-		}
-		else if(components == 2) {
-			/* grayscale + alpha */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = pixels[i*2+1];
-				pixels[i*4+2] = pixels[i*2+0];
-				pixels[i*4+1] = pixels[i*2+0];
-				pixels[i*4+0] = pixels[i*2+0];
-			}
-		}
-		else if(components == 3) {
-			/* RGB */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = alpha_one;
-				pixels[i*4+2] = pixels[i*3+2];
-				pixels[i*4+1] = pixels[i*3+1];
-				pixels[i*4+0] = pixels[i*3+0];
-			}
-		}
-		else if(components == 1) {
-			/* grayscale */
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = alpha_one;
-				pixels[i*4+2] = pixels[i];
-				pixels[i*4+1] = pixels[i];
-				pixels[i*4+0] = pixels[i];
-			}
-		}
-		if(img->use_alpha == false) {
-			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-				pixels[i*4+3] = alpha_one;
-			}
-		}
-	}
-	/* Make sure we don't have buggy values. */
-	if(FileFormat == TypeDesc::FLOAT) {
-		/* For RGBA buffers we put all channels to 0 if either of them is not
-		 * finite. This way we avoid possible artifacts caused by fully changed
-		 * hue.
+	if(is_rgba || FileFormat == TypeDesc::FLOAT) {
+		/* Convert backwards in place, RGBA pixels take at least as much
+		 * space as the pixels read from the file.
 		 */
-		if(is_rgba) {
-			for(size_t i = 0; i < num_pixels; i += 4) {
-				StorageType *pixel = &pixels[i*4];
-				if(!isfinite(pixel[0]) ||
-				   !isfinite(pixel[1]) ||
-				   !isfinite(pixel[2]) ||
-				   !isfinite(pixel[3]))
-				{
-					pixel[0] = 0;
-					pixel[1] = 0;
-					pixel[2] = 0;
-					pixel[3] = 0;
-				}
-			}
-		}
-		else {
-			for(size_t i = 0; i < num_pixels; ++i) {
-				StorageType *pixel = &pixels[i];
-				if(!isfinite(pixel[0])) {
-					pixel[0] = 0;
-				}
-			}
+		const int pixel_components = (is_rgba)? min(components, 4): 1;
+		const int channels = (is_rgba)? 4: 1;
+		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
+			image_convert_pixel<FileFormat>(&pixels[i*pixel_components],
+			                                &pixels[i*channels],
+			                                pixel_components,
+			                                is_rgba,
+			                                cmyk,
+			                                img->use_alpha);
 		}
 	}
 	/* Scale image down if needed. */
@@ -708,6 +1099,7 @@ void ImageManager::device_load_image(Device *device,
 	/* Free previous texture in slot. */
 	if(img->mem) {
 		thread_scoped_lock device_lock(device_mutex);
+		free_texture_cache_image(img);
 		delete img->mem;
 		img->mem = NULL;
 	}
@@ -875,6 +1267,7 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 
 		if(img->mem) {
 			thread_scoped_lock device_lock(device_mutex);
+			free_texture_cache_image(img);
 			delete img->mem;
 		}
 
@@ -884,6 +1277,14 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 	}
 }
 
+void ImageManager::free_texture_cache_image(Image *img)
+{
+	if(img->mem->texture_cache_image) {
+		texture_cache->remove_image(img->mem->texture_cache_image);
+		img->mem->texture_cache_image = NULL;
+	}
+}
+
 void ImageManager::device_update(Device *device,
                                  Scene *scene,
                                  Progress& progress)
@@ -961,6 +1362,13 @@ void ImageManager::device_free(Device *device)
 		}
 		images[type].clear();
 	}
+
+	if(texture_cache) {
+		VLOG(1) << "Texture cache statistics:\n"
+		        << texture_cache->get_stats().full_report();
+		delete texture_cache;
+		texture_cache = NULL;
+	}
 }
 
 CCL_NAMESPACE_END
@@ -28,8 +28,11 @@
 CCL_NAMESPACE_BEGIN
 
 class Device;
+class ImageCacheFiles;
 class Progress;
 class Scene;
+class TextureCache;
+struct TextureCacheStats;
 
 class ImageManager {
 public:
@@ -74,6 +77,11 @@ public:
 	void set_osl_texture_system(void *texture_system);
 	bool set_animation_frame_update(int frame);
 
+	/* Memory limit of the texture cache in bytes, zero disables it. */
+	void set_texture_cache_size(size_t size);
+	bool get_image_use_cache(int flat_slot);
+	bool get_texture_cache_stats(TextureCacheStats& stats);
+
 	bool need_update;
 
 	/* NOTE: Here pixels_size is a size of storage, which equals to
@@ -105,6 +113,7 @@ public:
 		bool builtin_free_cache;
 
 		bool use_alpha;
+		bool use_cache;
 		bool need_load;
 		bool animated;
 		float frame;
@@ -128,6 +137,12 @@ private:
 	vector<Image*> images[IMAGE_DATA_NUM_TYPES];
 	void *osl_texture_system;
 
+	/* Tiles of images which are paged in on demand by the CPU kernel. */
+	bool texture_cache_supported;
+	size_t texture_cache_size;
+	TextureCache *texture_cache;
+	ImageCacheFiles *texture_cache_files;
+
 	bool file_load_image_generic(Image *img,
 	                             ImageInput **in,
 	                             int &width,
@@ -143,6 +158,8 @@ private:
 	                     int texture_limit,
 	                     device_vector<DeviceType>& tex_img);
 
+	void free_texture_cache_image(Image *img);
+
 	int max_flattened_slot(ImageDataType type);
 	int type_index_to_flattened_slot(int slot, ImageDataType type);
 	int flattened_slot_to_type_index(int flat_slot, ImageDataType *type);
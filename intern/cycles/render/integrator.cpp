@@ -67,6 +67,10 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
 
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
@@ -175,6 +179,8 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 		kintegrator->light_inv_rr_threshold = 0.0f;
 	}
 
+	kintegrator->adaptive_threshold = adaptive_threshold;
+
 	/* sobol directions table */
 	int max_samples = 1;
 
@@ -230,5 +236,13 @@ void Integrator::tag_update(Scene *scene)
 	need_update = true;
 }
 
+bool Integrator::use_light_tree_sampling() const
+{
+	if(method == BRANCHED_PATH && (sample_all_lights_direct || sample_all_lights_indirect)) {
+		return false;
+	}
+	return use_light_tree;
+}
+
 CCL_NAMESPACE_END
 
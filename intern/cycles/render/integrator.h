@@ -68,6 +68,10 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
+
+	float adaptive_threshold;
+	int adaptive_min_samples;
 
 	enum Method {
 		BRANCHED_PATH = 0,
@@ -90,6 +94,9 @@ public:
 
 	bool modified(const Integrator& integrator);
 	void tag_update(Scene *scene);
+
+	/* Light tree is not used when sampling all lights. */
+	bool use_light_tree_sampling() const;
 };
 
 CCL_NAMESPACE_END
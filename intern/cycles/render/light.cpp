@@ -19,6 +19,7 @@
 #include "render/integrator.h"
 #include "render/film.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/object.h"
 #include "render/scene.h"
@@ -242,6 +243,18 @@ bool LightManager::object_usable_as_light(Object *object) {
 	return false;
 }
 
+/* Rough estimate of the radiance emitted by a shader, used to weight lights in
+ * the light tree. Only constant emission is known, other shaders are assumed
+ * to emit with unit strength. */
+static float shader_emission_estimate(Shader *shader)
+{
+	float3 emission;
+	if(shader->is_constant_emission(&emission)) {
+		return max(average(emission), 0.0f);
+	}
+	return 1.0f;
+}
+
 void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
@@ -287,6 +300,11 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	size_t num_distribution = num_triangles + num_lights;
 	VLOG(1) << "Total " << num_distribution << " of light distribution primitives.";
 
+	/* emitters for the light tree */
+	bool use_light_tree = scene->integrator->use_light_tree_sampling();
+	vector<LightTreeEmitter> tree_emitters;
+	vector<int> tree_infinite_lights;
+
 	/* emission area */
 	float4 *distribution = dscene->light_distribution.alloc(num_distribution + 1);
 	float totarea = 0.0f;
@@ -326,6 +344,13 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			use_light_visibility = true;
 		}
 
+		vector<float> shader_emission;
+		if(use_light_tree) {
+			foreach(Shader *shader, mesh->used_shaders) {
+				shader_emission.push_back(shader_emission_estimate(shader));
+			}
+		}
+
 		size_t mesh_num_triangles = mesh->num_triangles();
 		for(size_t i = 0; i < mesh_num_triangles; i++) {
 			int shader_index = mesh->shader[i];
@@ -354,7 +379,28 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_light_tree) {
+					/* Mesh lights emit from both sides. */
+					LightTreeEmitter emitter;
+					emitter.bbox = BoundBox(p1);
+					emitter.bbox.grow(p2);
+					emitter.bbox.grow(p3);
+					emitter.axis = safe_normalize(cross(p2 - p1, p3 - p1));
+					emitter.theta_o = M_PI_F;
+					emitter.theta_e = M_PI_2_F;
+					emitter.energy = (shader_index < shader_emission.size())
+					                         ? shader_emission[shader_index]
+					                         : 1.0f;
+					emitter.energy *= M_2PI_F*area;
+					emitter.distribution_index = offset - 1;
+
+					if(emitter.energy > 0.0f) {
+						tree_emitters.push_back(emitter);
+					}
+				}
 			}
 		}
 
@@ -385,6 +431,44 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			background_mis = light->use_mis;
 		}
 
+		if(use_light_tree) {
+			if(light->type == LIGHT_BACKGROUND || light->type == LIGHT_DISTANT) {
+				tree_infinite_lights.push_back(offset);
+			}
+			else {
+				Shader *shader = (light->shader) ? light->shader : scene->default_light;
+				LightTreeEmitter emitter;
+				emitter.distribution_index = offset;
+				emitter.energy = shader_emission_estimate(shader);
+
+				if(light->type == LIGHT_AREA) {
+					float3 axisu = light->axisu*(light->sizeu*light->size);
+					float3 axisv = light->axisv*(light->sizev*light->size);
+					float3 corner = light->co - 0.5f*(axisu + axisv);
+
+					emitter.bbox = BoundBox(corner);
+					emitter.bbox.grow(corner + axisu);
+					emitter.bbox.grow(corner + axisv);
+					emitter.bbox.grow(corner + axisu + axisv);
+					emitter.axis = safe_normalize(light->dir);
+					emitter.theta_o = 0.0f;
+					emitter.theta_e = M_PI_2_F;
+					emitter.energy *= M_PI_4_F;
+				}
+				else {
+					emitter.bbox = BoundBox(light->co);
+					emitter.bbox.grow(light->co, light->size);
+					emitter.axis = safe_normalize(light->dir);
+					emitter.theta_o = (light->type == LIGHT_SPOT)? light->spot_angle*0.5f: M_PI_F;
+					emitter.theta_e = 0.0f;
+				}
+
+				if(emitter.energy > 0.0f) {
+					tree_emitters.push_back(emitter);
+				}
+			}
+		}
+
 		light_index++;
 		offset++;
 	}
@@ -446,6 +530,17 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		/* CDF */
 		dscene->light_distribution.copy_to_device();
 
+		/* Light tree */
+		if(use_light_tree) {
+			device_update_tree(dscene, tree_emitters, tree_infinite_lights, num_distribution);
+		}
+		else {
+			kintegrator->use_light_tree = false;
+			dscene->light_tree_nodes.free();
+			dscene->light_tree_emitters.free();
+			dscene->light_tree_positions.free();
+		}
+
 		/* Portals */
 		if(num_portals > 0) {
 			kintegrator->portal_offset = light_index;
@@ -460,7 +555,11 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	}
 	else {
 		dscene->light_distribution.free();
+		dscene->light_tree_nodes.free();
+		dscene->light_tree_emitters.free();
+		dscene->light_tree_positions.free();
 
+		kintegrator->use_light_tree = false;
 		kintegrator->num_distribution = 0;
 		kintegrator->num_all_lights = 0;
 		kintegrator->pdf_triangles = 0.0f;
@@ -474,6 +573,53 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	}
 }
 
+void LightManager::device_update_tree(DeviceScene *dscene,
+                                      const vector<LightTreeEmitter>& emitters,
+                                      const vector<int>& infinite_lights,
+                                      size_t num_distribution)
+{
+	LightTree tree(emitters);
+
+	size_t num_emitters = tree.num_emitters();
+	size_t num_infinite = infinite_lights.size();
+
+	/* Tree leaves followed by the infinite lights, which are not in the tree
+	 * and picked uniformly instead, with the tree counting as one more light. */
+	float4 *nodes = dscene->light_tree_nodes.alloc(max((int)tree.num_nodes(), 1)*LIGHT_TREE_NODE_SIZE);
+	uint *tree_emitters = dscene->light_tree_emitters.alloc(max((int)(num_emitters + num_infinite), 1));
+	uint *positions = dscene->light_tree_positions.alloc(num_distribution);
+
+	memset(nodes, 0, sizeof(float4)*dscene->light_tree_nodes.size());
+	tree.pack(nodes, tree_emitters);
+
+	for(size_t i = 0; i < num_infinite; i++) {
+		tree_emitters[num_emitters + i] = infinite_lights[i];
+	}
+
+	/* Emitters which can't be picked by the tree have no position. */
+	for(size_t i = 0; i < num_distribution; i++) {
+		positions[i] = ~0u;
+	}
+	for(size_t i = 0; i < num_emitters + num_infinite; i++) {
+		positions[tree_emitters[i]] = i;
+	}
+
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+	kintegrator->use_light_tree = true;
+	kintegrator->light_tree_num_emitters = num_emitters;
+	kintegrator->light_tree_num_infinite = num_infinite;
+	kintegrator->light_tree_infinite_pdf = (num_infinite)
+	        ? 1.0f/(num_infinite + ((num_emitters)? 1: 0))
+	        : 0.0f;
+
+	dscene->light_tree_nodes.copy_to_device();
+	dscene->light_tree_emitters.copy_to_device();
+	dscene->light_tree_positions.copy_to_device();
+
+	VLOG(1) << "Light tree built with " << num_emitters << " emitters and "
+	        << num_infinite << " infinite lights.";
+}
+
 static void background_cdf(int start,
                            int end,
                            int res,
@@ -845,6 +991,9 @@ void LightManager::device_free(Device *, DeviceScene *dscene)
 	dscene->light_data.free();
 	dscene->light_background_marginal_cdf.free();
 	dscene->light_background_conditional_cdf.free();
+	dscene->light_tree_nodes.free();
+	dscene->light_tree_emitters.free();
+	dscene->light_tree_positions.free();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
@@ -32,6 +32,7 @@ class Object;
 class Progress;
 class Scene;
 class Shader;
+struct LightTreeEmitter;
 
 class Light : public Node {
 public:
@@ -111,6 +112,10 @@ protected:
 	                                DeviceScene *dscene,
 	                                Scene *scene,
 	                                Progress& progress);
+	void device_update_tree(DeviceScene *dscene,
+	                        const vector<LightTreeEmitter>& emitters,
+	                        const vector<int>& infinite_lights,
+	                        size_t num_distribution);
 	void device_update_background(Device *device,
 	                              DeviceScene *dscene,
 	                              Scene *scene,
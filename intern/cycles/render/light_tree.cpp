@@ -0,0 +1,163 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Orientation Cones */
+
+static void light_tree_cone_union(float3 axis_a, float theta_o_a, float theta_e_a,
+                                  float3 axis_b, float theta_o_b, float theta_e_b,
+                                  float3 *r_axis, float *r_theta_o, float *r_theta_e)
+{
+	/* Make a the wider cone. */
+	if(theta_o_b > theta_o_a) {
+		swap(axis_a, axis_b);
+		swap(theta_o_a, theta_o_b);
+	}
+
+	*r_theta_e = max(theta_e_a, theta_e_b);
+	*r_axis = axis_a;
+
+	const float theta_d = safe_acosf(dot(axis_a, axis_b));
+
+	if(min(theta_d + theta_o_b, M_PI_F) <= theta_o_a) {
+		/* Cone b is inside of cone a. */
+		*r_theta_o = theta_o_a;
+		return;
+	}
+
+	const float theta_o = 0.5f*(theta_o_a + theta_d + theta_o_b);
+	const float3 perp = axis_b - axis_a*dot(axis_a, axis_b);
+	const float perp_len = len(perp);
+
+	if(theta_o >= M_PI_F || perp_len < 1e-6f) {
+		/* Cone covering all directions. */
+		*r_theta_o = M_PI_F;
+		return;
+	}
+
+	/* Rotate axis of a towards b so the cone just covers both. */
+	const float theta_r = theta_o - theta_o_a;
+	*r_axis = normalize(axis_a*cosf(theta_r) + perp*(sinf(theta_r)/perp_len));
+	*r_theta_o = theta_o;
+}
+
+/* Light Tree */
+
+struct LightTreeEmitterCompare {
+	int dim;
+
+	explicit LightTreeEmitterCompare(int dim_) : dim(dim_) {}
+
+	bool operator()(const LightTreeEmitter& a, const LightTreeEmitter& b) const
+	{
+		return a.bbox.center2()[dim] < b.bbox.center2()[dim];
+	}
+};
+
+LightTree::LightTree(const vector<LightTreeEmitter>& emitters_)
+: emitters(emitters_)
+{
+	if(emitters.size() > 0) {
+		nodes.reserve(emitters.size()*2 - 1);
+		build(0, emitters.size());
+	}
+}
+
+int LightTree::build(int start, int end)
+{
+	const int index = nodes.size();
+	nodes.push_back(Node());
+
+	if(end - start == 1) {
+		const LightTreeEmitter& emitter = emitters[start];
+		Node& node = nodes[index];
+		node.bbox = emitter.bbox;
+		node.axis = emitter.axis;
+		node.theta_o = emitter.theta_o;
+		node.theta_e = emitter.theta_e;
+		node.energy = emitter.energy;
+		node.right_child = 0;
+		node.first = start;
+		return index;
+	}
+
+	/* Split at the median of the emitter centers along the longest axis. */
+	BoundBox centroid_bounds = BoundBox::empty;
+	for(int i = start; i < end; i++) {
+		centroid_bounds.grow(emitters[i].bbox.center());
+	}
+
+	const float3 extent = centroid_bounds.size();
+	int dim = 0;
+	if(extent.y > extent.x) dim = 1;
+	if(extent.z > ((dim == 0)? extent.x: extent.y)) dim = 2;
+
+	const int mid = (start + end)/2;
+	std::nth_element(emitters.begin() + start,
+	                 emitters.begin() + mid,
+	                 emitters.begin() + end,
+	                 LightTreeEmitterCompare(dim));
+
+	const int left = build(start, mid);
+	const int right = build(mid, end);
+
+	const Node& l = nodes[left];
+	const Node& r = nodes[right];
+	Node& node = nodes[index];
+
+	node.bbox = l.bbox;
+	node.bbox.grow(r.bbox);
+	node.energy = l.energy + r.energy;
+	light_tree_cone_union(l.axis, l.theta_o, l.theta_e,
+	                      r.axis, r.theta_o, r.theta_e,
+	                      &node.axis, &node.theta_o, &node.theta_e);
+	node.right_child = right;
+	node.first = start;
+
+	return index;
+}
+
+void LightTree::pack(float4 *packed_nodes, uint *packed_emitters) const
+{
+	for(size_t i = 0; i < nodes.size(); i++) {
+		const Node& node = nodes[i];
+		/* Inner nodes store the position of the first emitter of the right
+		 * child, so the kernel can find the path to a given emitter. */
+		const int position = (node.right_child)? nodes[node.right_child].first: node.first;
+		float4 *data = packed_nodes + i*LIGHT_TREE_NODE_SIZE;
+
+		data[0] = make_float4(node.bbox.min.x, node.bbox.min.y, node.bbox.min.z, node.energy);
+		data[1] = make_float4(node.bbox.max.x, node.bbox.max.y, node.bbox.max.z, node.theta_o);
+		data[2] = make_float4(node.axis.x, node.axis.y, node.axis.z, node.theta_e);
+		data[3] = make_float4(__int_as_float(node.right_child),
+		                      __int_as_float(position),
+		                      0.0f,
+		                      0.0f);
+	}
+
+	for(size_t i = 0; i < emitters.size(); i++) {
+		packed_emitters[i] = emitters[i].distribution_index;
+	}
+}
+
+CCL_NAMESPACE_END
+
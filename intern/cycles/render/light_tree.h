@@ -0,0 +1,87 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Bounding volume hierarchy over the local emitters of the scene, used to
+ * pick lights proportional to their estimated contribution to the shading
+ * point instead of proportional to their area. Every node stores the energy
+ * of its emitters, their bounding box and a cone bounding their emission
+ * directions, from which the kernel estimates the importance of the node
+ * while descending the tree.
+ *
+ * Based on "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Estevez and Kulla, 2018.
+ */
+
+struct LightTreeEmitter {
+	BoundBox bbox;
+	/* Emission cone: directions within theta_o of the axis emit light, which
+	 * falls off to zero at theta_o + theta_e. */
+	float3 axis;
+	float theta_o;
+	float theta_e;
+	float energy;
+	/* Index of the emitter in the light distribution. */
+	int distribution_index;
+};
+
+class LightTree {
+public:
+	explicit LightTree(const vector<LightTreeEmitter>& emitters);
+
+	size_t num_nodes() const { return nodes.size(); }
+	size_t num_emitters() const { return emitters.size(); }
+
+	/* Nodes are packed in depth first order, LIGHT_TREE_NODE_SIZE float4 per
+	 * node, and emitters as their distribution index in order of the leaves. */
+	void pack(float4 *packed_nodes, uint *packed_emitters) const;
+
+protected:
+	struct Node {
+		BoundBox bbox;
+		float3 axis;
+		float theta_o;
+		float theta_e;
+		float energy;
+		/* Index of the right child, the left child directly follows the node.
+		 * Zero for leaves. */
+		int right_child;
+		/* Position of the first emitter of the node. */
+		int first;
+	};
+
+	int build(int start, int end);
+
+	vector<LightTreeEmitter> emitters;
+	vector<Node> nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
+
@@ -35,8 +35,11 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_math_quantize.h"
+#include "util/util_md5.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -459,7 +462,8 @@ Mesh::Mesh()
 
 Mesh::~Mesh()
 {
-	delete bvh;
+	if(bvh_key.empty())
+		delete bvh;
 	delete patch_table;
 	delete subd_params;
 }
@@ -872,7 +876,7 @@ void Mesh::add_undisplaced()
 	}
 }
 
-void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal)
+void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal, uint *vnormal_oct)
 {
 	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
 	if(attr_vN == NULL) {
@@ -912,12 +916,18 @@ void Mesh::pack_normals(Scene *scene, uint *tri_shader, float4 *vnormal)
 		if(do_transform)
 			vNi = safe_normalize(transform_direction(&ntfm, vNi));
 
-		vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
+		if(vnormal_oct) {
+			vnormal_oct[i] = oct16_encode_unit_vector(vNi);
+		}
+		else {
+			vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
+		}
 	}
 }
 
 void Mesh::pack_verts(const vector<uint>& tri_prim_index,
                       uint4 *tri_vindex,
+                      float4 *tri_verts,
                       uint *tri_patch,
                       float2 *tri_patch_uv,
                       size_t vert_offset,
@@ -925,6 +935,12 @@ void Mesh::pack_verts(const vector<uint>& tri_prim_index,
 {
 	size_t verts_size = verts.size();
 
+	if(tri_verts) {
+		for(size_t i = 0; i < verts_size; i++) {
+			tri_verts[i] = float3_to_float4(verts[i]);
+		}
+	}
+
 	if(verts_size && subd_faces.size()) {
 		float2 *vert_patch_uv_ptr = vert_patch_uv.data();
 
@@ -1025,6 +1041,7 @@ void Mesh::pack_patches(uint *patch_data, uint vert_offset, uint face_offset, ui
 
 void Mesh::compute_bvh(Device *device,
                        DeviceScene *dscene,
+                       MeshManager *mesh_manager,
                        SceneParams *params,
                        Progress *progress,
                        int n,
@@ -1048,7 +1065,52 @@ void Mesh::compute_bvh(Device *device,
 		vector<Object*> objects;
 		objects.push_back(&object);
 
-		if(bvh && !need_update_rebuild) {
+		BVHParams bparams;
+		bparams.use_spatial_split = params->use_bvh_spatial_split;
+		/* Quantized nodes are only implemented for the BVH2 layout. */
+		bparams.use_compact_storage = params->use_compact_geometry;
+		bparams.use_qbvh = params->use_qbvh && device->info.has_qbvh &&
+		                   !bparams.use_compact_storage;
+		bparams.use_obvh = bparams.use_qbvh &&
+		                   params->use_obvh && device->info.has_obvh;
+		bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
+		                              params->use_bvh_unaligned_nodes;
+		bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
+		bparams.num_motion_curve_steps = params->num_bvh_time_steps;
+
+		if(params->use_bvh_cache) {
+			/* Cached BVHs might be shared between meshes, so they are never
+			 * refitted, a changed geometry gives a new key instead.
+			 */
+			string key = bvh_cache_key(bparams);
+
+			if(key != bvh_key) {
+				BVH *cached_bvh = mesh_manager->bvh_cache_find(key);
+
+				if(cached_bvh) {
+					progress->set_status(msg, "Using cached BVH");
+				}
+				else {
+					progress->set_status(msg, "Building BVH");
+
+					BVH *new_bvh = BVH::create(bparams, objects);
+					MEM_GUARDED_CALL(progress, new_bvh->build, *progress);
+
+					if(progress->get_cancel()) {
+						delete new_bvh;
+						return;
+					}
+
+					cached_bvh = mesh_manager->bvh_cache_add(key, new_bvh);
+				}
+
+				if(bvh_key.empty())
+					delete bvh;
+				bvh = cached_bvh;
+				bvh_key = key;
+			}
+		}
+		else if(bvh && !need_update_rebuild) {
 			progress->set_status(msg, "Refitting BVH");
 			bvh->objects = objects;
 			bvh->refit(*progress);
@@ -1056,14 +1118,6 @@ void Mesh::compute_bvh(Device *device,
 		else {
 			progress->set_status(msg, "Building BVH");
 
-			BVHParams bparams;
-			bparams.use_spatial_split = params->use_bvh_spatial_split;
-			bparams.use_qbvh = params->use_qbvh && device->info.has_qbvh;
-			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
-			                              params->use_bvh_unaligned_nodes;
-			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
-			bparams.num_motion_curve_steps = params->num_bvh_time_steps;
-
 			delete bvh;
 			bvh = BVH::create(bparams, objects);
 			MEM_GUARDED_CALL(progress, bvh->build, *progress);
@@ -1115,6 +1169,80 @@ bool Mesh::need_build_bvh() const
 	return !transform_applied || has_surface_bssrdf;
 }
 
+/* Append float3 array to the hash, skipping the padding which might contain
+ * uninitialized values.
+ */
+static void bvh_cache_key_append(MD5Hash& md5, const float3 *data, size_t size)
+{
+	const size_t chunk_size = 1024;
+	float chunk[chunk_size * 3];
+
+	md5.append((const uint8_t*)&size, sizeof(size));
+
+	for(size_t i = 0; i < size; i += chunk_size) {
+		const size_t num = (size - i < chunk_size)? size - i: chunk_size;
+		for(size_t j = 0; j < num; j++) {
+			chunk[j*3 + 0] = data[i + j].x;
+			chunk[j*3 + 1] = data[i + j].y;
+			chunk[j*3 + 2] = data[i + j].z;
+		}
+		md5.append((const uint8_t*)chunk, (int)(num * 3 * sizeof(float)));
+	}
+}
+
+template<typename T>
+static void bvh_cache_key_append(MD5Hash& md5, const T *data, size_t size)
+{
+	md5.append((const uint8_t*)&size, sizeof(size));
+
+	/* Chunked, hash appending takes an int size. */
+	const size_t chunk_size = 1 << 24;
+	for(size_t i = 0; i < size; i += chunk_size) {
+		const size_t num = (size - i < chunk_size)? size - i: chunk_size;
+		md5.append((const uint8_t*)(data + i), (int)(num * sizeof(T)));
+	}
+}
+
+string Mesh::bvh_cache_key(const BVHParams& bparams)
+{
+	MD5Hash md5;
+
+	const int params_data[] = {bparams.use_spatial_split,
+	                           bparams.use_qbvh,
+	                           bparams.use_obvh,
+	                           bparams.use_unaligned_nodes,
+	                           bparams.use_compact_storage,
+	                           bparams.num_motion_triangle_steps,
+	                           bparams.num_motion_curve_steps,
+	                           (int)motion_steps,
+	                           has_motion_blur()};
+	md5.append((const uint8_t*)params_data, sizeof(params_data));
+
+	bvh_cache_key_append(md5, verts.data(), verts.size());
+	bvh_cache_key_append(md5, triangles.data(), triangles.size());
+	bvh_cache_key_append(md5, curve_keys.data(), curve_keys.size());
+	bvh_cache_key_append(md5, curve_radius.data(), curve_radius.size());
+	bvh_cache_key_append(md5, curve_first_key.data(), curve_first_key.size());
+
+	if(has_motion_blur()) {
+		Attribute *attr = attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+		if(attr) {
+			bvh_cache_key_append(md5,
+			                     attr->data_float3(),
+			                     attr->buffer.size() / sizeof(float3));
+		}
+
+		Attribute *curve_attr = curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+		if(curve_attr) {
+			bvh_cache_key_append(md5,
+			                     curve_attr->data_float4(),
+			                     curve_attr->buffer.size() / sizeof(float4));
+		}
+	}
+
+	return md5.get_hex();
+}
+
 bool Mesh::is_instanced() const
 {
 	/* Currently we treat subsurface objects as instanced.
@@ -1135,6 +1263,63 @@ MeshManager::MeshManager()
 
 MeshManager::~MeshManager()
 {
+	bvh_cache_free();
+}
+
+BVH *MeshManager::bvh_cache_find(const string& key)
+{
+	thread_scoped_lock lock(bvh_cache_mutex);
+	map<string, BVH*>::iterator it = bvh_cache.find(key);
+	return (it != bvh_cache.end())? it->second: NULL;
+}
+
+BVH *MeshManager::bvh_cache_add(const string& key, BVH *bvh)
+{
+	thread_scoped_lock lock(bvh_cache_mutex);
+	map<string, BVH*>::iterator it = bvh_cache.find(key);
+
+	if(it != bvh_cache.end()) {
+		/* Mesh with the same geometry was built from another thread. */
+		delete bvh;
+		return it->second;
+	}
+
+	bvh_cache[key] = bvh;
+	return bvh;
+}
+
+void MeshManager::bvh_cache_free_unused(Scene *scene)
+{
+	set<string> used_keys;
+	foreach(Mesh *mesh, scene->meshes) {
+		if(!mesh->bvh_key.empty())
+			used_keys.insert(mesh->bvh_key);
+	}
+
+	size_t num_freed = 0;
+	map<string, BVH*>::iterator it = bvh_cache.begin();
+	while(it != bvh_cache.end()) {
+		if(used_keys.find(it->first) == used_keys.end()) {
+			delete it->second;
+			bvh_cache.erase(it++);
+			num_freed++;
+		}
+		else {
+			++it;
+		}
+	}
+
+	VLOG(1) << "BVH cache has " << bvh_cache.size() << " entries, "
+	        << num_freed << " unused entries freed.";
+}
+
+void MeshManager::bvh_cache_free()
+{
+	map<string, BVH*>::iterator it;
+	for(it = bvh_cache.begin(); it != bvh_cache.end(); ++it) {
+		delete it->second;
+	}
+	bvh_cache.clear();
 }
 
 void MeshManager::update_osl_attributes(Device *device, Scene *scene, vector<AttributeRequestSet>& mesh_attributes)
@@ -1706,9 +1891,16 @@ void MeshManager::device_update_mesh(Device *,
 		}
 	}
 
-	/* Create mapping from triangle to primitive triangle array. */
-	vector<uint> tri_prim_index(tri_size);
-	if(for_displacement) {
+	const bool use_compact_geometry = scene->params.use_compact_geometry;
+	dscene->data.bvh.use_compact_geometry = use_compact_geometry;
+
+	/* Create mapping from triangle to primitive triangle array, not used
+	 * with compact geometry where vertices are shared between triangles. */
+	vector<uint> tri_prim_index(tri_size, 0);
+	if(use_compact_geometry) {
+		/* pass */
+	}
+	else if(for_displacement) {
 		/* For displacement kernels we do some trickery to make them believe
 		 * we've got all required data ready. However, that data is different
 		 * from final render kernels since we don't have BVH yet, so can't
@@ -1734,7 +1926,16 @@ void MeshManager::device_update_mesh(Device *,
 		progress.set_status("Updating Mesh", "Computing normals");
 
 		uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-		float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+		float4 *vnormal = NULL;
+		uint *vnormal_oct = NULL;
+		float4 *tri_verts = NULL;
+		if(use_compact_geometry) {
+			vnormal_oct = dscene->tri_vnormal_oct.alloc(vert_size);
+			tri_verts = dscene->tri_verts.alloc(vert_size);
+		}
+		else {
+			vnormal = dscene->tri_vnormal.alloc(vert_size);
+		}
 		uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
 		uint *tri_patch = dscene->tri_patch.alloc(tri_size);
 		float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
@@ -1742,9 +1943,11 @@ void MeshManager::device_update_mesh(Device *,
 		foreach(Mesh *mesh, scene->meshes) {
 			mesh->pack_normals(scene,
 			                   &tri_shader[mesh->tri_offset],
-			                   &vnormal[mesh->vert_offset]);
+			                   (vnormal)? &vnormal[mesh->vert_offset]: NULL,
+			                   (vnormal_oct)? &vnormal_oct[mesh->vert_offset]: NULL);
 			mesh->pack_verts(tri_prim_index,
 			                 &tri_vindex[mesh->tri_offset],
+			                 (tri_verts)? &tri_verts[mesh->vert_offset]: NULL,
 			                 &tri_patch[mesh->tri_offset],
 			                 &tri_patch_uv[mesh->vert_offset],
 			                 mesh->vert_offset,
@@ -1756,7 +1959,13 @@ void MeshManager::device_update_mesh(Device *,
 		progress.set_status("Updating Mesh", "Copying Mesh to device");
 
 		dscene->tri_shader.copy_to_device();
-		dscene->tri_vnormal.copy_to_device();
+		if(use_compact_geometry) {
+			dscene->tri_vnormal_oct.copy_to_device();
+			dscene->tri_verts.copy_to_device();
+		}
+		else {
+			dscene->tri_vnormal.copy_to_device();
+		}
 		dscene->tri_vindex.copy_to_device();
 		dscene->tri_patch.copy_to_device();
 		dscene->tri_patch_uv.copy_to_device();
@@ -1795,7 +2004,7 @@ void MeshManager::device_update_mesh(Device *,
 		dscene->patches.copy_to_device();
 	}
 
-	if(for_displacement) {
+	if(for_displacement && !use_compact_geometry) {
 		float4 *prim_tri_verts = dscene->prim_tri_verts.alloc(tri_size * 3);
 		foreach(Mesh *mesh, scene->meshes) {
 			for(size_t i = 0; i < mesh->num_triangles(); ++i) {
@@ -1817,15 +2026,21 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	BVHParams bparams;
 	bparams.top_level = true;
-	bparams.use_qbvh = scene->params.use_qbvh && device->info.has_qbvh;
+	bparams.use_compact_storage = scene->params.use_compact_geometry;
+	bparams.use_qbvh = scene->params.use_qbvh && device->info.has_qbvh &&
+	                   !bparams.use_compact_storage;
+	bparams.use_obvh = bparams.use_qbvh &&
+	                   scene->params.use_obvh && device->info.has_obvh;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
 
-	VLOG(1) << (bparams.use_qbvh ? "Using QBVH optimization structure"
-	                             : "Using regular BVH optimization structure");
+	VLOG(1) << (bparams.use_obvh ? "Using OBVH optimization structure"
+	            : bparams.use_qbvh ? "Using QBVH optimization structure"
+	            : bparams.use_compact_storage ? "Using compact BVH optimization structure"
+	                               : "Using regular BVH optimization structure");
 
 	BVH *bvh = BVH::create(bparams, scene->objects);
 	bvh->build(progress);
@@ -1883,6 +2098,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	dscene->data.bvh.root = pack.root_index;
 	dscene->data.bvh.use_qbvh = bparams.use_qbvh;
+	dscene->data.bvh.use_obvh = bparams.use_obvh;
 	dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
 
 	delete bvh;
@@ -1950,6 +2166,53 @@ void MeshManager::device_update_displacement_images(Device *device,
 	pool.wait_work();
 }
 
+/* Device memory used by geometry, by category of data. */
+static string mesh_device_memory_report(DeviceScene *dscene)
+{
+	const struct {
+		const char *name;
+		size_t size;
+	} categories[] = {
+		{"BVH nodes", dscene->bvh_nodes.memory_size() +
+		              dscene->bvh_leaf_nodes.memory_size() +
+		              dscene->object_node.memory_size()},
+		{"BVH primitives", dscene->prim_type.memory_size() +
+		                   dscene->prim_visibility.memory_size() +
+		                   dscene->prim_index.memory_size() +
+		                   dscene->prim_object.memory_size() +
+		                   dscene->prim_time.memory_size() +
+		                   dscene->prim_tri_index.memory_size()},
+		{"Triangle vertices", dscene->prim_tri_verts.memory_size() +
+		                      dscene->tri_verts.memory_size()},
+		{"Triangle normals", dscene->tri_vnormal.memory_size() +
+		                     dscene->tri_vnormal_oct.memory_size()},
+		{"Triangle indices", dscene->tri_vindex.memory_size() +
+		                     dscene->tri_shader.memory_size()},
+		{"Patches", dscene->tri_patch.memory_size() +
+		            dscene->tri_patch_uv.memory_size() +
+		            dscene->patches.memory_size()},
+		{"Curves", dscene->curves.memory_size() +
+		           dscene->curve_keys.memory_size()},
+		{"Attributes", dscene->attributes_map.memory_size() +
+		               dscene->attributes_float.memory_size() +
+		               dscene->attributes_float3.memory_size() +
+		               dscene->attributes_uchar4.memory_size()},
+	};
+
+	string report;
+	size_t total = 0;
+	for(size_t i = 0; i < sizeof(categories)/sizeof(*categories); i++) {
+		report += string_printf("%-24s %s\n",
+		                        categories[i].name,
+		                        string_human_readable_size(categories[i].size).c_str());
+		total += categories[i].size;
+	}
+	report += string_printf("%-24s %s\n",
+	                        "Total",
+	                        string_human_readable_size(total).c_str());
+	return report;
+}
+
 void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	if(!need_update)
@@ -2075,6 +2338,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		}
 	}
 
+	scoped_timer bvh_timer;
 	TaskPool pool;
 
 	i = 0;
@@ -2084,6 +2348,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 			                        mesh,
 			                        device,
 			                        dscene,
+			                        this,
 			                        &scene->params,
 			                        &progress,
 			                        i,
@@ -2099,6 +2364,8 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
 
+	double bvh_time = bvh_timer.get_time();
+
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_attributes = false;
 	}
@@ -2118,12 +2385,24 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	{
+		scoped_timer timer;
+		device_update_bvh(device, dscene, scene, progress);
+		bvh_time += timer.get_time();
+	}
+	scene->update_stats.add("BVH Build", bvh_time);
 	if(progress.get_cancel()) return;
 
+	if(scene->params.use_bvh_cache) {
+		bvh_cache_free_unused(scene);
+	}
+
 	device_update_mesh(device, dscene, scene, false, progress);
 	if(progress.get_cancel()) return;
 
+	VLOG(1) << (scene->params.use_compact_geometry ? "Compact geometry" : "Geometry")
+	        << " device memory:\n" << mesh_device_memory_report(dscene);
+
 	need_update = false;
 
 	if(true_displacement_used) {
@@ -2152,6 +2431,8 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->tri_shader.free();
 	dscene->tri_vnormal.free();
 	dscene->tri_vindex.free();
+	dscene->tri_verts.free();
+	dscene->tri_vnormal_oct.free();
 	dscene->tri_patch.free();
 	dscene->tri_patch_uv.free();
 	dscene->curves.free();
@@ -26,6 +26,7 @@
 #include "util/util_list.h"
 #include "util/util_map.h"
 #include "util/util_param.h"
+#include "util/util_thread.h"
 #include "util/util_transform.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
@@ -34,9 +35,11 @@ CCL_NAMESPACE_BEGIN
 
 class Attribute;
 class BVH;
+class BVHParams;
 class Device;
 class DeviceScene;
 class Mesh;
+class MeshManager;
 class Progress;
 class Scene;
 class SceneParams;
@@ -239,6 +242,9 @@ public:
 
 	/* BVH */
 	BVH *bvh;
+	/* Key of the BVH in the mesh manager cache. When not empty the BVH is
+	 * owned by the cache and might be shared with other meshes. */
+	string bvh_key;
 	size_t tri_offset;
 	size_t vert_offset;
 
@@ -278,9 +284,14 @@ public:
 	void add_vertex_normals();
 	void add_undisplaced();
 
-	void pack_normals(Scene *scene, uint *shader, float4 *vnormal);
+	/* Vertex normals are packed either as float4 or octahedral encoded,
+	 * depending on which of vnormal and vnormal_oct is given. */
+	void pack_normals(Scene *scene, uint *shader, float4 *vnormal, uint *vnormal_oct);
+	/* Vertex positions are only packed for compact geometry, where the
+	 * kernel reads them through the vertex index buffer. */
 	void pack_verts(const vector<uint>& tri_prim_index,
 	                uint4 *tri_vindex,
+	                float4 *tri_verts,
 	                uint *tri_patch,
 	                float2 *tri_patch_uv,
 	                size_t vert_offset,
@@ -290,6 +301,7 @@ public:
 
 	void compute_bvh(Device *device,
 	                 DeviceScene *dscene,
+	                 MeshManager *mesh_manager,
 	                 SceneParams *params,
 	                 Progress *progress,
 	                 int n,
@@ -313,6 +325,11 @@ public:
 	 */
 	bool need_build_bvh() const;
 
+	/* Key identifying the BVH built for this mesh with given parameters,
+	 * based on the geometry only, so it stays the same for meshes which were
+	 * re-synchronized without any changes. */
+	string bvh_cache_key(const BVHParams& bparams);
+
 	/* Check if the mesh should be treated as instanced. */
 	bool is_instanced() const;
 
@@ -342,7 +359,22 @@ public:
 
 	void tag_update(Scene *scene);
 
+	/* Bottom level BVH cache.
+	 *
+	 * Keeps BVHs of instanced meshes across updates and scene resets, so
+	 * when meshes are synchronized again with the same geometry, for example
+	 * in the next frame of an animation render, only the top level BVH is
+	 * to be rebuilt. Meshes with identical geometry share the same BVH.
+	 */
+	BVH *bvh_cache_find(const string& key);
+	BVH *bvh_cache_add(const string& key, BVH *bvh);
+	void bvh_cache_free_unused(Scene *scene);
+	void bvh_cache_free();
+
 protected:
+	map<string, BVH*> bvh_cache;
+	thread_mutex bvh_cache_mutex;
+
 	/* Calculate verts/triangles/curves offsets in global arrays. */
 	void mesh_calc_offset(Scene *scene);
 
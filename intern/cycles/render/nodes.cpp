@@ -320,13 +320,37 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 		int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
 
 		if(projection != NODE_IMAGE_PROJ_BOX) {
+			int flags = srgb? NODE_IMAGE_SRGB: 0;
+
+			/* Cached images select a mip level from the UV derivatives,
+			 * which are only known for the default UV map. */
+			if(projection == NODE_IMAGE_PROJ_FLAT &&
+			   image_manager->get_image_use_cache(slot) &&
+			   tex_mapping.skip() &&
+			   vector_in->link)
+			{
+				ShaderOutput *link = vector_in->link;
+				ShaderNode *link_node = link->parent;
+
+				if(link_node->type == TextureCoordinateNode::node_type) {
+					TextureCoordinateNode *texco = (TextureCoordinateNode*)link_node;
+					if(link->name() == "UV" && !texco->from_dupli)
+						flags |= NODE_IMAGE_UV_FILTER;
+				}
+				else if(link_node->type == UVMapNode::node_type) {
+					UVMapNode *uvmap = (UVMapNode*)link_node;
+					if(uvmap->attribute.empty() && !uvmap->from_dupli)
+						flags |= NODE_IMAGE_UV_FILTER;
+				}
+			}
+
 			compiler.add_node(NODE_TEX_IMAGE,
 				slot,
 				compiler.encode_uchar4(
 					vector_offset,
 					compiler.stack_assign_if_linked(color_out),
 					compiler.stack_assign_if_linked(alpha_out),
-					srgb),
+					flags),
 				projection);
 		}
 		else {
@@ -54,6 +54,8 @@ DeviceScene::DeviceScene(Device *device)
   tri_shader(device, "__tri_shader", MEM_TEXTURE),
   tri_vnormal(device, "__tri_vnormal", MEM_TEXTURE),
   tri_vindex(device, "__tri_vindex", MEM_TEXTURE),
+  tri_verts(device, "__tri_verts", MEM_TEXTURE),
+  tri_vnormal_oct(device, "__tri_vnormal_oct", MEM_TEXTURE),
   tri_patch(device, "__tri_patch", MEM_TEXTURE),
   tri_patch_uv(device, "__tri_patch_uv", MEM_TEXTURE),
   curves(device, "__curves", MEM_TEXTURE),
@@ -69,6 +71,9 @@ DeviceScene::DeviceScene(Device *device)
   light_data(device, "__light_data", MEM_TEXTURE),
   light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
   light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+  light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+  light_tree_emitters(device, "__light_tree_emitters", MEM_TEXTURE),
+  light_tree_positions(device, "__light_tree_positions", MEM_TEXTURE),
   particles(device, "__particles", MEM_TEXTURE),
   svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
   shader_flag(device, "__shader_flag", MEM_TEXTURE),
@@ -93,6 +98,7 @@ Scene::Scene(const SceneParams& params_, Device *device)
 	object_manager = new ObjectManager();
 	integrator = new Integrator();
 	image_manager = new ImageManager(device->info);
+	image_manager->set_texture_cache_size(((size_t)params.texture_cache_size) * 1024 * 1024);
 	particle_system_manager = new ParticleSystemManager();
 	curve_system_manager = new CurveSystemManager();
 	bake_manager = new BakeManager();
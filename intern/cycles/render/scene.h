@@ -23,6 +23,7 @@
 #include "device/device_memory.h"
 
 #include "util/util_param.h"
+#include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_system.h"
 #include "util/util_texture.h"
@@ -75,6 +76,8 @@ public:
 	device_vector<uint> tri_shader;
 	device_vector<float4> tri_vnormal;
 	device_vector<uint4> tri_vindex;
+	device_vector<float4> tri_verts;
+	device_vector<uint> tri_vnormal_oct;
 	device_vector<uint> tri_patch;
 	device_vector<float2> tri_patch_uv;
 
@@ -98,6 +101,9 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_emitters;
+	device_vector<uint> light_tree_positions;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -133,8 +139,17 @@ public:
 	bool use_bvh_unaligned_nodes;
 	int num_bvh_time_steps;
 	bool use_qbvh;
+	bool use_obvh;
+	/* Keep BVHs of instanced meshes across updates and scene resets. */
+	bool use_bvh_cache;
+	/* Quantized BVH nodes, octahedral encoded normals and vertices shared
+	 * between triangles, for scenes which would not fit in memory otherwise.
+	 * Always uses the BVH2 layout. */
+	bool use_compact_geometry;
 	bool persistent_data;
 	int texture_limit;
+	/* Memory limit of the texture cache in megabytes, zero disables it. */
+	int texture_cache_size;
 
 	SceneParams()
 	{
@@ -144,8 +159,12 @@ public:
 		use_bvh_unaligned_nodes = true;
 		num_bvh_time_steps = 0;
 		use_qbvh = true;
+		use_obvh = true;
+		use_bvh_cache = false;
+		use_compact_geometry = false;
 		persistent_data = false;
 		texture_limit = 0;
+		texture_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -155,8 +174,12 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
+		&& use_obvh == params.use_obvh
+		&& use_bvh_cache == params.use_bvh_cache
+		&& use_compact_geometry == params.use_compact_geometry
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
@@ -200,6 +223,10 @@ public:
 	/* parameters */
 	SceneParams params;
 
+	/* time spent updating the device, accumulated over all updates. the
+	 * "BVH Build" phase is part of the "Device Update" phase */
+	SyncStats update_stats;
+
 	/* mutex must be locked manually by callers */
 	thread_mutex mutex;
 
@@ -21,6 +21,7 @@
 #include "render/camera.h"
 #include "device/device.h"
 #include "render/graph.h"
+#include "render/image.h"
 #include "render/integrator.h"
 #include "render/mesh.h"
 #include "render/object.h"
@@ -53,7 +54,7 @@ Session::Session(const SessionParams& params_)
 
 	TaskScheduler::init(params.threads);
 
-	device = Device::create(params.device, stats, params.background);
+	device = Device::create(params.device, stats, profiler, params.background);
 
 	if(params.background && params.output_path.empty()) {
 		buffers = NULL;
@@ -729,10 +730,16 @@ void Session::run()
 		/* reset number of rendered samples */
 		progress.reset_sample();
 
+		if(params.use_profiling && (params.device.type == DEVICE_CPU)) {
+			profiler.start();
+		}
+
 		if(device_use_gl)
 			run_gpu();
 		else
 			run_cpu();
+
+		profiler.stop();
 	}
 
 	/* progress update */
@@ -867,7 +874,16 @@ void Session::update_scene()
 		}
 
 		progress.set_status("Updating Scene");
+		scoped_timer timer;
 		MEM_GUARDED_CALL(&progress, scene->device_update, device, progress);
+		scene->update_stats.add("Device Update", timer.get_time());
+
+		/* Shaders and objects might have changed. Render threads of a
+		 * previous task might still be registered, the profiler keeps
+		 * their hit counters at the old size. */
+		if(params.use_profiling) {
+			profiler.reset(scene->shaders.size(), scene->objects.size());
+		}
 	}
 }
 
@@ -949,6 +965,19 @@ void Session::render()
 	task.requested_tile_size = params.tile_size;
 	task.passes_size = tile_manager.params.get_passes_size();
 
+	if(params.adaptive_sampling) {
+		/* Default to the square root of the sample count, so noisy pixels
+		 * are not mistaken for converged ones after only a few samples. */
+		int min_samples = scene->integrator->adaptive_min_samples;
+		if(min_samples == 0) {
+			min_samples = max((int)sqrtf((float)params.samples), task.adaptive_step);
+		}
+
+		task.adaptive_sampling = true;
+		task.adaptive_min_samples = min_samples;
+		task.update_skipped_samples = function_bind(&Progress::add_skipped_samples, &this->progress, _1);
+	}
+
 	if(params.use_denoising) {
 		task.denoising_radius = params.denoising_radius;
 		task.denoising_strength = params.denoising_strength;
@@ -1044,6 +1073,15 @@ void Session::device_free()
 	 */
 }
 
+void Session::collect_statistics(RenderStats *render_stats)
+{
+	if(params.use_profiling && (params.device.type == DEVICE_CPU)) {
+		render_stats->collect_profiling(scene, profiler);
+	}
+	render_stats->has_texture_cache =
+		scene->image_manager->get_texture_cache_stats(render_stats->texture_cache);
+}
+
 int Session::get_max_closure_count()
 {
 	int max_closures = 0;
@@ -20,6 +20,7 @@
 #include "render/buffers.h"
 #include "device/device.h"
 #include "render/shader.h"
+#include "render/stats.h"
 #include "render/tile.h"
 
 #include "util/util_progress.h"
@@ -64,6 +65,12 @@ public:
 	float denoising_feature_strength;
 	bool denoising_relative_pca;
 
+	bool adaptive_sampling;
+
+	/* Sample the time spent in kernel phases, shaders and objects. Only
+	 * supported on the CPU device. */
+	bool use_profiling;
+
 	double cancel_timeout;
 	double reset_timeout;
 	double text_timeout;
@@ -91,6 +98,10 @@ public:
 		denoising_feature_strength = 0.0f;
 		denoising_relative_pca = false;
 
+		adaptive_sampling = false;
+
+		use_profiling = false;
+
 		display_buffer_linear = false;
 
 		cancel_timeout = 0.1;
@@ -115,6 +126,8 @@ public:
 		&& pixel_size == params.pixel_size
 		&& threads == params.threads
 		&& display_buffer_linear == params.display_buffer_linear
+		&& adaptive_sampling == params.adaptive_sampling
+		&& use_profiling == params.use_profiling
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
 		&& text_timeout == params.text_timeout
@@ -139,6 +152,8 @@ public:
 	SessionParams params;
 	TileManager tile_manager;
 	Stats stats;
+	SyncStats sync_stats;
+	Profiler profiler;
 
 	function<void(RenderTile&)> write_render_tile_cb;
 	function<void(RenderTile&, bool)> update_render_tile_cb;
@@ -160,6 +175,10 @@ public:
 
 	void device_free();
 
+	/* Gathers statistics of the finished render, must not be called while
+	 * rendering. */
+	void collect_statistics(RenderStats *stats);
+
 	/* Returns the rendering progress or 0 if no progress can be determined
 	 * (for example, when rendering with unlimited samples). */
 	float get_progress();
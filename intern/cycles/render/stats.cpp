@@ -0,0 +1,187 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/stats.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/shader.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_foreach.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Every profiler sample represents this much time of one render thread. */
+static const double profiler_sample_time = 0.001;
+
+static const char *profiling_event_names[PROFILING_NUM_EVENTS] = {
+	"Unknown",
+	"Ray Setup",
+	"Path Integration",
+	"Scene Intersection",
+	"Indirect Emission",
+	"Volumes",
+	"Shader Setup",
+	"Shader Eval",
+	"Shader Apply",
+	"Ambient Occlusion",
+	"Subsurface",
+	"Connect Light",
+	"Shadows",
+	"Surface Bounce",
+	"Write Result",
+};
+
+static string indent_string(int indent_level)
+{
+	return string(indent_level * 2, ' ');
+}
+
+static bool namedsamplecountentry_sort(const NamedSampleCountEntry& a,
+                                       const NamedSampleCountEntry& b)
+{
+	if(a.samples == b.samples) {
+		return a.name < b.name;
+	}
+	return a.samples > b.samples;
+}
+
+NamedSampleCountEntry::NamedSampleCountEntry()
+: name(""), samples(0), hits(0)
+{
+}
+
+NamedSampleCountEntry::NamedSampleCountEntry(const string& name, uint64_t samples, uint64_t hits)
+: name(name), samples(samples), hits(hits)
+{
+}
+
+NamedSampleCountStats::NamedSampleCountStats()
+: total_samples(0)
+{
+}
+
+void NamedSampleCountStats::add(const string& name, uint64_t samples, uint64_t hits)
+{
+	map<string, NamedSampleCountEntry>::iterator it = entries.find(name);
+	if(it == entries.end()) {
+		entries[name] = NamedSampleCountEntry(name, samples, hits);
+	}
+	else {
+		it->second.samples += samples;
+		it->second.hits += hits;
+	}
+	total_samples += samples;
+}
+
+string NamedSampleCountStats::full_report(int indent_level, uint64_t report_total_samples)
+{
+	const string indent = indent_string(indent_level);
+
+	vector<NamedSampleCountEntry> sorted_entries;
+	sorted_entries.reserve(entries.size());
+
+	map<string, NamedSampleCountEntry>::iterator it;
+	for(it = entries.begin(); it != entries.end(); ++it) {
+		sorted_entries.push_back(it->second);
+	}
+
+	sort(sorted_entries.begin(), sorted_entries.end(), namedsamplecountentry_sort);
+
+	string result = "";
+	foreach(const NamedSampleCountEntry& entry, sorted_entries) {
+		const double percentage = (report_total_samples)?
+		        100.0 * entry.samples / report_total_samples: 0.0;
+		result += indent + string_printf("%-32s %10.3fs (%6.2f%%)",
+		                                 entry.name.c_str(),
+		                                 entry.samples * profiler_sample_time,
+		                                 percentage);
+		if(entry.hits) {
+			result += string_printf(", %llu hits", (unsigned long long)entry.hits);
+		}
+		result += "\n";
+	}
+	return result;
+}
+
+RenderStats::RenderStats()
+: has_profiling(false),
+  has_texture_cache(false)
+{
+}
+
+void RenderStats::collect_profiling(Scene *scene, Profiler& prof)
+{
+	has_profiling = true;
+
+	kernel = NamedSampleCountStats();
+	for(int i = 0; i < PROFILING_NUM_EVENTS; i++) {
+		uint64_t samples = prof.get_event((ProfilingEvent)i);
+		if(samples) {
+			kernel.add(profiling_event_names[i], samples, 0);
+		}
+	}
+
+	shaders = NamedSampleCountStats();
+	for(size_t i = 0; i < scene->shaders.size(); i++) {
+		uint64_t samples, hits;
+		if(prof.get_shader(i, samples, hits)) {
+			shaders.add(scene->shaders[i]->name.string(), samples, hits);
+		}
+	}
+
+	objects = NamedSampleCountStats();
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		uint64_t samples, hits;
+		if(prof.get_object(i, samples, hits)) {
+			const ustring& name = scene->objects[i]->name;
+			objects.add((name.empty())? string_printf("Object %d", (int)i): name.string(),
+			            samples,
+			            hits);
+		}
+	}
+}
+
+string RenderStats::full_report()
+{
+	string result = "";
+	if(has_texture_cache) {
+		result += texture_cache.full_report();
+	}
+	if(!has_profiling) {
+		return result;
+	}
+	if(has_texture_cache) {
+		result += "\n";
+	}
+
+	/* Shares of shaders and objects are relative to the render thread time,
+	 * time outside of any shader or object is not listed. */
+	const uint64_t total_samples = kernel.total_samples;
+
+	result += "Render thread time, sampled:\n";
+	result += string_printf("  %-32s %10.3fs\n", "Total", total_samples * profiler_sample_time);
+	result += "\nKernel phases:\n";
+	result += kernel.full_report(1, total_samples);
+	result += "\nShaders:\n";
+	result += shaders.full_report(1, total_samples);
+	result += "\nObjects:\n";
+	result += objects.full_report(1, total_samples);
+
+	return result;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RENDER_STATS_H__
+#define __RENDER_STATS_H__
+
+#include "util/util_map.h"
+#include "util/util_profiling.h"
+#include "util/util_string.h"
+#include "util/util_texture_cache.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Scene;
+
+/* Profiler samples and hits of a named item, like a shader or an object.
+ * Items with the same name are merged. */
+class NamedSampleCountEntry {
+public:
+	NamedSampleCountEntry();
+	NamedSampleCountEntry(const string& name, uint64_t samples, uint64_t hits);
+
+	string name;
+	uint64_t samples;
+	uint64_t hits;
+};
+
+class NamedSampleCountStats {
+public:
+	NamedSampleCountStats();
+
+	void add(const string& name, uint64_t samples, uint64_t hits);
+
+	/* Items sorted by samples, with their share of total_samples. */
+	string full_report(int indent_level, uint64_t total_samples);
+
+	uint64_t total_samples;
+	map<string, NamedSampleCountEntry> entries;
+};
+
+/* Statistics about a render, gathered by the session once it finished. */
+class RenderStats {
+public:
+	RenderStats();
+
+	/* Gathers the time spent in the kernel phases and per shader and object
+	 * from the profiler, which must be stopped. */
+	void collect_profiling(Scene *scene, Profiler& prof);
+
+	string full_report();
+
+	bool has_profiling;
+	bool has_texture_cache;
+
+	NamedSampleCountStats kernel;
+	NamedSampleCountStats shaders;
+	NamedSampleCountStats objects;
+
+	TextureCacheStats texture_cache;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __RENDER_STATS_H__ */
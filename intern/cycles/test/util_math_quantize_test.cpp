@@ -0,0 +1,131 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_math.h"
+#include "util/util_math_quantize.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Deterministic random numbers, so failures can be reproduced. */
+class TestRandom {
+public:
+	TestRandom() : state(12345) {}
+
+	float uniform(float min, float max)
+	{
+		state = state * 1664525u + 1013904223u;
+		return min + (max - min) * ((state >> 8) * (1.0f / 16777216.0f));
+	}
+
+private:
+	uint state;
+};
+
+/* Quantizes two child boxes along one axis the way BVH2 packs quantized
+ * nodes, and checks the decoded bounds contain them and are tight. */
+void test_quantize_axis(float min0, float max0, float min1, float max1)
+{
+	const float origin = min(min0, min1);
+	const float extent = max(max0, max1) - origin;
+	const uint exponent = quantize_step_exponent(extent);
+	const float scale = quantize_step_size(exponent);
+
+	const float4 bounds = make_float4(min0, min1, max0, max1);
+	const float4 decoded = dequantize_bounds(quantize_bounds(bounds, origin, exponent),
+	                                         origin,
+	                                         exponent);
+
+	EXPECT_LE(decoded.x, min0);
+	EXPECT_LE(decoded.y, min1);
+	EXPECT_GE(decoded.z, max0);
+	EXPECT_GE(decoded.w, max1);
+
+	/* Steps are at most 2/254 of the extent, rounding adds one step on each
+	 * side. Tiny extents are limited by the smallest exponent. */
+	EXPECT_LE(scale, max(extent * (2.0f/254.0f), quantize_step_size(1)));
+	EXPECT_LE(min0 - decoded.x, scale);
+	EXPECT_LE(min1 - decoded.y, scale);
+	EXPECT_LE(decoded.z - max0, scale);
+	EXPECT_LE(decoded.w - max1, scale);
+}
+
+}  /* namespace */
+
+TEST(util_math_quantize, bounds_round_trip)
+{
+	TestRandom rng;
+	for(int i = 0; i < 10000; i++) {
+		/* Vary the position and size over many orders of magnitude. */
+		const float offset = rng.uniform(-1.0f, 1.0f) * powf(10.0f, rng.uniform(-3.0f, 6.0f));
+		const float size = powf(10.0f, rng.uniform(-4.0f, 4.0f));
+
+		float a = offset + rng.uniform(0.0f, size), b = offset + rng.uniform(0.0f, size);
+		float c = offset + rng.uniform(0.0f, size), d = offset + rng.uniform(0.0f, size);
+		test_quantize_axis(min(a, b), max(a, b), min(c, d), max(c, d));
+	}
+}
+
+TEST(util_math_quantize, bounds_degenerate)
+{
+	/* Flat boxes and empty children stored as a point. */
+	test_quantize_axis(0.0f, 0.0f, 0.0f, 0.0f);
+	test_quantize_axis(1.0f, 1.0f, 1.0f, 2.0f);
+	test_quantize_axis(-5.0f, -5.0f, 3.0f, 3.0f);
+	/* Child spanning the whole parent. */
+	test_quantize_axis(-1.0f, 1.0f, -1.0f, 1.0f);
+	/* Small box far away from the origin of the scene. */
+	test_quantize_axis(1e6f, 1e6f + 0.25f, 1e6f + 0.125f, 1e6f + 0.5f);
+	/* Very large extent. */
+	test_quantize_axis(-1e30f, 1e30f, 0.0f, 1.0f);
+}
+
+TEST(util_math_quantize, oct16_round_trip)
+{
+	TestRandom rng;
+	for(int i = 0; i < 10000; i++) {
+		const float3 n = normalize(make_float3(rng.uniform(-1.0f, 1.0f),
+		                                       rng.uniform(-1.0f, 1.0f),
+		                                       rng.uniform(-1.0f, 1.0f)));
+		const float3 decoded = oct16_decode_unit_vector(oct16_encode_unit_vector(n));
+
+		EXPECT_NEAR(len(decoded), 1.0f, 1e-5f);
+		/* 16 bit octahedral encoding has an error well below 0.01 degrees. */
+		EXPECT_LT(len(decoded - n), 0.01f * M_PI_F / 180.0f);
+	}
+}
+
+TEST(util_math_quantize, oct16_axes)
+{
+	const float3 axes[6] = {make_float3(1.0f, 0.0f, 0.0f), make_float3(-1.0f, 0.0f, 0.0f),
+	                        make_float3(0.0f, 1.0f, 0.0f), make_float3(0.0f, -1.0f, 0.0f),
+	                        make_float3(0.0f, 0.0f, 1.0f), make_float3(0.0f, 0.0f, -1.0f)};
+	for(int i = 0; i < 6; i++) {
+		const float3 decoded = oct16_decode_unit_vector(oct16_encode_unit_vector(axes[i]));
+		EXPECT_NEAR(decoded.x, axes[i].x, 1e-4f);
+		EXPECT_NEAR(decoded.y, axes[i].y, 1e-4f);
+		EXPECT_NEAR(decoded.z, axes[i].z, 1e-4f);
+	}
+
+	/* Zero vectors are stored as the Z axis. */
+	const float3 decoded = oct16_decode_unit_vector(oct16_encode_unit_vector(make_float3(0.0f, 0.0f, 0.0f)));
+	EXPECT_NEAR(decoded.z, 1.0f, 1e-4f);
+}
+
+CCL_NAMESPACE_END
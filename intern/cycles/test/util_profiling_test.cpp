@@ -0,0 +1,88 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_profiling.h"
+
+CCL_NAMESPACE_BEGIN
+
+TEST(util_profiling, hits)
+{
+	Profiler profiler;
+	profiler.reset(2, 3);
+	profiler.start();
+
+	ProfilingState state;
+	profiler.add_state(&state);
+	{
+		ProfilingHelper prof(&state, PROFILING_SHADER_EVAL);
+		prof.set_shader(1);
+		prof.set_shader(1);
+		prof.set_object(2);
+	}
+	profiler.remove_state(&state);
+	profiler.stop();
+
+	uint64_t samples, hits;
+	/* Samples depend on timing, hits are only reported with samples. */
+	if(profiler.get_shader(1, samples, hits)) {
+		EXPECT_EQ(hits, 2u);
+	}
+	if(profiler.get_object(2, samples, hits)) {
+		EXPECT_EQ(hits, 1u);
+	}
+}
+
+TEST(util_profiling, reset_with_registered_state)
+{
+	Profiler profiler;
+	profiler.reset(1, 1);
+	profiler.start();
+
+	ProfilingState state;
+	profiler.add_state(&state);
+	EXPECT_EQ(state.shader_hits.size(), 1u);
+
+	/* The scene grew while the render thread is still registered, its
+	 * counters keep their size and hits beyond it are dropped. */
+	profiler.reset(4, 4);
+	{
+		ProfilingHelper prof(&state, PROFILING_SHADER_EVAL);
+		prof.set_shader(0);
+		prof.set_shader(3);
+		prof.set_object(3);
+		prof.set_object(-1);
+	}
+	EXPECT_EQ(state.shader_hits.size(), 1u);
+	EXPECT_EQ(state.shader_hits[0], 1u);
+	EXPECT_EQ(state.object_hits[0], 0u);
+
+	profiler.remove_state(&state);
+
+	/* The scene shrank while the render thread is registered. */
+	profiler.add_state(&state);
+	EXPECT_EQ(state.shader_hits.size(), 4u);
+	profiler.reset(1, 1);
+	{
+		ProfilingHelper prof(&state, PROFILING_SHADER_EVAL);
+		prof.set_shader(3);
+	}
+	profiler.remove_state(&state);
+	profiler.stop();
+}
+
+CCL_NAMESPACE_END
@@ -50,8 +50,14 @@ public:
 		/* Whether QBVH usage is allowed or not. */
 		bool qbvh;
 
+		/* Whether OBVH usage is allowed or not, only used with AVX2 kernel. */
+		bool obvh;
+
 		/* Whether split kernel is used */
 		bool split_kernel;
+
+		/* Whether coherent rays are traced in streams. */
+		bool ray_stream;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_MATH_QUANTIZE_H__
+#define __UTIL_MATH_QUANTIZE_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Quantized Bounds
+ *
+ * Bounds stored as 8 bit steps from an origin, with a power of two step size
+ * given by its float exponent. Four of them are packed into a uint. Lower
+ * bounds are rounded down and upper bounds up, so the decoded bounds always
+ * contain the original ones. Used for child bounds of compact BVH nodes. */
+
+ccl_device_inline float quantize_step_size(uint exponent)
+{
+	return __uint_as_float(exponent << 23);
+}
+
+ccl_device_inline float4 dequantize_bounds(uint quantized, float origin, uint exponent)
+{
+	const float scale = quantize_step_size(exponent);
+	return make_float4(origin + (float)(quantized & 0xff) * scale,
+	                   origin + (float)((quantized >> 8) & 0xff) * scale,
+	                   origin + (float)((quantized >> 16) & 0xff) * scale,
+	                   origin + (float)(quantized >> 24) * scale);
+}
+
+#ifndef __KERNEL_GPU__
+/* Exponent of the smallest step size covering the extent in 254 steps,
+ * leaving one step of slack for rounding of the origin. */
+ccl_device_inline uint quantize_step_exponent(float extent)
+{
+	if(!(extent > 0.0f)) {
+		return 1;
+	}
+
+	int exponent;
+	frexpf(extent * (1.0f/254.0f), &exponent);
+	return (uint)clamp(exponent + 127, 1, 254);
+}
+
+ccl_device_inline uint quantize_lower_bound(float value, float origin, uint exponent)
+{
+	const float scale = quantize_step_size(exponent);
+	int q = clamp((int)floorf((value - origin) / scale), 0, 255);
+	while(q > 0 && origin + (float)q*scale > value) {
+		q--;
+	}
+	return (uint)q;
+}
+
+ccl_device_inline uint quantize_upper_bound(float value, float origin, uint exponent)
+{
+	const float scale = quantize_step_size(exponent);
+	int q = clamp((int)ceilf((value - origin) / scale), 0, 255);
+	while(q < 255 && origin + (float)q*scale < value) {
+		q++;
+	}
+	return (uint)q;
+}
+
+/* Bounds in the same order as dequantize_bounds() returns them, two lower
+ * bounds followed by two upper bounds. */
+ccl_device_inline uint quantize_bounds(float4 bounds, float origin, uint exponent)
+{
+	return quantize_lower_bound(bounds.x, origin, exponent) |
+	       (quantize_lower_bound(bounds.y, origin, exponent) << 8) |
+	       (quantize_upper_bound(bounds.z, origin, exponent) << 16) |
+	       (quantize_upper_bound(bounds.w, origin, exponent) << 24);
+}
+#endif  /* __KERNEL_GPU__ */
+
+/* Octahedral encoding of unit vectors into two 16 bit values packed in a
+ * uint, see "A Survey of Efficient Representations for Independent Unit
+ * Vectors", Cigolle et al. 2014. */
+
+ccl_device_inline uint oct16_encode_unit_vector(float3 n)
+{
+	const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if(l1 == 0.0f) {
+		n = make_float3(0.0f, 0.0f, 1.0f);
+	}
+	else {
+		n *= 1.0f / l1;
+	}
+
+	float u = n.x, v = n.y;
+	if(n.z < 0.0f) {
+		u = (1.0f - fabsf(n.y)) * signf(n.x);
+		v = (1.0f - fabsf(n.x)) * signf(n.y);
+	}
+
+	const uint qu = (uint)(clamp(u*0.5f + 0.5f, 0.0f, 1.0f)*65535.0f + 0.5f);
+	const uint qv = (uint)(clamp(v*0.5f + 0.5f, 0.0f, 1.0f)*65535.0f + 0.5f);
+	return qu | (qv << 16);
+}
+
+ccl_device_inline float3 oct16_decode_unit_vector(uint packed)
+{
+	const float u = (float)(packed & 0xffff) * (2.0f/65535.0f) - 1.0f;
+	const float v = (float)(packed >> 16) * (2.0f/65535.0f) - 1.0f;
+	float3 n = make_float3(u, v, 1.0f - fabsf(u) - fabsf(v));
+	if(n.z < 0.0f) {
+		n.x = (1.0f - fabsf(v)) * signf(u);
+		n.y = (1.0f - fabsf(u)) * signf(v);
+	}
+	return normalize(n);
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_MATH_QUANTIZE_H__ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_PROFILING_H__
+#define __UTIL_PROFILING_H__
+
+#include "util/util_thread.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Phases of the path tracing kernel the profiler distinguishes. */
+enum ProfilingEvent {
+	PROFILING_UNKNOWN = 0,
+	PROFILING_RAY_SETUP,
+	PROFILING_PATH_INTEGRATE,
+	PROFILING_SCENE_INTERSECT,
+	PROFILING_INDIRECT_EMISSION,
+	PROFILING_VOLUME,
+	PROFILING_SHADER_SETUP,
+	PROFILING_SHADER_EVAL,
+	PROFILING_SHADER_APPLY,
+	PROFILING_AO,
+	PROFILING_SUBSURFACE,
+	PROFILING_CONNECT_LIGHT,
+	PROFILING_SHADOW,
+	PROFILING_SURFACE_BOUNCE,
+	PROFILING_WRITE_RESULT,
+
+	PROFILING_NUM_EVENTS,
+};
+
+/* Current state of a render thread. The thread only writes to it, the
+ * profiler thread periodically samples it, so the overhead for rendering is
+ * a few stores per phase.
+ *
+ * Hits of shaders and objects are counted by the render thread itself,
+ * only while the profiler is running. The hit counters are sized when the
+ * state is added and keep their size until it is removed, even if the
+ * profiler is reset in between. */
+struct ProfilingState {
+	ProfilingState()
+	: event(PROFILING_UNKNOWN),
+	  shader(-1),
+	  object(-1),
+	  active(false)
+	{
+	}
+
+	volatile uint32_t event;
+	volatile int32_t shader;
+	volatile int32_t object;
+	volatile bool active;
+
+	vector<uint64_t> shader_hits;
+	vector<uint64_t> object_hits;
+};
+
+/* Sampling profiler. A thread wakes up every millisecond and records the
+ * phase, shader and object of every registered render thread, the samples
+ * then give the share of render time spent in each of them. */
+class Profiler {
+public:
+	Profiler();
+	~Profiler();
+
+	/* Clears all counters and resizes them for the scene. Render threads
+	 * which are still registered keep counting into per-thread counters of
+	 * the previous size, hits of shaders and objects beyond it are dropped. */
+	void reset(int num_shaders, int num_objects);
+
+	void start();
+	void stop();
+
+	void add_state(ProfilingState *state);
+	void remove_state(ProfilingState *state);
+
+	uint64_t get_event(ProfilingEvent event);
+	bool get_shader(int shader, uint64_t &samples, uint64_t &hits);
+	bool get_object(int object, uint64_t &samples, uint64_t &hits);
+
+protected:
+	void run();
+
+	/* Samples, every one representing one millisecond of a render thread. */
+	vector<uint64_t> event_samples;
+	vector<uint64_t> shader_samples;
+	vector<uint64_t> object_samples;
+
+	/* Hits of the threads which already finished. */
+	vector<uint64_t> shader_hits;
+	vector<uint64_t> object_hits;
+
+	volatile bool do_stop_worker;
+	thread *worker;
+
+	thread_mutex mutex;
+	vector<ProfilingState*> states;
+};
+
+/* Sets the phase of a render thread for the scope of the helper, and the
+ * shader and object being worked on. */
+class ProfilingHelper {
+public:
+	ProfilingHelper(ProfilingState *state, ProfilingEvent event)
+	: state(state)
+	{
+		previous_event = state->event;
+		state->event = event;
+	}
+
+	~ProfilingHelper()
+	{
+		state->event = previous_event;
+	}
+
+	inline void set_event(ProfilingEvent event)
+	{
+		state->event = event;
+	}
+
+	inline void set_shader(int shader)
+	{
+		state->shader = shader;
+		if(state->active && shader >= 0 && shader < (int)state->shader_hits.size()) {
+			state->shader_hits[shader]++;
+		}
+	}
+
+	inline void set_object(int object)
+	{
+		state->object = object;
+		if(state->active && object >= 0 && object < (int)state->object_hits.size()) {
+			state->object_hits[object]++;
+		}
+	}
+
+private:
+	ProfilingState *state;
+	uint32_t previous_event;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __UTIL_PROFILING_H__ */
@@ -36,6 +36,7 @@ public:
 	{
 		pixel_samples = 0;
 		total_pixel_samples = 0;
+		skipped_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -67,6 +68,7 @@ public:
 
 		pixel_samples = progress.pixel_samples;
 		total_pixel_samples = progress.total_pixel_samples;
+		skipped_pixel_samples = progress.skipped_pixel_samples;
 		current_tile_sample = progress.get_current_sample();
 
 		return *this;
@@ -76,6 +78,7 @@ public:
 	{
 		pixel_samples = 0;
 		total_pixel_samples = 0;
+		skipped_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -188,6 +191,7 @@ public:
 		thread_scoped_lock lock(progress_mutex);
 
 		pixel_samples = 0;
+		skipped_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -222,6 +226,22 @@ public:
 		set_update();
 	}
 
+	/* Pixel samples which were not taken because of adaptive sampling. */
+	void add_skipped_samples(uint64_t skipped_pixel_samples_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		skipped_pixel_samples += skipped_pixel_samples_;
+	}
+
+	void get_skipped_samples(uint64_t& skipped_pixel_samples_, uint64_t& total_pixel_samples_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		skipped_pixel_samples_ = skipped_pixel_samples;
+		total_pixel_samples_ = total_pixel_samples;
+	}
+
 	void add_finished_tile(bool denoised)
 	{
 		thread_scoped_lock lock(progress_mutex);
@@ -339,6 +359,8 @@ protected:
 	 *
 	 * total_pixel_samples is the total amount of pixel samples that will be rendered. */
 	uint64_t pixel_samples, total_pixel_samples;
+	/* Pixel samples saved by adaptive sampling, included in pixel_samples. */
+	uint64_t skipped_pixel_samples;
 	/* Stores the current sample count of the last tile that called the update function.
 	 * It's used to display the sample count if only one tile is active. */
 	int current_tile_sample;
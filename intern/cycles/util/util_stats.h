@@ -18,6 +18,10 @@
 #define __UTIL_STATS_H__
 
 #include "util/util_atomic.h"
+#include "util/util_foreach.h"
+#include "util/util_string.h"
+#include "util/util_thread.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -42,6 +46,77 @@ public:
 	size_t mem_peak;
 };
 
+/* Time spent in the phases of synchronizing the scene from the host
+ * application, accumulated over all updates. Phases are kept in the order
+ * they were first recorded, and can be added to from multiple threads.
+ */
+class SyncStats {
+public:
+	struct Phase {
+		string name;
+		double time;
+		int count;
+	};
+
+	void add(const string& name, double time)
+	{
+		thread_scoped_lock lock(mutex);
+		foreach(Phase& phase, phases) {
+			if(phase.name == name) {
+				phase.time += time;
+				phase.count++;
+				return;
+			}
+		}
+
+		Phase phase;
+		phase.name = name;
+		phase.time = time;
+		phase.count = 1;
+		phases.push_back(phase);
+	}
+
+	double get_time(const string& name)
+	{
+		thread_scoped_lock lock(mutex);
+		foreach(const Phase& phase, phases) {
+			if(phase.name == name) {
+				return phase.time;
+			}
+		}
+		return 0.0;
+	}
+
+	vector<Phase> get_phases()
+	{
+		thread_scoped_lock lock(mutex);
+		return phases;
+	}
+
+	void clear()
+	{
+		thread_scoped_lock lock(mutex);
+		phases.clear();
+	}
+
+	string full_report()
+	{
+		thread_scoped_lock lock(mutex);
+		string report;
+		foreach(const Phase& phase, phases) {
+			report += string_printf("%-24s %10.4fs (%d updates)\n",
+			                        phase.name.c_str(),
+			                        phase.time,
+			                        phase.count);
+		}
+		return report;
+	}
+
+protected:
+	thread_mutex mutex;
+	vector<Phase> phases;
+};
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_STATS_H__ */
@@ -102,6 +102,10 @@ typedef struct TextureInfo {
 	uint interpolation, extension;
 	/* Dimensions. */
 	uint width, height, depth;
+	/* Data points to a texture cache image, CPU only. */
+	uint use_cache;
+	/* Padding to keep the struct 16 byte aligned for OpenCL. */
+	uint pad[3];
 } TextureInfo;
 
 CCL_NAMESPACE_END
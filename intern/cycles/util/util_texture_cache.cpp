@@ -0,0 +1,499 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+
+#include "util/util_foreach.h"
+#include "util/util_half.h"
+#include "util/util_math.h"
+
+#include <string.h>
+
+CCL_NAMESPACE_BEGIN
+
+/* Texel conversion, for averaging of mip levels. */
+
+static inline float4 texel_to_float4(const float4& t) { return t; }
+static inline float4 texel_to_float4(const float& t) { return make_float4(t, t, t, t); }
+static inline float4 texel_to_float4(const half4& t) { return half4_to_float4(t); }
+static inline float4 texel_to_float4(const half& t) { float f = half_to_float(t); return make_float4(f, f, f, f); }
+static inline float4 texel_to_float4(const uchar4& t) { return make_float4(t.x, t.y, t.z, t.w); }
+static inline float4 texel_to_float4(const uchar& t) { return make_float4(t, t, t, t); }
+
+static inline void float4_to_texel(const float4& f, float4 *t) { *t = f; }
+static inline void float4_to_texel(const float4& f, float *t) { *t = f.x; }
+static inline void float4_to_texel(const float4& f, half *t) { *t = float_to_half(f.x); }
+
+static inline void float4_to_texel(const float4& f, half4 *t)
+{
+	t->x = float_to_half(f.x);
+	t->y = float_to_half(f.y);
+	t->z = float_to_half(f.z);
+	t->w = float_to_half(f.w);
+}
+
+static inline uchar float_to_uchar(float f)
+{
+	return (uchar)clamp(float_to_int(f + 0.5f), 0, 255);
+}
+
+static inline void float4_to_texel(const float4& f, uchar4 *t)
+{
+	*t = make_uchar4(float_to_uchar(f.x),
+	                 float_to_uchar(f.y),
+	                 float_to_uchar(f.z),
+	                 float_to_uchar(f.w));
+}
+
+static inline void float4_to_texel(const float4& f, uchar *t) { *t = float_to_uchar(f.x); }
+
+static size_t image_data_type_size(ImageDataType type)
+{
+	switch(type) {
+		case IMAGE_DATA_TYPE_FLOAT4: return sizeof(float4);
+		case IMAGE_DATA_TYPE_BYTE4: return sizeof(uchar4);
+		case IMAGE_DATA_TYPE_HALF4: return sizeof(half4);
+		case IMAGE_DATA_TYPE_FLOAT: return sizeof(float);
+		case IMAGE_DATA_TYPE_BYTE: return sizeof(uchar);
+		case IMAGE_DATA_TYPE_HALF: return sizeof(half);
+		default: return 0;
+	}
+}
+
+/* Box filter tiles of the next finer level into the tile. */
+template<typename T>
+static void texture_cache_downsample(TextureCacheTile *tile,
+                                     TextureCacheTile *src_tiles[2][2],
+                                     const TextureCacheImage::Level& src_level)
+{
+	T *pixels = (T*)tile->pixels;
+
+	for(int j = 0; j < tile->height; j++) {
+		const int y = tile->y * TEXTURE_CACHE_TILE_SIZE + j;
+		const int sy[2] = {min(y*2, src_level.height - 1),
+		                   min(y*2 + 1, src_level.height - 1)};
+
+		for(int i = 0; i < tile->width; i++) {
+			const int x = tile->x * TEXTURE_CACHE_TILE_SIZE + i;
+			const int sx[2] = {min(x*2, src_level.width - 1),
+			                   min(x*2 + 1, src_level.width - 1)};
+
+			float4 sum = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+			for(int k = 0; k < 4; k++) {
+				const int px = sx[k & 1], py = sy[k >> 1];
+				const TextureCacheTile *src = src_tiles[py / TEXTURE_CACHE_TILE_SIZE - tile->y*2]
+				                                       [px / TEXTURE_CACHE_TILE_SIZE - tile->x*2];
+				const int lx = px % TEXTURE_CACHE_TILE_SIZE;
+				const int ly = py % TEXTURE_CACHE_TILE_SIZE;
+				sum += texel_to_float4(((const T*)src->pixels)[ly * src->width + lx]);
+			}
+
+			float4_to_texel(sum * 0.25f, &pixels[j * tile->width + i]);
+		}
+	}
+}
+
+/* Texture Cache Image */
+
+TextureCacheImage::TextureCacheImage(TextureCache *cache,
+                                     const string& name,
+                                     ImageDataType type,
+                                     int width,
+                                     int height,
+                                     TextureCacheReader *reader)
+: cache(cache), name(name), type(type), width(width), height(height), reader(reader)
+{
+	pixel_size = image_data_type_size(type);
+
+	int level_width = width, level_height = height;
+	while(true) {
+		Level level;
+		level.width = level_width;
+		level.height = level_height;
+		level.tiles_x = divide_up(level_width, TEXTURE_CACHE_TILE_SIZE);
+		level.tiles_y = divide_up(level_height, TEXTURE_CACHE_TILE_SIZE);
+		level.tiles.resize(level.tiles_x * level.tiles_y, NULL);
+		levels.push_back(level);
+
+		if(level_width == 1 && level_height == 1) {
+			break;
+		}
+
+		level_width = max(level_width / 2, 1);
+		level_height = max(level_height / 2, 1);
+	}
+}
+
+TextureCacheImage::~TextureCacheImage()
+{
+	delete reader;
+}
+
+/* Texture Cache Thread */
+
+TextureCacheThread::TextureCacheThread()
+: cache(NULL), last(0), hits(0)
+{
+	memset(tiles, 0, sizeof(tiles));
+}
+
+TextureCacheThread::~TextureCacheThread()
+{
+	for(int i = 0; i < TEXTURE_CACHE_THREAD_TILES; i++) {
+		if(tiles[i]) {
+			tiles[i]->image->cache->release_tile(tiles[i]);
+		}
+	}
+
+	if(cache) {
+		thread_scoped_lock lock(cache->cache_mutex);
+		cache->stats.hits += hits;
+	}
+}
+
+/* Texture Cache */
+
+TextureCache::TextureCache(size_t max_bytes)
+: lru_head(NULL), lru_tail(NULL)
+{
+	memset(&stats, 0, sizeof(stats));
+	stats.max_bytes = max_bytes;
+}
+
+TextureCache::~TextureCache()
+{
+	while(!images.empty()) {
+		remove_image(*images.begin());
+	}
+}
+
+TextureCacheImage *TextureCache::add_image(const string& name,
+                                           ImageDataType type,
+                                           int width,
+                                           int height,
+                                           TextureCacheReader *reader)
+{
+	TextureCacheImage *image = new TextureCacheImage(this, name, type, width, height, reader);
+
+	thread_scoped_lock lock(cache_mutex);
+	images.insert(image);
+
+	return image;
+}
+
+void TextureCache::remove_image(TextureCacheImage *image)
+{
+	thread_scoped_lock lock(cache_mutex);
+
+	foreach(TextureCacheImage::Level& level, image->levels) {
+		foreach(TextureCacheTile *tile, level.tiles) {
+			if(tile) {
+				assert(tile->users == 0);
+				free_tile(tile);
+			}
+		}
+	}
+
+	images.erase(image);
+	delete image;
+}
+
+TextureCacheTile *TextureCache::acquire_tile(TextureCacheImage *image, int level, int x, int y)
+{
+	thread_scoped_lock lock(cache_mutex);
+
+	TextureCacheImage::Level& image_level = image->levels[level];
+	TextureCacheTile *&slot = image_level.tiles[y * image_level.tiles_x + x];
+	TextureCacheTile *tile = slot;
+
+	if(tile) {
+		tile->users++;
+
+		/* Tile might still be loaded by another thread. */
+		while(!tile->loaded) {
+			tile_loaded_cond.wait(lock);
+		}
+
+		lru_remove(tile);
+		lru_push_front(tile);
+
+		stats.hits++;
+		return tile;
+	}
+
+	tile = new TextureCacheTile();
+	tile->image = image;
+	tile->level = level;
+	tile->x = x;
+	tile->y = y;
+	tile->width = min(TEXTURE_CACHE_TILE_SIZE, image_level.width - x * TEXTURE_CACHE_TILE_SIZE);
+	tile->height = min(TEXTURE_CACHE_TILE_SIZE, image_level.height - y * TEXTURE_CACHE_TILE_SIZE);
+	tile->pixels = NULL;
+	tile->users = 1;
+	tile->loaded = false;
+	tile->lru_prev = NULL;
+	tile->lru_next = NULL;
+	slot = tile;
+
+	stats.misses++;
+
+	/* Load without holding the lock, so other threads can continue. */
+	lock.unlock();
+	load_tile(tile);
+	lock.lock();
+
+	tile->loaded = true;
+	lru_push_front(tile);
+
+	stats.resident_bytes += tile->width * tile->height * image->pixel_size;
+	if(stats.resident_bytes > stats.peak_resident_bytes) {
+		stats.peak_resident_bytes = stats.resident_bytes;
+	}
+	free_unused_tiles();
+
+	tile_loaded_cond.notify_all();
+
+	return tile;
+}
+
+void TextureCache::release_tile(TextureCacheTile *tile)
+{
+	thread_scoped_lock lock(cache_mutex);
+
+	assert(tile->users > 0);
+	tile->users--;
+
+	if(stats.resident_bytes > stats.max_bytes) {
+		free_unused_tiles();
+	}
+}
+
+TextureCacheStats TextureCache::get_stats()
+{
+	thread_scoped_lock lock(cache_mutex);
+	return stats;
+}
+
+void TextureCache::load_tile(TextureCacheTile *tile)
+{
+	TextureCacheImage *image = tile->image;
+	const size_t size = tile->width * tile->height * image->pixel_size;
+	tile->pixels = new uchar[size];
+
+	bool success = false;
+	bool has_level;
+
+	{
+		thread_scoped_lock reader_lock(image->reader_mutex);
+		has_level = image->reader->has_level(tile->level);
+		if(has_level) {
+			success = image->reader->read(tile->level,
+			                              tile->x * TEXTURE_CACHE_TILE_SIZE,
+			                              tile->y * TEXTURE_CACHE_TILE_SIZE,
+			                              tile->width,
+			                              tile->height,
+			                              tile->pixels);
+		}
+	}
+
+	if(!has_level && tile->level > 0) {
+		downsample_tile(tile);
+		success = true;
+	}
+
+	if(!success) {
+		memset(tile->pixels, 0, size);
+	}
+}
+
+void TextureCache::downsample_tile(TextureCacheTile *tile)
+{
+	TextureCacheImage *image = tile->image;
+	const TextureCacheImage::Level& src_level = image->levels[tile->level - 1];
+	TextureCacheTile *src_tiles[2][2];
+
+	for(int j = 0; j < 2; j++) {
+		for(int i = 0; i < 2; i++) {
+			const int x = min(tile->x*2 + i, src_level.tiles_x - 1);
+			const int y = min(tile->y*2 + j, src_level.tiles_y - 1);
+			src_tiles[j][i] = acquire_tile(image, tile->level - 1, x, y);
+		}
+	}
+
+	switch(image->type) {
+		case IMAGE_DATA_TYPE_FLOAT4:
+			texture_cache_downsample<float4>(tile, src_tiles, src_level);
+			break;
+		case IMAGE_DATA_TYPE_BYTE4:
+			texture_cache_downsample<uchar4>(tile, src_tiles, src_level);
+			break;
+		case IMAGE_DATA_TYPE_HALF4:
+			texture_cache_downsample<half4>(tile, src_tiles, src_level);
+			break;
+		case IMAGE_DATA_TYPE_FLOAT:
+			texture_cache_downsample<float>(tile, src_tiles, src_level);
+			break;
+		case IMAGE_DATA_TYPE_BYTE:
+			texture_cache_downsample<uchar>(tile, src_tiles, src_level);
+			break;
+		case IMAGE_DATA_TYPE_HALF:
+			texture_cache_downsample<half>(tile, src_tiles, src_level);
+			break;
+		default:
+			assert(0);
+			break;
+	}
+
+	for(int j = 0; j < 2; j++) {
+		for(int i = 0; i < 2; i++) {
+			release_tile(src_tiles[j][i]);
+		}
+	}
+}
+
+void TextureCache::free_tile(TextureCacheTile *tile)
+{
+	TextureCacheImage *image = tile->image;
+	TextureCacheImage::Level& level = image->levels[tile->level];
+
+	level.tiles[tile->y * level.tiles_x + tile->x] = NULL;
+	lru_remove(tile);
+	stats.resident_bytes -= tile->width * tile->height * image->pixel_size;
+
+	delete [] tile->pixels;
+	delete tile;
+}
+
+void TextureCache::free_unused_tiles()
+{
+	TextureCacheTile *tile = lru_tail;
+
+	while(tile && stats.resident_bytes > stats.max_bytes) {
+		TextureCacheTile *prev = tile->lru_prev;
+		if(tile->users == 0) {
+			free_tile(tile);
+		}
+		tile = prev;
+	}
+}
+
+void TextureCache::lru_remove(TextureCacheTile *tile)
+{
+	if(tile->lru_prev) tile->lru_prev->lru_next = tile->lru_next;
+	else if(lru_head == tile) lru_head = tile->lru_next;
+
+	if(tile->lru_next) tile->lru_next->lru_prev = tile->lru_prev;
+	else if(lru_tail == tile) lru_tail = tile->lru_prev;
+
+	tile->lru_prev = NULL;
+	tile->lru_next = NULL;
+}
+
+void TextureCache::lru_push_front(TextureCacheTile *tile)
+{
+	tile->lru_prev = NULL;
+	tile->lru_next = lru_head;
+
+	if(lru_head) lru_head->lru_prev = tile;
+	lru_head = tile;
+
+	if(!lru_tail) lru_tail = tile;
+}
+
+/* Stats */
+
+string TextureCacheStats::full_report() const
+{
+	const uint64_t lookups = hits + misses;
+	const double hit_rate = (lookups)? (double)hits / lookups * 100.0: 0.0;
+
+	return string_printf("Texture cache:\n"
+	                     "  Hits: %llu (%.2f%%)\n"
+	                     "  Misses: %llu\n"
+	                     "  Resident: %s\n"
+	                     "  Peak resident: %s\n"
+	                     "  Limit: %s\n",
+	                     (unsigned long long)hits, hit_rate,
+	                     (unsigned long long)misses,
+	                     string_human_readable_size(resident_bytes).c_str(),
+	                     string_human_readable_size(peak_resident_bytes).c_str(),
+	                     string_human_readable_size(max_bytes).c_str());
+}
+
+/* Kernel Lookup */
+
+static inline bool texture_cache_tile_match(const TextureCacheTile *tile,
+                                            const TextureCacheImage *image,
+                                            int level,
+                                            int tx,
+                                            int ty)
+{
+	return tile &&
+	       tile->image == image &&
+	       tile->level == level &&
+	       tile->x == tx &&
+	       tile->y == ty;
+}
+
+static inline const void *texture_cache_tile_pixel(const TextureCacheTile *tile,
+                                                   int x,
+                                                   int y)
+{
+	const int lx = x - tile->x * TEXTURE_CACHE_TILE_SIZE;
+	const int ly = y - tile->y * TEXTURE_CACHE_TILE_SIZE;
+	return tile->pixels + (ly * tile->width + lx) * tile->image->pixel_size;
+}
+
+const void *texture_cache_lookup(TextureCacheThread *thread,
+                                 TextureCacheImage *image,
+                                 int level,
+                                 int x,
+                                 int y)
+{
+	const int tx = x / TEXTURE_CACHE_TILE_SIZE;
+	const int ty = y / TEXTURE_CACHE_TILE_SIZE;
+
+	/* Tiles locked by the thread, starting with the most recent one. */
+	TextureCacheTile *tile = thread->tiles[thread->last];
+	if(texture_cache_tile_match(tile, image, level, tx, ty)) {
+		thread->hits++;
+		return texture_cache_tile_pixel(tile, x, y);
+	}
+
+	for(int i = 0; i < TEXTURE_CACHE_THREAD_TILES; i++) {
+		tile = thread->tiles[i];
+		if(texture_cache_tile_match(tile, image, level, tx, ty)) {
+			thread->last = i;
+			thread->hits++;
+			return texture_cache_tile_pixel(tile, x, y);
+		}
+	}
+
+	/* Replace the oldest locked tile. */
+	const int slot = (thread->last + 1) % TEXTURE_CACHE_THREAD_TILES;
+	if(thread->tiles[slot]) {
+		thread->tiles[slot]->image->cache->release_tile(thread->tiles[slot]);
+	}
+
+	tile = image->cache->acquire_tile(image, level, tx, ty);
+	thread->tiles[slot] = tile;
+	thread->last = slot;
+	thread->cache = image->cache;
+
+	return texture_cache_tile_pixel(tile, x, y);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_set.h"
+#include "util/util_string.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Tiled and mipmapped storage of image textures for the CPU kernel, with a
+ * bounded amount of memory. Images are split into square tiles on every mip
+ * level, which are loaded on demand when the kernel looks them up and freed
+ * in least recently used order once the cache exceeds its memory limit.
+ *
+ * Tiles of the full resolution image are read from a TextureCacheReader,
+ * coarser levels are read as well if the file contains them, otherwise they
+ * are computed by averaging tiles of the next finer level.
+ *
+ * Every render thread keeps a few recently used tiles locked in the cache,
+ * so most lookups don't need any synchronization.
+ */
+
+#define TEXTURE_CACHE_TILE_SIZE 64
+#define TEXTURE_CACHE_THREAD_TILES 16
+
+class TextureCache;
+class TextureCacheImage;
+
+/* Reads pixels of an image, rows are ordered from bottom to top like in image
+ * textures and pixels are stored in the image data type. Calls are
+ * serialized per image.
+ */
+class TextureCacheReader {
+public:
+	virtual ~TextureCacheReader() {}
+
+	/* Whether the image itself contains given mip level. */
+	virtual bool has_level(int level) { return level == 0; }
+
+	virtual bool read(int level, int x, int y, int width, int height, void *pixels) = 0;
+};
+
+struct TextureCacheTile {
+	TextureCacheImage *image;
+	int level, x, y;
+	int width, height;
+	uchar *pixels;
+
+	/* Protected by the cache lock. */
+	int users;
+	bool loaded;
+	TextureCacheTile *lru_prev, *lru_next;
+};
+
+class TextureCacheImage {
+public:
+	struct Level {
+		int width, height;
+		int tiles_x, tiles_y;
+		vector<TextureCacheTile*> tiles;
+	};
+
+	TextureCache *cache;
+	const string name;
+	ImageDataType type;
+	size_t pixel_size;
+	int width, height;
+	vector<Level> levels;
+
+protected:
+	friend class TextureCache;
+
+	TextureCacheImage(TextureCache *cache,
+	                  const string& name,
+	                  ImageDataType type,
+	                  int width,
+	                  int height,
+	                  TextureCacheReader *reader);
+	~TextureCacheImage();
+
+	TextureCacheReader *reader;
+	thread_mutex reader_mutex;
+};
+
+/* Tiles locked by one render thread, stored in the kernel globals. */
+struct TextureCacheThread {
+	TextureCacheThread();
+	~TextureCacheThread();
+
+	TextureCache *cache;
+	TextureCacheTile *tiles[TEXTURE_CACHE_THREAD_TILES];
+	int last;
+	uint64_t hits;
+};
+
+struct TextureCacheStats {
+	uint64_t hits;
+	uint64_t misses;
+	size_t resident_bytes;
+	size_t peak_resident_bytes;
+	size_t max_bytes;
+
+	string full_report() const;
+};
+
+class TextureCache {
+public:
+	explicit TextureCache(size_t max_bytes);
+	~TextureCache();
+
+	/* Cache takes ownership of the reader. */
+	TextureCacheImage *add_image(const string& name,
+	                             ImageDataType type,
+	                             int width,
+	                             int height,
+	                             TextureCacheReader *reader);
+	/* Must not be called while rendering. */
+	void remove_image(TextureCacheImage *image);
+
+	/* Tile with given index, loaded when needed. Must be released again. */
+	TextureCacheTile *acquire_tile(TextureCacheImage *image, int level, int x, int y);
+	void release_tile(TextureCacheTile *tile);
+
+	TextureCacheStats get_stats();
+
+protected:
+	friend struct TextureCacheThread;
+
+	void load_tile(TextureCacheTile *tile);
+	void downsample_tile(TextureCacheTile *tile);
+	void free_tile(TextureCacheTile *tile);
+	void free_unused_tiles();
+
+	void lru_remove(TextureCacheTile *tile);
+	void lru_push_front(TextureCacheTile *tile);
+
+	thread_mutex cache_mutex;
+	thread_condition_variable tile_loaded_cond;
+
+	TextureCacheTile *lru_head, *lru_tail;
+	set<TextureCacheImage*> images;
+
+	TextureCacheStats stats;
+};
+
+/* Pixel at given texel coordinate of the mip level, which must be inside of
+ * the level. Uses the tiles locked by the thread when possible.
+ */
+const void *texture_cache_lookup(TextureCacheThread *thread,
+                                 TextureCacheImage *image,
+                                 int level,
+                                 int x,
+                                 int y);
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
@@ -58,12 +58,19 @@
  *
  *     // leave image in cache.
  * \endcode
+ *
+ * By default the least recently used element is freed first, or the element
+ * with the lowest priority when an item priority function is set. When an item
+ * cost function is set, elements with the same priority are freed based on the
+ * time since they were last used, their size and the cost to calculate them
+ * again: old, big and cheap elements are freed first.
  */
 
 #include <list>
 #include <queue>
 #include <vector>
 #include "MEM_Allocator.h"
+#include "atomic/atomic_ops.h"
 
 template<class T>
 class MEM_CacheLimiter;
@@ -83,6 +90,7 @@ public:
 	explicit MEM_CacheLimiterHandle(T * data_,MEM_CacheLimiter<T> *parent_) :
 		data(data_),
 		refcount(0),
+		last_access(0),
 		parent(parent_)
 	{ }
 
@@ -134,6 +142,7 @@ private:
 	T * data;
 	int refcount;
 	int pos;
+	uint64_t last_access;
 	MEM_CacheLimiter<T> * parent;
 };
 
@@ -143,9 +152,14 @@ public:
 	typedef size_t (*MEM_CacheLimiter_DataSize_Func) (void *data);
 	typedef int    (*MEM_CacheLimiter_ItemPriority_Func) (void *item, int default_priority);
 	typedef bool   (*MEM_CacheLimiter_ItemDestroyable_Func) (void *item);
+	typedef float  (*MEM_CacheLimiter_ItemCost_Func) (void *item);
 
 	MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func)
-		: data_size_func(data_size_func) {
+		: data_size_func(data_size_func),
+		  item_priority_func(NULL),
+		  item_destroyable_func(NULL),
+		  item_cost_func(NULL),
+		  access_clock(0) {
 	}
 
 	~MEM_CacheLimiter() {
@@ -158,6 +172,7 @@ public:
 	MEM_CacheLimiterHandle<T> *insert(T * elem) {
 		queue.push_back(new MEM_CacheLimiterHandle<T>(elem, this));
 		queue.back()->pos = queue.size() - 1;
+		queue.back()->last_access = atomic_add_and_fetch_uint64(&access_clock, 1);
 		return queue.back();
 	}
 
@@ -227,6 +242,15 @@ public:
 	}
 
 	void touch(MEM_CacheLimiterHandle<T> * handle) {
+		/* With cost based freeing only the access time is updated, which
+		 * is safe to do without locking the cache limiter.
+		 */
+		if (item_cost_func) {
+			uint64_t time = atomic_add_and_fetch_uint64(&access_clock, 1);
+			atomic_store_uint64(&handle->last_access, time);
+			return;
+		}
+
 		/* If we're using custom priority callback re-arranging the queue
 		 * doesn't make much sense because we'll iterate it all to get
 		 * least priority element anyway.
@@ -248,6 +272,10 @@ public:
 		this->item_destroyable_func = item_destroyable_func;
 	}
 
+	void set_item_cost_func(MEM_CacheLimiter_ItemCost_Func item_cost_func) {
+		this->item_cost_func = item_cost_func;
+	}
+
 private:
 	typedef MEM_CacheLimiterHandle<T> *MEM_CacheElementPtr;
 	typedef std::vector<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr> > MEM_CacheQueue;
@@ -272,7 +300,10 @@ private:
 
 		MEM_CacheElementPtr best_match_elem = NULL;
 
-		if (!item_priority_func) {
+		if (item_cost_func) {
+			best_match_elem = get_highest_cost_score_destroyable_element();
+		}
+		else if (!item_priority_func) {
 			for (iterator it = queue.begin(); it != queue.end(); it++) {
 				MEM_CacheElementPtr elem = *it;
 				if (!can_destroy_element(elem))
@@ -307,10 +338,55 @@ private:
 		return best_match_elem;
 	}
 
+	/* Among the elements with the lowest priority, find the one where
+	 * (time since last access * size / cost to calculate again) is highest.
+	 */
+	MEM_CacheElementPtr get_highest_cost_score_destroyable_element(void) {
+		MEM_CacheElementPtr best_match_elem = NULL;
+		int best_match_priority = 0;
+		double best_match_score = 0.0;
+		uint64_t now = access_clock;
+		int i;
+
+		for (i = 0; i < queue.size(); i++) {
+			MEM_CacheElementPtr elem = queue[i];
+			void *data;
+
+			if (!can_destroy_element(elem))
+				continue;
+
+			data = elem->get()->get_data();
+
+			int priority = 0;
+			if (item_priority_func) {
+				priority = item_priority_func(data, priority);
+			}
+
+			if (best_match_elem && priority > best_match_priority) {
+				continue;
+			}
+
+			double age = (double)(now - atomic_load_uint64(&elem->last_access) + 1);
+			double size = data_size_func ? (double)data_size_func(data) : 1.0;
+			double cost = (double)item_cost_func(data);
+			double score = age * (size + 1.0) / (cost > 1e-6 ? cost : 1e-6);
+
+			if (best_match_elem == NULL || priority < best_match_priority || score > best_match_score) {
+				best_match_priority = priority;
+				best_match_score = score;
+				best_match_elem = elem;
+			}
+		}
+
+		return best_match_elem;
+	}
+
 	MEM_CacheQueue queue;
 	MEM_CacheLimiter_DataSize_Func data_size_func;
 	MEM_CacheLimiter_ItemPriority_Func item_priority_func;
 	MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func;
+	MEM_CacheLimiter_ItemCost_Func item_cost_func;
+	uint64_t access_clock;
 };
 
 #endif  // __MEM_CACHELIMITER_H__
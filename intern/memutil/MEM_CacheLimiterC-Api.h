@@ -50,6 +50,9 @@ typedef int (*MEM_CacheLimiter_ItemPriority_Func) (void*, int);
 /* function to check whether item could be destroyed */
 typedef bool (*MEM_CacheLimiter_ItemDestroyable_Func) (void*);
 
+/* function used to get the cost of calculating the item again when freeing memory */
+typedef float (*MEM_CacheLimiter_ItemCost_Func) (void*);
+
 #ifndef __MEM_CACHELIMITER_H__
 void MEM_CacheLimiter_set_maximum(size_t m);
 size_t MEM_CacheLimiter_get_maximum(void);
@@ -108,6 +111,9 @@ void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle);
 /**
  * Raise priority of object (put it at the tail of the deletion chain)
  *
+ * When an item cost function is set this is thread safe,
+ * otherwise the cache limiter must be locked by the caller.
+ *
  * \param handle of object
  */
 
@@ -153,6 +159,13 @@ void MEM_CacheLimiter_ItemPriority_Func_set(MEM_CacheLimiterC *This,
 void MEM_CacheLimiter_ItemDestroyable_Func_set(MEM_CacheLimiterC *This,
                                                MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func);
 
+/**
+ * Free elements based on size, priority and the cost of calculating them again
+ * instead of least recently used first.
+ */
+void MEM_CacheLimiter_ItemCost_Func_set(MEM_CacheLimiterC *This,
+                                        MEM_CacheLimiter_ItemCost_Func item_cost_func);
+
 size_t MEM_CacheLimiter_get_memory_in_use(MEM_CacheLimiterC *This);
 
 #ifdef __cplusplus
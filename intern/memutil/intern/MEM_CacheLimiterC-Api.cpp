@@ -221,6 +221,12 @@ void MEM_CacheLimiter_ItemDestroyable_Func_set(MEM_CacheLimiterC *This,
 	cast(This)->get_cache()->set_item_destroyable_func(item_destroyable_func);
 }
 
+void MEM_CacheLimiter_ItemCost_Func_set(MEM_CacheLimiterC *This,
+                                        MEM_CacheLimiter_ItemCost_Func item_cost_func)
+{
+	cast(This)->get_cache()->set_item_cost_func(item_cost_func);
+}
+
 size_t MEM_CacheLimiter_get_memory_in_use(MEM_CacheLimiterC *This)
 {
 	return cast(This)->get_cache()->get_memory_in_use();
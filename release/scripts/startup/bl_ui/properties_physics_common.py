@@ -171,6 +171,14 @@ def point_cache_ui(self, context, cache, enabled, cachetype):
             row.label(text="Compression:")
             row.prop(cache, "compression", expand=True)
 
+            row = layout.row()
+            row.enabled = enabled and bpy.data.is_saved
+            row.active = cache.use_disk_cache
+            row.prop(cache, "use_single_file")
+            sub = row.row()
+            sub.active = cache.use_disk_cache and cache.use_single_file and cache.compression != 'NO'
+            sub.prop(cache, "use_frame_delta")
+
             layout.separator()
 
             if cache.id_data.library and not cache.use_disk_cache:
@@ -559,6 +559,16 @@ class USERPREF_PT_system(Panel):
         # col.prop(system, "prefetch_frames")
         col.prop(system, "memory_cache_limit")
 
+        col.separator()
+
+        col.label(text="Compositor:")
+        col.prop(system, "compositor_cache_limit")
+
+        col.separator()
+
+        col.label(text="Modifiers:")
+        col.prop(system, "modifier_cache_limit")
+
         # 3. Column
         column = split.column()
 
@@ -44,6 +44,7 @@ extern void          BKE_undo_number(struct bContext *C, int nr);
 extern const char   *BKE_undo_get_name(int nr, bool *r_active);
 extern const char   *BKE_undo_get_name_last(void);
 extern bool          BKE_undo_save_file(const char *filename);
+extern size_t        BKE_undo_memory_get(void);
 extern struct Main  *BKE_undo_get_main(struct Scene **r_scene);
 
 extern void          BKE_undo_callback_wm_kill_jobs_set(void (*callback)(struct bContext *C));
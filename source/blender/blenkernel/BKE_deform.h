@@ -116,4 +116,14 @@ void BKE_defvert_extract_vgroup_to_polyweights(
         struct MDeformVert *dvert, const int defgroup, const int num_verts, struct MLoop *loops, const int num_loops,
         struct MPoly *polys, const int num_polys, float *r_weights, const bool invert_vgroup);
 
+/* Threaded deformation of vertex coordinates, meshes with fewer vertices are deformed in a single thread. */
+#define DEFORM_VERTS_THREADED_MIN 1000
+
+typedef void (*DeformVertFunc)(void *userdata, const int index, float co[3], const float weight);
+
+void BKE_deform_verts_parallel(
+        float (*vertexCos)[3], const int numVerts,
+        const struct MDeformVert *dvert, const int defgrp_index,
+        void *userdata, DeformVertFunc func);
+
 #endif  /* __BKE_DEFORM_H__ */
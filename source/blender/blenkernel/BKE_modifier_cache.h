@@ -0,0 +1,89 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BKE_MODIFIER_CACHE_H__
+#define __BKE_MODIFIER_CACHE_H__
+
+/** \file BKE_modifier_cache.h
+ *  \ingroup bke
+ *
+ * Cache of intermediate results of the mesh modifier stack, so tweaking a
+ * modifier doesn't evaluate the expensive modifiers in front of it again.
+ */
+
+#include "BKE_customdata.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct DerivedMesh;
+struct ID;
+struct ModifierData;
+struct Object;
+struct Scene;
+
+/* Settings of the stack evaluation which cached results depend on. */
+typedef struct ModifierCacheSettings {
+	CustomDataMask data_mask;
+	int required_mode;
+	int draw_flag;
+	bool need_mapping;
+	bool allow_gpu;
+} ModifierCacheSettings;
+
+bool BKE_modifier_cache_is_enabled(void);
+
+/* Keys of the results of the stack, one for every modifier starting at md,
+ * 0 for results which can't be cached. Returns NULL when nothing can be cached.
+ * vertexCos are the deformed input coordinates, or NULL to use the mesh. */
+uint64_t *BKE_modifier_cache_keys_calc(
+        struct Scene *scene, struct Object *ob, struct ModifierData *md,
+        float (*vertexCos)[3], const ModifierCacheSettings *settings,
+        int *r_num_keys);
+
+/* Copy the result of the last modifier which has a valid cache entry,
+ * returns its index in the keys or -1 when there is none. */
+int BKE_modifier_cache_restore(
+        struct Object *ob, const uint64_t *keys, const int num_keys,
+        struct DerivedMesh **r_dm, struct DerivedMesh **r_orcodm, struct DerivedMesh **r_clothorcodm,
+        CustomDataMask *r_append_mask);
+
+/* Store a copy of the result of the modifier at index, if it took long
+ * enough to calculate and fits into the memory limit. */
+void BKE_modifier_cache_store(
+        struct Object *ob, const int index, const uint64_t key, const double time,
+        struct DerivedMesh *dm, struct DerivedMesh *orcodm, struct DerivedMesh *clothorcodm,
+        const CustomDataMask append_mask);
+
+void BKE_modifier_cache_free(struct Object *ob);
+
+/* Free cached results which depend on the given datablock, called when it is tagged for update. */
+void BKE_modifier_cache_tag_update(struct ID *id);
+
+size_t BKE_modifier_cache_memory_in_use(void);
+/* Number of times a cached result was restored. */
+unsigned int BKE_modifier_cache_hits(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BKE_MODIFIER_CACHE_H__ */
@@ -279,6 +279,9 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, struct Seque
  */
 
 void BKE_sequencer_cache_put(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type, struct ImBuf *nval);
+/* cost is the time in seconds it took to render nval, 0 when unknown */
+void BKE_sequencer_cache_put_ex(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                struct ImBuf *nval, float cost);
 
 void BKE_sequencer_cache_cleanup_sequence(struct Sequence *seq);
 
@@ -58,6 +58,7 @@
 #include "BKE_library.h"
 #include "BKE_material.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_object.h"
@@ -75,6 +76,8 @@ static DerivedMesh *navmesh_dm_createNavMeshForVisualization(DerivedMesh *dm);
 
 #include "BLI_sys_types.h" /* for intptr_t support */
 
+#include "PIL_time.h"
+
 #include "GPU_buffers.h"
 #include "GPU_glew.h"
 #include "GPU_shader.h"
@@ -1792,6 +1795,13 @@ static void mesh_calc_modifiers(
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = me->smoothresh;
 
+	/* Intermediate results are only cached for interactive updates in object mode,
+	 * in other modes the mesh can change without the object being tagged. */
+	const bool use_stack_cache = (useCache && !useRenderParams && useDeform > 0 && index == -1 &&
+	                              !build_shapekey_layers && ob->mode == OB_MODE_OBJECT);
+	uint64_t *cache_keys = NULL;
+	int num_cache_keys = 0, cache_index = 0;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -1906,7 +1916,39 @@ static void mesh_calc_modifiers(
 	orcodm = NULL;
 	clothorcodm = NULL;
 
-	for (; md; md = md->next, curr = curr->next) {
+	if (use_stack_cache) {
+		ModifierCacheSettings cache_settings = {0};
+
+		cache_settings.data_mask = dataMask;
+		cache_settings.required_mode = required_mode;
+		cache_settings.draw_flag = draw_flag;
+		cache_settings.need_mapping = need_mapping;
+		cache_settings.allow_gpu = allow_gpu;
+
+		cache_keys = BKE_modifier_cache_keys_calc(
+		        scene, ob, md, deformedVerts, &cache_settings, &num_cache_keys);
+	}
+
+	if (cache_keys) {
+		const int cache_restored = BKE_modifier_cache_restore(
+		        ob, cache_keys, num_cache_keys, &dm, &orcodm, &clothorcodm, &append_mask);
+
+		if (cache_restored != -1) {
+			/* Continue behind the cached modifier, its result replaces the deformed vertices. */
+			for (; cache_index <= cache_restored; cache_index++, md = md->next, curr = curr->next) {
+				md->scene = scene;
+			}
+
+			if (deformedVerts && deformedVerts != inputVertexCos)
+				MEM_freeN(deformedVerts);
+			deformedVerts = NULL;
+		}
+	}
+	else if (useCache && ob->modifier_cache) {
+		BKE_modifier_cache_free(ob);
+	}
+
+	for (; md; md = md->next, curr = curr->next, cache_index++) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
 		md->scene = scene;
@@ -2009,6 +2051,7 @@ static void mesh_calc_modifiers(
 		}
 		else {
 			DerivedMesh *ndm;
+			double start_time = 0.0;
 
 			/* determine which data layers are needed by following modifiers */
 			if (curr->next)
@@ -2080,6 +2123,9 @@ static void mesh_calc_modifiers(
 				}
 			}
 
+			if (cache_keys)
+				start_time = PIL_check_seconds_timer();
+
 			ndm = modwrap_applyModifier(md, ob, dm, app_flags);
 			ASSERT_IS_VALID_DM(ndm);
 
@@ -2148,6 +2194,12 @@ static void mesh_calc_modifiers(
 			}
 
 			dm->deformedOnly = false;
+
+			if (cache_keys && cache_keys[cache_index] && !deformedVerts) {
+				BKE_modifier_cache_store(
+				        ob, cache_index, cache_keys[cache_index], PIL_check_seconds_timer() - start_time,
+				        dm, orcodm, clothorcodm, append_mask);
+			}
 		}
 
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -2269,6 +2321,9 @@ static void mesh_calc_modifiers(
 	if (deformedVerts && deformedVerts != inputVertexCos)
 		MEM_freeN(deformedVerts);
 
+	if (cache_keys)
+		MEM_freeN(cache_keys);
+
 	BLI_linklist_free((LinkNode *)datamasks, NULL);
 }
 
@@ -2677,6 +2732,8 @@ static void editbmesh_build_data(Scene *scene, Object *obedit, BMEditMesh *em, C
 {
 	BKE_object_free_derived_caches(obedit);
 	BKE_object_sculpt_modifiers_changed(obedit);
+	/* The mesh is being edited, cached modifier results won't be valid anymore. */
+	BKE_modifier_cache_free(obedit);
 
 	BKE_editmesh_free_derivedmesh(em);
 
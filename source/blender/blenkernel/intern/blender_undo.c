@@ -78,7 +78,6 @@ typedef struct UndoElem {
 	char str[FILE_MAX];
 	char name[BKE_UNDO_STR_MAX];
 	MemFile memfile;
-	uintptr_t undosize;
 } UndoElem;
 
 static ListBase undobase = {NULL, NULL};
@@ -127,7 +126,7 @@ static int read_undosave(bContext *C, UndoElem *uel)
 /* name can be a dynamic string */
 void BKE_undo_write(bContext *C, const char *name)
 {
-	uintptr_t maxmem, totmem, memused;
+	uintptr_t maxmem;
 	int nr /*, success */ /* UNUSED */;
 	UndoElem *uel;
 
@@ -194,39 +193,42 @@ void BKE_undo_write(bContext *C, const char *name)
 
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 
-		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
-		curundo->undosize = MEM_get_memory_in_use() - memused;
 	}
 
 	if (U.undomemory != 0) {
 		/* limit to maximum memory (afterwards, we can't know in advance) */
-		totmem = 0;
 		maxmem = ((uintptr_t)U.undomemory) * 1024 * 1024;
 
-		/* keep at least two (original + other) */
-		uel = undobase.last;
-		while (uel && uel->prev) {
-			totmem += uel->undosize;
-			if (totmem > maxmem) break;
-			uel = uel->prev;
+		/* Steps share unchanged data, so freeing a step only frees what no other step uses,
+		 * remove the oldest steps until the whole stack fits. Keep at least two (original + other). */
+		while ((BKE_undo_memory_get() > maxmem) &&
+		       (undobase.first != undobase.last) &&
+		       (((UndoElem *)undobase.first)->next != undobase.last))
+		{
+			UndoElem *first = undobase.first;
+			BLI_remlink(&undobase, first);
+			/* the merge is because of compression */
+			BLO_memfile_merge(&first->memfile, &first->next->memfile);
+			MEM_freeN(first);
 		}
+	}
 
-		if (uel) {
-			if (uel->prev && uel->prev->prev)
-				uel = uel->prev;
-
-			while (undobase.first != uel) {
-				UndoElem *first = undobase.first;
-				BLI_remlink(&undobase, first);
-				/* the merge is because of compression */
-				BLO_memfile_merge(&first->memfile, &first->next->memfile);
-				MEM_freeN(first);
-			}
-		}
+	if (G.debug & G_DEBUG) {
+		printf("undo push %s: %u bytes added, %d steps use %.2f MB\n",
+		       curundo->name, curundo->memfile.size, BLI_listbase_count(&undobase),
+		       (double)BKE_undo_memory_get() / (1024.0 * 1024.0));
 	}
 }
 
+/**
+ * \return Memory used by the global undo stack, data shared between steps is only counted once.
+ */
+size_t BKE_undo_memory_get(void)
+{
+	return BLO_memfile_shared_size_get();
+}
+
 /* 1 = an undo, -1 is a redo. we have to make sure 'curundo' remains at current situation */
 void BKE_undo_step(bContext *C, int step)
 {
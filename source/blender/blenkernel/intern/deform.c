@@ -47,6 +47,7 @@
 #include "BLI_math.h"
 #include "BLI_string.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -992,6 +993,52 @@ void BKE_defvert_extract_vgroup_to_polyweights(
 /** \} */
 
 
+/* -------------------------------------------------------------------- */
+
+/** \name Threaded Deform
+ * \{ */
+
+typedef struct DeformVertsUserdata {
+	float (*vertexCos)[3];
+	const MDeformVert *dvert;
+	int defgrp_index;
+	void *userdata;
+	DeformVertFunc func;
+} DeformVertsUserdata;
+
+static void deform_verts_task(void *userdata, const int index)
+{
+	const DeformVertsUserdata *data = userdata;
+	const float weight = data->dvert ? defvert_find_weight(&data->dvert[index], data->defgrp_index) : 1.0f;
+
+	data->func(data->userdata, index, data->vertexCos[index], weight);
+}
+
+/**
+ * Call \a func for every vertex coordinate, in threads for large enough meshes.
+ * Vertices are independent of each other, so \a func may only write to the coordinate it is given.
+ *
+ * \param dvert: Weights passed to \a func, when NULL all vertices have a weight of 1.0.
+ */
+void BKE_deform_verts_parallel(
+        float (*vertexCos)[3], const int numVerts,
+        const MDeformVert *dvert, const int defgrp_index,
+        void *userdata, DeformVertFunc func)
+{
+	DeformVertsUserdata data;
+
+	data.vertexCos = vertexCos;
+	data.dvert = dvert;
+	data.defgrp_index = defgrp_index;
+	data.userdata = userdata;
+	data.func = func;
+
+	BLI_task_parallel_range(0, numVerts, &data, deform_verts_task, numVerts > DEFORM_VERTS_THREADED_MIN);
+}
+
+/** \} */
+
+
 /* -------------------------------------------------------------------- */
 
 /** \name Data Transfer
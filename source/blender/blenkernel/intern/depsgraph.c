@@ -80,6 +80,7 @@
 #include "BKE_material.h"
 #include "BKE_mball.h"
 #include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_object.h"
 #include "BKE_paint.h"
 #include "BKE_particle.h"
@@ -1728,6 +1729,18 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* tag relations of a single ID for update */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		/* New dependency graph. */
+		DEG_id_relations_tag_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -2979,6 +2992,8 @@ void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 		printf("%s: id=%s flag=%d\n", __func__, id->name, flag);
 	}
 
+	BKE_modifier_cache_tag_update(id);
+
 	/* tag ID for update */
 	if (flag) {
 		if (flag & OB_RECALC_OB)
@@ -3633,6 +3648,12 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+/* Tag relations of a single ID for update. */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	DEG_id_relations_tag_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
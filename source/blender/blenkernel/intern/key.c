@@ -39,6 +39,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -574,6 +575,55 @@ static bool key_pointer_size(const Key *key, const int mode, int *poinsize, int
 	return true;
 }
 
+/* Number of floats of one element, threaded evaluation only supports a single entry in elemstr. */
+static int key_elem_totfloat(const char *elemstr)
+{
+	BLI_assert(elemstr[0] && elemstr[2] == 0);
+
+	switch (elemstr[1]) {
+		case IPO_FLOAT:
+			return 3;
+		case IPO_BPOINT:
+			return 4;
+		case IPO_BEZTRIPLE:
+			return 12;
+		default:
+			BLI_assert(!"invalid 'elemstr[1]'");
+			return 0;
+	}
+}
+
+/* Number of elements in the start/end range, a BezTriple takes 3 of them. */
+static int key_elem_count(const int start, const int end, const int mode)
+{
+	const int step = (mode == KEY_MODE_BEZTRIPLE) ? 3 : 1;
+	return (end > start) ? (end - start + step - 1) / step : 0;
+}
+
+typedef struct KeyCopyUserdata {
+	char *poin;
+	char *k1, *kref;
+	float *weights;
+	int poinstep, elemsize, totfloat;
+} KeyCopyUserdata;
+
+static void cp_key_task(void *userdata, const int index)
+{
+	KeyCopyUserdata *data = userdata;
+	float *poin = (float *)(data->poin + (size_t)index * data->poinstep);
+	float *k1 = (float *)(data->k1 + (size_t)index * data->elemsize);
+
+	if (data->weights) {
+		float *kref = (float *)(data->kref + (size_t)index * data->elemsize);
+		memcpy(poin, kref, sizeof(float) * 3);
+		if (data->weights[index] != 0.0f)
+			rel_flerp(data->totfloat, poin, kref, k1, data->weights[index]);
+	}
+	else {
+		memcpy(poin, k1, sizeof(float) * data->totfloat);
+	}
+}
+
 static void cp_key(const int start, int end, const int tot, char *poin, Key *key, KeyBlock *actkb, KeyBlock *kb, float *weights, const int mode)
 {
 	float ktot = 0.0, kd = 0.0;
@@ -631,6 +681,26 @@ static void cp_key(const int start, int end, const int tot, char *poin, Key *key
 	elemsize = key->elemsize;
 	if (mode == KEY_MODE_BEZTRIPLE) elemsize *= 3;
 
+	/* without resampling all elements are independent, copy them in threads */
+	if (flagflo == 0) {
+		const int totelem = key_elem_count(start, end, mode);
+		KeyCopyUserdata data;
+
+		data.poin = poin;
+		data.k1 = k1;
+		data.kref = kref;
+		data.weights = weights;
+		data.poinstep = ofs[0];
+		data.elemsize = elemsize;
+		data.totfloat = key_elem_totfloat((mode == KEY_MODE_BEZTRIPLE) ? elemstr : key->elemstr);
+
+		BLI_task_parallel_range(0, totelem, &data, cp_key_task, totelem > DEFORM_VERTS_THREADED_MIN);
+
+		if (freek1) MEM_freeN(freek1);
+		if (freekref) MEM_freeN(freekref);
+		return;
+	}
+
 	for (a = start; a < end; a++) {
 		cp = key->elemstr;
 		if (mode == KEY_MODE_BEZTRIPLE) cp = elemstr;
@@ -721,13 +791,67 @@ static void cp_cu_key(Curve *cu, Key *key, KeyBlock *actkb, KeyBlock *kb, const
 	}
 }
 
+/* Interpolation between absolute shape keys in do_key(). */
+typedef struct KeyInterpUserdata {
+	char *poin;
+	char *k1, *k2, *k3, *k4;
+	float *t;
+	int poinstep, elemsize, totfloat;
+} KeyInterpUserdata;
+
+static void do_key_task(void *userdata, const int index)
+{
+	KeyInterpUserdata *data = userdata;
+	const size_t elemofs = (size_t)index * data->elemsize;
+
+	flerp(data->totfloat, (float *)(data->poin + (size_t)index * data->poinstep),
+	      (float *)(data->k1 + elemofs), (float *)(data->k2 + elemofs),
+	      (float *)(data->k3 + elemofs), (float *)(data->k4 + elemofs), data->t);
+}
+
+/* Shape key blended in by BKE_key_evaluate_relative(). */
+typedef struct KeyRelativeBlock {
+	char *from, *reffrom;
+	char *freefrom, *freereffrom;
+	float *weights;
+	float icuval;
+} KeyRelativeBlock;
+
+typedef struct KeyRelativeUserdata {
+	KeyRelativeBlock *blocks;
+	int totblock;
+	char *poin;
+	int poinstep, elemsize, totfloat;
+} KeyRelativeUserdata;
+
+static void key_evaluate_relative_task(void *userdata, const int index)
+{
+	KeyRelativeUserdata *data = userdata;
+	float *poin = (float *)(data->poin + (size_t)index * data->poinstep);
+	int b;
+
+	/* Blend all shape keys into one element at a time, so it stays in cache,
+	 * the order of blending is the same as one shape key at a time. */
+	for (b = 0; b < data->totblock; b++) {
+		const KeyRelativeBlock *block = &data->blocks[b];
+		const float weight = block->weights ? (block->weights[index] * block->icuval) : block->icuval;
+
+		rel_flerp(data->totfloat, poin,
+		          (float *)(block->reffrom + (size_t)index * data->elemsize),
+		          (float *)(block->from + (size_t)index * data->elemsize),
+		          weight);
+	}
+}
+
 void BKE_key_evaluate_relative(const int start, int end, const int tot, char *basispoin, Key *key, KeyBlock *actkb,
                                float **per_keyblock_weights, const int mode)
 {
 	KeyBlock *kb;
-	int *ofsp, ofs[3], elemsize, b;
-	char *cp, *poin, *reffrom, *from, elemstr[8];
-	int poinsize, keyblock_index;
+	KeyRelativeUserdata data;
+	KeyRelativeBlock *blocks;
+	int ofs[3], elemsize, b, totelem;
+	char elemstr[8];
+	int poinsize, keyblock_index, totblock = 0;
 
 	/* currently always 0, in future key_pointer_size may assign */
 	ofs[1] = 0;
@@ -749,8 +873,9 @@ void BKE_key_evaluate_relative(const int start, int end, const int tot, char *ba
 	/* step 1 init */
 	cp_key(start, end, tot, basispoin, key, actkb, key->refkey, NULL, mode);
 	
-	/* step 2: do it */
-	
+	/* step 2: gather the shape keys to blend */
+	blocks = MEM_mallocN(sizeof(*blocks) * key->totkey, __func__);
+
 	for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
 		if (kb != key->refkey) {
 			float icuval = kb->curval;
@@ -758,68 +883,42 @@ void BKE_key_evaluate_relative(const int start, int end, const int tot, char *ba
 			/* only with value, and no difference allowed */
 			if (!(kb->flag & KEYBLOCK_MUTE) && icuval != 0.0f && kb->totelem == tot) {
 				KeyBlock *refb;
-				float weight, *weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
-				char *freefrom = NULL, *freereffrom = NULL;
+				KeyRelativeBlock *block;
 
 				/* reference now can be any block */
 				refb = BLI_findlink(&key->block, kb->relative);
 				if (refb == NULL) continue;
-				
-				poin = basispoin;
-				from = key_block_get_data(key, actkb, kb, &freefrom);
-				reffrom = key_block_get_data(key, actkb, refb, &freereffrom);
-
-				poin += start * poinsize;
-				reffrom += key->elemsize * start;  // key elemsize yes!
-				from += key->elemsize * start;
-				
-				for (b = start; b < end; b++) {
-				
-					weight = weights ? (*weights * icuval) : icuval;
-					
-					cp = key->elemstr;
-					if (mode == KEY_MODE_BEZTRIPLE) cp = elemstr;
-					
-					ofsp = ofs;
-					
-					while (cp[0]) {  /* (cp[0] == amount) */
-						
-						switch (cp[1]) {
-							case IPO_FLOAT:
-								rel_flerp(3, (float *)poin, (float *)reffrom, (float *)from, weight);
-								break;
-							case IPO_BPOINT:
-								rel_flerp(4, (float *)poin, (float *)reffrom, (float *)from, weight);
-								break;
-							case IPO_BEZTRIPLE:
-								rel_flerp(12, (float *)poin, (float *)reffrom, (float *)from, weight);
-								break;
-							default:
-								/* should never happen */
-								if (freefrom) MEM_freeN(freefrom);
-								if (freereffrom) MEM_freeN(freereffrom);
-								BLI_assert(!"invalid 'cp[1]'");
-								return;
-						}
-
-						poin += *ofsp;
-						
-						cp += 2;
-						ofsp++;
-					}
-					
-					reffrom += elemsize;
-					from += elemsize;
-					
-					if (mode == KEY_MODE_BEZTRIPLE) b += 2;
-					if (weights) weights++;
-				}
 
-				if (freefrom) MEM_freeN(freefrom);
-				if (freereffrom) MEM_freeN(freereffrom);
+				block = &blocks[totblock++];
+				block->from = key_block_get_data(key, actkb, kb, &block->freefrom);
+				block->reffrom = key_block_get_data(key, actkb, refb, &block->freereffrom);
+				block->reffrom += key->elemsize * start;  // key elemsize yes!
+				block->from += key->elemsize * start;
+				block->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+				block->icuval = icuval;
 			}
 		}
 	}
+
+	/* step 3: do it */
+	totelem = key_elem_count(start, end, mode);
+
+	if (totblock != 0) {
+		data.blocks = blocks;
+		data.totblock = totblock;
+		data.poin = basispoin + start * poinsize;
+		data.poinstep = ofs[0];
+		data.elemsize = elemsize;
+		data.totfloat = key_elem_totfloat((mode == KEY_MODE_BEZTRIPLE) ? elemstr : key->elemstr);
+
+		BLI_task_parallel_range(0, totelem, &data, key_evaluate_relative_task, totelem > DEFORM_VERTS_THREADED_MIN);
+	}
+
+	for (b = 0; b < totblock; b++) {
+		if (blocks[b].freefrom) MEM_freeN(blocks[b].freefrom);
+		if (blocks[b].freereffrom) MEM_freeN(blocks[b].freereffrom);
+	}
+	MEM_freeN(blocks);
 }
 
 
@@ -956,6 +1055,30 @@ static void do_key(const int start, int end, const int tot, char *poin, Key *key
 	elemsize = key->elemsize;
 	if (mode == KEY_MODE_BEZTRIPLE) elemsize *= 3;
 
+	/* without resampling all elements are independent, interpolate them in threads */
+	if (flagflo == 0) {
+		const int totelem = key_elem_count(start, end, mode);
+		KeyInterpUserdata data;
+
+		data.poin = poin;
+		data.k1 = k1;
+		data.k2 = k2;
+		data.k3 = k3;
+		data.k4 = k4;
+		data.t = t;
+		data.poinstep = ofs[0];
+		data.elemsize = elemsize;
+		data.totfloat = key_elem_totfloat((mode == KEY_MODE_BEZTRIPLE) ? elemstr : key->elemstr);
+
+		BLI_task_parallel_range(0, totelem, &data, do_key_task, totelem > DEFORM_VERTS_THREADED_MIN);
+
+		if (freek1) MEM_freeN(freek1);
+		if (freek2) MEM_freeN(freek2);
+		if (freek3) MEM_freeN(freek3);
+		if (freek4) MEM_freeN(freek4);
+		return;
+	}
+
 	for (a = start; a < end; a++) {
 	
 		cp = key->elemstr;
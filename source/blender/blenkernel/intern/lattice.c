@@ -705,6 +705,39 @@ static bool calc_curve_deform(Scene *scene, Object *par, float co[3],
 	return false;
 }
 
+typedef struct CurveDeformUserdata {
+	Scene *scene;
+	Object *cuOb;
+	CurveDeform *cd;
+	short defaxis;
+	bool use_curvespace;
+} CurveDeformUserdata;
+
+static void curve_deform_vert_task(void *userdata, const int UNUSED(index), float co[3], const float weight)
+{
+	CurveDeformUserdata *data = userdata;
+	CurveDeform *cd = data->cd;
+
+	if (weight == 1.0f) {
+		if (data->use_curvespace) {
+			mul_m4_v3(cd->curvespace, co);
+		}
+		calc_curve_deform(data->scene, data->cuOb, co, data->defaxis, cd, NULL);
+		mul_m4_v3(cd->objectspace, co);
+	}
+	else if (weight > 0.0f) {
+		float vec[3];
+
+		if (data->use_curvespace) {
+			mul_m4_v3(cd->curvespace, co);
+		}
+		copy_v3_v3(vec, co);
+		calc_curve_deform(data->scene, data->cuOb, vec, data->defaxis, cd, NULL);
+		interp_v3_v3v3(co, co, vec, weight);
+		mul_m4_v3(cd->objectspace, co);
+	}
+}
+
 void curve_deform_verts(
         Scene *scene, Object *cuOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
         int numVerts, const char *vgroup, short defaxis)
@@ -712,6 +745,7 @@ void curve_deform_verts(
 	Curve *cu;
 	int a;
 	CurveDeform cd;
+	CurveDeformUserdata data;
 	MDeformVert *dvert = NULL;
 	int defgrp_index = -1;
 	const bool is_neg_axis = (defaxis > 2);
@@ -754,71 +788,33 @@ void curve_deform_verts(
 		}
 	}
 
-	if (dvert) {
-		MDeformVert *dvert_iter;
-		float vec[3];
-
-		if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-				const float weight = defvert_find_weight(dvert_iter, defgrp_index);
-
-				if (weight > 0.0f) {
-					mul_m4_v3(cd.curvespace, vertexCos[a]);
-					copy_v3_v3(vec, vertexCos[a]);
-					calc_curve_deform(scene, cuOb, vec, defaxis, &cd, NULL);
-					interp_v3_v3v3(vertexCos[a], vertexCos[a], vec, weight);
-					mul_m4_v3(cd.objectspace, vertexCos[a]);
-				}
-			}
-		}
-		else {
-			/* set mesh min/max bounds */
-			INIT_MINMAX(cd.dmin, cd.dmax);
-
-			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-				if (defvert_find_weight(dvert_iter, defgrp_index) > 0.0f) {
-					mul_m4_v3(cd.curvespace, vertexCos[a]);
-					minmax_v3v3_v3(cd.dmin, cd.dmax, vertexCos[a]);
-				}
-			}
+#ifdef CYCLIC_DEPENDENCY_WORKAROUND
+	/* Done here rather than in calc_curve_deform(), which is called from threads. */
+	if (cuOb->curve_cache == NULL) {
+		BKE_displist_make_curveTypes(scene, cuOb, false);
+	}
+#endif
 
-			for (a = 0, dvert_iter = dvert; a < numVerts; a++, dvert_iter++) {
-				const float weight = defvert_find_weight(dvert_iter, defgrp_index);
+	if ((cu->flag & CU_DEFORM_BOUNDS_OFF) == 0) {
+		/* set mesh min/max bounds, needed by all vertices so it can't be threaded */
+		INIT_MINMAX(cd.dmin, cd.dmax);
 
-				if (weight > 0.0f) {
-					/* already in 'cd.curvespace', prev for loop */
-					copy_v3_v3(vec, vertexCos[a]);
-					calc_curve_deform(scene, cuOb, vec, defaxis, &cd, NULL);
-					interp_v3_v3v3(vertexCos[a], vertexCos[a], vec, weight);
-					mul_m4_v3(cd.objectspace, vertexCos[a]);
-				}
-			}
-		}
-	}
-	else {
-		if (cu->flag & CU_DEFORM_BOUNDS_OFF) {
-			for (a = 0; a < numVerts; a++) {
-				mul_m4_v3(cd.curvespace, vertexCos[a]);
-				calc_curve_deform(scene, cuOb, vertexCos[a], defaxis, &cd, NULL);
-				mul_m4_v3(cd.objectspace, vertexCos[a]);
-			}
-		}
-		else {
-			/* set mesh min max bounds */
-			INIT_MINMAX(cd.dmin, cd.dmax);
-				
-			for (a = 0; a < numVerts; a++) {
+		for (a = 0; a < numVerts; a++) {
+			if (dvert == NULL || defvert_find_weight(&dvert[a], defgrp_index) > 0.0f) {
 				mul_m4_v3(cd.curvespace, vertexCos[a]);
 				minmax_v3v3_v3(cd.dmin, cd.dmax, vertexCos[a]);
 			}
-	
-			for (a = 0; a < numVerts; a++) {
-				/* already in 'cd.curvespace', prev for loop */
-				calc_curve_deform(scene, cuOb, vertexCos[a], defaxis, &cd, NULL);
-				mul_m4_v3(cd.objectspace, vertexCos[a]);
-			}
 		}
 	}
+
+	data.scene = scene;
+	data.cuOb = cuOb;
+	data.cd = &cd;
+	data.defaxis = defaxis;
+	/* without bounds the coordinates are not in 'cd.curvespace' yet */
+	data.use_curvespace = (cu->flag & CU_DEFORM_BOUNDS_OFF) != 0;
+
+	BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, curve_deform_vert_task);
 }
 
 /* input vec and orco = local coord in armature space */
@@ -856,11 +852,25 @@ void curve_deform_vector(Scene *scene, Object *cuOb, Object *target,
 
 }
 
+typedef struct LatticeDeformUserdata {
+	LatticeDeformData *lattice_deform_data;
+	float fac;
+} LatticeDeformUserdata;
+
+static void lattice_deform_vert_task(void *userdata, const int UNUSED(index), float co[3], const float weight)
+{
+	LatticeDeformUserdata *data = userdata;
+
+	if (weight > 0.0f) {
+		calc_latt_deform(data->lattice_deform_data, co, weight * data->fac);
+	}
+}
+
 void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
                           float (*vertexCos)[3], int numVerts, const char *vgroup, float fac)
 {
 	LatticeDeformData *lattice_deform_data;
-	int a;
+	LatticeDeformUserdata data;
 	bool use_vgroups;
 
 	if (laOb->type != OB_LATTICE)
@@ -886,28 +896,25 @@ void lattice_deform_verts(Object *laOb, Object *target, DerivedMesh *dm,
 		use_vgroups = false;
 	}
 	
+	data.lattice_deform_data = lattice_deform_data;
+	data.fac = fac;
+
 	if (vgroup && vgroup[0] && use_vgroups) {
 		Mesh *me = target->data;
 		const int defgrp_index = defgroup_name_index(target, vgroup);
-		float weight;
 
 		if (defgrp_index >= 0 && (me->dvert || dm)) {
-			MDeformVert *dvert = me->dvert;
-			
-			for (a = 0; a < numVerts; a++, dvert++) {
-				if (dm) dvert = dm->getVertData(dm, a, CD_MDEFORMVERT);
+			MDeformVert *dvert = dm ? dm->getVertDataArray(dm, CD_MDEFORMVERT) : me->dvert;
 
-				weight = defvert_find_weight(dvert, defgrp_index);
-
-				if (weight > 0.0f)
-					calc_latt_deform(lattice_deform_data, vertexCos[a], weight * fac);
+			/* without weights nothing is deformed, all vertices would get a weight of 1.0 */
+			if (dvert) {
+				BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index,
+				                          &data, lattice_deform_vert_task);
 			}
 		}
 	}
 	else {
-		for (a = 0; a < numVerts; a++) {
-			calc_latt_deform(lattice_deform_data, vertexCos[a], fac);
-		}
+		BKE_deform_verts_parallel(vertexCos, numVerts, NULL, -1, &data, lattice_deform_vert_task);
 	}
 	end_latt_deform(lattice_deform_data);
 }
@@ -163,6 +163,22 @@ bool modifier_dependsOnTime(ModifierData *md)
 	return mti->dependsOnTime && mti->dependsOnTime(md);
 }
 
+/* Modifiers which make other objects depend on their object, like collision
+ * and smoke flow objects, or which depend on collision or effector objects of
+ * the scene. Adding or removing them changes relations of other objects,
+ * which needs a full relations update. */
+bool modifier_typeAffectsSceneRelations(ModifierType type)
+{
+	return ELEM(type,
+	            eModifierType_Collision,
+	            eModifierType_Surface,
+	            eModifierType_Smoke,
+	            eModifierType_DynamicPaint,
+	            eModifierType_Cloth,
+	            eModifierType_Softbody,
+	            eModifierType_ParticleSystem);
+}
+
 bool modifier_supportsMapping(ModifierData *md)
 {
 	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
@@ -0,0 +1,777 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/modifier_cache.c
+ *  \ingroup bke
+ *
+ * Cache of intermediate results of the mesh modifier stack.
+ *
+ * After an expensive constructive modifier a copy of its result is kept on
+ * the object, keyed by a hash of everything the result depends on: the input
+ * mesh and its deformed coordinates, settings of the stack evaluation and the
+ * settings of all modifiers up to it. Evaluation of the stack continues from
+ * the last result with a matching key.
+ *
+ * Settings of modifiers are hashed by walking their DNA struct, skipping
+ * pointers. Datablocks used by modifiers are hashed separately, only empties
+ * and evaluated meshes are supported. Everything behind a modifier which
+ * depends on data that can't be hashed is not cached. Datablocks are
+ * identified by name, their address can be reused once they are freed.
+ *
+ * Changes to custom data layers of the mesh are not part of the key, entries
+ * are freed when the mesh is tagged for update instead. Entries remember the
+ * meshes they depend on, which are counted in a hash so updates of other
+ * meshes don't have to look at any entry.
+ *
+ * Entries of all objects are kept in one list in order of use, the least
+ * recently used ones are freed first when the memory limit is reached.
+ * Objects are evaluated in parallel, so all access to entries is locked.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_linklist.h"
+#include "BLI_listbase.h"
+#include "BLI_threads.h"
+
+#include "BKE_cdderivedmesh.h"
+#include "BKE_DerivedMesh.h"
+#include "BKE_modifier.h"
+#include "BKE_modifier_cache.h"
+#include "BKE_object.h"
+
+#include "atomic_ops.h"
+
+/* Results which took less time to calculate are not worth the memory. */
+#define MODIFIER_CACHE_MIN_TIME 0.005
+
+typedef struct ModifierCacheEntry {
+	struct ModifierCacheEntry *next, *prev;
+
+	struct ModifierStackCache *cache;  /* cache of the object owning the entry */
+	int index;  /* index of the modifier in the keys */
+	uint64_t key;
+	size_t size;
+
+	DerivedMesh *dm;
+	DerivedMesh *orcodm, *clothorcodm;
+	CustomDataMask append_mask;
+
+	LinkNode *ids;  /* meshes the result depends on */
+} ModifierCacheEntry;
+
+/* Stored in Object.modifier_cache. */
+typedef struct ModifierStackCache {
+	int num_entries;
+} ModifierStackCache;
+
+/* Entries of all objects, least recently used first. */
+static ListBase g_modifier_cache_entries = {NULL, NULL};
+static ThreadMutex g_modifier_cache_lock = BLI_MUTEX_INITIALIZER;
+
+/* Number of entries depending on each mesh, NULL when there are no entries. */
+static GHash *g_modifier_cache_ids = NULL;
+
+/* Memory used by the caches of all objects. */
+static size_t g_modifier_cache_size = 0;
+
+static unsigned int g_modifier_cache_hits = 0;
+
+static size_t modifier_cache_limit(void)
+{
+	return (size_t)U.modifier_cache_limit * 1024 * 1024;
+}
+
+bool BKE_modifier_cache_is_enabled(void)
+{
+	return U.modifier_cache_limit > 0;
+}
+
+size_t BKE_modifier_cache_memory_in_use(void)
+{
+	return atomic_add_and_fetch_z(&g_modifier_cache_size, 0);
+}
+
+unsigned int BKE_modifier_cache_hits(void)
+{
+	return atomic_add_and_fetch_u(&g_modifier_cache_hits, 0);
+}
+
+/* ******************** Hashing ******************** */
+
+typedef struct ModifierCacheHash {
+	/* two independent hashes, combined into a 64 bit key */
+	BLI_HashMurmur2A mm2[2];
+	/* cleared when something is found that can't be hashed */
+	bool valid;
+	Object *ob;
+} ModifierCacheHash;
+
+static void modifier_cache_hash_init(ModifierCacheHash *hash, Object *ob)
+{
+	BLI_hash_mm2a_init(&hash->mm2[0], 0);
+	BLI_hash_mm2a_init(&hash->mm2[1], 0x9e3779b9);
+	hash->valid = true;
+	hash->ob = ob;
+}
+
+static void modifier_cache_hash_add(ModifierCacheHash *hash, const void *data, size_t size)
+{
+	BLI_hash_mm2a_add(&hash->mm2[0], data, size);
+	BLI_hash_mm2a_add(&hash->mm2[1], data, size);
+}
+
+static void modifier_cache_hash_add_int(ModifierCacheHash *hash, int value)
+{
+	modifier_cache_hash_add(hash, &value, sizeof(value));
+}
+
+/* Add large arrays, like mesh data, only a digest of the data is added. */
+static void modifier_cache_hash_add_array(ModifierCacheHash *hash, const void *data, size_t size)
+{
+	modifier_cache_hash_add_int(hash, (int)size);
+	if (data) {
+		modifier_cache_hash_add_int(hash, (int)BLI_hash_mm2(data, size, 0));
+	}
+}
+
+/* Datablocks are hashed by name, their content is hashed separately where needed. */
+static void modifier_cache_hash_id_name(ModifierCacheHash *hash, const ID *id)
+{
+	if (id == NULL) {
+		modifier_cache_hash_add_int(hash, 0);
+		return;
+	}
+
+	modifier_cache_hash_add(hash, id->name, strlen(id->name) + 1);
+	if (id->lib) {
+		modifier_cache_hash_add(hash, id->lib->name, strlen(id->lib->name) + 1);
+	}
+}
+
+static void modifier_cache_hash_customdata_layers(ModifierCacheHash *hash, const CustomData *data)
+{
+	int i;
+
+	modifier_cache_hash_add_int(hash, data->totlayer);
+	for (i = 0; i < data->totlayer; i++) {
+		modifier_cache_hash_add_int(hash, data->layers[i].type);
+		modifier_cache_hash_add(hash, data->layers[i].name, strlen(data->layers[i].name) + 1);
+	}
+}
+
+static uint64_t modifier_cache_hash_key(const ModifierCacheHash *hash)
+{
+	/* ending the hash modifies it, so hashing can continue on the original */
+	BLI_HashMurmur2A mm2[2] = {hash->mm2[0], hash->mm2[1]};
+	const uint64_t key = ((uint64_t)BLI_hash_mm2a_end(&mm2[0]) << 32) |
+	                     (uint64_t)BLI_hash_mm2a_end(&mm2[1]);
+	/* 0 is used for results which can't be cached */
+	return key ? key : 1;
+}
+
+/* Hash all members of a DNA struct except pointers, recursing into nested structs. */
+static void modifier_cache_hash_dna_struct(
+        ModifierCacheHash *hash, const SDNA *sdna, const int struct_nr, const char *data,
+        const bool skip_first)
+{
+	const int first_struct_type = sdna->structs[0][0];
+	const short *sp = sdna->structs[struct_nr];
+	const int num_members = sp[1];
+	int a;
+
+	sp += 2;
+	for (a = 0; a < num_members; a++, sp += 2) {
+		const char *name = sdna->names[sp[1]];
+		const bool is_pointer = ELEM(name[0], '*', '(');
+		const int array_len = DNA_elem_array_size(name);
+		const int elem_size = is_pointer ? sdna->pointerlen : sdna->typelens[sp[0]];
+
+		if (is_pointer || (a == 0 && skip_first)) {
+			/* pointers are runtime data or datablocks, which are hashed separately */
+		}
+		else if (sp[0] >= first_struct_type) {
+			const int member_nr = DNA_struct_find_nr(sdna, sdna->types[sp[0]]);
+			int i;
+
+			for (i = 0; i < array_len; i++) {
+				modifier_cache_hash_dna_struct(hash, sdna, member_nr, data + i * elem_size, false);
+			}
+		}
+		else {
+			modifier_cache_hash_add(hash, data, elem_size * array_len);
+		}
+
+		data += elem_size * array_len;
+	}
+}
+
+static void modifier_cache_hash_dm(ModifierCacheHash *hash, DerivedMesh *dm)
+{
+	const int num_verts = dm->getNumVerts(dm);
+
+	modifier_cache_hash_add_int(hash, num_verts);
+	modifier_cache_hash_add_int(hash, dm->getNumEdges(dm));
+	modifier_cache_hash_add_int(hash, dm->getNumLoops(dm));
+	modifier_cache_hash_add_int(hash, dm->getNumPolys(dm));
+
+	if (dm->type == DM_TYPE_CDDM) {
+		modifier_cache_hash_add_array(hash, CDDM_get_verts(dm), sizeof(MVert) * num_verts);
+	}
+	else {
+		/* don't use getVertArray(), it is not thread safe for all types */
+		float (*cos)[3] = MEM_mallocN(sizeof(*cos) * num_verts, __func__);
+		dm->getVertCos(dm, cos);
+		modifier_cache_hash_add_array(hash, cos, sizeof(*cos) * num_verts);
+		MEM_freeN(cos);
+	}
+}
+
+static void modifier_cache_hash_id_link(void *userData, Object *UNUSED(ob), ID **idpoin, int UNUSED(cb_flag))
+{
+	ModifierCacheHash *hash = userData;
+	ID *id = *idpoin;
+	Object *target;
+
+	modifier_cache_hash_id_name(hash, id);
+
+	if (id == NULL) {
+		return;
+	}
+	if (GS(id->name) != ID_OB) {
+		hash->valid = false;
+		return;
+	}
+
+	target = (Object *)id;
+	if (target == hash->ob) {
+		hash->valid = false;
+		return;
+	}
+
+	/* modifiers using other objects work in the space of the modified object */
+	modifier_cache_hash_add(hash, hash->ob->obmat, sizeof(hash->ob->obmat));
+	modifier_cache_hash_add(hash, target->obmat, sizeof(target->obmat));
+
+	if (target->type == OB_EMPTY) {
+		/* only the transform is used */
+	}
+	else if (target->type == OB_MESH && target->derivedFinal && !BKE_object_is_in_editmode(target)) {
+		modifier_cache_hash_dm(hash, target->derivedFinal);
+	}
+	else {
+		hash->valid = false;
+	}
+}
+
+/* Modifiers which depend on time, caches or data outside of their settings. */
+static bool modifier_cache_is_supported(ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+	if (mti->flags & eModifierTypeFlag_UsesPointCache) {
+		return false;
+	}
+	if (modifier_dependsOnTime(md)) {
+		return false;
+	}
+
+	switch (md->type) {
+		case eModifierType_Collision:
+		case eModifierType_Explode:
+		case eModifierType_MeshCache:
+		case eModifierType_MeshSequenceCache:
+		case eModifierType_Multires:
+		case eModifierType_Ocean:
+		case eModifierType_ParticleInstance:
+		case eModifierType_ParticleSystem:
+		case eModifierType_ShapeKey:
+		case eModifierType_Surface:
+			return false;
+		case eModifierType_Subsurf:
+			/* results of GPU subdivision can't be copied */
+			return ((SubsurfModifierData *)md)->use_opensubdiv == 0;
+		default:
+			return true;
+	}
+}
+
+static void modifier_cache_hash_modifier(ModifierCacheHash *hash, Object *ob, ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	const SDNA *sdna = DNA_sdna_current_get();
+	const int struct_nr = DNA_struct_find_nr(sdna, mti->structName);
+
+	if (!modifier_cache_is_supported(md) || struct_nr == -1) {
+		hash->valid = false;
+		return;
+	}
+
+	/* all modifier structs start with ModifierData, its name and UI flags don't matter */
+	modifier_cache_hash_add_int(hash, md->type);
+	modifier_cache_hash_add_int(hash, md->mode & (eModifierMode_Realtime | eModifierMode_Render));
+	modifier_cache_hash_dna_struct(hash, sdna, struct_nr, (const char *)md, true);
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_cache_hash_id_link, hash);
+	}
+	else if (mti->foreachObjectLink) {
+		/* each Object can masquerade as an ID, so this should be OK */
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_cache_hash_id_link, hash);
+	}
+}
+
+/* Settings modifiers read through ModifierData.scene. The frame is not needed,
+ * modifiers which depend on time are not cached. */
+static void modifier_cache_hash_scene(ModifierCacheHash *hash, const Scene *scene)
+{
+	if (scene == NULL) {
+		modifier_cache_hash_add_int(hash, -1);
+		return;
+	}
+
+	modifier_cache_hash_add_int(hash, scene->r.mode & R_SIMPLIFY);
+	modifier_cache_hash_add_int(hash, scene->r.simplify_subsurf);
+	modifier_cache_hash_add_int(hash, scene->r.simplify_subsurf_render);
+}
+
+static void modifier_cache_hash_input(
+        ModifierCacheHash *hash, const Scene *scene, Object *ob, float (*vertexCos)[3],
+        const ModifierCacheSettings *settings)
+{
+	Mesh *me = ob->data;
+	bDeformGroup *defgroup;
+
+	modifier_cache_hash_scene(hash, scene);
+
+	modifier_cache_hash_add(hash, &settings->data_mask, sizeof(settings->data_mask));
+	modifier_cache_hash_add_int(hash, settings->required_mode);
+	modifier_cache_hash_add_int(hash, settings->draw_flag);
+	modifier_cache_hash_add_int(hash, settings->need_mapping);
+	modifier_cache_hash_add_int(hash, settings->allow_gpu);
+
+	/* contents of custom data layers are not hashed, only which layers exist */
+	modifier_cache_hash_id_name(hash, &me->id);
+	modifier_cache_hash_add_int(hash, me->cd_flag);
+	modifier_cache_hash_customdata_layers(hash, &me->vdata);
+	modifier_cache_hash_customdata_layers(hash, &me->edata);
+	modifier_cache_hash_customdata_layers(hash, &me->ldata);
+	modifier_cache_hash_customdata_layers(hash, &me->pdata);
+	modifier_cache_hash_add_array(hash, me->mvert, sizeof(MVert) * me->totvert);
+	modifier_cache_hash_add_array(hash, me->medge, sizeof(MEdge) * me->totedge);
+	modifier_cache_hash_add_array(hash, me->mloop, sizeof(MLoop) * me->totloop);
+	modifier_cache_hash_add_array(hash, me->mpoly, sizeof(MPoly) * me->totpoly);
+	if (vertexCos) {
+		modifier_cache_hash_add_array(hash, vertexCos, sizeof(*vertexCos) * me->totvert);
+	}
+
+	/* vertex groups are looked up by name */
+	for (defgroup = ob->defbase.first; defgroup; defgroup = defgroup->next) {
+		modifier_cache_hash_add(hash, defgroup->name, strlen(defgroup->name) + 1);
+	}
+}
+
+uint64_t *BKE_modifier_cache_keys_calc(
+        Scene *scene, Object *ob, ModifierData *md_first,
+        float (*vertexCos)[3], const ModifierCacheSettings *settings,
+        int *r_num_keys)
+{
+	ModifierCacheHash hash;
+	ModifierData *md;
+	uint64_t *keys;
+	int num_keys, first_constructive = -1, last_enabled = -1, i;
+
+	*r_num_keys = 0;
+
+	if (!BKE_modifier_cache_is_enabled()) {
+		return NULL;
+	}
+
+	/* Cheap check for a constructive modifier which is followed by another
+	 * modifier, before hashing the mesh. Results of the last modifier are not
+	 * cached, they are kept as the final result of the object anyway. */
+	for (md = md_first, i = 0; md; md = md->next, i++) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+		md->scene = scene;
+
+		if (!modifier_isEnabled(scene, md, settings->required_mode)) {
+			continue;
+		}
+		if (first_constructive == -1 && mti->type != eModifierTypeType_OnlyDeform) {
+			first_constructive = i;
+		}
+		last_enabled = i;
+		if (!modifier_cache_is_supported(md)) {
+			break;
+		}
+	}
+
+	if (first_constructive == -1 || first_constructive >= last_enabled) {
+		return NULL;
+	}
+
+	for (md = md_first, num_keys = 0; md; md = md->next) {
+		num_keys++;
+	}
+
+	keys = MEM_callocN(sizeof(*keys) * num_keys, __func__);
+
+	modifier_cache_hash_init(&hash, ob);
+	modifier_cache_hash_input(&hash, scene, ob, vertexCos, settings);
+
+	for (md = md_first, i = 0; md && hash.valid; md = md->next, i++) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+		const bool enabled = modifier_isEnabled(scene, md, settings->required_mode);
+
+		modifier_cache_hash_add_int(&hash, md->type);
+		modifier_cache_hash_add_int(&hash, enabled);
+
+		if (!enabled) {
+			continue;
+		}
+
+		modifier_cache_hash_modifier(&hash, ob, md);
+
+		if (hash.valid && i < last_enabled && mti->type != eModifierTypeType_OnlyDeform) {
+			keys[i] = modifier_cache_hash_key(&hash);
+		}
+	}
+
+	*r_num_keys = num_keys;
+	return keys;
+}
+
+/* ******************** Cache ******************** */
+
+static size_t modifier_cache_dm_size(DerivedMesh *dm)
+{
+	const CustomData *data[4];
+	int num_elems[4];
+	size_t size = sizeof(DerivedMesh);
+	int i, j;
+
+	if (dm == NULL) {
+		return 0;
+	}
+
+	data[0] = &dm->vertData;
+	data[1] = &dm->edgeData;
+	data[2] = &dm->loopData;
+	data[3] = &dm->polyData;
+	num_elems[0] = dm->numVertData;
+	num_elems[1] = dm->numEdgeData;
+	num_elems[2] = dm->numLoopData;
+	num_elems[3] = dm->numPolyData;
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < data[i]->totlayer; j++) {
+			size += (size_t)CustomData_sizeof(data[i]->layers[j].type) * num_elems[i];
+		}
+	}
+
+	return size;
+}
+
+/* Meshes whose custom data layers the results of the object depend on: its
+ * own mesh and the meshes of objects used by its modifiers, their evaluated
+ * data is hashed without custom data layers too. */
+static void modifier_cache_find_mesh_link(void *userData, Object *UNUSED(ob), Object **obpoin, int UNUSED(cb_flag))
+{
+	LinkNode **r_ids = userData;
+	Object *target = *obpoin;
+
+	if (target && target->type == OB_MESH && target->data) {
+		BLI_linklist_prepend(r_ids, target->data);
+	}
+}
+
+static LinkNode *modifier_cache_find_mesh_ids(Object *ob)
+{
+	LinkNode *ids = NULL;
+
+	BLI_linklist_prepend(&ids, ob->data);
+	modifiers_foreachObjectLink(ob, modifier_cache_find_mesh_link, &ids);
+
+	return ids;
+}
+
+/* Count the meshes the entry depends on, must be called with the lock held. */
+static void modifier_cache_ids_add(const ModifierCacheEntry *entry)
+{
+	LinkNode *link;
+
+	if (g_modifier_cache_ids == NULL) {
+		g_modifier_cache_ids = BLI_ghash_ptr_new(__func__);
+	}
+
+	for (link = entry->ids; link; link = link->next) {
+		void **count_p;
+
+		if (!BLI_ghash_ensure_p(g_modifier_cache_ids, link->link, &count_p)) {
+			*count_p = SET_INT_IN_POINTER(0);
+		}
+		*count_p = SET_INT_IN_POINTER(GET_INT_FROM_POINTER(*count_p) + 1);
+	}
+}
+
+static void modifier_cache_ids_remove(const ModifierCacheEntry *entry)
+{
+	LinkNode *link;
+
+	for (link = entry->ids; link; link = link->next) {
+		void **count_p = BLI_ghash_lookup_p(g_modifier_cache_ids, link->link);
+		const int count = GET_INT_FROM_POINTER(*count_p) - 1;
+
+		if (count == 0) {
+			BLI_ghash_remove(g_modifier_cache_ids, link->link, NULL, NULL);
+		}
+		else {
+			*count_p = SET_INT_IN_POINTER(count);
+		}
+	}
+
+	if (BLI_ghash_size(g_modifier_cache_ids) == 0) {
+		BLI_ghash_free(g_modifier_cache_ids, NULL, NULL);
+		g_modifier_cache_ids = NULL;
+	}
+}
+
+/* Remove the entry from the cache, must be called with the lock held.
+ * Freeing the results is left to modifier_cache_entries_free() so it can
+ * happen after unlocking. */
+static void modifier_cache_entry_unlink(ModifierCacheEntry *entry, ListBase *r_unlinked)
+{
+	BLI_remlink(&g_modifier_cache_entries, entry);
+	BLI_addtail(r_unlinked, entry);
+	modifier_cache_ids_remove(entry);
+
+	entry->cache->num_entries--;
+	atomic_sub_and_fetch_z(&g_modifier_cache_size, entry->size);
+}
+
+static void modifier_cache_entries_free(ListBase *entries)
+{
+	ModifierCacheEntry *entry, *entry_next;
+
+	for (entry = entries->first; entry; entry = entry_next) {
+		entry_next = entry->next;
+
+		entry->dm->release(entry->dm);
+		if (entry->orcodm) {
+			entry->orcodm->release(entry->orcodm);
+		}
+		if (entry->clothorcodm) {
+			entry->clothorcodm->release(entry->clothorcodm);
+		}
+		BLI_linklist_free(entry->ids, NULL);
+		MEM_freeN(entry);
+	}
+
+	BLI_listbase_clear(entries);
+}
+
+int BKE_modifier_cache_restore(
+        Object *ob, const uint64_t *keys, const int num_keys,
+        DerivedMesh **r_dm, DerivedMesh **r_orcodm, DerivedMesh **r_clothorcodm,
+        CustomDataMask *r_append_mask)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+	ModifierCacheEntry *entry, *entry_next, *found = NULL;
+	ListBase unlinked = {NULL, NULL};
+	int index = -1;
+
+	if (cache == NULL) {
+		return -1;
+	}
+
+	BLI_mutex_lock(&g_modifier_cache_lock);
+
+	/* Results of modifiers behind a change can't be used anymore. */
+	for (entry = g_modifier_cache_entries.first; entry && cache->num_entries; entry = entry_next) {
+		entry_next = entry->next;
+
+		if (entry->cache != cache) {
+			continue;
+		}
+
+		if (entry->index >= num_keys || keys[entry->index] != entry->key) {
+			modifier_cache_entry_unlink(entry, &unlinked);
+		}
+		else if (found == NULL || entry->index > found->index) {
+			found = entry;
+		}
+	}
+
+	if (found) {
+		/* move to the end, so it is freed last */
+		BLI_remlink(&g_modifier_cache_entries, found);
+		BLI_addtail(&g_modifier_cache_entries, found);
+
+		/* copy while locked, other threads can free the entry */
+		*r_dm = CDDM_copy(found->dm);
+		*r_orcodm = found->orcodm ? CDDM_copy(found->orcodm) : NULL;
+		*r_clothorcodm = found->clothorcodm ? CDDM_copy(found->clothorcodm) : NULL;
+		*r_append_mask = found->append_mask;
+		index = found->index;
+
+		atomic_add_and_fetch_u(&g_modifier_cache_hits, 1);
+	}
+
+	BLI_mutex_unlock(&g_modifier_cache_lock);
+
+	modifier_cache_entries_free(&unlinked);
+
+	return index;
+}
+
+void BKE_modifier_cache_store(
+        Object *ob, const int index, const uint64_t key, const double time,
+        DerivedMesh *dm, DerivedMesh *orcodm, DerivedMesh *clothorcodm,
+        const CustomDataMask append_mask)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+	ModifierCacheEntry *entry, *entry_next, *new_entry;
+	ListBase unlinked = {NULL, NULL};
+	const size_t limit = modifier_cache_limit();
+	const size_t size = modifier_cache_dm_size(dm) +
+	                    modifier_cache_dm_size(orcodm) +
+	                    modifier_cache_dm_size(clothorcodm);
+
+	if (key == 0 || time < MODIFIER_CACHE_MIN_TIME || size > limit) {
+		return;
+	}
+
+	if (cache == NULL) {
+		cache = ob->modifier_cache = MEM_callocN(sizeof(*cache), "ModifierStackCache");
+	}
+
+	/* copy before locking, it is only visible to other threads once added */
+	new_entry = MEM_callocN(sizeof(*new_entry), "ModifierCacheEntry");
+	new_entry->cache = cache;
+	new_entry->index = index;
+	new_entry->key = key;
+	new_entry->size = size;
+	new_entry->dm = CDDM_copy(dm);
+	new_entry->orcodm = orcodm ? CDDM_copy(orcodm) : NULL;
+	new_entry->clothorcodm = clothorcodm ? CDDM_copy(clothorcodm) : NULL;
+	new_entry->append_mask = append_mask;
+	new_entry->ids = modifier_cache_find_mesh_ids(ob);
+
+	BLI_mutex_lock(&g_modifier_cache_lock);
+
+	for (entry = g_modifier_cache_entries.first; entry && cache->num_entries; entry = entry_next) {
+		entry_next = entry->next;
+
+		if (entry->cache == cache && entry->index == index) {
+			modifier_cache_entry_unlink(entry, &unlinked);
+			break;
+		}
+	}
+
+	/* Free the least recently used results of any object. */
+	while (g_modifier_cache_entries.first && g_modifier_cache_size + size > limit) {
+		modifier_cache_entry_unlink(g_modifier_cache_entries.first, &unlinked);
+	}
+
+	if (g_modifier_cache_size + size > limit) {
+		/* the limit was lowered while adding */
+		BLI_addtail(&unlinked, new_entry);
+	}
+	else {
+		BLI_addtail(&g_modifier_cache_entries, new_entry);
+		modifier_cache_ids_add(new_entry);
+		cache->num_entries++;
+		atomic_add_and_fetch_z(&g_modifier_cache_size, size);
+	}
+
+	BLI_mutex_unlock(&g_modifier_cache_lock);
+
+	modifier_cache_entries_free(&unlinked);
+}
+
+void BKE_modifier_cache_free(Object *ob)
+{
+	ModifierStackCache *cache = ob->modifier_cache;
+	ModifierCacheEntry *entry, *entry_next;
+	ListBase unlinked = {NULL, NULL};
+
+	if (cache == NULL) {
+		return;
+	}
+
+	BLI_mutex_lock(&g_modifier_cache_lock);
+
+	for (entry = g_modifier_cache_entries.first; entry && cache->num_entries; entry = entry_next) {
+		entry_next = entry->next;
+
+		if (entry->cache == cache) {
+			modifier_cache_entry_unlink(entry, &unlinked);
+		}
+	}
+
+	BLI_mutex_unlock(&g_modifier_cache_lock);
+
+	modifier_cache_entries_free(&unlinked);
+
+	MEM_freeN(cache);
+	ob->modifier_cache = NULL;
+}
+
+void BKE_modifier_cache_tag_update(ID *id)
+{
+	ModifierCacheEntry *entry, *entry_next;
+	ListBase unlinked = {NULL, NULL};
+
+	/* Custom data layers of meshes are not part of the keys. */
+	if (id == NULL || GS(id->name) != ID_ME) {
+		return;
+	}
+
+	BLI_mutex_lock(&g_modifier_cache_lock);
+
+	if (g_modifier_cache_ids && BLI_ghash_haskey(g_modifier_cache_ids, id)) {
+		for (entry = g_modifier_cache_entries.first; entry; entry = entry_next) {
+			entry_next = entry->next;
+
+			if (BLI_linklist_index(entry->ids, id) != -1) {
+				modifier_cache_entry_unlink(entry, &unlinked);
+			}
+		}
+	}
+
+	BLI_mutex_unlock(&g_modifier_cache_lock);
+
+	modifier_cache_entries_free(&unlinked);
+}
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 
 #include "MEM_guardedalloc.h"
 
@@ -47,6 +48,7 @@
 #include "DNA_smoke_types.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_hash.h"
 #include "BLI_threads.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
@@ -103,6 +105,7 @@
 /* needed for directory lookup */
 #ifndef WIN32
 #  include <dirent.h>
+#  include <sys/mman.h>  /* for mmap */
 #else
 #  include "BLI_winstuff.h"
 #endif
@@ -1912,14 +1915,76 @@ static void ptcache_file_close(PTCacheFile *pf)
 	}
 }
 
+/* Compress in_len bytes of in into out, which must be at least LZO_OUT_LEN(in_len) bytes.
+ * Returns the compression that was used, 0 when the data doesn't compress and in should be stored as is. */
+static unsigned char ptcache_compress_buffer(unsigned char *in, unsigned int in_len, unsigned char *out, size_t *r_out_len,
+                                             unsigned char *props, size_t *r_props_len, int mode)
+{
+	unsigned char compressed = 0;
+	size_t out_len= 0;
+	size_t sizeOfIt = 5;
+
+	(void)mode; /* unused when building w/o compression */
+
+#ifdef WITH_LZO
+	out_len= LZO_OUT_LEN(in_len);
+	if (mode == 1) {
+		LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
+		int r;
+		
+		r = lzo1x_1_compress(in, (lzo_uint)in_len, out, (lzo_uint *)&out_len, wrkmem);
+		if (!(r == LZO_E_OK) || (out_len >= in_len))
+			compressed = 0;
+		else
+			compressed = 1;
+	}
+#endif
+#ifdef WITH_LZMA
+	if (mode == 2) {
+		int r;
+		
+		r = LzmaCompress(out, &out_len, in, in_len, //assume sizeof(char)==1....
+		                 props, &sizeOfIt, 5, 1 << 24, 3, 0, 2, 32, 2);
+
+		if (!(r == SZ_OK) || (out_len >= in_len))
+			compressed = 0;
+		else
+			compressed = 2;
+	}
+#endif
+
+	*r_out_len = out_len;
+	*r_props_len = sizeOfIt;
+
+	return compressed;
+}
+/* Decompress in into len bytes of result, returns false on failure. */
+static bool ptcache_decompress_buffer(unsigned char compressed, const unsigned char *in, size_t in_len,
+                                      const unsigned char *props, size_t props_len, unsigned char *result, size_t len)
+{
+	bool ok = false;
+
+#ifdef WITH_LZO
+	if (compressed == 1) {
+		size_t out_len = len;
+		ok = (lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, NULL) == LZO_E_OK);
+	}
+#endif
+#ifdef WITH_LZMA
+	if (compressed == 2) {
+		size_t leni = in_len, leno = len;
+		ok = (LzmaUncompress(result, &leno, in, &leni, props, props_len) == SZ_OK);
+	}
+#endif
+
+	return ok;
+}
+
 static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result, unsigned int len)
 {
 	int r = 0;
 	unsigned char compressed = 0;
 	size_t in_len;
-#ifdef WITH_LZO
-	size_t out_len = len;
-#endif
 	unsigned char *in;
 	unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
 
@@ -1932,22 +1997,17 @@ static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result,
 			/* do nothing */
 		}
 		else {
+			size_t sizeOfIt = 0;
 			in = (unsigned char *)MEM_callocN(sizeof(unsigned char)*in_len, "pointcache_compressed_buffer");
 			ptcache_file_read(pf, in, in_len, sizeof(unsigned char));
-#ifdef WITH_LZO
-			if (compressed == 1)
-				r = lzo1x_decompress_safe(in, (lzo_uint)in_len, result, (lzo_uint *)&out_len, NULL);
-#endif
 #ifdef WITH_LZMA
 			if (compressed == 2) {
-				size_t sizeOfIt;
-				size_t leni = in_len, leno = len;
 				ptcache_file_read(pf, &size, 1, sizeof(unsigned int));
 				sizeOfIt = (size_t)size;
 				ptcache_file_read(pf, props, sizeOfIt, sizeof(unsigned char));
-				r = LzmaUncompress(result, &leno, in, &leni, props, sizeOfIt);
 			}
 #endif
+			r = !ptcache_decompress_buffer(compressed, in, in_len, props, sizeOfIt, result, len);
 			MEM_freeN(in);
 		}
 	}
@@ -1961,38 +2021,11 @@ static int ptcache_file_compressed_read(PTCacheFile *pf, unsigned char *result,
 }
 static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, unsigned int in_len, unsigned char *out, int mode)
 {
-	int r = 0;
-	unsigned char compressed = 0;
-	size_t out_len= 0;
+	unsigned char compressed;
+	size_t out_len, sizeOfIt;
 	unsigned char *props = MEM_callocN(16 * sizeof(char), "tmp");
-	size_t sizeOfIt = 5;
-
-	(void)mode; /* unused when building w/o compression */
-
-#ifdef WITH_LZO
-	out_len= LZO_OUT_LEN(in_len);
-	if (mode == 1) {
-		LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
-		
-		r = lzo1x_1_compress(in, (lzo_uint)in_len, out, (lzo_uint *)&out_len, wrkmem);
-		if (!(r == LZO_E_OK) || (out_len >= in_len))
-			compressed = 0;
-		else
-			compressed = 1;
-	}
-#endif
-#ifdef WITH_LZMA
-	if (mode == 2) {
-		
-		r = LzmaCompress(out, &out_len, in, in_len, //assume sizeof(char)==1....
-		                 props, &sizeOfIt, 5, 1 << 24, 3, 0, 2, 32, 2);
 
-		if (!(r == SZ_OK) || (out_len >= in_len))
-			compressed = 0;
-		else
-			compressed = 2;
-	}
-#endif
+	compressed = ptcache_compress_buffer(in, in_len, out, &out_len, props, &sizeOfIt, mode);
 	
 	ptcache_file_write(pf, &compressed, 1, sizeof(unsigned char));
 	if (compressed) {
@@ -2011,7 +2044,7 @@ static int ptcache_file_compressed_write(PTCacheFile *pf, unsigned char *in, uns
 
 	MEM_freeN(props);
 
-	return r;
+	return compressed;
 }
 static int ptcache_file_read(PTCacheFile *pf, void *f, unsigned int tot, unsigned int size)
 {
@@ -2282,12 +2315,879 @@ static void ptcache_find_frames_around(PTCacheID *pid, unsigned int frame, int *
 	}
 }
 
+/* Single file disk cache
+ *
+ * With PTCACHE_DISK_SINGLE_FILE all frames of a point cache are stored in one
+ * ".bphysarc" file instead of a file per frame:
+ *
+ * - PTCacheArchiveHeader.
+ * - Frame blocks: a PTCacheArchiveBlock followed by one column per data type and
+ *   per extra data, each a PTCacheArchiveColumn followed by the compression
+ *   properties and the (compressed) data.
+ * - The frame index: a PTCacheArchiveFrame per frame, sorted by frame.
+ *
+ * New frames are appended after the last frame block, after which the index is
+ * written again. Reading a frame only touches its own block, on most platforms
+ * straight from a memory mapping of the file.
+ *
+ * With PTCACHE_DISK_DELTA (only when compression is enabled) frames are stored as
+ * XOR difference to the last key frame, which compresses a lot better for data
+ * that changes little between frames. A new key frame is started every
+ * PTCACHE_ARCHIVE_KEY_INTERVAL frames or when the point count or data types change.
+ *
+ * Everything is stored in native byte order, like the regular cache files.
+ */
+
+#define PTCACHE_ARCHIVE_EXT ".bphysarc"
+#define PTCACHE_ARCHIVE_ID "BPHYSARC"
+#define PTCACHE_ARCHIVE_VERSION 1
+#define PTCACHE_ARCHIVE_KEY_INTERVAL 16
+
+#ifndef WIN32
+#  define USE_ARCHIVE_MMAP
+#endif
+
+typedef struct PTCacheArchiveHeader {
+	char id[8];                 /* PTCACHE_ARCHIVE_ID, not null terminated */
+	unsigned int version;
+	unsigned int type;          /* PTCACHE_TYPE_* */
+	unsigned int totframe;      /* number of frames in the index */
+	unsigned int stamp;         /* changed on every index write, to notice rewrites the mtime can't tell apart */
+	uint64_t index_offset;      /* file offset of the frame index, also the end of the frame data */
+} PTCacheArchiveHeader;
+
+typedef struct PTCacheArchiveFrame {
+	int frame;
+	int key_frame;              /* frame this is a delta of, same as frame for key frames */
+	uint64_t offset;            /* file offset of the frame block */
+	uint64_t size;
+} PTCacheArchiveFrame;
+
+typedef struct PTCacheArchiveBlock {
+	unsigned int totpoint;
+	unsigned int data_types;
+	unsigned int totextra;
+	unsigned int pad;
+} PTCacheArchiveBlock;
+
+typedef struct PTCacheArchiveColumn {
+	unsigned int type;          /* BPHYS_DATA_* or BPHYS_EXTRA_* */
+	unsigned int totdata;
+	unsigned int size;          /* size of the stored data */
+	unsigned char compressed;   /* PTCACHE_COMPRESS_* */
+	unsigned char pad;
+	unsigned short props_size;  /* size of the compression properties before the data */
+} PTCacheArchiveColumn;
+
+/* Runtime handle, stored in PointCache.archive */
+typedef struct PTCacheArchive {
+	char filename[MAX_PTCACHE_FILE];
+	/* file size (-1 when there is no file), modification time, inode and header
+	 * stamp when the index was last read or written, to notice changes by others */
+	int64_t file_size;
+	int64_t file_mtime;
+	uint64_t file_ino;
+	unsigned int file_stamp;
+
+	PTCacheArchiveFrame *frames;
+	unsigned int totframe, maxframe;
+	uint64_t data_end;          /* end of the last frame block */
+
+	unsigned char *map;         /* read only mapping of the file, if supported */
+	size_t map_size;
+
+	/* decoded data of the last used key frame */
+	bool has_key;
+	int key_frame;
+	unsigned int key_totpoint, key_data_types;
+	void *key_data[BPHYS_TOT_DATA];
+} PTCacheArchive;
+
+static bool ptcache_use_archive(PTCacheID *pid)
+{
+	return ((pid->cache->flag & (PTCACHE_DISK_SINGLE_FILE | PTCACHE_EXTERNAL)) == PTCACHE_DISK_SINGLE_FILE &&
+	        pid->file_type == PTCACHE_FILE_PTCACHE &&
+	        pid->write_point != NULL);
+}
+
+/* The file name includes the cache index, there is no file before one is assigned on writing. */
+static bool ptcache_archive_filename(PTCacheID *pid, char *filename)
+{
+	int len;
+
+	if (!G.relbase_valid) return false; /* save blend file before using disk pointcache */
+	if (pid->cache->index < 0) return false;
+
+	len = ptcache_filename(pid, filename, 0, 1, 0);
+
+	BLI_snprintf(filename + len, MAX_PTCACHE_FILE - len, "_%02u%s", pid->stack_index, PTCACHE_ARCHIVE_EXT);
+
+	return true;
+}
+
+/* Only a stat() call, done on every access to the archive. */
+static void ptcache_archive_stat(const char *filename, int64_t *r_size, int64_t *r_mtime, uint64_t *r_ino)
+{
+	BLI_stat_t st;
+
+	*r_size = -1;
+	*r_mtime = 0;
+	*r_ino = 0;
+
+	if (BLI_stat(filename, &st) == 0) {
+		*r_size = (int64_t)st.st_size;
+		*r_ino = (uint64_t)st.st_ino;
+		/* with sub-second precision where available */
+#if defined(WIN32)
+		*r_mtime = (int64_t)st.st_mtime * 1000000000;
+#elif defined(__APPLE__)
+		*r_mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+		*r_mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+	}
+}
+
+/* Stamp in the header of the file, from the mapping when there is one. */
+static unsigned int ptcache_archive_stamp_read(PTCacheArchive *archive)
+{
+	PTCacheArchiveHeader header;
+	FILE *fp;
+
+	if (archive->map && archive->map_size >= sizeof(header)) {
+		/* the mapping shows writes to the file by others, the header is never copied on write */
+		memcpy(&header, archive->map, sizeof(header));
+		return header.stamp;
+	}
+
+	fp = BLI_fopen(archive->filename, "rb");
+	header.stamp = 0;
+
+	if (fp) {
+		if (fread(&header, sizeof(header), 1, fp) != 1)
+			header.stamp = 0;
+		fclose(fp);
+	}
+
+	return header.stamp;
+}
+
+static void ptcache_archive_unmap(PTCacheArchive *archive)
+{
+#ifdef USE_ARCHIVE_MMAP
+	if (archive->map) {
+		munmap(archive->map, archive->map_size);
+	}
+#endif
+	archive->map = NULL;
+	archive->map_size = 0;
+}
+
+/* Map the whole file for reading, returns false when not supported or on failure. */
+static bool ptcache_archive_map(PTCacheArchive *archive)
+{
+#ifdef USE_ARCHIVE_MMAP
+	if (archive->map == NULL && archive->file_size > 0) {
+		FILE *fp = BLI_fopen(archive->filename, "rb");
+		void *mem;
+
+		if (fp == NULL)
+			return false;
+
+		mem = mmap(NULL, (size_t)archive->file_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+		/* mapping stays valid after closing the file */
+		fclose(fp);
+
+		if (mem == MAP_FAILED)
+			return false;
+
+		archive->map = mem;
+		archive->map_size = (size_t)archive->file_size;
+	}
+#endif
+
+	return archive->map != NULL;
+}
+
+static void ptcache_archive_key_free(PTCacheArchive *archive)
+{
+	int i;
+
+	for (i = 0; i < BPHYS_TOT_DATA; i++) {
+		if (archive->key_data[i]) {
+			MEM_freeN(archive->key_data[i]);
+			archive->key_data[i] = NULL;
+		}
+	}
+
+	archive->has_key = false;
+}
+
+/* Use the data of pm as key frame data, pm keeps its data when copy is set. */
+static void ptcache_archive_key_set(PTCacheArchive *archive, PTCacheMem *pm, bool copy)
+{
+	int i;
+
+	ptcache_archive_key_free(archive);
+
+	for (i = 0; i < BPHYS_TOT_DATA; i++) {
+		if (pm->data[i]) {
+			archive->key_data[i] = copy ? MEM_dupallocN(pm->data[i]) : pm->data[i];
+			if (!copy)
+				pm->data[i] = NULL;
+		}
+	}
+
+	archive->has_key = true;
+	archive->key_frame = pm->frame;
+	archive->key_totpoint = pm->totpoint;
+	archive->key_data_types = pm->data_types;
+}
+
+static void ptcache_archive_reset(PTCacheArchive *archive)
+{
+	ptcache_archive_unmap(archive);
+	ptcache_archive_key_free(archive);
+
+	MEM_SAFE_FREE(archive->frames);
+	archive->totframe = archive->maxframe = 0;
+	archive->data_end = sizeof(PTCacheArchiveHeader);
+	archive->file_size = -1;
+	archive->file_mtime = 0;
+	archive->file_ino = 0;
+	archive->file_stamp = 0;
+}
+
+static void ptcache_archive_free(PointCache *cache)
+{
+	if (cache->archive) {
+		ptcache_archive_reset(cache->archive);
+		MEM_freeN(cache->archive);
+		cache->archive = NULL;
+	}
+}
+
+/* Index of the first frame in the (sorted) frames which is not before frame. */
+static unsigned int ptcache_archive_frame_index(const PTCacheArchiveFrame *frames, unsigned int totframe, int frame)
+{
+	unsigned int low = 0, high = totframe;
+
+	while (low < high) {
+		const unsigned int mid = (low + high) / 2;
+
+		if (frames[mid].frame < frame)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static PTCacheArchiveFrame *ptcache_archive_frame_find(PTCacheArchive *archive, int frame)
+{
+	const unsigned int index = ptcache_archive_frame_index(archive->frames, archive->totframe, frame);
+
+	return (index < archive->totframe && archive->frames[index].frame == frame) ? &archive->frames[index] : NULL;
+}
+
+static void ptcache_archive_frame_insert(PTCacheArchive *archive, const PTCacheArchiveFrame *af)
+{
+	const unsigned int index = ptcache_archive_frame_index(archive->frames, archive->totframe, af->frame);
+
+	if (archive->totframe == archive->maxframe) {
+		archive->maxframe = MAX2(16, archive->maxframe * 2);
+
+		if (archive->frames)
+			archive->frames = MEM_reallocN(archive->frames, sizeof(PTCacheArchiveFrame) * archive->maxframe);
+		else
+			archive->frames = MEM_mallocN(sizeof(PTCacheArchiveFrame) * archive->maxframe, "PTCacheArchive frames");
+	}
+
+	memmove(&archive->frames[index + 1], &archive->frames[index], sizeof(PTCacheArchiveFrame) * (archive->totframe - index));
+	archive->frames[index] = *af;
+	archive->totframe++;
+}
+
+/* Remove frames from the index like BKE_ptcache_id_clear, along with delta frames
+ * of removed key frames. Returns true when the index changed. */
+static bool ptcache_archive_frames_remove(PTCacheArchive *archive, PointCache *cache, int mode, int cfra)
+{
+	const int sta = cache->startframe, end = cache->endframe;
+	unsigned int i, totframe = 0;
+	bool changed = false;
+
+	for (i = 0; i < archive->totframe; i++) {
+		const PTCacheArchiveFrame af = archive->frames[i];
+		bool remove = ((mode == PTCACHE_CLEAR_FRAME && af.frame == cfra) ||
+		               (mode == PTCACHE_CLEAR_BEFORE && af.frame < cfra) ||
+		               (mode == PTCACHE_CLEAR_AFTER && af.frame > cfra));
+
+		if (!remove && af.key_frame != af.frame) {
+			/* key frames come before their deltas, so a kept key frame is in the already compacted part */
+			const unsigned int key_index = ptcache_archive_frame_index(archive->frames, totframe, af.key_frame);
+			remove = (key_index == totframe || archive->frames[key_index].frame != af.key_frame);
+		}
+
+		if (remove) {
+			if (archive->has_key && archive->key_frame == af.frame)
+				ptcache_archive_key_free(archive);
+			if (cache->cached_frames && af.frame >= sta && af.frame <= end)
+				cache->cached_frames[af.frame - sta] = 0;
+			changed = true;
+		}
+		else {
+			archive->frames[totframe++] = af;
+		}
+	}
+
+	if (changed) {
+		/* the space after the last frame block is reused for new frames */
+		archive->totframe = totframe;
+		archive->data_end = sizeof(PTCacheArchiveHeader);
+
+		for (i = 0; i < totframe; i++)
+			archive->data_end = MAX2(archive->data_end, archive->frames[i].offset + archive->frames[i].size);
+	}
+
+	return changed;
+}
+
+static bool ptcache_archive_index_read(PTCacheArchive *archive, int type)
+{
+	PTCacheArchiveHeader header;
+	FILE *fp = BLI_fopen(archive->filename, "rb");
+	unsigned int i;
+	bool ok;
+
+	if (fp == NULL)
+		return false;
+
+	ok = (fread(&header, sizeof(header), 1, fp) == 1 &&
+	      memcmp(header.id, PTCACHE_ARCHIVE_ID, sizeof(header.id)) == 0 &&
+	      header.version == PTCACHE_ARCHIVE_VERSION &&
+	      header.type == (unsigned int)type &&
+	      header.index_offset >= sizeof(header) &&
+	      header.index_offset + (uint64_t)header.totframe * sizeof(PTCacheArchiveFrame) <= (uint64_t)archive->file_size &&
+	      fseek(fp, header.index_offset, SEEK_SET) == 0);
+
+	if (ok && header.totframe) {
+		archive->frames = MEM_mallocN(sizeof(PTCacheArchiveFrame) * header.totframe, "PTCacheArchive frames");
+		archive->totframe = archive->maxframe = header.totframe;
+
+		ok = (fread(archive->frames, sizeof(PTCacheArchiveFrame), header.totframe, fp) == header.totframe);
+
+		for (i = 0; ok && i < header.totframe; i++) {
+			const PTCacheArchiveFrame *af = &archive->frames[i];
+
+			ok = (af->offset >= sizeof(header) && af->offset + af->size <= header.index_offset &&
+			      (i == 0 || af->frame > af[-1].frame) && af->key_frame <= af->frame);
+		}
+	}
+
+	fclose(fp);
+
+	if (ok) {
+		archive->data_end = header.index_offset;
+		archive->file_stamp = header.stamp;
+	}
+	else {
+		MEM_SAFE_FREE(archive->frames);
+		archive->totframe = archive->maxframe = 0;
+	}
+
+	return ok;
+}
+
+static bool ptcache_archive_index_write(PTCacheArchive *archive, FILE *fp, int type)
+{
+	PTCacheArchiveHeader header = {{0}};
+
+	memcpy(header.id, PTCACHE_ARCHIVE_ID, sizeof(header.id));
+	header.version = PTCACHE_ARCHIVE_VERSION;
+	header.type = type;
+	header.totframe = archive->totframe;
+	/* the time makes separate writes of the same data differ */
+	header.stamp = BLI_hash_int_2d(archive->file_stamp, (unsigned int)(PIL_check_seconds_timer() * 1e6));
+	header.index_offset = archive->data_end;
+	archive->file_stamp = header.stamp;
+
+	return (fseek(fp, archive->data_end, SEEK_SET) == 0 &&
+	        (archive->totframe == 0 ||
+	         fwrite(archive->frames, sizeof(PTCacheArchiveFrame), archive->totframe, fp) == archive->totframe) &&
+	        fseek(fp, 0, SEEK_SET) == 0 &&
+	        fwrite(&header, sizeof(header), 1, fp) == 1);
+}
+
+/* Get the archive of pid, (re)reading the index when the file changed. */
+static PTCacheArchive *ptcache_archive_get(PTCacheID *pid)
+{
+	PointCache *cache = pid->cache;
+	PTCacheArchive *archive = cache->archive;
+	char filename[MAX_PTCACHE_FILE];
+	int64_t file_size, file_mtime;
+	uint64_t file_ino;
+	bool changed;
+
+	if (!ptcache_archive_filename(pid, filename))
+		return NULL;
+
+	if (archive == NULL) {
+		archive = cache->archive = MEM_callocN(sizeof(PTCacheArchive), "PTCacheArchive");
+		ptcache_archive_reset(archive);
+	}
+
+	ptcache_archive_stat(filename, &file_size, &file_mtime, &file_ino);
+
+	changed = (!STREQ(archive->filename, filename) ||
+	           archive->file_size != file_size ||
+	           archive->file_mtime != file_mtime ||
+	           archive->file_ino != file_ino);
+
+	/* A rewrite of the same size within the resolution of the mtime is only
+	 * noticed by the stamp. Reading it is cheap from the mapping, without one
+	 * it is only read while the mtime is recent enough for that to happen. */
+	if (!changed && file_size >= (int64_t)sizeof(PTCacheArchiveHeader) &&
+	    (archive->map || (int64_t)time(NULL) - file_mtime / 1000000000 <= 2))
+	{
+		changed = (ptcache_archive_stamp_read(archive) != archive->file_stamp);
+	}
+
+	if (changed) {
+		ptcache_archive_reset(archive);
+		BLI_strncpy(archive->filename, filename, sizeof(archive->filename));
+		archive->file_size = file_size;
+		archive->file_mtime = file_mtime;
+		archive->file_ino = file_ino;
+
+		/* an unreadable file is overwritten by the next written frame */
+		if (file_size > 0 && !ptcache_archive_index_read(archive, pid->type) && (G.debug & G_DEBUG))
+			printf("Error reading disk cache file %s\n", filename);
+	}
+
+	return archive;
+}
+
+/* Get the block of a frame, either from the mapping or in a buffer to be freed by the caller. */
+static const unsigned char *ptcache_archive_block_get(PTCacheArchive *archive, const PTCacheArchiveFrame *af, bool *r_free)
+{
+	unsigned char *block = NULL;
+	FILE *fp;
+
+	*r_free = false;
+
+	if (ptcache_archive_map(archive)) {
+		return (af->offset + af->size <= archive->map_size) ? archive->map + af->offset : NULL;
+	}
+
+	fp = BLI_fopen(archive->filename, "rb");
+
+	if (fp) {
+		block = MEM_mallocN((size_t)af->size, "PTCacheArchive block");
+
+		if (fseek(fp, af->offset, SEEK_SET) != 0 || fread(block, 1, (size_t)af->size, fp) != (size_t)af->size)
+			MEM_SAFE_FREE(block);
+
+		fclose(fp);
+	}
+
+	*r_free = (block != NULL);
+
+	return block;
+}
+
+static bool ptcache_archive_column_begin(const unsigned char *block, size_t block_size, size_t *r_pos,
+                                         PTCacheArchiveColumn *column)
+{
+	if (*r_pos + sizeof(PTCacheArchiveColumn) > block_size)
+		return false;
+
+	memcpy(column, block + *r_pos, sizeof(PTCacheArchiveColumn));
+	*r_pos += sizeof(PTCacheArchiveColumn);
+
+	return (*r_pos + column->props_size + column->size <= block_size);
+}
+
+static bool ptcache_archive_column_end(const unsigned char *block, size_t *r_pos, const PTCacheArchiveColumn *column,
+                                       void *data, size_t len)
+{
+	const unsigned char *props = block + *r_pos;
+	const unsigned char *in = props + column->props_size;
+	bool ok;
+
+	if (column->compressed) {
+		ok = ptcache_decompress_buffer(column->compressed, in, column->size, props, column->props_size, data, len);
+	}
+	else {
+		ok = (column->size == len);
+		if (ok && len)
+			memcpy(data, in, len);
+	}
+
+	*r_pos += column->props_size + column->size;
+
+	return ok;
+}
+
+static bool ptcache_archive_column_write(FILE *fp, unsigned int type, unsigned int totdata, unsigned char *data,
+                                         unsigned int len, int compression, uint64_t *r_size)
+{
+	PTCacheArchiveColumn column = {0};
+	unsigned char props[16];
+	unsigned char *out = NULL;
+	size_t out_len = 0, props_len = 0;
+	bool ok;
+
+	column.type = type;
+	column.totdata = totdata;
+
+	if (compression && len) {
+		out = MEM_mallocN(LZO_OUT_LEN(len) * 4, "pointcache_lzo_buffer");
+		column.compressed = ptcache_compress_buffer(data, len, out, &out_len, props, &props_len, compression);
+	}
+
+	if (column.compressed) {
+		column.size = (unsigned int)out_len;
+		column.props_size = (column.compressed == PTCACHE_COMPRESS_LZMA) ? (unsigned short)props_len : 0;
+	}
+	else {
+		column.size = len;
+	}
+
+	ok = (fwrite(&column, sizeof(column), 1, fp) == 1 &&
+	      (column.props_size == 0 || fwrite(props, column.props_size, 1, fp) == 1) &&
+	      (column.size == 0 || fwrite(column.compressed ? out : data, column.size, 1, fp) == 1));
+
+	*r_size += sizeof(column) + column.props_size + column.size;
+
+	if (out)
+		MEM_freeN(out);
+
+	return ok;
+}
+
+static void ptcache_archive_delta_apply(void *data, const void *key, size_t len)
+{
+	unsigned char *d = data;
+	const unsigned char *k = key;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		d[i] ^= k[i];
+}
+
+/* Decode a frame block, delta frames still contain the difference to their key frame. */
+static PTCacheMem *ptcache_archive_frame_decode(PTCacheArchive *archive, const PTCacheArchiveFrame *af)
+{
+	PTCacheArchiveBlock header;
+	PTCacheArchiveColumn column;
+	PTCacheMem *pm;
+	const unsigned char *block;
+	const size_t block_size = (size_t)af->size;
+	size_t pos = sizeof(header);
+	unsigned int i;
+	bool do_free, ok;
+
+	block = ptcache_archive_block_get(archive, af, &do_free);
+
+	if (block == NULL)
+		return NULL;
+
+	if (block_size < sizeof(header)) {
+		if (do_free)
+			MEM_freeN((void *)block);
+		return NULL;
+	}
+
+	memcpy(&header, block, sizeof(header));
+
+	pm = MEM_callocN(sizeof(PTCacheMem), "Pointcache mem");
+	pm->frame = af->frame;
+	pm->totpoint = header.totpoint;
+	pm->data_types = header.data_types;
+
+	ptcache_data_alloc(pm);
+
+	ok = true;
+
+	for (i = 0; ok && i < BPHYS_TOT_DATA; i++) {
+		if (pm->data_types & (1 << i)) {
+			ok = (ptcache_archive_column_begin(block, block_size, &pos, &column) && column.type == i &&
+			      ptcache_archive_column_end(block, &pos, &column, pm->data[i], pm->totpoint * ptcache_data_size[i]));
+		}
+	}
+
+	for (i = 0; ok && i < header.totextra; i++) {
+		ok = (ptcache_archive_column_begin(block, block_size, &pos, &column) &&
+		      column.type < ARRAY_SIZE(ptcache_extra_datasize));
+
+		if (ok) {
+			PTCacheExtra *extra = MEM_callocN(sizeof(PTCacheExtra), "Pointcache extradata");
+			const size_t len = column.totdata * ptcache_extra_datasize[column.type];
+
+			extra->type = column.type;
+			extra->totdata = column.totdata;
+			extra->data = MEM_callocN(len, "Pointcache extradata->data");
+
+			BLI_addtail(&pm->extradata, extra);
+
+			ok = ptcache_archive_column_end(block, &pos, &column, extra->data, len);
+		}
+	}
+
+	if (do_free)
+		MEM_freeN((void *)block);
+
+	if (!ok) {
+		ptcache_data_free(pm);
+		ptcache_extra_free(pm);
+		MEM_freeN(pm);
+		pm = NULL;
+	}
+
+	return pm;
+}
+
+static bool ptcache_archive_key_load(PTCacheArchive *archive, int key_frame)
+{
+	PTCacheArchiveFrame *af;
+	PTCacheMem *pm;
+
+	if (archive->has_key && archive->key_frame == key_frame)
+		return true;
+
+	ptcache_archive_key_free(archive);
+
+	af = ptcache_archive_frame_find(archive, key_frame);
+
+	if (af == NULL || af->key_frame != af->frame)
+		return false;
+
+	pm = ptcache_archive_frame_decode(archive, af);
+
+	if (pm == NULL)
+		return false;
+
+	ptcache_archive_key_set(archive, pm, false);
+
+	ptcache_data_free(pm);
+	ptcache_extra_free(pm);
+	MEM_freeN(pm);
+
+	return true;
+}
+
+static PTCacheMem *ptcache_archive_frame_to_mem(PTCacheID *pid, int cfra)
+{
+	PTCacheArchive *archive = ptcache_archive_get(pid);
+	PTCacheArchiveFrame *af = archive ? ptcache_archive_frame_find(archive, cfra) : NULL;
+	PTCacheMem *pm;
+	int i;
+
+	if (af == NULL)
+		return NULL;
+
+	if (af->key_frame != af->frame && !ptcache_archive_key_load(archive, af->key_frame))
+		pm = NULL;
+	else
+		pm = ptcache_archive_frame_decode(archive, af);
+
+	if (pm && af->key_frame != af->frame) {
+		if (pm->totpoint == archive->key_totpoint && pm->data_types == archive->key_data_types) {
+			for (i = 0; i < BPHYS_TOT_DATA; i++) {
+				if (pm->data[i])
+					ptcache_archive_delta_apply(pm->data[i], archive->key_data[i], pm->totpoint * ptcache_data_size[i]);
+			}
+		}
+		else {
+			ptcache_data_free(pm);
+			ptcache_extra_free(pm);
+			MEM_freeN(pm);
+			pm = NULL;
+		}
+	}
+
+	if (pm == NULL && G.debug & G_DEBUG)
+		printf("Error reading from disk cache\n");
+
+	return pm;
+}
+
+static int ptcache_archive_frame_write(PTCacheID *pid, PTCacheMem *pm)
+{
+	PointCache *cache = pid->cache;
+	PTCacheArchive *archive;
+	PTCacheArchiveBlock header = {0};
+	PTCacheArchiveFrame af;
+	PTCacheExtra *extra;
+	FILE *fp;
+	unsigned int i;
+	bool is_delta = false, ok;
+
+	/* the file name depends on the cache index */
+	if (cache->index < 0)
+		cache->index = pid->stack_index = BKE_object_insert_ptcache(pid->ob);
+
+	archive = ptcache_archive_get(pid);
+
+	if (archive == NULL)
+		return 0;
+
+	for (i = 0; i < BPHYS_TOT_DATA; i++) {
+		if (pm->data[i])
+			header.data_types |= (1 << i);
+	}
+
+	for (extra = pm->extradata.first; extra; extra = extra->next) {
+		if (extra->data && extra->totdata)
+			header.totextra++;
+	}
+
+	header.totpoint = pm->totpoint;
+
+	/* an existing version of this frame is replaced */
+	ptcache_archive_frames_remove(archive, cache, PTCACHE_CLEAR_FRAME, pm->frame);
+
+	af.frame = af.key_frame = pm->frame;
+
+	if ((cache->flag & PTCACHE_DISK_DELTA) && cache->compression) {
+		const unsigned int index = ptcache_archive_frame_index(archive->frames, archive->totframe, pm->frame);
+
+		if (index > 0) {
+			const int key_frame = archive->frames[index - 1].key_frame;
+
+			if (pm->frame - key_frame < PTCACHE_ARCHIVE_KEY_INTERVAL &&
+			    ptcache_archive_key_load(archive, key_frame) &&
+			    archive->key_totpoint == header.totpoint &&
+			    archive->key_data_types == header.data_types)
+			{
+				af.key_frame = key_frame;
+				is_delta = true;
+			}
+		}
+	}
+
+	ptcache_archive_unmap(archive);
+
+	if (archive->totframe == 0) {
+		archive->data_end = sizeof(PTCacheArchiveHeader);
+		BLI_make_existing_file(archive->filename);
+		fp = BLI_fopen(archive->filename, "wb");
+	}
+	else {
+		fp = BLI_fopen(archive->filename, "rb+");
+	}
+
+	if (fp == NULL) {
+		if (G.debug & G_DEBUG)
+			printf("Error opening disk cache file for writing\n");
+		return 0;
+	}
+
+	af.offset = archive->data_end;
+	af.size = sizeof(header);
+
+	ok = (fseek(fp, af.offset, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1);
+
+	for (i = 0; ok && i < BPHYS_TOT_DATA; i++) {
+		if (pm->data[i]) {
+			unsigned int len = pm->totpoint * ptcache_data_size[i];
+			unsigned char *data = pm->data[i];
+
+			if (is_delta) {
+				data = MEM_mallocN(len, "pointcache delta");
+				memcpy(data, pm->data[i], len);
+				ptcache_archive_delta_apply(data, archive->key_data[i], len);
+			}
+
+			ok = ptcache_archive_column_write(fp, i, pm->totpoint, data, len, cache->compression, &af.size);
+
+			if (is_delta)
+				MEM_freeN(data);
+		}
+	}
+
+	for (extra = pm->extradata.first; ok && extra; extra = extra->next) {
+		if (extra->data == NULL || extra->totdata == 0)
+			continue;
+
+		ok = ptcache_archive_column_write(fp, extra->type, extra->totdata, extra->data,
+		                                  extra->totdata * ptcache_extra_datasize[extra->type],
+		                                  cache->compression, &af.size);
+	}
+
+	if (ok) {
+		archive->data_end = af.offset + af.size;
+		ptcache_archive_frame_insert(archive, &af);
+		ok = ptcache_archive_index_write(archive, fp, pid->type);
+	}
+
+	fclose(fp);
+
+	ptcache_archive_stat(archive->filename, &archive->file_size, &archive->file_mtime, &archive->file_ino);
+
+	if (ok && !is_delta && (cache->flag & PTCACHE_DISK_DELTA))
+		ptcache_archive_key_set(archive, pm, true);
+
+	if (!ok && G.debug & G_DEBUG)
+		printf("Error writing to disk cache\n");
+
+	return ok;
+}
+
+static void ptcache_archive_clear(PTCacheID *pid, int mode, int cfra)
+{
+	PointCache *cache = pid->cache;
+	PTCacheArchive *archive = ptcache_archive_get(pid);
+	FILE *fp;
+
+	if (archive == NULL)
+		return;
+
+	if (mode == PTCACHE_CLEAR_ALL) {
+		cache->last_exact = MIN2(cache->startframe, 0);
+
+		if (cache->cached_frames)
+			memset(cache->cached_frames, 0, MEM_allocN_len(cache->cached_frames));
+
+		archive->totframe = 0;
+	}
+	else if (!ptcache_archive_frames_remove(archive, cache, mode, cfra)) {
+		return;
+	}
+
+	ptcache_archive_unmap(archive);
+
+	if (archive->totframe == 0) {
+		if (archive->file_size >= 0)
+			BLI_delete(archive->filename, false, false);
+
+		ptcache_archive_reset(archive);
+		return;
+	}
+
+	fp = BLI_fopen(archive->filename, "rb+");
+
+	if (fp) {
+		if (!ptcache_archive_index_write(archive, fp, pid->type) && G.debug & G_DEBUG)
+			printf("Error writing to disk cache\n");
+		fclose(fp);
+	}
+
+	ptcache_archive_stat(archive->filename, &archive->file_size, &archive->file_mtime, &archive->file_ino);
+}
+
 static PTCacheMem *ptcache_disk_frame_to_mem(PTCacheID *pid, int cfra)
 {
-	PTCacheFile *pf = ptcache_file_open(pid, PTCACHE_FILE_READ, cfra);
+	PTCacheFile *pf;
 	PTCacheMem *pm = NULL;
 	unsigned int i, error = 0;
 
+	if (ptcache_use_archive(pid))
+		return ptcache_archive_frame_to_mem(pid, cfra);
+
+	pf = ptcache_file_open(pid, PTCACHE_FILE_READ, cfra);
+
 	if (pf == NULL)
 		return NULL;
 
@@ -2367,6 +3267,9 @@ static int ptcache_mem_frame_to_disk(PTCacheID *pid, PTCacheMem *pm)
 {
 	PTCacheFile *pf = NULL;
 	unsigned int i, error = 0;
+
+	if (ptcache_use_archive(pid))
+		return ptcache_archive_frame_write(pid, pm);
 	
 	BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_FRAME, pm->frame);
 
@@ -2971,6 +3874,12 @@ void BKE_ptcache_id_clear(PTCacheID *pid, int mode, unsigned int cfra)
 
 	/*if (!G.relbase_valid) return; *//* save blend file before using pointcache */
 
+	if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_archive(pid)) {
+		ptcache_archive_clear(pid, mode, cfra);
+		BKE_ptcache_update_info(pid);
+		return;
+	}
+
 	const char *fext = ptcache_file_extension(pid);
 
 	/* clear all files in the temp dir with the prefix of the ID and the ".bphys" suffix */
@@ -3101,7 +4010,12 @@ int  BKE_ptcache_id_exist(PTCacheID *pid, int cfra)
 	if (pid->cache->cached_frames &&	pid->cache->cached_frames[cfra-pid->cache->startframe]==0)
 		return 0;
 	
-	if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+	if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_archive(pid)) {
+		PTCacheArchive *archive = ptcache_archive_get(pid);
+
+		return (archive && ptcache_archive_frame_find(archive, cfra) != NULL);
+	}
+	else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 		char filename[MAX_PTCACHE_FILE];
 		
 		ptcache_filename(pid, filename, cfra, 1, 1);
@@ -3179,7 +4093,18 @@ void BKE_ptcache_id_time(PTCacheID *pid, Scene *scene, float cfra, int *startfra
 
 		cache->cached_frames = MEM_callocN(sizeof(char) * (cache->endframe-cache->startframe+1), "cached frames array");
 
-		if (pid->cache->flag & PTCACHE_DISK_CACHE) {
+		if ((pid->cache->flag & PTCACHE_DISK_CACHE) && ptcache_use_archive(pid)) {
+			PTCacheArchive *archive = ptcache_archive_get(pid);
+			unsigned int i;
+
+			for (i = 0; archive && i < archive->totframe; i++) {
+				const int frame = archive->frames[i].frame;
+
+				if (frame >= sta && frame <= end)
+					cache->cached_frames[frame-sta] = 1;
+			}
+		}
+		else if (pid->cache->flag & PTCACHE_DISK_CACHE) {
 			/* mode is same as fopen's modes */
 			DIR *dir; 
 			struct dirent *de;
@@ -3438,6 +4363,7 @@ void BKE_ptcache_free(PointCache *cache)
 		cache->free_edit(cache->edit);
 	if (cache->cached_frames)
 		MEM_freeN(cache->cached_frames);
+	ptcache_archive_free(cache);
 	MEM_freeN(cache);
 }
 void BKE_ptcache_free_list(ListBase *ptcaches)
@@ -3456,12 +4382,14 @@ static PointCache *ptcache_copy(PointCache *cache, const bool copy_data)
 	ncache= MEM_dupallocN(cache);
 
 	BLI_listbase_clear(&ncache->mem_cache);
+	ncache->archive = NULL;
 
 	if (copy_data == false) {
 		ncache->cached_frames = NULL;
 
 		/* flag is a mix of user settings and simulator/baking state */
-		ncache->flag= ncache->flag & (PTCACHE_DISK_CACHE|PTCACHE_EXTERNAL|PTCACHE_IGNORE_LIBPATH);
+		ncache->flag= ncache->flag & (PTCACHE_DISK_CACHE|PTCACHE_EXTERNAL|PTCACHE_IGNORE_LIBPATH|
+		                              PTCACHE_DISK_SINGLE_FILE|PTCACHE_DISK_DELTA);
 		ncache->simframe= 0;
 	}
 	else {
@@ -3840,6 +4768,61 @@ void BKE_ptcache_toggle_disk_cache(PTCacheID *pid)
 	}
 }
 
+void BKE_ptcache_toggle_disk_single_file(PTCacheID *pid)
+{
+	PointCache *cache = pid->cache;
+	ListBase frames = {NULL, NULL};
+	PTCacheMem *pm;
+	int baked = cache->flag & PTCACHE_BAKED;
+	int last_exact = cache->last_exact;
+	int cfra;
+
+	/* PTCACHE_DISK_SINGLE_FILE flag was toggled already, convert the existing disk cache */
+	if ((cache->flag & (PTCACHE_DISK_CACHE | PTCACHE_EXTERNAL)) != PTCACHE_DISK_CACHE || !G.relbase_valid)
+		return;
+
+	if (pid->file_type != PTCACHE_FILE_PTCACHE || pid->write_point == NULL)
+		return;
+
+	cache->flag ^= PTCACHE_DISK_SINGLE_FILE;
+
+	for (cfra = cache->startframe; cfra <= cache->endframe; cfra++) {
+		pm = ptcache_disk_frame_to_mem(pid, cfra);
+
+		if (pm)
+			BLI_addtail(&frames, pm);
+	}
+
+	/* Remove possible bake flag to allow clear */
+	cache->flag &= ~PTCACHE_BAKED;
+	BKE_ptcache_id_clear(pid, PTCACHE_CLEAR_ALL, 0);
+	cache->flag |= baked;
+
+	cache->flag ^= PTCACHE_DISK_SINGLE_FILE;
+
+	for (pm = frames.first; pm; pm = pm->next) {
+		if (ptcache_mem_frame_to_disk(pid, pm) == 0)
+			break;
+	}
+
+	BKE_ptcache_free_mem(&frames);
+
+	cache->last_exact = last_exact;
+
+	/* write info file */
+	if (cache->flag & PTCACHE_BAKED)
+		BKE_ptcache_write(pid, 0);
+
+	if (cache->cached_frames) {
+		MEM_freeN(cache->cached_frames);
+		cache->cached_frames = NULL;
+	}
+
+	BKE_ptcache_id_time(pid, NULL, 0.0f, NULL, NULL, NULL);
+
+	BKE_ptcache_update_info(pid);
+}
+
 void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const char *name_dst)
 {
 	char old_name[80];
@@ -3856,6 +4839,17 @@ void BKE_ptcache_disk_cache_rename(PTCacheID *pid, const char *name_src, const c
 	/* save old name */
 	BLI_strncpy(old_name, pid->cache->name, sizeof(old_name));
 
+	if (ptcache_use_archive(pid)) {
+		BLI_strncpy(pid->cache->name, name_src, sizeof(pid->cache->name));
+		if (ptcache_archive_filename(pid, old_path_full) && BLI_exists(old_path_full)) {
+			BLI_strncpy(pid->cache->name, name_dst, sizeof(pid->cache->name));
+			ptcache_archive_filename(pid, new_path_full);
+			BLI_rename(old_path_full, new_path_full);
+		}
+		BLI_strncpy(pid->cache->name, old_name, sizeof(pid->cache->name));
+		return;
+	}
+
 	/* get "from" filename */
 	BLI_strncpy(pid->cache->name, name_src, sizeof(pid->cache->name));
 
@@ -4033,6 +5027,27 @@ void BKE_ptcache_update_info(PTCacheID *pid)
 			else
 				BLI_snprintf(mem_info, sizeof(mem_info), IFACE_("%i cells cached"), totpoint);
 		}
+		else if (ptcache_use_archive(pid)) {
+			PTCacheArchive *archive = ptcache_archive_get(pid);
+			float bytes = 0.0f;
+			unsigned int i;
+			int mb;
+
+			if (archive) {
+				for (i = 0; i < archive->totframe; i++) {
+					if (archive->frames[i].frame >= cache->startframe && archive->frames[i].frame <= cache->endframe)
+						totframes++;
+				}
+				bytes = (float)MAX2(archive->file_size, 0);
+			}
+
+			mb = (bytes > 1024.0f * 1024.0f);
+
+			BLI_snprintf(mem_info, sizeof(mem_info), IFACE_("%i frames on disk (%.1f %s)"),
+			             totframes,
+			             bytes / (mb ? 1024.0f * 1024.0f : 1024.0f),
+			             mb ? IFACE_("Mb") : IFACE_("kb"));
+		}
 		else {
 			int cfra = cache->startframe;
 
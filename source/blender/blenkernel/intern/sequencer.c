@@ -62,6 +62,8 @@
 
 #include "BLT_translation.h"
 
+#include "PIL_time.h"
+
 #include "BKE_animsys.h"
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
@@ -3590,12 +3592,16 @@ static ImBuf *seq_render_strip(
 	ImBuf *ibuf = NULL;
 	bool use_preprocess = false;
 	bool is_proxy_image = false;
+	bool is_cached;
 	float nr = give_stripelem_index(seq, cfra);
 	/* all effects are handled similarly with the exception of speed effect */
 	int type = (seq->type & SEQ_TYPE_EFFECT && seq->type != SEQ_TYPE_SPEED) ? SEQ_TYPE_EFFECT : seq->type;
 	bool is_preprocessed = !ELEM(type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP);
+	/* time to render the strip, so the cache frees strips that are slow to render last */
+	double start_time = PIL_check_seconds_timer();
 
 	ibuf = BKE_sequencer_cache_get(context, seq, cfra, SEQ_STRIPELEM_IBUF);
+	is_cached = (ibuf != NULL);
 
 	if (ibuf == NULL) {
 		ibuf = copy_from_ibuf_still(context, seq, nr);
@@ -3646,7 +3652,11 @@ static ImBuf *seq_render_strip(
 	if (use_preprocess)
 		ibuf = input_preprocess(context, seq, cfra, ibuf, is_proxy_image, is_preprocessed);
 
-	BKE_sequencer_cache_put(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf);
+	/* putting a cached buffer again would only reset its render time */
+	if (!is_cached || use_preprocess) {
+		BKE_sequencer_cache_put_ex(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf,
+		                           (float)(PIL_check_seconds_timer() - start_time));
+	}
 
 	return ibuf;
 }
@@ -0,0 +1,43 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GZIP_READER_H__
+#define __BLI_GZIP_READER_H__
+
+/** \file BLI_gzip_reader.h
+ *  \ingroup bli
+ *  \brief Streaming gzip decompression from memory.
+ */
+
+#include "BLI_compiler_attrs.h"
+
+typedef struct GzipMemReader GzipMemReader;
+
+GzipMemReader *BLI_gzip_mem_reader_open(
+        const void *mem, size_t mem_len) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+size_t BLI_gzip_mem_reader_read(
+        GzipMemReader *gr,
+        void *buffer, size_t buffer_len) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+bool BLI_gzip_mem_reader_has_error(
+        const GzipMemReader *gr) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+void BLI_gzip_mem_reader_close(
+        GzipMemReader *gr) ATTR_NONNULL();
+
+#endif  /* __BLI_GZIP_READER_H__ */
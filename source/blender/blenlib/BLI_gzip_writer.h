@@ -0,0 +1,44 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GZIP_WRITER_H__
+#define __BLI_GZIP_WRITER_H__
+
+/** \file BLI_gzip_writer.h
+ *  \ingroup bli
+ *  \brief Streaming gzip file writer, compressing in parallel.
+ */
+
+#include "BLI_compiler_attrs.h"
+
+struct TaskScheduler;
+
+typedef struct GzipWriter GzipWriter;
+
+GzipWriter *BLI_gzip_writer_open(
+        const char *filepath, const int level,
+        struct TaskScheduler *scheduler) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+bool BLI_gzip_writer_write(
+        GzipWriter *gw,
+        const void *data, size_t data_len) ATTR_NONNULL();
+bool BLI_gzip_writer_close(
+        GzipWriter *gw) ATTR_NONNULL();
+
+#endif  /* __BLI_GZIP_WRITER_H__ */
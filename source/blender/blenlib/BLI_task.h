@@ -40,7 +40,8 @@ struct BLI_mempool;
 /* Task Scheduler
  * 
  * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * queue holds the task from all pools. Optionally, tasks pushed from worker
+ * threads are kept in per-thread deques, from which idle workers steal.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
@@ -54,6 +55,7 @@ enum {
 };
 
 TaskScheduler *BLI_task_scheduler_create(int num_threads);
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_work_stealing);
 void BLI_task_scheduler_free(TaskScheduler *scheduler);
 
 int BLI_task_scheduler_num_threads(TaskScheduler *scheduler);
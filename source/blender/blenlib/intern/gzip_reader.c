@@ -0,0 +1,107 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/gzip_reader.c
+ *  \ingroup bli
+ *  \brief Streaming gzip decompression from memory.
+ *
+ * Handles multi-member gzip data as written by #BLI_gzip_writer_open,
+ * members following each other are decompressed as a single stream.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "zlib.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "BLI_gzip_reader.h"  /* own include */
+
+struct GzipMemReader {
+	z_stream strm;
+	bool stream_end;
+	bool error;
+};
+
+GzipMemReader *BLI_gzip_mem_reader_open(const void *mem, size_t mem_len)
+{
+	GzipMemReader *gr = MEM_callocN(sizeof(*gr), __func__);
+
+	gr->strm.next_in = (Bytef *)mem;
+	gr->strm.avail_in = (uInt)mem_len;
+	gr->strm.zalloc = Z_NULL;
+	gr->strm.zfree = Z_NULL;
+
+	/* 16 + MAX_WBITS: gzip header and trailer. */
+	if (inflateInit2(&gr->strm, 16 + MAX_WBITS) != Z_OK) {
+		MEM_freeN(gr);
+		return NULL;
+	}
+
+	return gr;
+}
+
+/**
+ * Decompress up to \a buffer_len bytes.
+ *
+ * \return The number of bytes read, less than \a buffer_len at the end of the data or on error.
+ */
+size_t BLI_gzip_mem_reader_read(GzipMemReader *gr, void *buffer, size_t buffer_len)
+{
+	gr->strm.next_out = (Bytef *)buffer;
+	gr->strm.avail_out = (uInt)buffer_len;
+
+	while (gr->strm.avail_out != 0 && !gr->stream_end && !gr->error) {
+		const int err = inflate(&gr->strm, Z_SYNC_FLUSH);
+
+		if (err == Z_STREAM_END) {
+			/* Another member follows, continue with it. Trailing bytes which
+			 * aren't a gzip member are ignored, same as gzread. */
+			if (gr->strm.avail_in >= 2 && gr->strm.next_in[0] == 0x1f && gr->strm.next_in[1] == 0x8b) {
+				if (inflateReset(&gr->strm) != Z_OK) {
+					gr->error = true;
+				}
+			}
+			else {
+				gr->stream_end = true;
+			}
+		}
+		else if (err != Z_OK) {
+			/* Includes Z_BUF_ERROR, input ended in the middle of a member. */
+			gr->error = true;
+		}
+	}
+
+	return buffer_len - gr->strm.avail_out;
+}
+
+bool BLI_gzip_mem_reader_has_error(const GzipMemReader *gr)
+{
+	return gr->error;
+}
+
+void BLI_gzip_mem_reader_close(GzipMemReader *gr)
+{
+	inflateEnd(&gr->strm);
+	MEM_freeN(gr);
+}
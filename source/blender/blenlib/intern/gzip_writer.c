@@ -0,0 +1,297 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/gzip_writer.c
+ *  \ingroup bli
+ *  \brief Streaming gzip file writer, compressing in parallel.
+ *
+ * Written data is collected in fixed size chunks, each chunk is compressed
+ * into its own gzip member by a task while the caller keeps filling the next chunk.
+ * Compressed chunks are written to the file in order, the result is a multi-member
+ * gzip file which any gzip reader (including zlib's gzread) decompresses as a single stream.
+ *
+ * The number of chunks in flight is bounded, so memory use doesn't grow with the file size.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#ifdef WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include "zlib.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BLI_gzip_writer.h"  /* own include */
+
+/* Size of uncompressed data per gzip member. */
+#define GZIP_CHUNK_SIZE (1 << 20)
+
+typedef struct GzipChunk {
+	/* uncompressed data */
+	char *data;
+	size_t data_len;
+
+	/* compressed gzip member, set once the chunk is done */
+	char *comp;
+	size_t comp_len;
+
+	bool done;
+	bool error;
+} GzipChunk;
+
+struct GzipWriter {
+	int file;
+	int level;
+	bool error;
+
+	/* NULL when compressing on the calling thread. */
+	TaskPool *pool;
+	ThreadMutex mutex;
+	ThreadCondition cond;
+
+	/* Ring buffer of chunks, the first 'chunks_used' items from 'chunk_first' are being compressed,
+	 * the one after that is being filled by the caller. */
+	GzipChunk *chunks;
+	int chunks_len;
+	int chunk_first;
+	int chunks_used;
+};
+
+static bool gzip_chunk_compress(GzipChunk *chunk, const int level)
+{
+	z_stream strm = {NULL};
+	bool ok;
+
+	/* 16 added to window bits writes a gzip header and trailer instead of a zlib one */
+	if (deflateInit2(&strm, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+
+	chunk->comp = MEM_mallocN(deflateBound(&strm, chunk->data_len), __func__);
+
+	strm.next_in = (Bytef *)chunk->data;
+	strm.avail_in = chunk->data_len;
+	strm.next_out = (Bytef *)chunk->comp;
+	strm.avail_out = deflateBound(&strm, chunk->data_len);
+
+	ok = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+	chunk->comp_len = strm.total_out;
+
+	deflateEnd(&strm);
+
+	return ok;
+}
+
+static void gzip_chunk_compress_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	GzipWriter *gw = BLI_task_pool_userdata(pool);
+	GzipChunk *chunk = taskdata;
+	const bool ok = gzip_chunk_compress(chunk, gw->level);
+
+	BLI_mutex_lock(&gw->mutex);
+	chunk->error = !ok;
+	chunk->done = true;
+	BLI_condition_notify_all(&gw->cond);
+	BLI_mutex_unlock(&gw->mutex);
+}
+
+static void gzip_chunk_write(GzipWriter *gw, GzipChunk *chunk)
+{
+	if (chunk->error) {
+		gw->error = true;
+	}
+	else if (!gw->error) {
+		const size_t len = (size_t)write(gw->file, chunk->comp, chunk->comp_len);
+		if (len != chunk->comp_len) {
+			gw->error = true;
+		}
+	}
+
+	MEM_SAFE_FREE(chunk->comp);
+	chunk->comp_len = 0;
+	chunk->data_len = 0;
+	chunk->done = false;
+	chunk->error = false;
+}
+
+/**
+ * Write compressed chunks to the file in order.
+ *
+ * \param wait: Wait for the oldest chunk to be compressed, otherwise only write the ones already done.
+ */
+static void gzip_writer_flush_done(GzipWriter *gw, const bool wait)
+{
+	while (gw->chunks_used != 0) {
+		GzipChunk *chunk = &gw->chunks[gw->chunk_first];
+
+		BLI_mutex_lock(&gw->mutex);
+		if (wait) {
+			while (!chunk->done) {
+				BLI_condition_wait(&gw->cond, &gw->mutex);
+			}
+		}
+		const bool done = chunk->done;
+		BLI_mutex_unlock(&gw->mutex);
+
+		if (!done) {
+			break;
+		}
+
+		gzip_chunk_write(gw, chunk);
+		gw->chunk_first = (gw->chunk_first + 1) % gw->chunks_len;
+		gw->chunks_used--;
+
+		/* once there is room for a new chunk there is no need to wait any longer */
+		if (wait) {
+			break;
+		}
+	}
+}
+
+/* Compress the chunk being filled, once this returns a new (empty) chunk can be filled. */
+static void gzip_writer_chunk_submit(GzipWriter *gw)
+{
+	GzipChunk *chunk = &gw->chunks[(gw->chunk_first + gw->chunks_used) % gw->chunks_len];
+
+	if (chunk->data_len == 0) {
+		return;
+	}
+
+	if (gw->pool == NULL) {
+		chunk->error = !gzip_chunk_compress(chunk, gw->level);
+		gzip_chunk_write(gw, chunk);
+		return;
+	}
+
+	gw->chunks_used++;
+	BLI_task_pool_push(gw->pool, gzip_chunk_compress_task, chunk, false, TASK_PRIORITY_HIGH);
+
+	/* write out whatever finished meanwhile, and make room for the next chunk */
+	gzip_writer_flush_done(gw, false);
+	if (gw->chunks_used == gw->chunks_len) {
+		gzip_writer_flush_done(gw, true);
+	}
+}
+
+/**
+ * Open a file for writing gzip compressed data.
+ *
+ * \param level: zlib compression level.
+ * \param scheduler: Scheduler used to compress chunks in parallel,
+ * when NULL all compression happens on the calling thread.
+ */
+GzipWriter *BLI_gzip_writer_open(const char *filepath, const int level, TaskScheduler *scheduler)
+{
+	GzipWriter *gw;
+	const int file = BLI_open(filepath, O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	gw = MEM_callocN(sizeof(*gw), __func__);
+	gw->file = file;
+	gw->level = level;
+
+	if (scheduler && BLI_task_scheduler_num_threads(scheduler) > 1) {
+		/* enough chunks to keep all threads busy while the caller fills the next one */
+		gw->chunks_len = BLI_task_scheduler_num_threads(scheduler) * 2 + 1;
+		gw->pool = BLI_task_pool_create(scheduler, gw);
+		BLI_mutex_init(&gw->mutex);
+		BLI_condition_init(&gw->cond);
+	}
+	else {
+		gw->chunks_len = 1;
+	}
+
+	gw->chunks = MEM_callocN(sizeof(*gw->chunks) * gw->chunks_len, __func__);
+	for (int i = 0; i < gw->chunks_len; i++) {
+		gw->chunks[i].data = MEM_mallocN(GZIP_CHUNK_SIZE, __func__);
+	}
+
+	return gw;
+}
+
+/**
+ * \return false on error, once an error happens any further writes are ignored.
+ */
+bool BLI_gzip_writer_write(GzipWriter *gw, const void *data, size_t data_len)
+{
+	const char *src = data;
+
+	while (data_len != 0 && !gw->error) {
+		GzipChunk *chunk = &gw->chunks[(gw->chunk_first + gw->chunks_used) % gw->chunks_len];
+		const size_t len = MIN2(data_len, GZIP_CHUNK_SIZE - chunk->data_len);
+
+		memcpy(chunk->data + chunk->data_len, src, len);
+		chunk->data_len += len;
+		src += len;
+		data_len -= len;
+
+		if (chunk->data_len == GZIP_CHUNK_SIZE) {
+			gzip_writer_chunk_submit(gw);
+		}
+	}
+
+	return !gw->error;
+}
+
+/**
+ * Compress remaining data and close the file, \a gw is freed.
+ *
+ * \return false if any write failed.
+ */
+bool BLI_gzip_writer_close(GzipWriter *gw)
+{
+	bool ok;
+
+	gzip_writer_chunk_submit(gw);
+
+	if (gw->pool) {
+		BLI_task_pool_work_and_wait(gw->pool);
+		while (gw->chunks_used != 0) {
+			gzip_writer_flush_done(gw, true);
+		}
+		BLI_task_pool_free(gw->pool);
+		BLI_condition_end(&gw->cond);
+		BLI_mutex_end(&gw->mutex);
+	}
+
+	ok = (close(gw->file) != -1) && !gw->error;
+
+	for (int i = 0; i < gw->chunks_len; i++) {
+		MEM_freeN(gw->chunks[i].data);
+	}
+	MEM_freeN(gw->chunks);
+	MEM_freeN(gw);
+
+	return ok;
+}
@@ -62,6 +62,14 @@
  */
 #define DELAYED_QUEUE_SIZE 4096
 
+/* Number of tasks which fit into a per-worker work-stealing deque.
+ *
+ * Must be power of two. When the deque is full tasks are pushed to the
+ * global scheduler's queue.
+ */
+#define STEAL_DEQUE_SIZE 1024
+#define STEAL_DEQUE_MASK (STEAL_DEQUE_SIZE - 1)
+
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id)                              \
 	do {                                                                      \
@@ -92,6 +100,31 @@ typedef struct Task {
 	TaskPool *pool;
 } Task;
 
+/* Work-stealing deque of a worker thread.
+ *
+ * This is a bounded version of the Chase-Lev deque: owner thread pushes and
+ * pops tasks at the bottom without any locks, other threads are stealing tasks
+ * from the top using a single CAS.
+ *
+ * Pool pointer is stored next to the task so thieves can check whether task
+ * belongs to a pool they are interested in without touching task memory which
+ * might have been freed already by the time the steal is validated.
+ */
+typedef struct TaskDequeItem {
+	Task *task;
+	TaskPool *pool;
+} TaskDequeItem;
+
+typedef struct TaskDeque {
+	/* Index of the next task to be stolen. Modified by thieves and by the owner
+	 * when it pops the last task.
+	 */
+	int64_t top;
+	/* Index of the next free slot. Only modified by the owner thread. */
+	int64_t bottom;
+	TaskDequeItem items[STEAL_DEQUE_SIZE];
+} TaskDeque;
+
 /* This is a per-thread storage of pre-allocated tasks.
  *
  * The idea behind this is simple: reduce amount of malloc() calls when pushing
@@ -216,6 +249,18 @@ struct TaskScheduler {
 
 	volatile bool do_exit;
 
+	/* Worker threads have their own lock-free deques, tasks pushed from worker
+	 * threads go there and idle workers steal from random victims. Global queue
+	 * is then only used for pushes from non-worker threads.
+	 */
+	bool use_work_stealing;
+	/* Number of tasks in all the workers' deques. */
+	uint32_t num_deque_tasks;
+	/* Number of worker threads which are going to sleep or are sleeping on
+	 * queue_cond. Used to avoid locking queue_mutex on every deque push.
+	 */
+	uint32_t num_sleeping_threads;
+
 	/* NOTE: In pthread's TLS we store the whole TaskThread structure. */
 	pthread_key_t tls_id_key;
 };
@@ -224,6 +269,10 @@ typedef struct TaskThread {
 	TaskScheduler *scheduler;
 	int id;
 	TaskThreadLocalStorage tls;
+	/* Only allocated for worker threads when scheduler uses work stealing. */
+	TaskDeque *deque;
+	/* State of random number generator used to pick victim to steal from. */
+	uint32_t steal_seed;
 } TaskThread;
 
 /* Helper */
@@ -352,10 +401,207 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Work-stealing deque.
+ *
+ * NOTE: Atomic read-modify-write operations are used where memory barriers
+ * are required, since they imply a full barrier on all supported platforms.
+ */
+
+BLI_INLINE int64_t task_deque_read_index(int64_t *index)
+{
+	return *((volatile int64_t *)index);
+}
+
+/* Only to be called from the deque owner thread. */
+BLI_INLINE bool task_deque_is_full(TaskDeque *deque)
+{
+	return (deque->bottom - task_deque_read_index(&deque->top)) >= STEAL_DEQUE_SIZE;
+}
+
+/* Only to be called from the deque owner thread, after checking the deque is
+ * not full. Thieves can only free slots, so push can not fail then.
+ */
+static void task_deque_push(TaskDeque *deque, Task *task)
+{
+	TaskDequeItem *item = &deque->items[deque->bottom & STEAL_DEQUE_MASK];
+	BLI_assert(!task_deque_is_full(deque));
+	item->task = task;
+	item->pool = task->pool;
+	/* Make sure item is visible to thieves before they see new bottom. */
+	atomic_add_and_fetch_int64(&deque->bottom, 1);
+}
+
+/* Only to be called from the deque owner thread.
+ *
+ * If pool is not NULL, the newest task is only popped if it belongs to that
+ * pool.
+ */
+static Task *task_deque_pop(TaskDeque *deque, TaskPool *pool)
+{
+	int64_t bottom = deque->bottom;
+	int64_t top = task_deque_read_index(&deque->top);
+	Task *task = NULL;
+	if (top >= bottom) {
+		return NULL;
+	}
+	if (pool != NULL && deque->items[(bottom - 1) & STEAL_DEQUE_MASK].pool != pool) {
+		return NULL;
+	}
+	bottom = atomic_sub_and_fetch_int64(&deque->bottom, 1);
+	top = task_deque_read_index(&deque->top);
+	if (top < bottom) {
+		/* There are more tasks left, no conflict with thieves possible. */
+		return deque->items[bottom & STEAL_DEQUE_MASK].task;
+	}
+	if (top == bottom) {
+		/* Last task in the deque, race against thieves for it. */
+		if (atomic_cas_int64(&deque->top, top, top + 1) == top) {
+			task = deque->items[bottom & STEAL_DEQUE_MASK].task;
+		}
+	}
+	/* Deque is empty now, restore canonical state where top == bottom. */
+	atomic_add_and_fetch_int64(&deque->bottom, 1);
+	return task;
+}
+
+/* Can be called from any thread.
+ *
+ * If pool is not NULL, the oldest task is only stolen if it belongs to that
+ * pool.
+ */
+static Task *task_deque_steal(TaskDeque *deque, TaskPool *pool)
+{
+	int64_t top, bottom;
+	TaskDequeItem item;
+	/* Cheap check first, so idle threads do not hammer cache lines of all the
+	 * deques with atomic operations.
+	 */
+	if (task_deque_read_index(&deque->top) >= task_deque_read_index(&deque->bottom)) {
+		return NULL;
+	}
+	top = atomic_fetch_and_add_int64(&deque->top, 0);
+	bottom = atomic_fetch_and_add_int64(&deque->bottom, 0);
+	if (top >= bottom) {
+		return NULL;
+	}
+	item = deque->items[top & STEAL_DEQUE_MASK];
+	if (pool != NULL && item.pool != pool) {
+		return NULL;
+	}
+	if (atomic_cas_int64(&deque->top, top, top + 1) != top) {
+		/* Lost the race against owner or another thief. */
+		return NULL;
+	}
+	return item.task;
+}
+
+BLI_INLINE uint32_t task_thread_steal_rand(TaskThread *thread)
+{
+	/* Xorshift, good enough for victim selection. */
+	uint32_t x = thread->steal_seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	thread->steal_seed = x;
+	return x;
+}
+
+/* Steal a task from other workers' deques, starting from a random victim.
+ *
+ * thread is NULL when called from non-worker thread.
+ */
+static Task *task_scheduler_steal(TaskScheduler *scheduler,
+                                  TaskThread *thread,
+                                  TaskPool *pool)
+{
+	const int num_threads = scheduler->num_threads;
+	int victim;
+	if (*((volatile uint32_t *)&scheduler->num_deque_tasks) == 0) {
+		return NULL;
+	}
+	victim = (thread != NULL) ? (int)(task_thread_steal_rand(thread) % num_threads) : 0;
+	for (int i = 0; i < num_threads; i++, victim = (victim + 1) % num_threads) {
+		TaskThread *victim_thread = &scheduler->task_threads[victim + 1];
+		Task *task;
+		if (victim_thread == thread) {
+			continue;
+		}
+		task = task_deque_steal(victim_thread->deque, pool);
+		if (task != NULL) {
+			atomic_sub_and_fetch_uint32(&scheduler->num_deque_tasks, 1);
+			return task;
+		}
+	}
+	return NULL;
+}
+
+/* Get task from the worker's own deque, or steal one from other workers. */
+static Task *task_scheduler_thread_local_pop(TaskScheduler *scheduler,
+                                             TaskThread *thread,
+                                             TaskPool *pool)
+{
+	Task *task = task_deque_pop(thread->deque, pool);
+	if (task != NULL) {
+		atomic_sub_and_fetch_uint32(&scheduler->num_deque_tasks, 1);
+		return task;
+	}
+	return task_scheduler_steal(scheduler, thread, pool);
+}
+
+static bool task_scheduler_thread_push(TaskScheduler *scheduler,
+                                       TaskThread *thread,
+                                       Task *task)
+{
+	if (task_deque_is_full(thread->deque)) {
+		return false;
+	}
+	/* Pool counter is to be increased before task becomes visible to thieves,
+	 * otherwise it might be decreased by them first.
+	 */
+	task_pool_num_increase(task->pool, 1);
+	task_deque_push(thread->deque, task);
+	atomic_add_and_fetch_uint32(&scheduler->num_deque_tasks, 1);
+	/* Wake up a sleeping worker, if any. The atomic increment above acts as a
+	 * barrier, pairs with the one in task_scheduler_thread_wait_pop().
+	 */
+	if (*((volatile uint32_t *)&scheduler->num_sleeping_threads) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+	return true;
+}
+
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, TaskThread *thread, Task **task)
 {
 	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
+
+	if (scheduler->use_work_stealing) {
+		while (true) {
+			*task = task_scheduler_thread_local_pop(scheduler, thread, NULL);
+			if (*task != NULL) {
+				return true;
+			}
+			BLI_mutex_lock(&scheduler->queue_mutex);
+			if (scheduler->queue.first || scheduler->do_exit) {
+				/* Fall back to the global queue. */
+				break;
+			}
+			/* Go to sleep unless some tasks were pushed to deques in the
+			 * meantime. Increment acts as a barrier, pairs with the one in
+			 * task_scheduler_thread_push().
+			 */
+			atomic_add_and_fetch_uint32(&scheduler->num_sleeping_threads, 1);
+			if (*((volatile uint32_t *)&scheduler->num_deque_tasks) == 0) {
+				BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+			}
+			atomic_sub_and_fetch_uint32(&scheduler->num_sleeping_threads, 1);
+			BLI_mutex_unlock(&scheduler->queue_mutex);
+		}
+	}
+	else {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+	}
 
 	while (!scheduler->queue.first && !scheduler->do_exit)
 		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
@@ -433,7 +679,7 @@ static void *task_scheduler_thread_run(void *thread_p)
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+	while (task_scheduler_thread_wait_pop(scheduler, thread, &task)) {
 		TaskPool *pool = task->pool;
 
 		/* run task */
@@ -455,6 +701,19 @@ static void *task_scheduler_thread_run(void *thread_p)
 }
 
 TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	return BLI_task_scheduler_create_ex(num_threads, true);
+}
+
+/**
+ * Create task scheduler.
+ *
+ * \param use_work_stealing: When true tasks pushed from worker threads are put
+ * into lock-free per-worker deques and idle workers steal tasks from each other,
+ * avoiding contention on the global queue lock. Ignored when there is only one
+ * worker thread.
+ */
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_work_stealing)
 {
 	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
 
@@ -480,11 +739,15 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		num_threads = 1;
 	}
 
+	/* Stealing between workers only makes sense when there are some. */
+	scheduler->use_work_stealing = use_work_stealing && num_threads > 1;
+
 	scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
 	                                      "TaskScheduler task threads");
 
 	/* Initialize TLS for main thread. */
 	initialize_task_tls(&scheduler->task_threads[0].tls);
+	scheduler->task_threads[0].deque = NULL;
 
 	pthread_key_create(&scheduler->tls_id_key, NULL);
 
@@ -500,6 +763,11 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 			thread->scheduler = scheduler;
 			thread->id = i + 1;
 			initialize_task_tls(&thread->tls);
+			thread->deque = NULL;
+			thread->steal_seed = (uint32_t)(i + 1) * 2654435761u;
+			if (scheduler->use_work_stealing) {
+				thread->deque = MEM_callocN(sizeof(TaskDeque), "TaskScheduler deque");
+			}
 
 			if (pthread_create(&scheduler->threads[i], NULL, task_scheduler_thread_run, thread) != 0) {
 				fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
@@ -539,6 +807,13 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 		for (int i = 0; i < scheduler->num_threads + 1; ++i) {
 			TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
 			free_task_tls(tls);
+			if (scheduler->task_threads[i].deque != NULL) {
+				/* Tasks can not be left in deques: worker threads only exit
+				 * when they run out of work and pools can not be freed until
+				 * all their tasks are done.
+				 */
+				MEM_freeN(scheduler->task_threads[i].deque);
+			}
 		}
 
 		MEM_freeN(scheduler->task_threads);
@@ -771,6 +1046,18 @@ BLI_INLINE bool task_can_use_local_queues(TaskPool *pool, int thread_id)
 	return (thread_id != -1 && (thread_id != pool->thread_id || pool->do_work));
 }
 
+/* Worker thread from which task can be pushed to a work-stealing deque,
+ * NULL for non-worker threads.
+ */
+BLI_INLINE TaskThread *task_pool_steal_thread(TaskPool *pool, int thread_id)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	if (!scheduler->use_work_stealing || thread_id <= 0) {
+		return NULL;
+	}
+	return &scheduler->task_threads[thread_id];
+}
+
 static void task_pool_push(
         TaskPool *pool, TaskRunFunction run, void *taskdata,
         bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority,
@@ -806,6 +1093,13 @@ static void task_pool_push(
 			tls->num_local_queue++;
 			return;
 		}
+		/* Push to worker's own deque, without any locks. There is no need
+		 * in delayed push then, other workers will steal from the deque.
+		 */
+		TaskThread *thread = task_pool_steal_thread(pool, thread_id);
+		if (thread != NULL && task_scheduler_thread_push(pool->scheduler, thread, task)) {
+			return;
+		}
 		/* If we are in the delayed tasks push mode, we push tasks to a
 		 * temporary local queue first without any locks, and then move them
 		 * to global execution queue with a single lock.
@@ -870,21 +1164,37 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 		BLI_mutex_unlock(&pool->num_mutex);
 
-		BLI_mutex_lock(&scheduler->queue_mutex);
+		/* Tasks of this pool might be in the workers' deques, only take the
+		 * ones from this pool there as well.
+		 */
+		if (scheduler->use_work_stealing) {
+			TaskThread *thread = task_pool_steal_thread(pool, pool->thread_id);
+			if (thread != NULL) {
+				work_task = task_scheduler_thread_local_pop(scheduler, thread, pool);
+			}
+			else {
+				work_task = task_scheduler_steal(scheduler, NULL, pool);
+			}
+			found_task = (work_task != NULL);
+		}
 
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
+		if (!found_task) {
+			BLI_mutex_lock(&scheduler->queue_mutex);
 
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
+			/* find task from this pool. if we get a task from another pool,
+			 * we can get into deadlock */
+
+			for (task = scheduler->queue.first; task; task = task->next) {
+				if (task->pool == pool) {
+					work_task = task;
+					found_task = true;
+					BLI_remlink(&scheduler->queue, task);
+					break;
+				}
 			}
-		}
 
-		BLI_mutex_unlock(&scheduler->queue_mutex);
+			BLI_mutex_unlock(&scheduler->queue_mutex);
+		}
 
 		/* if found task, do it, otherwise wait until other tasks are done */
 		if (found_task) {
@@ -894,7 +1204,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_assert(!tls->do_delayed_push);
 
 			/* delete task */
-			task_free(pool, task, pool->thread_id);
+			task_free(pool, work_task, pool->thread_id);
 
 			/* Handle all tasks from local queue. */
 			handle_local_queue(tls, pool->thread_id);
@@ -37,13 +37,16 @@ typedef struct {
 	void *next, *prev;
 	
 	char *buf;
+	/* ident: buffer is shared with another chunk (not new in this memfile) */
 	unsigned int ident, size;
-	
+
+	/* reference counted buffer, 'buf' points to its data */
+	struct MemFileSharedBuf *shared;
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
-	unsigned int size;
+	unsigned int size;  /* size of buffers added by this memfile */
 } MemFile;
 
 /* actually only used writefile.c */
@@ -52,6 +55,7 @@ extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *bu
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern size_t BLO_memfile_shared_size_get(void);
 
 #endif
 
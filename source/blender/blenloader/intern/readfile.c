@@ -45,6 +45,7 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -105,10 +106,14 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_endian_switch.h"
+#include "BLI_gzip_reader.h"
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+
+#include "PIL_time.h"
 
 #include "BLT_translation.h"
 
@@ -219,6 +224,18 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Use hash index for OldNewMap lookups which miss lasthit */
+#define USE_OLDNEWMAP_HASH
+
+/* Memory map uncompressed files, blocks are then used directly from the mapping
+ * when the file has native endianness and pointer size.
+ * NOTE: blocks are only 4 byte aligned in the file (header is 12 bytes), BHeads are
+ * copied out of the mapping and block data is realigned before reconstruction,
+ * the remaining in-place reads still rely on platforms handling unaligned access. */
+#if !defined(WIN32) && (defined(__x86_64__) || defined(__i386__) || defined(__aarch64__))
+#  define USE_MMAP_READ
+#endif
+
 /***/
 
 typedef struct OldNew {
@@ -232,6 +249,13 @@ typedef struct OldNewMap {
 	int nentries, entriessize;
 	bool sorted;
 	int lasthit;
+#ifdef USE_OLDNEWMAP_HASH
+	/* Open addressing hash of entry indices by old address (-1 for empty slots),
+	 * built lazily on the first lookup which misses lasthit, NULL until then. */
+	int *map;
+	/* Number of map slots is (1 << map_size_exp). */
+	int map_size_exp;
+#endif
 } OldNewMap;
 
 
@@ -294,11 +318,84 @@ static int verg_oldnewmap(const void *v1, const void *v2)
 }
 
 
+#ifdef USE_OLDNEWMAP_HASH
+
+/* Maps with less entries than this are always searched linearly. */
+#define OLDNEWMAP_HASH_MIN_ENTRIES 64
+
+BLI_INLINE unsigned int oldnewmap_hash_slot(const OldNewMap *onm, const void *addr)
+{
+	/* Fibonacci hashing, old addresses are aligned so low bits are useless. */
+	const uint64_t key = (uint64_t)(uintptr_t)addr * 0x9E3779B97F4A7C15ull;
+	return (unsigned int)(key >> (64 - onm->map_size_exp));
+}
+
+static void oldnewmap_hash_insert_index(OldNewMap *onm, const int index)
+{
+	const unsigned int mask = (1u << onm->map_size_exp) - 1;
+	const void *addr = onm->entries[index].old;
+	unsigned int slot = oldnewmap_hash_slot(onm, addr);
+
+	while (onm->map[slot] != -1) {
+		if (onm->entries[onm->map[slot]].old == addr) {
+			/* Keep most recent entry, same as a full backwards search would find. */
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	onm->map[slot] = index;
+}
+
+/* (Re)build the index with enough slots to keep load factor under 0.5. */
+static void oldnewmap_hash_build(OldNewMap *onm)
+{
+	int size_exp = 8;
+	while ((1 << size_exp) < onm->nentries * 2) {
+		size_exp++;
+	}
+
+	MEM_SAFE_FREE(onm->map);
+	onm->map_size_exp = size_exp;
+	onm->map = MEM_mallocN(sizeof(*onm->map) << size_exp, "OldNewMap.map");
+	memset(onm->map, -1, sizeof(*onm->map) << size_exp);
+
+	for (int i = 0; i < onm->nentries; i++) {
+		oldnewmap_hash_insert_index(onm, i);
+	}
+}
+
+static void oldnewmap_hash_clear(OldNewMap *onm)
+{
+	MEM_SAFE_FREE(onm->map);
+	onm->map_size_exp = 0;
+}
+
+static int oldnewmap_hash_lookup(const OldNewMap *onm, const void *addr)
+{
+	const unsigned int mask = (1u << onm->map_size_exp) - 1;
+	unsigned int slot = oldnewmap_hash_slot(onm, addr);
+	int index;
+
+	while ((index = onm->map[slot]) != -1) {
+		if (onm->entries[index].old == addr) {
+			return index;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+#endif  /* USE_OLDNEWMAP_HASH */
+
 static void oldnewmap_sort(FileData *fd) 
 {
 	BLI_assert(fd->libmap->sorted == false);
 	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
 	fd->libmap->sorted = 1;
+#ifdef USE_OLDNEWMAP_HASH
+	/* Indices are invalid now, sorted map uses binary search anyway. */
+	oldnewmap_hash_clear(fd->libmap);
+#endif
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -317,6 +414,18 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+#ifdef USE_OLDNEWMAP_HASH
+	/* Keep the index up to date once it exists. */
+	if (onm->map) {
+		if (UNLIKELY(onm->nentries * 2 > (1 << onm->map_size_exp))) {
+			oldnewmap_hash_build(onm);
+		}
+		else {
+			oldnewmap_hash_insert_index(onm, onm->nentries - 1);
+		}
+	}
+#endif
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -330,18 +439,26 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
  * \param lasthit: Use as a reference position to avoid a full search
  * from either end of the array, giving more efficient lookups.
  *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
+ * \note The data is written in-order, using the \a lasthit will normally avoid calling this function.
+ * Creating a hash structure upfront adds overhead for the common-case to optimize the corner-case
+ * (since most entries will never be retrieved), so with #USE_OLDNEWMAP_HASH the index is only built
+ * on the first call, which is when lookups start to happen out of order (heavy linking for example).
  */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static int oldnewmap_lookup_entry_full(OldNewMap *onm, const void *addr, int lasthit)
 {
 	const int nentries = onm->nentries;
 	const OldNew *entries = onm->entries;
 	int i;
 
+#ifdef USE_OLDNEWMAP_HASH
+	if (nentries >= OLDNEWMAP_HASH_MIN_ENTRIES) {
+		if (onm->map == NULL) {
+			oldnewmap_hash_build(onm);
+		}
+		return oldnewmap_hash_lookup(onm, addr);
+	}
+#endif
+
 	/* search relative to lasthit where possible */
 	if (lasthit >= 0 && lasthit < nentries) {
 
@@ -455,10 +572,16 @@ static void oldnewmap_clear(OldNewMap *onm)
 {
 	onm->nentries = 0;
 	onm->lasthit = 0;
+#ifdef USE_OLDNEWMAP_HASH
+	oldnewmap_hash_clear(onm);
+#endif
 }
 
 static void oldnewmap_free(OldNewMap *onm) 
 {
+#ifdef USE_OLDNEWMAP_HASH
+	oldnewmap_hash_clear(onm);
+#endif
 	MEM_freeN(onm->entries);
 	MEM_freeN(onm);
 }
@@ -818,10 +941,71 @@ static BHeadN *get_bhead(FileData *fd)
 	return(new_bhead);
 }
 
+#ifdef USE_MMAP_READ
+
+/**
+ * Index all blocks of a memory mapped file, so block data is used straight
+ * from the mapping instead of being read into BHeadN's.
+ *
+ * BHeads in the file are not aligned (the file header is 12 bytes), so they are
+ * copied into the index, only the data following them stays in the mapping.
+ * Only possible when BHeads in the file are the same as in memory, otherwise
+ * the regular reading from mapping (#fd_read_from_mmap) is used.
+ */
+static void mmap_bhead_index_build(FileData *fd)
+{
+	size_t offset = fd->mmap_seek;
+	int tot_alloc = 1024;
+
+	if (fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS)) {
+		return;
+	}
+
+	fd->mmap_bheads = MEM_mallocN(sizeof(*fd->mmap_bheads) * tot_alloc, __func__);
+	fd->mmap_bhead_data = MEM_mallocN(sizeof(*fd->mmap_bhead_data) * tot_alloc, __func__);
+	fd->mmap_tot_bheads = 0;
+
+	while (offset + sizeof(BHead) <= fd->mmap_size) {
+		BHead bhead;
+
+		memcpy(&bhead, POINTER_OFFSET(fd->mmap_mem, offset), sizeof(bhead));
+
+		/* Same as get_bhead(), stop on bad or truncated blocks. */
+		if (bhead.len < 0 || (size_t)bhead.len > fd->mmap_size - offset - sizeof(BHead)) {
+			break;
+		}
+
+		if (UNLIKELY(fd->mmap_tot_bheads == tot_alloc)) {
+			tot_alloc *= 2;
+			fd->mmap_bheads = MEM_reallocN(fd->mmap_bheads, sizeof(*fd->mmap_bheads) * tot_alloc);
+			fd->mmap_bhead_data = MEM_reallocN(fd->mmap_bhead_data, sizeof(*fd->mmap_bhead_data) * tot_alloc);
+		}
+		fd->mmap_bheads[fd->mmap_tot_bheads] = bhead;
+		fd->mmap_bhead_data[fd->mmap_tot_bheads] = POINTER_OFFSET(fd->mmap_mem, offset + sizeof(BHead));
+		fd->mmap_tot_bheads++;
+
+		offset += sizeof(BHead) + bhead.len;
+
+		if (bhead.code == ENDB) {
+			break;
+		}
+	}
+
+	fd->mmap_seek = offset;
+}
+
+#endif  /* USE_MMAP_READ */
+
 BHead *blo_firstbhead(FileData *fd)
 {
 	BHeadN *new_bhead;
 	BHead *bhead = NULL;
+
+#ifdef USE_MMAP_READ
+	if (fd->mmap_bheads) {
+		return (fd->mmap_tot_bheads != 0) ? &fd->mmap_bheads[0] : NULL;
+	}
+#endif
 	
 	/* Rewind the file
 	 * Read in a new block if necessary
@@ -838,10 +1022,21 @@ BHead *blo_firstbhead(FileData *fd)
 	return(bhead);
 }
 
-BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
+BHead *blo_prevbhead(FileData *fd, BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
-	BHeadN *prev = bheadn->prev;
+	BHeadN *bheadn, *prev;
+
+#ifdef USE_MMAP_READ
+	if (fd->mmap_bheads) {
+		BLI_assert(thisblock >= fd->mmap_bheads && thisblock < fd->mmap_bheads + fd->mmap_tot_bheads);
+		return (thisblock != fd->mmap_bheads) ? thisblock - 1 : NULL;
+	}
+#else
+	UNUSED_VARS(fd);
+#endif
+
+	bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+	prev = bheadn->prev;
 	
 	return (prev) ? &prev->bhead : NULL;
 }
@@ -850,6 +1045,16 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 {
 	BHeadN *new_bhead = NULL;
 	BHead *bhead = NULL;
+
+#ifdef USE_MMAP_READ
+	if (fd->mmap_bheads) {
+		/* all blocks were validated by mmap_bhead_index_build() */
+		if (thisblock == NULL || thisblock == &fd->mmap_bheads[fd->mmap_tot_bheads - 1]) {
+			return NULL;
+		}
+		return thisblock + 1;
+	}
+#endif
 	
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
@@ -872,10 +1077,23 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	return(bhead);
 }
 
+/* Data of the block, following the BHead in the file. */
+void *blo_bhead_data(const FileData *fd, const BHead *bhead)
+{
+#ifdef USE_MMAP_READ
+	if (fd->mmap_bheads) {
+		return (void *)fd->mmap_bhead_data[bhead - fd->mmap_bheads];
+	}
+#else
+	UNUSED_VARS(fd);
+#endif
+	return (void *)(bhead + 1);
+}
+
 /* Warning! Caller's responsibility to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(blo_bhead_data(fd, bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -929,10 +1147,12 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
 			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			fd->filesdna = DNA_sdna_from_data(
+			        blo_bhead_data(fd, bhead), bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-				/* used to retrieve ID names from (bhead+1) */
+				fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
+				/* used to retrieve ID names from the data of ID blocks */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
 				return true;
@@ -958,7 +1178,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = blo_bhead_data(fd, bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1024,6 +1244,19 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+#ifdef USE_MMAP_READ
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the mapping */
+	const size_t readsize = MIN2((size_t)size, filedata->mmap_size - filedata->mmap_seek);
+
+	memcpy(buffer, (const char *)filedata->mmap_mem + filedata->mmap_seek, readsize);
+	filedata->mmap_seek += readsize;
+
+	return (int)readsize;
+}
+#endif
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -1105,6 +1338,11 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	
 	if (fd->flags & FD_FLAGS_FILE_OK) {
 		const char *error_message = NULL;
+#ifdef USE_MMAP_READ
+		if (fd->mmap_mem) {
+			mmap_bhead_index_build(fd);
+		}
+#endif
 		if (read_file_dna(fd, &error_message) == false) {
 			BKE_reportf(reports, RPT_ERROR,
 			            "Failed to read blend file '%s': %s",
@@ -1122,11 +1360,71 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+#ifdef USE_MMAP_READ
+/**
+ * Memory map an uncompressed file, avoiding a read() call and a copy for every block.
+ *
+ * \return NULL for compressed files or when mapping failed, regular reading is used then.
+ */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
+{
+	FileData *fd;
+	unsigned char magic[2];
+	size_t size;
+	void *mem;
+	int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	/* gzip files go through gzread */
+	size = BLI_file_descriptor_size(file);
+	if (size < SIZEOFBLENDERHEADER || size == (size_t)-1 ||
+	    read(file, magic, sizeof(magic)) != sizeof(magic) ||
+	    (magic[0] == 0x1f && magic[1] == 0x8b))
+	{
+		close(file);
+		return NULL;
+	}
+
+	/* Private writable mapping, some blocks are patched in place while reading
+	 * (pages are then copied on write, the file is never modified). */
+	mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	/* Mapping stays valid after closing the file. */
+	close(file);
+
+	if (mem == MAP_FAILED) {
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->mmap_mem = mem;
+	fd->mmap_size = size;
+	fd->read = fd_read_from_mmap;
+
+	return fd;
+}
+#endif
+
 /* cannot be called with relative paths anymore! */
 /* on each new library added, it now checks for the current FileData and expands relativeness */
 FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 {
 	gzFile gzfile;
+
+#ifdef USE_MMAP_READ
+	{
+		FileData *fd = blo_openblenderfile_mmap(filepath);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+	}
+#endif
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1176,37 +1474,23 @@ static FileData *blo_openblenderfile_minimal(const char *filepath)
 
 static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
-	int err;
-
-	filedata->strm.next_out = (Bytef *) buffer;
-	filedata->strm.avail_out = size;
-
-	// Inflate another chunk.
-	err = inflate (&filedata->strm, Z_SYNC_FLUSH);
+	/* Continues over gzip members, compressed files are written as several of them. */
+	const int readsize = (int)BLI_gzip_mem_reader_read(filedata->gzip_mem_reader, buffer, size);
 
-	if (err == Z_STREAM_END) {
-		return 0;
-	}
-	else if (err != Z_OK) {
+	if (BLI_gzip_mem_reader_has_error(filedata->gzip_mem_reader)) {
 		printf("fd_read_gzip_from_memory: zlib error\n");
 		return 0;
 	}
 
-	filedata->seek += size;
+	filedata->seek += readsize;
 
-	return (size);
+	return readsize;
 }
 
 static int fd_read_gzip_from_memory_init(FileData *fd)
 {
-
-	fd->strm.next_in = (Bytef *) fd->buffer;
-	fd->strm.avail_in = fd->buffersize;
-	fd->strm.total_out = 0;
-	fd->strm.zalloc = Z_NULL;
-	fd->strm.zfree = Z_NULL;
-	
-	if (inflateInit2(&fd->strm, (16+MAX_WBITS)) != Z_OK)
+	fd->gzip_mem_reader = BLI_gzip_mem_reader_open(fd->buffer, (size_t)fd->buffersize);
+	if (fd->gzip_mem_reader == NULL)
 		return 0;
 
 	fd->read = fd_read_gzip_from_memory;
@@ -1272,10 +1556,8 @@ void blo_freefiledata(FileData *fd)
 			gzclose(fd->gzfiledes);
 		}
 		
-		if (fd->strm.next_in) {
-			if (inflateEnd(&fd->strm) != Z_OK) {
-				printf("close gzip stream error\n");
-			}
+		if (fd->gzip_mem_reader) {
+			BLI_gzip_mem_reader_close(fd->gzip_mem_reader);
 		}
 		
 		if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
@@ -1286,6 +1568,20 @@ void blo_freefiledata(FileData *fd)
 		// Free all BHeadN data blocks
 		BLI_freelistN(&fd->listbase);
 
+#ifdef USE_MMAP_READ
+		if (fd->mmap_mem) {
+			if (munmap(fd->mmap_mem, fd->mmap_size) != 0) {
+				BKE_reportf(fd->reports, RPT_WARNING, "Unable to unmap '%s': %s", fd->relabase, strerror(errno));
+			}
+		}
+		if (fd->mmap_bheads) {
+			MEM_freeN(fd->mmap_bheads);
+			MEM_freeN(fd->mmap_bhead_data);
+		}
+#endif
+
+		if (fd->reconstruct_info)
+			DNA_reconstruct_info_free(fd->reconstruct_info);
 		if (fd->filesdna)
 			DNA_sdna_free(fd->filesdna);
 		if (fd->compflags)
@@ -1858,12 +2154,13 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 /* ********** END OLD POINTERS ****************** */
 /* ********** READ FILE ****************** */
 
-static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
+static void switch_endian_structs(FileData *fd, BHead *bhead)
 {
+	const struct SDNA *filesdna = fd->filesdna;
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = blo_bhead_data(fd, bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1874,6 +2171,66 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	}
 }
 
+/* Blocks holding many structs which need converting (typically mesh and particle data
+ * from older files) are split into chunks which are reconstructed in parallel. */
+#define RECONSTRUCT_CHUNK_SIZE 1024
+
+typedef struct ReconstructChunkData {
+	const struct DNA_ReconstructInfo *reconstruct_info;
+	int SDNAnr;
+	int blocks;
+	const void *data;
+	void *cur;
+} ReconstructChunkData;
+
+static void read_struct_reconstruct_chunk(void *userdata, const int chunk)
+{
+	ReconstructChunkData *data = userdata;
+	const int block_start = chunk * RECONSTRUCT_CHUNK_SIZE;
+	const int block_end = min_ii(block_start + RECONSTRUCT_CHUNK_SIZE, data->blocks);
+
+	DNA_struct_reconstruct_range(data->reconstruct_info, data->SDNAnr, block_start, block_end, data->data, data->cur);
+}
+
+static void *read_struct_reconstruct(FileData *fd, BHead *bh, const char *blockname)
+{
+	const int curlen = DNA_struct_reconstruct_size(fd->reconstruct_info, bh->SDNAnr);
+	const int num_chunks = (bh->nr + RECONSTRUCT_CHUNK_SIZE - 1) / RECONSTRUCT_CHUNK_SIZE;
+	const void *olddata = blo_bhead_data(fd, bh);
+	void *olddata_aligned = NULL;
+	ReconstructChunkData data;
+
+	/* Reconstruction reads members of the old structs in place, data from a
+	 * memory mapped file is only 4 byte aligned. */
+	if (((uintptr_t)olddata & (sizeof(double) - 1)) != 0) {
+		olddata_aligned = MEM_mallocN(bh->len, __func__);
+		memcpy(olddata_aligned, olddata, bh->len);
+		olddata = olddata_aligned;
+	}
+
+	if (num_chunks <= 1) {
+		data.cur = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, olddata);
+	}
+	else if (curlen == 0) {
+		data.cur = NULL;
+	}
+	else {
+		data.reconstruct_info = fd->reconstruct_info;
+		data.SDNAnr = bh->SDNAnr;
+		data.blocks = bh->nr;
+		data.data = olddata;
+		data.cur = MEM_callocN((size_t)bh->nr * curlen, blockname);
+
+		BLI_task_parallel_range(0, num_chunks, &data, read_struct_reconstruct_chunk, true);
+	}
+
+	if (olddata_aligned) {
+		MEM_freeN(olddata_aligned);
+	}
+
+	return data.cur;
+}
+
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 {
 	void *temp = NULL;
@@ -1881,16 +2238,16 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 	if (bh->len) {
 		/* switch is based on file dna */
 		if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN))
-			switch_endian_structs(fd->filesdna, bh);
+			switch_endian_structs(fd, bh);
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = read_struct_reconstruct(fd, bh, blockname);
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, blo_bhead_data(fd, bh), bh->len);
 			}
 		}
 	}
@@ -4064,6 +4421,7 @@ static void direct_link_pointcache(FileData *fd, PointCache *cache)
 	cache->edit = NULL;
 	cache->free_edit = NULL;
 	cache->cached_frames = NULL;
+	cache->archive = NULL;
 }
 
 static void direct_link_pointcache_list(FileData *fd, ListBase *ptcaches, PointCache **ocache, int force_disk)
@@ -5634,6 +5992,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 
 	/* Runtime curve data  */
 	ob->curve_cache = NULL;
+	ob->modifier_cache = NULL;
 
 	/* in case this value changes in future, clamp else we get undefined behavior */
 	CLAMP(ob->rotmode, ROT_MODE_MIN, ROT_MODE_MAX);
@@ -8610,6 +8969,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	BHead *bhead = blo_firstbhead(fd);
 	BlendFileData *bfd;
 	ListBase mainlist = {NULL, NULL};
+	/* Timing of the main reading phases, reported with --debug-io. */
+	double time_start, time_read_blocks, time_do_versions, time_read_libraries, time_lib_link;
+
+	time_start = PIL_check_seconds_timer();
 	
 	bfd = MEM_callocN(sizeof(BlendFileData), "blendfiledata");
 	bfd->main = BKE_main_new();
@@ -8687,18 +9050,26 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 	
+	time_read_blocks = PIL_check_seconds_timer();
+
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
 		do_versions(fd, NULL, bfd->main);
 		do_versions_userdef(fd, bfd);
 	}
+
+	time_do_versions = PIL_check_seconds_timer();
 	
 	read_libraries(fd, &mainlist);
 	
 	blo_join_main(&mainlist);
+
+	time_read_libraries = PIL_check_seconds_timer();
 	
 	lib_link_all(fd, bfd->main);
 
+	time_lib_link = PIL_check_seconds_timer();
+
 	/* Skip in undo case. */
 	if (fd->memfile == NULL) {
 		/* Yep, second splitting... but this is a very cheap operation, so no big deal. */
@@ -8719,6 +9090,17 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	
 	fd->mainlist = NULL;  /* Safety, this is local variable, shall not be used afterward. */
 
+	if (G.debug & G_DEBUG_IO) {
+		const double time_end = PIL_check_seconds_timer();
+		printf("read file %s timing:\n", filepath);
+		printf("  read blocks:    %.4f sec\n", time_read_blocks - time_start);
+		printf("  do versions:    %.4f sec\n", time_do_versions - time_read_blocks);
+		printf("  read libraries: %.4f sec\n", time_read_libraries - time_do_versions);
+		printf("  lib link:       %.4f sec\n", time_lib_link - time_read_libraries);
+		printf("  finalize:       %.4f sec\n", time_end - time_lib_link);
+		printf("  total:          %.4f sec\n", time_end - time_start);
+	}
+
 	return bfd;
 }
 
@@ -43,6 +43,7 @@ struct Object;
 struct PartEff;
 struct View3D;
 struct Key;
+struct DNA_ReconstructInfo;
 
 typedef struct FileData {
 	// linked list of BHeadN's
@@ -62,6 +63,17 @@ typedef struct FileData {
 	int filedes;
 	gzFile gzfiledes;
 
+	// variables needed for reading from memory mapped file
+	void *mmap_mem;
+	size_t mmap_size;
+	size_t mmap_seek;
+	// aligned copies of all BHeads of the mapped file in file order, and the
+	// data of their blocks in the mapping, NULL when blocks can not be used
+	// directly from the mapping (see USE_MMAP_READ)
+	struct BHead *mmap_bheads;
+	const void **mmap_bhead_data;
+	int mmap_tot_bheads;
+
 	// now only in use for library appending
 	char relabase[FILE_MAX];
 	
@@ -70,12 +82,13 @@ typedef struct FileData {
 	int inbuffer;
 	
 	// gzip stream for memory decompression
-	z_stream strm;
+	struct GzipMemReader *gzip_mem_reader;
 	
 	// general reading variables
 	struct SDNA *filesdna;
 	const struct SDNA *memsdna;
 	const char *compflags;  /* array of eSDNA_StructCompare */
+	struct DNA_ReconstructInfo *reconstruct_info;  /* conversion of SDNA_CMP_NOT_EQUAL structs */
 	
 	int fileversion;
 	int id_name_offs;       /* used to retrieve ID names from (bhead+1) */
@@ -152,6 +165,7 @@ BHead *blo_firstbhead(FileData *fd);
 BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
+void *blo_bhead_data(const FileData *fd, const BHead *bhead);
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
 
 /* do versions stuff */
@@ -40,19 +40,112 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Chunk buffers are reference counted and shared between all memfiles (undo steps).
+ *
+ * Besides comparing each chunk with the one at the same position in the previous memfile,
+ * buffers are indexed by their contents, so a chunk which moved
+ * (because data was inserted or removed before it) is still stored only once.
+ */
+typedef struct MemFileSharedBuf {
+	char *buf;
+	unsigned int size;
+	unsigned int hash;
+	unsigned int users;
+} MemFileSharedBuf;
+
+static struct {
+	/* Set of MemFileSharedBuf, NULL when there are no buffers. */
+	GSet *bufs;
+	/* Total size of all buffers. */
+	size_t size;
+} memfile_shared = {NULL, 0};
+
+static unsigned int memfile_shared_buf_hash(const void *key)
+{
+	const MemFileSharedBuf *sbuf = key;
+	return sbuf->hash;
+}
+
+static bool memfile_shared_buf_cmp(const void *a, const void *b)
+{
+	const MemFileSharedBuf *sbuf_a = a;
+	const MemFileSharedBuf *sbuf_b = b;
+
+	return ((sbuf_a->hash != sbuf_b->hash) ||
+	        (sbuf_a->size != sbuf_b->size) ||
+	        (memcmp(sbuf_a->buf, sbuf_b->buf, sbuf_a->size) != 0));
+}
+
+static MemFileSharedBuf *memfile_shared_buf_ensure(const char *buf, unsigned int size, bool *r_is_new)
+{
+	MemFileSharedBuf sbuf_key, *sbuf;
+
+	sbuf_key.buf = (char *)buf;
+	sbuf_key.size = size;
+	sbuf_key.hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+
+	if (memfile_shared.bufs == NULL) {
+		memfile_shared.bufs = BLI_gset_new(memfile_shared_buf_hash, memfile_shared_buf_cmp, __func__);
+	}
+	else if ((sbuf = BLI_gset_lookup(memfile_shared.bufs, &sbuf_key))) {
+		sbuf->users++;
+		*r_is_new = false;
+		return sbuf;
+	}
+
+	sbuf = MEM_mallocN(sizeof(*sbuf), "MemFileSharedBuf");
+	sbuf->buf = MEM_mallocN(size, "Chunk buffer");
+	memcpy(sbuf->buf, buf, size);
+	sbuf->size = size;
+	sbuf->hash = sbuf_key.hash;
+	sbuf->users = 1;
+	BLI_gset_insert(memfile_shared.bufs, sbuf);
+	memfile_shared.size += size;
+
+	*r_is_new = true;
+	return sbuf;
+}
+
+static void memfile_shared_buf_release(MemFileSharedBuf *sbuf)
+{
+	BLI_assert(sbuf->users != 0);
+
+	if (--sbuf->users == 0) {
+		BLI_gset_remove(memfile_shared.bufs, sbuf, NULL);
+		memfile_shared.size -= sbuf->size;
+		MEM_freeN(sbuf->buf);
+		MEM_freeN(sbuf);
+
+		if (BLI_gset_size(memfile_shared.bufs) == 0) {
+			BLI_gset_free(memfile_shared.bufs, NULL);
+			memfile_shared.bufs = NULL;
+		}
+	}
+}
+
+/**
+ * \return The memory used by chunk buffers of all memfiles, shared buffers are only counted once.
+ */
+size_t BLO_memfile_shared_size_get(void)
+{
+	return memfile_shared.size;
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
-			MEM_freeN(chunk->buf);
+		memfile_shared_buf_release(chunk->shared);
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
@@ -60,23 +153,9 @@ void BLO_memfile_free(MemFile *memfile)
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
-void BLO_memfile_merge(MemFile *first, MemFile *second)
+void BLO_memfile_merge(MemFile *first, MemFile *UNUSED(second))
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
-		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
-	}
-	
+	/* buffers are reference counted, the ones still used by 'second' are kept */
 	BLO_memfile_free(first);
 }
 
@@ -84,6 +163,7 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 {
 	static MemFileChunk *compchunk = NULL;
 	MemFileChunk *curchunk;
+	bool is_new = false;
 	
 	/* this function inits when compare != NULL or when current == NULL  */
 	if (compare) {
@@ -97,26 +177,31 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
+	curchunk->shared = NULL;
 	curchunk->ident = 0;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* we compare compchunk with buf, the common case of unchanged data avoids hashing */
 	if (compchunk) {
 		if (compchunk->size == curchunk->size) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
-				curchunk->buf = compchunk->buf;
-				curchunk->ident = 1;
+				curchunk->shared = compchunk->shared;
+				curchunk->shared->users++;
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
+	/* not equal, look for the same data anywhere in the undo stack */
+	if (curchunk->shared == NULL) {
+		curchunk->shared = memfile_shared_buf_ensure(buf, size, &is_new);
+	}
+
+	curchunk->buf = curchunk->shared->buf;
+	if (is_new) {
 		current->size += size;
 	}
+	else {
+		curchunk->ident = 1;
+	}
 }
-
@@ -152,8 +152,11 @@
 #include "MEM_guardedalloc.h" // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_writer.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -215,7 +218,7 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		GzipWriter *gz_writer;
 	} _user_data;
 };
 
@@ -249,15 +252,16 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 
 /* zlib */
 #define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+	(ww)->_user_data.gz_writer
 
 static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-	gzFile file;
+	GzipWriter *file;
 
-	file = BLI_gzopen(filepath, "wb1");
+	/* compress chunks of the file in parallel, written as a multi-member gzip stream */
+	file = BLI_gzip_writer_open(filepath, 1, BLI_task_scheduler_get());
 
-	if (file != Z_NULL) {
+	if (file != NULL) {
 		FILE_HANDLE(ww) = file;
 		return true;
 	}
@@ -267,11 +271,11 @@ static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	return BLI_gzip_writer_close(FILE_HANDLE(ww));
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	return BLI_gzip_writer_write(FILE_HANDLE(ww), buf, buf_len) ? buf_len : 0;
 }
 #undef FILE_HANDLE
 
@@ -0,0 +1,299 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <list>
+#include <string.h>
+#include <typeinfo>
+
+#include "COM_BufferCache.h"
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+extern "C" {
+#  include "MEM_guardedalloc.h"
+#  include "DNA_camera_types.h"
+#  include "DNA_object_types.h"
+}
+
+/* ******** BufferCacheHash ******** */
+
+BufferCacheHash::BufferCacheHash()
+{
+	BLI_hash_mm2a_init(&this->m_mm2[0], 0);
+	BLI_hash_mm2a_init(&this->m_mm2[1], 0x9e3779b9);
+}
+
+void BufferCacheHash::add(const void *data, size_t size)
+{
+	BLI_hash_mm2a_add(&this->m_mm2[0], (const unsigned char *)data, size);
+	BLI_hash_mm2a_add(&this->m_mm2[1], (const unsigned char *)data, size);
+}
+
+void BufferCacheHash::addInt(int value)
+{
+	BLI_hash_mm2a_add_int(&this->m_mm2[0], value);
+	BLI_hash_mm2a_add_int(&this->m_mm2[1], value);
+}
+
+void BufferCacheHash::addFloat(float value)
+{
+	add(&value, sizeof(value));
+}
+
+void BufferCacheHash::addString(const char *str)
+{
+	if (str) {
+		add(str, strlen(str) + 1);
+	}
+	else {
+		addInt(0);
+	}
+}
+
+void BufferCacheHash::addBuffer(const void *data, size_t size)
+{
+	/* hashing once is enough, large buffers would take twice as long otherwise */
+	addInt((int)size);
+	if (data) {
+		addInt((int)BLI_hash_mm2((const unsigned char *)data, size, 0));
+	}
+}
+
+void BufferCacheHash::addNode(const bNode *node)
+{
+	add(&node->id, sizeof(node->id));
+	addInt(node->type);
+	addInt(node->custom1);
+	addInt(node->custom2);
+	addFloat(node->custom3);
+	addFloat(node->custom4);
+	if (node->storage) {
+		/* pointers inside storage are not followed, data they point to is expected to
+		 * be updated together with the storage itself (like CurveMapping.changed_timestamp) */
+		add(node->storage, MEM_allocN_len(node->storage));
+	}
+
+	/* values of unlinked inputs, and of value and color nodes */
+	for (const bNodeSocket *sock = (const bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+	for (const bNodeSocket *sock = (const bNodeSocket *)node->outputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+}
+
+uint64_t BufferCacheHash::getKey()
+{
+	uint64_t key = ((uint64_t)BLI_hash_mm2a_end(&this->m_mm2[0]) << 32) |
+	               (uint64_t)BLI_hash_mm2a_end(&this->m_mm2[1]);
+	/* 0 is used for buffers that can't be cached */
+	return key ? key : 1;
+}
+
+/* ******** BufferCache ******** */
+
+typedef struct BufferCacheEntry {
+	uint64_t key;
+	float *buffer;
+	size_t size;
+	unsigned int width;
+	unsigned int height;
+	unsigned int num_channels;
+} BufferCacheEntry;
+
+typedef std::list<BufferCacheEntry> BufferCacheEntries;
+
+/* Access is serialized by the compositor mutex, see COM_execute.
+ * Most recently used entries are at the front of the list. */
+static BufferCacheEntries g_entries;
+static std::map<uint64_t, BufferCacheEntries::iterator> g_entry_map;
+static size_t g_memory_in_use = 0;
+static size_t g_memory_limit = 0;
+
+static void buffer_cache_free_last()
+{
+	BufferCacheEntry &entry = g_entries.back();
+	g_memory_in_use -= entry.size;
+	g_entry_map.erase(entry.key);
+	MEM_freeN(entry.buffer);
+	g_entries.pop_back();
+}
+
+static void buffer_cache_fit(size_t size)
+{
+	while (!g_entries.empty() && g_memory_in_use + size > g_memory_limit) {
+		buffer_cache_free_last();
+	}
+}
+
+void BufferCache::setMemoryLimit(size_t limit)
+{
+	g_memory_limit = limit;
+	buffer_cache_fit(0);
+}
+
+bool BufferCache::isEnabled()
+{
+	return g_memory_limit != 0;
+}
+
+size_t BufferCache::getMemoryInUse()
+{
+	return g_memory_in_use;
+}
+
+static uint64_t buffer_cache_hash_operation(NodeOperation *operation, BufferCache::KeyMap &keys)
+{
+	BufferCache::KeyMap::const_iterator found = keys.find(operation);
+	if (found != keys.end()) {
+		return found->second;
+	}
+
+	BufferCacheHash hash;
+	bool valid = operation->hashSettings(hash);
+
+	if (valid) {
+		hash.addString(typeid(*operation).name());
+		hash.addInt(operation->getWidth());
+		hash.addInt(operation->getHeight());
+
+		if (operation->isReadBufferOperation()) {
+			ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+			NodeOperation *writeOperation = readOperation->getMemoryProxy()->getWriteBufferOperation();
+			uint64_t input_key = buffer_cache_hash_operation(writeOperation, keys);
+			valid = (input_key != 0);
+			hash.add(&input_key, sizeof(input_key));
+		}
+
+		for (unsigned int index = 0; valid && index < operation->getNumberOfInputSockets(); index++) {
+			NodeOperationOutput *link = operation->getInputSocket(index)->getLink();
+			uint64_t input_key = 0;
+			if (link) {
+				input_key = buffer_cache_hash_operation(&link->getOperation(), keys);
+				valid = (input_key != 0);
+			}
+			hash.add(&input_key, sizeof(input_key));
+		}
+	}
+
+	uint64_t key = valid ? hash.getKey() : 0;
+	keys[operation] = key;
+	return key;
+}
+
+uint64_t BufferCache::determineKey(WriteBufferOperation *operation, const CompositorContext &context, KeyMap &keys)
+{
+	uint64_t operation_key = buffer_cache_hash_operation(operation, keys);
+	if (operation_key == 0) {
+		return 0;
+	}
+
+	BufferCacheHash hash;
+	hash.add(&operation_key, sizeof(operation_key));
+
+	/* settings of the execution that operations read from the context */
+	hash.add(context.getRenderData(), sizeof(RenderData));
+	hash.addInt(context.getQuality());
+	hash.addInt(context.isRendering());
+	hash.addInt(context.isFastCalculation());
+	hash.addString(context.getViewName());
+
+	const bNodeTree *ntree = context.getbNodeTree();
+	if (ntree->flag & NTREE_VIEWER_BORDER) {
+		hash.add(&ntree->viewer_border, sizeof(ntree->viewer_border));
+	}
+
+	/* defocus uses the scene camera */
+	Scene *scene = context.getScene();
+	if (scene && scene->camera) {
+		Object *camera = scene->camera;
+		hash.add(camera->obmat, sizeof(camera->obmat));
+		if (camera->type == OB_CAMERA && camera->data) {
+			hash.add(camera->data, sizeof(Camera));
+		}
+	}
+
+	return hash.getKey();
+}
+
+bool BufferCache::restore(uint64_t key, MemoryBuffer *buffer)
+{
+	std::map<uint64_t, BufferCacheEntries::iterator>::iterator found = g_entry_map.find(key);
+	if (found == g_entry_map.end()) {
+		return false;
+	}
+
+	BufferCacheEntries::iterator entry = found->second;
+	if (entry->width != (unsigned int)buffer->getWidth() ||
+	    entry->height != (unsigned int)buffer->getHeight() ||
+	    entry->num_channels != buffer->get_num_channels())
+	{
+		return false;
+	}
+
+	memcpy(buffer->getBuffer(), entry->buffer, entry->size);
+
+	/* move to the front, so it is freed last */
+	g_entries.splice(g_entries.begin(), g_entries, entry);
+	return true;
+}
+
+void BufferCache::store(uint64_t key, MemoryBuffer *buffer)
+{
+	const size_t size = sizeof(float) * buffer->getWidth() * buffer->getHeight() * buffer->get_num_channels();
+
+	if (key == 0 || size > g_memory_limit) {
+		return;
+	}
+
+	std::map<uint64_t, BufferCacheEntries::iterator>::iterator found = g_entry_map.find(key);
+	if (found != g_entry_map.end()) {
+		/* same result as the cached buffer, only mark it as used */
+		g_entries.splice(g_entries.begin(), g_entries, found->second);
+		return;
+	}
+
+	buffer_cache_fit(size);
+
+	BufferCacheEntry entry;
+	entry.key = key;
+	entry.buffer = (float *)MEM_mallocN(size, "COM_BufferCache");
+	entry.size = size;
+	entry.width = buffer->getWidth();
+	entry.height = buffer->getHeight();
+	entry.num_channels = buffer->get_num_channels();
+	memcpy(entry.buffer, buffer->getBuffer(), size);
+
+	g_entries.push_front(entry);
+	g_entry_map[key] = g_entries.begin();
+	g_memory_in_use += size;
+}
+
+void BufferCache::clear()
+{
+	while (!g_entries.empty()) {
+		buffer_cache_free_last();
+	}
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_BufferCache_h_
+#define _COM_BufferCache_h_
+
+#include <map>
+
+extern "C" {
+#  include "BLI_hash_mm2a.h"
+}
+
+#include "DNA_node_types.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+class CompositorContext;
+class MemoryBuffer;
+class NodeOperation;
+class WriteBufferOperation;
+
+/**
+ * @brief incremental hash of everything the result of an operation depends on
+ * @see NodeOperation.hashSettings
+ * @ingroup execution
+ */
+class BufferCacheHash {
+private:
+	/* two independent hashes, combined into a 64 bit key */
+	BLI_HashMurmur2A m_mm2[2];
+
+public:
+	BufferCacheHash();
+
+	void add(const void *data, size_t size);
+	void addInt(int value);
+	void addFloat(float value);
+	void addString(const char *str);
+
+	/**
+	 * @brief add large data like image buffers, only a digest of the data is added
+	 */
+	void addBuffer(const void *data, size_t size);
+
+	/**
+	 * @brief add the settings of an editor node
+	 * @note the contents of the datablock of the node are not added
+	 */
+	void addNode(const bNode *node);
+
+	uint64_t getKey();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:BufferCacheHash")
+#endif
+};
+
+/**
+ * @brief cache of MemoryProxy buffers that is kept between executions
+ *
+ * Buffers are keyed by a hash of all operations they depend on, including the settings of the
+ * operations and the data of their inputs. When a key is found at the start of an execution the
+ * buffer is restored and its ExecutionGroup, with everything in front of it, is not calculated.
+ * The cache is limited to a user set amount of memory, least recently used buffers are freed first.
+ * @ingroup execution
+ */
+class BufferCache {
+public:
+	typedef std::map<NodeOperation *, uint64_t> KeyMap;
+
+	/**
+	 * @brief set the maximum amount of memory used by the cache, 0 disables it
+	 */
+	static void setMemoryLimit(size_t limit);
+	static bool isEnabled();
+	static size_t getMemoryInUse();
+
+	/**
+	 * @brief determine the key of the buffer of a WriteBufferOperation
+	 * operations need to be initialized, as the data of input operations is part of the key.
+	 * @param keys keys of operations that are already hashed, shared between calls of one execution
+	 * @return the key, or 0 when the buffer can't be cached
+	 */
+	static uint64_t determineKey(WriteBufferOperation *operation, const CompositorContext &context, KeyMap &keys);
+
+	/**
+	 * @brief copy a cached buffer into buffer
+	 * @return true when key was found
+	 */
+	static bool restore(uint64_t key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief store a copy of buffer, freeing least recently used buffers when needed
+	 */
+	static void store(uint64_t key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief free all cached buffers
+	 */
+	static void clear();
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:BufferCache")
+#endif
+};
+
+#endif
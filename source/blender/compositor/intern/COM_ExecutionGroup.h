@@ -353,6 +353,16 @@ public:
 	 */
 	void finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers);
 	
+	/**
+	 * @brief mark all chunks as executed, used when the result is restored from the BufferCache
+	 */
+	void setAllChunksExecuted();
+
+	/**
+	 * @brief have all chunks of this ExecutionGroup been executed
+	 */
+	bool areAllChunksExecuted() const;
+
 	/**
 	 * @brief deinitExecution is called just after execution the whole graph.
 	 * @note It will release all needed resources
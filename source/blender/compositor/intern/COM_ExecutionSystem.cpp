@@ -36,6 +36,8 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+#include "COM_BufferCache.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -174,6 +176,11 @@ void ExecutionSystem::execute()
 		executionGroup->initExecution();
 	}
 
+	vector<uint64_t> cacheKeys(this->m_groups.size(), 0);
+	if (BufferCache::isEnabled()) {
+		restoreCachedBuffers(cacheKeys);
+	}
+
 	WorkScheduler::start(this->m_context);
 
 	executeGroups(COM_PRIORITY_HIGH);
@@ -185,6 +192,10 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	if (BufferCache::isEnabled() && !editingtree->test_break(editingtree->tbh)) {
+		storeCachedBuffers(cacheKeys);
+	}
+
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -196,6 +207,44 @@ void ExecutionSystem::execute()
 	}
 }
 
+void ExecutionSystem::restoreCachedBuffers(vector<uint64_t> &cacheKeys)
+{
+	BufferCache::KeyMap keys;
+	unsigned int index;
+
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *executionGroup = this->m_groups[index];
+		NodeOperation *operation = executionGroup->getOutputOperation();
+		if (!operation->isWriteBufferOperation()) {
+			continue;
+		}
+
+		WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+		cacheKeys[index] = BufferCache::determineKey(writeOperation, this->m_context, keys);
+
+		MemoryBuffer *buffer = writeOperation->getMemoryProxy()->getBuffer();
+		if (cacheKeys[index] && BufferCache::restore(cacheKeys[index], buffer)) {
+			buffer->setCreatedState();
+			executionGroup->setAllChunksExecuted();
+			/* nothing to store again */
+			cacheKeys[index] = 0;
+		}
+	}
+}
+
+void ExecutionSystem::storeCachedBuffers(const vector<uint64_t> &cacheKeys)
+{
+	unsigned int index;
+
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *executionGroup = this->m_groups[index];
+		if (cacheKeys[index] && executionGroup->areAllChunksExecuted()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)executionGroup->getOutputOperation();
+			BufferCache::store(cacheKeys[index], writeOperation->getMemoryProxy()->getBuffer());
+		}
+	}
+}
+
 void ExecutionSystem::executeGroups(CompositorPriority priority)
 {
 	unsigned int index;
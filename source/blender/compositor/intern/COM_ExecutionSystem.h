@@ -177,6 +177,17 @@ public:
 private:
 	void executeGroups(CompositorPriority priority);
 
+	/**
+	 * @brief restore the buffers of write buffer groups from the BufferCache
+	 * groups that are restored are marked as executed, cacheKeys gets the keys of the groups to store afterwards.
+	 */
+	void restoreCachedBuffers(vector<uint64_t> &cacheKeys);
+
+	/**
+	 * @brief add the buffers of fully executed groups to the BufferCache
+	 */
+	void storeCachedBuffers(const vector<uint64_t> &cacheKeys);
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
@@ -134,6 +134,16 @@ public:
 	 * @note buffer should already be available in memory
 	 */
 	float *getBuffer() { return this->m_buffer; }
+
+	/**
+	 * @brief get the data of the pixel at (x, y)
+	 * @note the pixel has to be inside the rect of this MemoryBuffer
+	 */
+	inline float *getElem(int x, int y)
+	{
+		BLI_assert(x >= m_rect.xmin && x < m_rect.xmax && y >= m_rect.ymin && y < m_rect.ymax);
+		return &this->m_buffer[((y - m_rect.ymin) * this->m_width + (x - m_rect.xmin)) * this->m_num_channels];
+	}
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -24,6 +24,7 @@
 #include <stdio.h>
 
 #include "COM_defines.h"
+#include "COM_BufferCache.h"
 #include "COM_ExecutionSystem.h"
 
 #include "COM_NodeOperation.h" /* own include */
@@ -41,6 +42,7 @@ NodeOperation::NodeOperation()
 	this->m_isResolutionSet = false;
 	this->m_openCL = false;
 	this->m_btree = NULL;
+	this->m_bnode = NULL;
 }
 
 NodeOperation::~NodeOperation()
@@ -151,6 +153,58 @@ NodeOperation *NodeOperation::getInputOperation(unsigned int inputSocketIndex)
 		return NULL;
 }
 
+bool NodeOperation::hashSettings(BufferCacheHash &hash)
+{
+	if (this->m_bnode) {
+		const ID *id = this->m_bnode->id;
+		/* the contents of datablocks can change without any change to the node, only images are
+		 * fine as they are read by input operations, which hash the image data themselves */
+		if (id && (this->getNumberOfInputSockets() == 0 || GS(id->name) != ID_IM)) {
+			return false;
+		}
+		hash.addNode(this->m_bnode);
+		return true;
+	}
+	/* operations added by the compositor itself only depend on their inputs,
+	 * except for input operations which have to hash their own data */
+	return this->getNumberOfInputSockets() != 0;
+}
+
+MemoryBuffer *NodeOperation::getInputRect(unsigned int inputSocketIndex, const rcti *rect)
+{
+	NodeOperation *operation = this->getInputOperation(inputSocketIndex);
+	MemoryBuffer *buffer = new MemoryBuffer(this->getInputSocket(inputSocketIndex)->getDataType(), (rcti *)rect);
+
+	/* complex operations are always behind a buffer, so no tile data is needed here */
+	BLI_assert(!operation->isComplex());
+	operation->executeRect(buffer, rect, NULL);
+	return buffer;
+}
+
+void NodeOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	const int num_channels = output->get_num_channels();
+	const bool complex = this->isComplex();
+	float color[4];
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = rect->xmin; x < rect->xmax; x++) {
+			if (complex) {
+				this->read(color, x, y, data);
+			}
+			else {
+				this->readSampled(color, x, y, COM_PS_NEAREST);
+			}
+			memcpy(elem, color, sizeof(float) * num_channels);
+			elem += num_channels;
+		}
+		if (isBreaked()) {
+			break;
+		}
+	}
+}
+
 void NodeOperation::getConnectedInputSockets(Inputs *sockets)
 {
 	for (Inputs::const_iterator it = m_inputs.begin(); it != m_inputs.end(); ++it) {
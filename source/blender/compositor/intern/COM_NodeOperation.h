@@ -44,6 +44,7 @@ using std::list;
 using std::min;
 using std::max;
 
+class BufferCacheHash;
 class OpenCLDevice;
 class ReadBufferOperation;
 class WriteBufferOperation;
@@ -121,6 +122,11 @@ private:
 	 */
 	const bNodeTree *m_btree;
 
+	/**
+	 * @brief the editor node this operation was created for, NULL for operations added by the compositor itself
+	 */
+	const bNode *m_bnode;
+
 	/**
 	 * @brief set to truth when resolution for this operation is set
 	 */
@@ -166,6 +172,16 @@ public:
 	virtual int isSingleThreaded() { return false; }
 
 	void setbNodeTree(const bNodeTree *tree) { this->m_btree = tree; }
+	void setbNode(const bNode *node) { this->m_bnode = node; }
+	const bNode *getbNode() const { return this->m_bnode; }
+
+	/**
+	 * @brief add the settings the result of this operation depends on to hash
+	 * used by the BufferCache to find buffers of earlier executions, the inputs of the operation are added separately.
+	 * The default implementation hashes the settings of the editor node.
+	 * @return false when the result depends on data that can't be hashed and must not be cached
+	 */
+	virtual bool hashSettings(BufferCacheHash &hash);
 	virtual void initExecution();
 	
 	/**
@@ -178,6 +194,18 @@ public:
 	virtual void executeRegion(rcti * /*rect*/,
 	                           unsigned int /*chunkNumber*/) {}
 
+	/**
+	 * @brief calculate the output of this operation for a whole rectangle at once
+	 * @ingroup execution
+	 *
+	 * Operations that can process a full MemoryBuffer in a tight loop override this,
+	 * the default implementation evaluates every pixel of the rectangle on its own.
+	 * @param output the MemoryBuffer to write to, its rect must contain rect
+	 * @param rect the area to calculate
+	 * @param data the tile data of complex operations, see initializeTileData
+	 */
+	virtual void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
+
 	/**
 	 * @brief when a chunk is executed by an OpenCLDevice, this method is called
 	 * @ingroup execution
@@ -315,6 +343,12 @@ protected:
 	SocketReader *getInputSocketReader(unsigned int inputSocketindex);
 	NodeOperation *getInputOperation(unsigned int inputSocketindex);
 
+	/**
+	 * @brief calculate the connected input operation for a whole rectangle
+	 * @note the caller owns the returned MemoryBuffer and has to delete it
+	 */
+	MemoryBuffer *getInputRect(unsigned int inputSocketindex, const rcti *rect);
+
 	void deinitMutex();
 	void initMutex();
 	void lockMutex();
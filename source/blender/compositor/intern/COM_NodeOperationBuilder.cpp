@@ -130,6 +130,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+	if (m_current_node) {
+		operation->setbNode(m_current_node->getbNode());
+	}
 	m_operations.push_back(operation);
 }
 
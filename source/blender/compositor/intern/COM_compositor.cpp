@@ -30,7 +30,10 @@ extern "C" {
 
 #include "BKE_scene.h"
 
+#include "DNA_userdef_types.h"
+
 #include "COM_compositor.h"
+#include "COM_BufferCache.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
 #include "clew.h"
@@ -84,6 +87,8 @@ void COM_execute(RenderData *rd, Scene *scene, bNodeTree *editingtree, int rende
 	bool use_opencl = (editingtree->flag & NTREE_COM_OPENCL) != 0;
 	WorkScheduler::initialize(use_opencl, BKE_render_num_threads(rd));
 
+	BufferCache::setMemoryLimit((size_t)U.compositor_cache_limit * 1024 * 1024);
+
 	/* set progress bar to 0% and status to init compositing */
 	editingtree->progress(editingtree->prh, 0.0);
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing"));
@@ -116,8 +121,18 @@ void COM_deinitialize()
 	if (is_compositorMutex_init) {
 		BLI_mutex_lock(&s_compositorMutex);
 		WorkScheduler::deinitialize();
+		BufferCache::clear();
 		is_compositorMutex_init = false;
 		BLI_mutex_unlock(&s_compositorMutex);
 		BLI_mutex_end(&s_compositorMutex);
 	}
 }
+
+void COM_clearCaches()
+{
+	if (is_compositorMutex_init) {
+		BLI_mutex_lock(&s_compositorMutex);
+		BufferCache::clear();
+		BLI_mutex_unlock(&s_compositorMutex);
+	}
+}
@@ -27,6 +27,26 @@ AlphaOverMixedOperation::AlphaOverMixedOperation() : MixBaseOperation()
 	this->m_x = 0.0f;
 }
 
+static inline void alpha_over_mixed(float output[4], const float inputColor1[4], const float inputOverColor[4], float value, float x)
+{
+	if (inputOverColor[3] <= 0.0f) {
+		copy_v4_v4(output, inputColor1);
+	}
+	else if (value == 1.0f && inputOverColor[3] >= 1.0f) {
+		copy_v4_v4(output, inputOverColor);
+	}
+	else {
+		float addfac = 1.0f - x + inputOverColor[3] * x;
+		float premul = value * addfac;
+		float mul = 1.0f - value * inputOverColor[3];
+
+		output[0] = (mul * inputColor1[0]) + premul * inputOverColor[0];
+		output[1] = (mul * inputColor1[1]) + premul * inputOverColor[1];
+		output[2] = (mul * inputColor1[2]) + premul * inputOverColor[2];
+		output[3] = (mul * inputColor1[3]) + value * inputOverColor[3];
+	}
+}
+
 void AlphaOverMixedOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -37,21 +57,38 @@ void AlphaOverMixedOperation::executePixelSampled(float output[4], float x, floa
 	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
 	this->m_inputColor2Operation->readSampled(inputOverColor, x, y, sampler);
 	
-	if (inputOverColor[3] <= 0.0f) {
-		copy_v4_v4(output, inputColor1);
-	}
-	else if (value[0] == 1.0f && inputOverColor[3] >= 1.0f) {
-		copy_v4_v4(output, inputOverColor);
+	alpha_over_mixed(output, inputColor1, inputOverColor, value[0], this->m_x);
+}
+
+void AlphaOverMixedOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	if (output->get_num_channels() != COM_NUM_CHANNELS_COLOR) {
+		NodeOperation::executeRect(output, rect, data);
+		return;
 	}
-	else {
-		float addfac = 1.0f - this->m_x + inputOverColor[3] * this->m_x;
-		float premul = value[0] * addfac;
-		float mul = 1.0f - value[0] * inputOverColor[3];
 
-		output[0] = (mul * inputColor1[0]) + premul * inputOverColor[0];
-		output[1] = (mul * inputColor1[1]) + premul * inputOverColor[1];
-		output[2] = (mul * inputColor1[2]) + premul * inputOverColor[2];
-		output[3] = (mul * inputColor1[3]) + value[0] * inputOverColor[3];
+	MemoryBuffer *inputValue = this->getInputRect(0, rect);
+	MemoryBuffer *inputColor1 = this->getInputRect(1, rect);
+	MemoryBuffer *inputOverColor = this->getInputRect(2, rect);
+	const float *value = inputValue->getBuffer();
+	const float *color1 = inputColor1->getBuffer();
+	const float *overColor = inputOverColor->getBuffer();
+	const int value_stride = inputValue->get_num_channels();
+	const int width = BLI_rcti_size_x(rect);
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = 0; x < width; x++) {
+			alpha_over_mixed(elem, color1, overColor, value[0], this->m_x);
+			value += value_stride;
+			color1 += COM_NUM_CHANNELS_COLOR;
+			overColor += COM_NUM_CHANNELS_COLOR;
+			elem += COM_NUM_CHANNELS_COLOR;
+		}
 	}
+
+	delete inputValue;
+	delete inputColor1;
+	delete inputOverColor;
 }
 
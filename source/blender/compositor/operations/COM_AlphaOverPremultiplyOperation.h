@@ -40,6 +40,7 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 
 };
 #endif
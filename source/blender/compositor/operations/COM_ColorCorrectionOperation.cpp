@@ -44,13 +44,8 @@ void ColorCorrectionOperation::initExecution()
 	this->m_inputMask = this->getInputSocketReader(1);
 }
 
-void ColorCorrectionOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+inline void ColorCorrectionOperation::correctPixel(float output[4], const float inputImageColor[4], const float inputMask)
 {
-	float inputImageColor[4];
-	float inputMask[4];
-	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
-	this->m_inputMask->readSampled(inputMask, x, y, sampler);
-	
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
@@ -59,7 +54,7 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float lift = this->m_data->master.lift;
 	float r, g, b;
 	
-	float value = inputMask[0];
+	float value = inputMask;
 	value = min(1.0f, value);
 	const float mvalue = 1.0f - value;
 	
@@ -139,6 +134,44 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	output[3] = inputImageColor[3];
 }
 
+void ColorCorrectionOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+{
+	float inputImageColor[4];
+	float inputMask[4];
+	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
+	this->m_inputMask->readSampled(inputMask, x, y, sampler);
+
+	correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	if (output->get_num_channels() != COM_NUM_CHANNELS_COLOR) {
+		NodeOperation::executeRect(output, rect, data);
+		return;
+	}
+
+	MemoryBuffer *inputImage = this->getInputRect(0, rect);
+	MemoryBuffer *inputMask = this->getInputRect(1, rect);
+	const float *color = inputImage->getBuffer();
+	const float *mask = inputMask->getBuffer();
+	const int mask_stride = inputMask->get_num_channels();
+	const int width = BLI_rcti_size_x(rect);
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = 0; x < width; x++) {
+			correctPixel(elem, color, mask[0]);
+			color += COM_NUM_CHANNELS_COLOR;
+			mask += mask_stride;
+			elem += COM_NUM_CHANNELS_COLOR;
+		}
+	}
+
+	delete inputImage;
+	delete inputMask;
+}
+
 void ColorCorrectionOperation::deinitExecution()
 {
 	this->m_inputImage = NULL;
@@ -83,11 +83,10 @@ void GaussianXBlurOperation::updateGauss()
 	}
 }
 
-void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *data)
+inline void GaussianXBlurOperation::blurPixel(float output[4], int x, int y, MemoryBuffer *inputBuffer)
 {
 	float ATTR_ALIGN(16) color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 	float multiplier_accum = 0.0f;
-	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
 	float *buffer = inputBuffer->getBuffer();
 	int bufferwidth = inputBuffer->getWidth();
 	int bufferstartx = inputBuffer->getRect()->xmin;
@@ -123,6 +122,31 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *data)
+{
+	blurPixel(output, x, y, (MemoryBuffer *)data);
+}
+
+void GaussianXBlurOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	if (output->get_num_channels() != COM_NUM_CHANNELS_COLOR) {
+		NodeOperation::executeRect(output, rect, data);
+		return;
+	}
+
+	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = rect->xmin; x < rect->xmax; x++) {
+			blurPixel(elem, x, y, inputBuffer);
+			elem += COM_NUM_CHANNELS_COLOR;
+		}
+		if (isBreaked()) {
+			break;
+		}
+	}
+}
+
 void GaussianXBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
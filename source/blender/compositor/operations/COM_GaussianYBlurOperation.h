@@ -33,6 +33,7 @@ private:
 #endif
 	int m_filtersize;
 	void updateGauss();
+	void blurPixel(float output[4], int x, int y, MemoryBuffer *inputBuffer);
 public:
 	GaussianYBlurOperation();
 	
@@ -40,6 +41,7 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixel(float output[4], int x, int y, void *data);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 
 	void executeOpenCL(OpenCLDevice *device,
 	                   MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
@@ -21,6 +21,7 @@
  */
 
 #include "COM_ImageOperation.h"
+#include "COM_BufferCache.h"
 
 #include "BLI_listbase.h"
 #include "DNA_image_types.h"
@@ -107,6 +108,38 @@ void BaseImageOperation::deinitExecution()
 	BKE_image_release_ibuf(this->m_image, this->m_buffer, NULL);
 }
 
+bool BaseImageOperation::hashSettings(BufferCacheHash &hash)
+{
+	/* images can be reloaded or painted on, so hash the pixels that are used */
+	ImBuf *ibuf = this->m_buffer;
+	if (ibuf == NULL) {
+		hash.addInt(0);
+		return true;
+	}
+
+	const size_t num_pixels = (size_t)ibuf->x * ibuf->y;
+	hash.addInt(ibuf->x);
+	hash.addInt(ibuf->y);
+	hash.addInt(ibuf->channels);
+	if (ibuf->rect_float) {
+		hash.addBuffer(ibuf->rect_float, sizeof(float) * num_pixels * ibuf->channels);
+	}
+	else if (ibuf->rect) {
+		hash.addBuffer(ibuf->rect, sizeof(unsigned int) * num_pixels);
+	}
+	if (ibuf->zbuf_float) {
+		hash.addBuffer(ibuf->zbuf_float, sizeof(float) * num_pixels);
+	}
+	hash.add(&ibuf->rect_colorspace, sizeof(ibuf->rect_colorspace));
+	hash.add(&ibuf->float_colorspace, sizeof(ibuf->float_colorspace));
+	if (this->m_image) {
+		hash.addString(this->m_image->colorspace_settings.name);
+		hash.addInt(this->m_image->alpha_mode);
+		hash.addInt(this->m_image->flag);
+	}
+	return true;
+}
+
 void BaseImageOperation::determineResolution(unsigned int resolution[2], unsigned int /*preferredResolution*/[2])
 {
 	ImBuf *stackbuf = getImBuf();
@@ -64,6 +64,7 @@ public:
 	
 	void initExecution();
 	void deinitExecution();
+	bool hashSettings(BufferCacheHash &hash);
 	void setImage(Image *image) { this->m_image = image; }
 	void setImageUser(ImageUser *imageuser) { this->m_imageUser = imageuser; }
 	void setRenderData(const RenderData *rd) { this->m_rd = rd; }
@@ -107,6 +107,14 @@ MixAddOperation::MixAddOperation() : MixBaseOperation()
 	/* pass */
 }
 
+static inline void mix_add(float output[4], const float color1[4], const float color2[4], float value)
+{
+	output[0] = color1[0] + value * color2[0];
+	output[1] = color1[1] + value * color2[1];
+	output[2] = color1[2] + value * color2[2];
+	output[3] = color1[3];
+}
+
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -121,14 +129,16 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
 	}
-	output[0] = inputColor1[0] + value * inputColor2[0];
-	output[1] = inputColor1[1] + value * inputColor2[1];
-	output[2] = inputColor1[2] + value * inputColor2[2];
-	output[3] = inputColor1[3];
+	mix_add(output, inputColor1, inputColor2, value);
 
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRect(MemoryBuffer *output, const rcti *rect, void * /*data*/)
+{
+	executeRectMix<mix_add>(output, rect);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -136,6 +146,15 @@ MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 	/* pass */
 }
 
+static inline void mix_blend(float output[4], const float color1[4], const float color2[4], float value)
+{
+	float valuem = 1.0f - value;
+	output[0] = valuem * (color1[0]) + value * (color2[0]);
+	output[1] = valuem * (color1[1]) + value * (color2[1]);
+	output[2] = valuem * (color1[2]) + value * (color2[2]);
+	output[3] = color1[3];
+}
+
 void MixBlendOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -151,15 +170,16 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
 	}
-	float valuem = 1.0f - value;
-	output[0] = valuem * (inputColor1[0]) + value * (inputColor2[0]);
-	output[1] = valuem * (inputColor1[1]) + value * (inputColor2[1]);
-	output[2] = valuem * (inputColor1[2]) + value * (inputColor2[2]);
-	output[3] = inputColor1[3];
+	mix_blend(output, inputColor1, inputColor2, value);
 
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRect(MemoryBuffer *output, const rcti *rect, void * /*data*/)
+{
+	executeRectMix<mix_blend>(output, rect);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -600,6 +620,15 @@ MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 	/* pass */
 }
 
+static inline void mix_multiply(float output[4], const float color1[4], const float color2[4], float value)
+{
+	float valuem = 1.0f - value;
+	output[0] = color1[0] * (valuem + value * color2[0]);
+	output[1] = color1[1] * (valuem + value * color2[1]);
+	output[2] = color1[2] * (valuem + value * color2[2]);
+	output[3] = color1[3];
+}
+
 void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -614,15 +643,16 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
 	}
-	float valuem = 1.0f - value;
-	output[0] = inputColor1[0] * (valuem + value * inputColor2[0]);
-	output[1] = inputColor1[1] * (valuem + value * inputColor2[1]);
-	output[2] = inputColor1[2] * (valuem + value * inputColor2[2]);
-	output[3] = inputColor1[3];
+	mix_multiply(output, inputColor1, inputColor2, value);
 
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRect(MemoryBuffer *output, const rcti *rect, void * /*data*/)
+{
+	executeRectMix<mix_multiply>(output, rect);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -716,6 +746,15 @@ MixScreenOperation::MixScreenOperation() : MixBaseOperation()
 	/* pass */
 }
 
+static inline void mix_screen(float output[4], const float color1[4], const float color2[4], float value)
+{
+	float valuem = 1.0f - value;
+	output[0] = 1.0f - (valuem + value * (1.0f - color2[0])) * (1.0f - color1[0]);
+	output[1] = 1.0f - (valuem + value * (1.0f - color2[1])) * (1.0f - color1[1]);
+	output[2] = 1.0f - (valuem + value * (1.0f - color2[2])) * (1.0f - color1[2]);
+	output[3] = color1[3];
+}
+
 void MixScreenOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -730,16 +769,16 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
 	}
-	float valuem = 1.0f - value;
-
-	output[0] = 1.0f - (valuem + value * (1.0f - inputColor2[0])) * (1.0f - inputColor1[0]);
-	output[1] = 1.0f - (valuem + value * (1.0f - inputColor2[1])) * (1.0f - inputColor1[1]);
-	output[2] = 1.0f - (valuem + value * (1.0f - inputColor2[2])) * (1.0f - inputColor1[2]);
-	output[3] = inputColor1[3];
+	mix_screen(output, inputColor1, inputColor2, value);
 
 	clampIfNeeded(output);
 }
 
+void MixScreenOperation::executeRect(MemoryBuffer *output, const rcti *rect, void * /*data*/)
+{
+	executeRectMix<mix_screen>(output, rect);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -784,6 +823,14 @@ MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 	/* pass */
 }
 
+static inline void mix_subtract(float output[4], const float color1[4], const float color2[4], float value)
+{
+	output[0] = color1[0] - value * (color2[0]);
+	output[1] = color1[1] - value * (color2[1]);
+	output[2] = color1[2] - value * (color2[2]);
+	output[3] = color1[3];
+}
+
 void MixSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor1[4];
@@ -798,14 +845,16 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
 	}
-	output[0] = inputColor1[0] - value * (inputColor2[0]);
-	output[1] = inputColor1[1] - value * (inputColor2[1]);
-	output[2] = inputColor1[2] - value * (inputColor2[2]);
-	output[3] = inputColor1[3];
+	mix_subtract(output, inputColor1, inputColor2, value);
 
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRect(MemoryBuffer *output, const rcti *rect, void * /*data*/)
+{
+	executeRectMix<mix_subtract>(output, rect);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -50,7 +50,51 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
-	
+
+	/**
+	 * Calculate the inputs for the whole rect and mix them in a single loop,
+	 * used by executeRect of the mix operations. mix_func gets the factor
+	 * with the alpha of the second color already applied.
+	 */
+	template<void (*mix_func)(float output[4], const float color1[4], const float color2[4], float value)>
+	void executeRectMix(MemoryBuffer *output, const rcti *rect)
+	{
+		if (output->get_num_channels() != COM_NUM_CHANNELS_COLOR) {
+			NodeOperation::executeRect(output, rect, NULL);
+			return;
+		}
+
+		MemoryBuffer *inputValue = this->getInputRect(0, rect);
+		MemoryBuffer *inputColor1 = this->getInputRect(1, rect);
+		MemoryBuffer *inputColor2 = this->getInputRect(2, rect);
+		const float *value = inputValue->getBuffer();
+		const float *color1 = inputColor1->getBuffer();
+		const float *color2 = inputColor2->getBuffer();
+		const int value_stride = inputValue->get_num_channels();
+		const int width = BLI_rcti_size_x(rect);
+
+		for (int y = rect->ymin; y < rect->ymax; y++) {
+			float *elem = output->getElem(rect->xmin, y);
+			for (int x = 0; x < width; x++) {
+				float fac = value[0];
+				if (this->m_valueAlphaMultiply) {
+					fac *= color2[3];
+				}
+				mix_func(elem, color1, color2, fac);
+				clampIfNeeded(elem);
+
+				value += value_stride;
+				color1 += COM_NUM_CHANNELS_COLOR;
+				color2 += COM_NUM_CHANNELS_COLOR;
+				elem += COM_NUM_CHANNELS_COLOR;
+			}
+		}
+
+		delete inputValue;
+		delete inputColor1;
+		delete inputColor2;
+	}
+
 public:
 	/**
 	 * Default constructor
@@ -84,12 +128,14 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -156,6 +202,7 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +221,7 @@ class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +234,7 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 };
 
 class MixValueOperation : public MixBaseOperation {
@@ -23,6 +23,7 @@
 #include "COM_ReadBufferOperation.h"
 #include "COM_WriteBufferOperation.h"
 #include "COM_defines.h"
+#include "COM_BufferCache.h"
 
 ReadBufferOperation::ReadBufferOperation(DataType datatype) : NodeOperation()
 {
@@ -102,6 +103,52 @@ void ReadBufferOperation::executePixelFiltered(float output[4], float x, float y
 	}
 }
 
+void ReadBufferOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	const int num_channels = output->get_num_channels();
+	const size_t elem_size = sizeof(float) * num_channels;
+
+	if (num_channels != (int)m_buffer->get_num_channels()) {
+		NodeOperation::executeRect(output, rect, data);
+		return;
+	}
+
+	if (m_single_value) {
+		/* write buffer has a single value stored at (0,0) */
+		const float *value = m_buffer->getElem(0, 0);
+		for (int y = rect->ymin; y < rect->ymax; y++) {
+			float *elem = output->getElem(rect->xmin, y);
+			for (int x = rect->xmin; x < rect->xmax; x++) {
+				memcpy(elem, value, elem_size);
+				elem += num_channels;
+			}
+		}
+		return;
+	}
+
+	/* same as reading every pixel with COM_PS_NEAREST, clipped pixels are zero */
+	const rcti *buffer_rect = m_buffer->getRect();
+	const int xmin = max(rect->xmin, buffer_rect->xmin);
+	const int xmax = max(xmin, min(rect->xmax, buffer_rect->xmax));
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		if (y < buffer_rect->ymin || y >= buffer_rect->ymax || xmin == xmax) {
+			memset(elem, 0, elem_size * BLI_rcti_size_x(rect));
+			continue;
+		}
+		memset(elem, 0, elem_size * (xmin - rect->xmin));
+		memcpy(elem + (xmin - rect->xmin) * num_channels, m_buffer->getElem(xmin, y), elem_size * (xmax - xmin));
+		memset(elem + (xmax - rect->xmin) * num_channels, 0, elem_size * (rect->xmax - xmax));
+	}
+}
+
+bool ReadBufferOperation::hashSettings(BufferCacheHash & /*hash*/)
+{
+	/* the buffer is hashed by its write operation */
+	return true;
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	if (this == readOperation) {
@@ -21,6 +21,7 @@
  */
 
 #include "COM_RenderLayersProg.h"
+#include "COM_BufferCache.h"
 
 #include "BLI_listbase.h"
 #include "BKE_scene.h"
@@ -171,6 +172,19 @@ void RenderLayersProg::executePixelSampled(float output[4], float x, float y, Pi
 	}
 }
 
+bool RenderLayersProg::hashSettings(BufferCacheHash &hash)
+{
+	/* the render result can change without any change to the node, so hash the pass itself */
+	hash.addInt(this->m_elementsize);
+	if (this->m_inputBuffer) {
+		hash.addBuffer(this->m_inputBuffer, sizeof(float) * this->getWidth() * this->getHeight() * this->m_elementsize);
+	}
+	else {
+		hash.addInt(0);
+	}
+	return true;
+}
+
 void RenderLayersProg::deinitExecution()
 {
 	this->m_inputBuffer = NULL;
@@ -104,6 +104,7 @@ public:
 	const char *getViewName() { return this->m_viewName; }
 	void initExecution();
 	void deinitExecution();
+	bool hashSettings(BufferCacheHash &hash);
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 };
 
@@ -21,6 +21,7 @@
  */
 
 #include "COM_SetColorOperation.h"
+#include "COM_BufferCache.h"
 
 SetColorOperation::SetColorOperation() : NodeOperation()
 {
@@ -34,6 +35,25 @@ void SetColorOperation::executePixelSampled(float output[4],
 	copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeRect(MemoryBuffer *output, const rcti *rect, void */*data*/)
+{
+	const int num_channels = output->get_num_channels();
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = rect->xmin; x < rect->xmax; x++) {
+			memcpy(elem, this->m_color, sizeof(float) * num_channels);
+			elem += num_channels;
+		}
+	}
+}
+
+bool SetColorOperation::hashSettings(BufferCacheHash &hash)
+{
+	hash.add(this->m_color, sizeof(this->m_color));
+	return true;
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
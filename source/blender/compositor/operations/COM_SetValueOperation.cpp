@@ -21,6 +21,7 @@
  */
 
 #include "COM_SetValueOperation.h"
+#include "COM_BufferCache.h"
 
 SetValueOperation::SetValueOperation() : NodeOperation()
 {
@@ -34,6 +35,28 @@ void SetValueOperation::executePixelSampled(float output[4],
 	output[0] = this->m_value;
 }
 
+void SetValueOperation::executeRect(MemoryBuffer *output, const rcti *rect, void *data)
+{
+	const int num_channels = output->get_num_channels();
+	if (num_channels != 1) {
+		NodeOperation::executeRect(output, rect, data);
+		return;
+	}
+
+	for (int y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = output->getElem(rect->xmin, y);
+		for (int x = rect->xmin; x < rect->xmax; x++) {
+			elem[x - rect->xmin] = this->m_value;
+		}
+	}
+}
+
+bool SetValueOperation::hashSettings(BufferCacheHash &hash)
+{
+	hash.addFloat(this->m_value);
+	return true;
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
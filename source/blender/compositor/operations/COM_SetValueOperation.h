@@ -47,6 +47,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	bool hashSettings(BufferCacheHash &hash);
+	void executeRect(MemoryBuffer *output, const rcti *rect, void *data);
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	
 	bool isSetOperation() const { return true; }
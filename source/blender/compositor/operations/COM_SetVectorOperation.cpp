@@ -21,6 +21,7 @@
  */
 
 #include "COM_SetVectorOperation.h"
+#include "COM_BufferCache.h"
 #include "COM_defines.h"
 
 SetVectorOperation::SetVectorOperation() : NodeOperation()
@@ -37,6 +38,15 @@ void SetVectorOperation::executePixelSampled(float output[4],
 	output[2] = this->m_z;
 }
 
+bool SetVectorOperation::hashSettings(BufferCacheHash &hash)
+{
+	hash.addFloat(this->m_x);
+	hash.addFloat(this->m_y);
+	hash.addFloat(this->m_z);
+	hash.addFloat(this->m_w);
+	return true;
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -60,52 +60,16 @@ void WriteBufferOperation::deinitExecution()
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 {
 	MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
-	float *buffer = memoryBuffer->getBuffer();
-	const int num_channels = memoryBuffer->get_num_channels();
 	if (this->m_input->isComplex()) {
 		void *data = this->m_input->initializeTileData(rect);
-		int x1 = rect->xmin;
-		int y1 = rect->ymin;
-		int x2 = rect->xmax;
-		int y2 = rect->ymax;
-		int x;
-		int y;
-		bool breaked = false;
-		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
-			for (x = x1; x < x2; x++) {
-				this->m_input->read(&(buffer[offset4]), x, y, data);
-				offset4 += num_channels;
-			}
-			if (isBreaked()) {
-				breaked = true;
-			}
-
-		}
+		this->m_input->executeRect(memoryBuffer, rect, data);
 		if (data) {
 			this->m_input->deinitializeTileData(rect, data);
 			data = NULL;
 		}
 	}
 	else {
-		int x1 = rect->xmin;
-		int y1 = rect->ymin;
-		int x2 = rect->xmax;
-		int y2 = rect->ymax;
-
-		int x;
-		int y;
-		bool breaked = false;
-		for (y = y1; y < y2 && (!breaked); y++) {
-			int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
-			for (x = x1; x < x2; x++) {
-				this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-				offset4 += num_channels;
-			}
-			if (isBreaked()) {
-				breaked = true;
-			}
-		}
+		this->m_input->executeRect(memoryBuffer, rect, NULL);
 	}
 	memoryBuffer->setCreatedState();
 }
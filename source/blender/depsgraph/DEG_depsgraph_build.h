@@ -40,6 +40,7 @@ struct Depsgraph;
 
 /* ------------------------------------------------ */
 
+struct ID;
 struct Main;
 struct Scene;
 struct Group;
@@ -66,6 +67,11 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update. Only relations of this ID and
+ * its direct neighbours are rebuilt, unless the whole graph is tagged.
+ */
+void DEG_id_relations_tag_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -53,6 +53,24 @@ void DEG_stats_simple(const struct Depsgraph *graph,
 
 void DEG_debug_graphviz(const struct Depsgraph *graph, FILE *stream, const char *label, bool show_eval);
 
+/* ************************************************ */
+/* Evaluation Timeline */
+
+/* Start recording of all evaluated operations, dropping the previous recording. */
+void DEG_debug_timeline_begin(struct Depsgraph *graph);
+/* Stop recording, the recording is kept for the export. */
+void DEG_debug_timeline_end(struct Depsgraph *graph);
+
+/* Write the recording in the Trace Event Format, to be viewed in chrome://tracing.
+ * Returns false if nothing was recorded. */
+bool DEG_debug_timeline_write_chrome_trace(const struct Depsgraph *graph, FILE *stream);
+
+/* Summary of the recording, with the given number of slowest operations. */
+void DEG_debug_timeline_stats(const struct Depsgraph *graph,
+                              int num_slowest,
+                              char *result,
+                              size_t result_maxncpy);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
@@ -63,6 +81,15 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 bool DEG_debug_scene_relations_validate(struct Main *bmain,
                                         struct Scene *scene);
 
+/* Same as DEG_scene_relations_update(), returns false if the graph had to be
+ * built from scratch instead of updating relations of the tagged IDs only. */
+bool DEG_debug_scene_relations_update_incremental(struct Main *bmain,
+                                                  struct Scene *scene);
+
+/* Compare the graph with one built from scratch, without asserting. */
+bool DEG_debug_scene_relations_compare(struct Main *bmain,
+                                       struct Scene *scene);
+
 
 /* Perform consistency check on the graph. */
 bool DEG_debug_consistency_check(struct Depsgraph *graph);
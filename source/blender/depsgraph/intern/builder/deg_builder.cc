@@ -117,6 +117,18 @@ void deg_graph_build_flush_layers(Depsgraph *graph)
 	BLI_stack_free(stack);
 }
 
+void deg_graph_build_flush_customdata_mask(Depsgraph *graph)
+{
+	foreach (OperationDepsNode *node, graph->operations) {
+		IDDepsNode *id_node = node->owner->owner;
+		ID *id = id_node->id;
+		if (GS(id->name) == ID_OB) {
+			Object *object = (Object *)id;
+			object->customdata_mask |= node->customdata_mask;
+		}
+	}
+}
+
 void deg_graph_build_finalize(Depsgraph *graph)
 {
 	/* STEP 1: Make sure new invisible dependencies are ready for use.
@@ -40,5 +40,6 @@ struct Depsgraph;
 
 void deg_graph_build_finalize(struct Depsgraph *graph);
 void deg_graph_build_flush_layers(struct Depsgraph *graph);
+void deg_graph_build_flush_customdata_mask(struct Depsgraph *graph);
 
 }  // namespace DEG
@@ -0,0 +1,425 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ *
+ * Update of relations of a few objects without rebuilding the whole graph.
+ *
+ * Nodes of the tagged objects are freed together with all their relations,
+ * and built again by the regular builders. Builders skip IDs which are tagged
+ * with LIB_TAG_DOIT, so all the IDs which are kept in the graph are tagged
+ * first. Relations of the neighbour objects are built again as well, since
+ * relations from their side were freed with the nodes.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+
+extern "C" {
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_main.h"
+#include "BKE_scene.h"
+} /* extern "C" */
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/builder/deg_builder_transitive.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+#include "intern/depsgraph_types.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+/* Tagged object which nodes are to be rebuilt. */
+struct IncrementalObject {
+	Object *object;
+	Base *base;
+	/* Layers of the old ID node, which are kept for objects which are not in
+	 * the scene and only get layers flushed from their users.
+	 */
+	unsigned int layers;
+};
+
+typedef vector<IncrementalObject> IncrementalObjects;
+
+/* Objects which builders add nodes and relations for other objects, which
+ * are not known without building those objects as well.
+ */
+bool deg_incremental_object_supported(const Object *object)
+{
+	if (object->proxy != NULL ||
+	    object->proxy_from != NULL ||
+	    object->proxy_group != NULL)
+	{
+		return false;
+	}
+	if (object->particlesystem.first != NULL) {
+		return false;
+	}
+	/* Camera DOF node is added to the first object which uses the camera,
+	 * same goes for the grease pencil animation.
+	 */
+	if (object->type == OB_CAMERA || object->gpd != NULL) {
+		return false;
+	}
+	return true;
+}
+
+IDDepsNode *deg_incremental_node_owner(const DepsNode *node)
+{
+	if (node->tclass == DEG_NODE_CLASS_OPERATION) {
+		return reinterpret_cast<const OperationDepsNode *>(node)->owner->owner;
+	}
+	else if (node->tclass == DEG_NODE_CLASS_COMPONENT) {
+		return reinterpret_cast<const ComponentDepsNode *>(node)->owner;
+	}
+	return NULL;
+}
+
+/* All component and operation nodes of the ID. */
+void deg_incremental_id_nodes(IDDepsNode *id_node, vector<DepsNode *> *nodes)
+{
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		BLI_assert(comp_node->operations_map == NULL);
+		nodes->push_back(comp_node);
+		foreach (OperationDepsNode *op_node, comp_node->operations) {
+			nodes->push_back(op_node);
+		}
+	}
+	GHASH_FOREACH_END();
+}
+
+/* Collect objects which nodes are linked with nodes of the given ID.
+ *
+ * Returns false if nodes of other data-blocks are linked with the ID in
+ * either direction, relations of those are only built together with the
+ * data-block. Data of the tagged objects is an exception, it is built again
+ * with the objects.
+ */
+bool deg_incremental_collect_neighbours(IDDepsNode *id_node,
+                                        GSet *objects_data,
+                                        GSet *neighbours)
+{
+	vector<DepsNode *> nodes;
+	deg_incremental_id_nodes(id_node, &nodes);
+	foreach (DepsNode *node, nodes) {
+		foreach (DepsRelation *rel, node->inlinks) {
+			IDDepsNode *from = deg_incremental_node_owner(rel->from);
+			if (from == NULL || from == id_node) {
+				continue;
+			}
+			if (GS(from->id->name) == ID_OB) {
+				BLI_gset_add(neighbours, from->id);
+			}
+			else if (!BLI_gset_haskey(objects_data, from->id)) {
+				return false;
+			}
+		}
+		foreach (DepsRelation *rel, node->outlinks) {
+			IDDepsNode *to = deg_incremental_node_owner(rel->to);
+			if (to == NULL || to == id_node) {
+				continue;
+			}
+			if (GS(to->id->name) == ID_OB) {
+				BLI_gset_add(neighbours, to->id);
+			}
+			else if (!BLI_gset_haskey(objects_data, to->id)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/* Collect tagged objects and their neighbours, without modifying the graph.
+ *
+ * Tagged pointers might be dangling if the object was freed after it was
+ * tagged, so objects are looked up in the database instead.
+ */
+bool deg_incremental_collect(Depsgraph *graph,
+                             Main *bmain,
+                             Scene *scene,
+                             IncrementalObjects *objects,
+                             GSet *neighbours)
+{
+	GSet *objects_data = BLI_gset_ptr_new(__func__);
+	bool supported = true;
+	LINKLIST_FOREACH (Object *, object, &bmain->object) {
+		if (!BLI_gset_haskey(graph->id_relations_tags, &object->id)) {
+			continue;
+		}
+		IDDepsNode *id_node = graph->find_id_node(&object->id);
+		if (id_node == NULL) {
+			/* Object is not used by the scene. */
+			continue;
+		}
+		if (!deg_incremental_object_supported(object)) {
+			supported = false;
+			break;
+		}
+		IncrementalObject incremental_object;
+		incremental_object.object = object;
+		incremental_object.base = BKE_scene_base_find(scene, object);
+		incremental_object.layers = id_node->layers;
+		objects->push_back(incremental_object);
+		if (object->data != NULL) {
+			BLI_gset_add(objects_data, object->data);
+		}
+	}
+	if (supported) {
+		foreach (const IncrementalObject &incremental_object, *objects) {
+			IDDepsNode *id_node = graph->find_id_node(&incremental_object.object->id);
+			if (!deg_incremental_collect_neighbours(id_node,
+			                                        objects_data,
+			                                        neighbours))
+			{
+				supported = false;
+				break;
+			}
+		}
+	}
+	BLI_gset_free(objects_data, NULL);
+	return supported;
+}
+
+void deg_incremental_relations_remove(DepsNode::Relations *relations,
+                                      DepsRelation *rel)
+{
+	DepsNode::Relations::iterator it = std::find(relations->begin(),
+	                                             relations->end(),
+	                                             rel);
+	BLI_assert(it != relations->end());
+	relations->erase(it);
+}
+
+/* Free the ID node together with all its relations. Operations are to be
+ * removed from graph->operations by the caller.
+ */
+void deg_incremental_free_id_node(Depsgraph *graph, IDDepsNode *id_node)
+{
+	vector<DepsNode *> nodes;
+	deg_incremental_id_nodes(id_node, &nodes);
+	/* Relations between nodes of the same ID are in both outlinks and
+	 * inlinks of its nodes, so outgoing relations are all freed first and
+	 * only incoming relations from other IDs are left after that.
+	 */
+	foreach (DepsNode *node, nodes) {
+		foreach (DepsRelation *rel, node->outlinks) {
+			deg_incremental_relations_remove(&rel->to->inlinks, rel);
+			OBJECT_GUARDED_DELETE(rel, DepsRelation);
+		}
+		node->outlinks.clear();
+	}
+	foreach (DepsNode *node, nodes) {
+		foreach (DepsRelation *rel, node->inlinks) {
+			deg_incremental_relations_remove(&rel->from->outlinks, rel);
+			OBJECT_GUARDED_DELETE(rel, DepsRelation);
+		}
+		node->inlinks.clear();
+		if (node->tclass == DEG_NODE_CLASS_OPERATION) {
+			BLI_gset_remove(graph->entry_tags, node, NULL);
+		}
+	}
+	BLI_ghash_remove(graph->id_hash, id_node->id, NULL, NULL);
+	OBJECT_GUARDED_DELETE(id_node, IDDepsNode);
+}
+
+void deg_incremental_free_objects_nodes(Depsgraph *graph,
+                                        const IncrementalObjects &objects)
+{
+	GSet *id_nodes = BLI_gset_ptr_new(__func__);
+	foreach (const IncrementalObject &incremental_object, objects) {
+		BLI_gset_add(id_nodes, graph->find_id_node(&incremental_object.object->id));
+	}
+	size_t num_operations = 0;
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (!BLI_gset_haskey(id_nodes, op_node->owner->owner)) {
+			graph->operations[num_operations++] = op_node;
+		}
+	}
+	graph->operations.resize(num_operations);
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, id_nodes)
+	{
+		deg_incremental_free_id_node(graph, id_node);
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(id_nodes, NULL);
+}
+
+/* Compare the graph with the graph built from scratch. */
+bool deg_incremental_validate(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	::Depsgraph *full_graph = DEG_graph_new();
+	DEG_graph_build_from_scene(full_graph, bmain, scene);
+	const bool valid = DEG_debug_compare(reinterpret_cast< ::Depsgraph *>(graph),
+	                                     full_graph);
+	DEG_graph_free(full_graph);
+	if (!valid) {
+		fprintf(stderr,
+		        "Incremental relations update of scene %s differs from the "
+		        "full rebuild\n",
+		        scene->id.name + 2);
+	}
+	return valid;
+}
+
+}  /* namespace */
+
+bool deg_graph_build_incremental(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	/* Scene level builders add relations for all objects of the scene. */
+	if (scene->set != NULL || scene->rigidbody_world != NULL) {
+		return false;
+	}
+
+	/* 1) Find out which objects are to be rebuilt. */
+	IncrementalObjects objects;
+	GSet *rebuild_objects = BLI_gset_ptr_new(__func__);
+	if (!deg_incremental_collect(graph, bmain, scene, &objects, rebuild_objects)) {
+		BLI_gset_free(rebuild_objects, NULL);
+		return false;
+	}
+	if (objects.empty()) {
+		BLI_gset_free(rebuild_objects, NULL);
+		return true;
+	}
+	foreach (const IncrementalObject &incremental_object, objects) {
+		BLI_gset_add(rebuild_objects, &incremental_object.object->id);
+	}
+	DEG_DEBUG_PRINTF("Incremental relations update of %d objects, %d objects "
+	                 "with relations rebuilt\n",
+	                 (int)objects.size(),
+	                 (int)BLI_gset_size(rebuild_objects));
+
+	/* 2) Free nodes of the tagged objects, IDs which are left in the graph
+	 *    are not built again.
+	 */
+	deg_incremental_free_objects_nodes(graph, objects);
+	GSet *built_ids = BLI_gset_ptr_new(__func__);
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		BLI_gset_add(built_ids, id_node->id);
+	}
+	GHASH_FOREACH_END();
+
+	/* 3) Build nodes of the tagged objects, and of scene objects which are
+	 *    not in the graph yet.
+	 */
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build_incremental(scene);
+	foreach (const IncrementalObject &incremental_object, objects) {
+		node_builder.build_object(incremental_object.base,
+		                          incremental_object.object);
+	}
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		node_builder.build_object(base, base->object);
+	}
+	foreach (const IncrementalObject &incremental_object, objects) {
+		IDDepsNode *id_node = graph->find_id_node(&incremental_object.object->id);
+		id_node->layers |= incremental_object.layers;
+	}
+
+	/* 4) Build relations of new IDs, tagged objects and their neighbours.
+	 *    Object data is built again as well, since some of its relations
+	 *    are added to the first object which uses it.
+	 */
+	DepsgraphRelationBuilder relation_builder(bmain, graph);
+	relation_builder.begin_build_incremental(scene);
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		if (!BLI_gset_haskey(built_ids, id_node->id)) {
+			id_node->id->tag &= ~LIB_TAG_DOIT;
+		}
+	}
+	GHASH_FOREACH_END();
+	GSET_FOREACH_BEGIN(Object *, object, rebuild_objects)
+	{
+		object->id.tag &= ~LIB_TAG_DOIT;
+		if (object->data != NULL) {
+			((ID *)object->data)->tag &= ~LIB_TAG_DOIT;
+		}
+	}
+	GSET_FOREACH_END();
+	GSET_FOREACH_BEGIN(Object *, object, rebuild_objects)
+	{
+		relation_builder.build_object(object);
+	}
+	GSET_FOREACH_END();
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		relation_builder.build_object(base->object);
+	}
+	BLI_gset_free(built_ids, NULL);
+	BLI_gset_free(rebuild_objects, NULL);
+
+	/* 5) Cycles are detected for the whole graph again, since relations
+	 *    which were closing cycles might not be in a cycle anymore.
+	 */
+	foreach (OperationDepsNode *node, graph->operations) {
+		foreach (DepsRelation *rel, node->outlinks) {
+			rel->flag &= ~DEPSREL_FLAG_CYCLIC;
+		}
+	}
+	deg_graph_detect_cycles(graph);
+	if (G.debug_value == 799) {
+		deg_graph_transitive_reduction(graph);
+	}
+	deg_graph_build_flush_customdata_mask(graph);
+	deg_graph_build_finalize(graph);
+
+	/* New nodes don't know whether the object was evaluated already. */
+	foreach (const IncrementalObject &incremental_object, objects) {
+		IDDepsNode *id_node = graph->find_id_node(&incremental_object.object->id);
+		id_node->tag_update(graph);
+	}
+
+	if (G.debug & G_DEBUG_DEPSGRAPH_VALIDATE) {
+		return deg_incremental_validate(graph, bmain, scene);
+	}
+	return true;
+}
+
+}  // namespace DEG
@@ -38,6 +38,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 
@@ -295,6 +296,20 @@ void DepsgraphNodeBuilder::begin_build() {
 	FOREACH_NODETREE_END;
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental(Scene *scene)
+{
+	begin_build();
+	/* Builders skip IDs which have LIB_TAG_DOIT set, so tag all IDs which
+	 * already have nodes.
+	 */
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph_->id_hash)
+	{
+		id_node->id->tag |= LIB_TAG_DOIT;
+	}
+	GHASH_FOREACH_END();
+	scene_ = scene;
+}
+
 void DepsgraphNodeBuilder::build_group(Base *base, Group *group)
 {
 	ID *group_id = &group->id;
@@ -71,6 +71,10 @@ struct DepsgraphNodeBuilder {
 	~DepsgraphNodeBuilder();
 
 	void begin_build();
+	/* Prepare for adding nodes of IDs which are not in the graph yet, nodes
+	 * which are already in the graph are kept untouched.
+	 */
+	void begin_build_incremental(Scene *scene);
 
 	IDDepsNode *add_id_node(ID *id);
 	TimeSourceDepsNode *add_time_source();
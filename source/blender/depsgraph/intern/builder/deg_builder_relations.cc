@@ -40,6 +40,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 
 extern "C" {
 #include "DNA_action_types.h"
@@ -205,7 +206,8 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    Depsgraph *graph)
     : bmain_(bmain),
       graph_(graph),
-      scene_(NULL)
+      scene_(NULL),
+      check_unique_relations_(false)
 {
 }
 
@@ -277,7 +279,10 @@ void DepsgraphRelationBuilder::add_time_relation(TimeSourceDepsNode *timesrc,
                                                  bool check_unique)
 {
 	if (timesrc && node_to) {
-		graph_->add_new_relation(timesrc, node_to, description, check_unique);
+		graph_->add_new_relation(timesrc,
+		                         node_to,
+		                         description,
+		                         check_unique || check_unique_relations_);
 	}
 	else {
 		DEG_DEBUG_PRINTF("add_time_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -294,7 +299,10 @@ void DepsgraphRelationBuilder::add_operation_relation(
         bool check_unique)
 {
 	if (node_from && node_to) {
-		graph_->add_new_relation(node_from, node_to, description, check_unique);
+		graph_->add_new_relation(node_from,
+		                         node_to,
+		                         description,
+		                         check_unique || check_unique_relations_);
 	}
 	else {
 		DEG_DEBUG_PRINTF("add_operation_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -420,6 +428,18 @@ void DepsgraphRelationBuilder::begin_build()
 	FOREACH_NODETREE_END;
 }
 
+void DepsgraphRelationBuilder::begin_build_incremental(Scene *scene)
+{
+	begin_build();
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph_->id_hash)
+	{
+		id_node->id->tag |= LIB_TAG_DOIT;
+	}
+	GHASH_FOREACH_END();
+	check_unique_relations_ = true;
+	scene_ = scene;
+}
+
 void DepsgraphRelationBuilder::build_group(Object *object, Group *group)
 {
 	ID *group_id = &group->id;
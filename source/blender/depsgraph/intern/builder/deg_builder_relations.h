@@ -170,6 +170,12 @@ struct DepsgraphRelationBuilder
 	DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph);
 
 	void begin_build();
+	/* Prepare for adding relations of some of the IDs to the graph which
+	 * already has relations. Relations are only added for IDs which don't
+	 * have LIB_TAG_DOIT set, and relations which already exist are not
+	 * duplicated.
+	 */
+	void begin_build_incremental(Scene *scene);
 
 	template <typename KeyFrom, typename KeyTo>
 	void add_relation(const KeyFrom& key_from,
@@ -286,6 +292,11 @@ private:
 
 	/* State which demotes currently built entities. */
 	Scene *scene_;
+
+	/* Check for existing relations before adding new ones, used when only
+	 * part of the graph is being rebuilt.
+	 */
+	bool check_unique_relations_;
 };
 
 struct DepsNodeHandle
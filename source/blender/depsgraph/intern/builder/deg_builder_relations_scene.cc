@@ -107,18 +107,7 @@ void DepsgraphRelationBuilder::build_scene(Scene *scene)
 	LINKLIST_FOREACH (MovieClip *, clip, &bmain_->movieclip) {
 		build_movieclip(clip);
 	}
-	for (Depsgraph::OperationNodes::const_iterator it_op = graph_->operations.begin();
-	     it_op != graph_->operations.end();
-	     ++it_op)
-	{
-		OperationDepsNode *node = *it_op;
-		IDDepsNode *id_node = node->owner->owner;
-		ID *id = id_node->id;
-		if (GS(id->name) == ID_OB) {
-			Object *object = (Object *)id;
-			object->customdata_mask |= node->customdata_mask;
-		}
-	}
+	deg_graph_build_flush_customdata_mask(graph_);
 }
 
 }  // namespace DEG
@@ -0,0 +1,323 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/debug/deg_debug_timeline.cc
+ *  \ingroup depsgraph
+ *
+ * Recording of the evaluation timeline and its export to the Trace Event
+ * Format, which can be loaded into chrome://tracing.
+ */
+
+#include "intern/debug/deg_debug_timeline.h"
+
+#include <algorithm>
+#include <map>
+
+#include "PIL_time.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+DepsgraphTimeline::DepsgraphTimeline()
+  : is_recording(false),
+    time_origin(PIL_check_seconds_timer())
+{
+}
+
+void DepsgraphTimeline::begin_evaluation(float frame, int num_threads)
+{
+	if (thread_events.size() < (size_t)num_threads) {
+		thread_events.resize(num_threads);
+	}
+	DepsgraphTimelineEvaluation evaluation;
+	evaluation.start_time = PIL_check_seconds_timer();
+	evaluation.end_time = evaluation.start_time;
+	evaluation.frame = frame;
+	evaluation.num_threads = num_threads;
+	evaluations.push_back(evaluation);
+}
+
+void DepsgraphTimeline::end_evaluation()
+{
+	BLI_assert(!evaluations.empty());
+	evaluations.back().end_time = PIL_check_seconds_timer();
+}
+
+void DepsgraphTimeline::add_operation(int thread_id,
+                                      const OperationDepsNode *node,
+                                      double start_time,
+                                      double end_time)
+{
+	BLI_assert(thread_id < (int)thread_events.size());
+	const ComponentDepsNode *comp_node = node->owner;
+	DepsgraphTimelineEvent event;
+	event.id_name = comp_node->owner->name;
+	if (comp_node->type == DEG_NODE_TYPE_BONE) {
+		event.name = string(comp_node->name) + "." + node->identifier();
+	}
+	else {
+		event.name = node->identifier();
+	}
+	event.start_time = start_time;
+	event.end_time = end_time;
+	thread_events[thread_id].push_back(event);
+}
+
+/* ****************** */
+/* Chrome Trace Export */
+
+static void deg_debug_timeline_write_string(FILE *f, const string &str)
+{
+	fputc('"', f);
+	for (size_t i = 0; i < str.size(); i++) {
+		const unsigned char c = str[i];
+		if (c == '"' || c == '\\') {
+			fprintf(f, "\\%c", c);
+		}
+		else if (c < 0x20) {
+			fprintf(f, "\\u%04x", c);
+		}
+		else {
+			fputc(c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+/* Timestamps of the trace format are in microseconds. */
+static double deg_debug_timeline_usec(double time, double time_origin)
+{
+	return (time - time_origin) * 1e6;
+}
+
+void DepsgraphTimeline::write_chrome_trace(FILE *f) const
+{
+	fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (size_t thread_id = 0; thread_id < thread_events.size(); thread_id++) {
+		fprintf(f,
+		        "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+		        "\"tid\": %d, \"args\": {\"name\": \"%s %d\"}},\n",
+		        (int)thread_id,
+		        (thread_id == 0) ? "Main" : "Worker",
+		        (int)thread_id);
+	}
+	/* Evaluations are put on the main thread, which is evaluating
+	 * operations as well.
+	 */
+	foreach (const DepsgraphTimelineEvaluation &evaluation, evaluations) {
+		fprintf(f,
+		        "{\"name\": \"Frame %g\", \"cat\": \"evaluation\", \"ph\": \"X\", "
+		        "\"pid\": 0, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f, "
+		        "\"args\": {\"threads\": %d}},\n",
+		        evaluation.frame,
+		        deg_debug_timeline_usec(evaluation.start_time, time_origin),
+		        (evaluation.end_time - evaluation.start_time) * 1e6,
+		        evaluation.num_threads);
+	}
+	for (size_t thread_id = 0; thread_id < thread_events.size(); thread_id++) {
+		foreach (const DepsgraphTimelineEvent &event, thread_events[thread_id]) {
+			fprintf(f, "{\"name\": ");
+			deg_debug_timeline_write_string(f, event.name);
+			fprintf(f, ", \"cat\": \"operation\", \"ph\": \"X\", \"pid\": 0, "
+			        "\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"id\": ",
+			        (int)thread_id,
+			        deg_debug_timeline_usec(event.start_time, time_origin),
+			        (event.end_time - event.start_time) * 1e6);
+			deg_debug_timeline_write_string(f, event.id_name);
+			fprintf(f, "}},\n");
+		}
+	}
+	/* Trailing entry, so all the above can end with a comma. */
+	fprintf(f, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, "
+	        "\"args\": {\"name\": \"Depsgraph\"}}\n");
+	fprintf(f, "]}\n");
+}
+
+/* ****************** */
+/* Summary Statistics */
+
+struct DepsgraphTimelineOperationStats {
+	DepsgraphTimelineOperationStats()
+	  : total_time(0.0),
+	    max_time(0.0),
+	    count(0)
+	{
+	}
+
+	string id_name;
+	string name;
+	double total_time;
+	double max_time;
+	int count;
+};
+
+static bool deg_debug_timeline_stats_slower(
+        const DepsgraphTimelineOperationStats *a,
+        const DepsgraphTimelineOperationStats *b)
+{
+	return a->total_time > b->total_time;
+}
+
+string DepsgraphTimeline::stats(int num_slowest) const
+{
+	typedef std::pair<string, string> OperationKey;
+	typedef std::map<OperationKey, DepsgraphTimelineOperationStats> OperationStatsMap;
+
+	double evaluation_time = 0.0;
+	double thread_time = 0.0;
+	foreach (const DepsgraphTimelineEvaluation &evaluation, evaluations) {
+		const double time = evaluation.end_time - evaluation.start_time;
+		evaluation_time += time;
+		thread_time += time * evaluation.num_threads;
+	}
+
+	/* Accumulate all evaluations of the same operation. */
+	OperationStatsMap operation_stats;
+	double operation_time = 0.0;
+	size_t num_operations = 0;
+	foreach (const vector<DepsgraphTimelineEvent> &events, thread_events) {
+		foreach (const DepsgraphTimelineEvent &event, events) {
+			const double time = event.end_time - event.start_time;
+			DepsgraphTimelineOperationStats &stats =
+			        operation_stats[OperationKey(event.id_name, event.name)];
+			if (stats.count == 0) {
+				stats.id_name = event.id_name;
+				stats.name = event.name;
+			}
+			stats.total_time += time;
+			stats.max_time = std::max(stats.max_time, time);
+			stats.count++;
+			operation_time += time;
+			num_operations++;
+		}
+	}
+
+	vector<const DepsgraphTimelineOperationStats *> sorted_stats;
+	sorted_stats.reserve(operation_stats.size());
+	for (OperationStatsMap::const_iterator it = operation_stats.begin();
+	     it != operation_stats.end();
+	     ++it)
+	{
+		sorted_stats.push_back(&it->second);
+	}
+	std::sort(sorted_stats.begin(),
+	          sorted_stats.end(),
+	          deg_debug_timeline_stats_slower);
+
+	char line[1024];
+	string result;
+
+	BLI_snprintf(line, sizeof(line),
+	             "Evaluations: %d, total time: %.3f ms, average: %.3f ms\n",
+	             (int)evaluations.size(),
+	             evaluation_time * 1e3,
+	             evaluations.empty() ? 0.0 : evaluation_time * 1e3 / evaluations.size());
+	result += line;
+	BLI_snprintf(line, sizeof(line),
+	             "Operations evaluated: %d, operations time: %.3f ms\n",
+	             (int)num_operations,
+	             operation_time * 1e3);
+	result += line;
+	/* Share of the time threads were busy evaluating operations, the rest
+	 * is spent waiting for dependencies or in the scheduler.
+	 */
+	BLI_snprintf(line, sizeof(line),
+	             "Parallel efficiency: %.1f%%\n",
+	             (thread_time > 0.0) ? operation_time / thread_time * 100.0 : 0.0);
+	result += line;
+
+	const int num_lines = std::min(num_slowest, (int)sorted_stats.size());
+	if (num_lines > 0) {
+		result += "Slowest operations (total, count, max):\n";
+	}
+	for (int i = 0; i < num_lines; i++) {
+		const DepsgraphTimelineOperationStats *stats = sorted_stats[i];
+		BLI_snprintf(line, sizeof(line),
+		             "  %10.3f ms %6d %10.3f ms  %s %s\n",
+		             stats->total_time * 1e3,
+		             stats->count,
+		             stats->max_time * 1e3,
+		             stats->id_name.c_str(),
+		             stats->name.c_str());
+		result += line;
+	}
+	return result;
+}
+
+}  // namespace DEG
+
+/* ****************** */
+/* Public API */
+
+void DEG_debug_timeline_begin(Depsgraph *graph)
+{
+	using DEG::DepsgraphTimeline;
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	/* Start over, dropping the previous recording. */
+	if (deg_graph->timeline != NULL) {
+		OBJECT_GUARDED_DELETE(deg_graph->timeline, DepsgraphTimeline);
+	}
+	deg_graph->timeline = OBJECT_GUARDED_NEW(DEG::DepsgraphTimeline);
+	deg_graph->timeline->is_recording = true;
+}
+
+void DEG_debug_timeline_end(Depsgraph *graph)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	if (deg_graph->timeline != NULL) {
+		deg_graph->timeline->is_recording = false;
+	}
+}
+
+bool DEG_debug_timeline_write_chrome_trace(const Depsgraph *graph, FILE *f)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	if (deg_graph->timeline == NULL) {
+		return false;
+	}
+	deg_graph->timeline->write_chrome_trace(f);
+	return true;
+}
+
+void DEG_debug_timeline_stats(const Depsgraph *graph,
+                              int num_slowest,
+                              char *result,
+                              size_t result_maxncpy)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	if (deg_graph->timeline == NULL) {
+		BLI_strncpy(result, "Timeline was not recorded", result_maxncpy);
+		return;
+	}
+	const std::string stats = deg_graph->timeline->stats(num_slowest);
+	BLI_strncpy(result, stats.c_str(), result_maxncpy);
+}
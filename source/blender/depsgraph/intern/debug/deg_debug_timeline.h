@@ -0,0 +1,97 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/debug/deg_debug_timeline.h
+ *  \ingroup depsgraph
+ *
+ * Recording of the evaluation timeline, for finding out where the time of
+ * depsgraph updates goes.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct OperationDepsNode;
+
+/* Single evaluated operation. */
+struct DepsgraphTimelineEvent {
+	/* Name of the ID and operation. Copied, since the nodes might be freed
+	 * when relations are rebuilt.
+	 */
+	string id_name;
+	string name;
+	double start_time;
+	double end_time;
+};
+
+/* Whole evaluation of the graph, from deg_evaluate_on_refresh(). */
+struct DepsgraphTimelineEvaluation {
+	double start_time;
+	double end_time;
+	float frame;
+	int num_threads;
+};
+
+/* Timeline of all evaluations done while recording. Every thread appends
+ * to its own list of events, so no locking is needed for recording.
+ */
+struct DepsgraphTimeline {
+	DepsgraphTimeline();
+
+	/* Called before and after the graph is evaluated, from the thread doing
+	 * the evaluation.
+	 */
+	void begin_evaluation(float frame, int num_threads);
+	void end_evaluation();
+
+	/* Record evaluation of an operation, from the thread which evaluated it. */
+	void add_operation(int thread_id,
+	                   const OperationDepsNode *node,
+	                   double start_time,
+	                   double end_time);
+
+	/* Export all events in the Trace Event Format, as used by the
+	 * chrome://tracing viewer.
+	 */
+	void write_chrome_trace(FILE *stream) const;
+
+	/* Summary of the recording: total times, parallel efficiency and the
+	 * operations which took most of the time.
+	 */
+	string stats(int num_slowest) const;
+
+	/* Evaluations are only recorded while this is set, the recording is kept
+	 * afterwards for the export.
+	 */
+	bool is_recording;
+
+	/* Time all timestamps are relative to. */
+	double time_origin;
+
+	vector<DepsgraphTimelineEvaluation> evaluations;
+	vector< vector<DepsgraphTimelineEvent> > thread_events;
+};
+
+}  // namespace DEG
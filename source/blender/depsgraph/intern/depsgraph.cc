@@ -55,6 +55,7 @@ extern "C" {
 
 #include "DEG_depsgraph.h"
 
+#include "intern/debug/deg_debug_timeline.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -71,11 +72,13 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 Depsgraph::Depsgraph()
   : time_source(NULL),
     need_update(false),
-    layers(0)
+    layers(0),
+    timeline(NULL)
 {
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -83,9 +86,13 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
+	if (timeline != NULL) {
+		OBJECT_GUARDED_DELETE(timeline, DepsgraphTimeline);
+	}
 	BLI_spin_end(&lock);
 }
 
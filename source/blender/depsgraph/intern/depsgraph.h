@@ -53,6 +53,7 @@ struct TimeSourceDepsNode;
 struct IDDepsNode;
 struct ComponentDepsNode;
 struct OperationDepsNode;
+struct DepsgraphTimeline;
 
 /* *************************** */
 /* Relationships Between Nodes */
@@ -151,6 +152,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations needs to be updated, used when only relations of
+	 * some IDs were tagged and need_update is not set.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -172,6 +178,11 @@ struct Depsgraph {
 	/* Visible layers bitfield, used for skipping invisible objects updates. */
 	unsigned int layers;
 
+	/* Debugging .......................... */
+
+	/* Timeline of evaluated operations, NULL unless it was requested. */
+	DepsgraphTimeline *timeline;
+
 	// XXX: additional stuff like eval contexts, mempools for allocating nodes from, etc.
 };
 
@@ -60,6 +60,7 @@ extern "C" {
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -251,6 +252,26 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
 	deg_graph->need_update = true;
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (GS(id->name) != ID_OB) {
+		/* Only objects are supported by the incremental update. */
+		DEG_relations_tag_update(bmain);
+		return;
+	}
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG::Depsgraph *deg_graph =
+			        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+			BLI_gset_add(deg_graph->id_relations_tags, id);
+		}
+	}
+}
+
 /* Tag all relations for update. */
 void DEG_relations_tag_update(Main *bmain)
 {
@@ -264,22 +285,29 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
-/* Create new graph if didn't exist yet,
- * or update relations if graph was tagged for update.
- */
-void DEG_scene_relations_update(Main *bmain, Scene *scene)
+/* Returns false if the graph was built from scratch. */
+static bool deg_scene_relations_update(Main *bmain, Scene *scene)
 {
 	if (scene->depsgraph == NULL) {
 		/* Rebuild graph from scratch and exit. */
 		scene->depsgraph = DEG_graph_new();
 		DEG_graph_build_from_scene(scene->depsgraph, bmain, scene);
-		return;
+		return false;
 	}
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return true;
+		}
+		/* Only relations of some objects were tagged, try to update them
+		 * without rebuilding the whole graph.
+		 */
+		if (DEG::deg_graph_build_incremental(graph, bmain, scene)) {
+			BLI_gset_clear(graph->id_relations_tags, NULL);
+			return true;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
@@ -292,7 +320,22 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 	                           bmain,
 	                           scene);
 
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 	graph->need_update = false;
+	return false;
+}
+
+/* Create new graph if didn't exist yet,
+ * or update relations if graph was tagged for update.
+ */
+void DEG_scene_relations_update(Main *bmain, Scene *scene)
+{
+	deg_scene_relations_update(bmain, scene);
+}
+
+bool DEG_debug_scene_relations_update_incremental(Main *bmain, Scene *scene)
+{
+	return deg_scene_relations_update(bmain, scene);
 }
 
 /* Rebuild dependency graph only for a given scene. */
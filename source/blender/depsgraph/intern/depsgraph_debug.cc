@@ -30,8 +30,11 @@
  * Implementation of tools for debugging the depsgraph
  */
 
+#include <set>
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_string.h"
 
 extern "C" {
 #include "DNA_scene_types.h"
@@ -44,6 +47,81 @@ extern "C" {
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
+namespace {
+
+typedef std::set<std::string> DebugKeySet;
+
+/* Key of the node which does not depend on the node's address, so same
+ * nodes of different graphs built for the same scene have the same key.
+ */
+std::string deg_debug_node_key(const DEG::DepsNode *node)
+{
+	char type[16];
+	BLI_snprintf(type, sizeof(type), "(%d)", (int)node->type);
+	if (node->tclass == DEG::DEG_NODE_CLASS_OPERATION) {
+		const DEG::OperationDepsNode *op_node =
+		        reinterpret_cast<const DEG::OperationDepsNode *>(node);
+		char name_tag[16] = "";
+		if (op_node->name_tag != -1) {
+			BLI_snprintf(name_tag, sizeof(name_tag), "[%d]", op_node->name_tag);
+		}
+		return deg_debug_node_key(op_node->owner) + "." +
+		       op_node->identifier() + name_tag;
+	}
+	else if (node->tclass == DEG::DEG_NODE_CLASS_COMPONENT) {
+		const DEG::ComponentDepsNode *comp_node =
+		        reinterpret_cast<const DEG::ComponentDepsNode *>(node);
+		return std::string(comp_node->owner->name) + type + comp_node->name;
+	}
+	return std::string(node->name) + type;
+}
+
+std::string deg_debug_relation_key(const DEG::DepsRelation *rel)
+{
+	return deg_debug_node_key(rel->from) + " -> " +
+	       deg_debug_node_key(rel->to) + " (" + rel->name + ")";
+}
+
+void deg_debug_graph_keys(const DEG::Depsgraph *graph,
+                          DebugKeySet *operations,
+                          DebugKeySet *relations)
+{
+	foreach (const DEG::OperationDepsNode *node, graph->operations) {
+		operations->insert(deg_debug_node_key(node));
+		foreach (const DEG::DepsRelation *rel, node->inlinks) {
+			relations->insert(deg_debug_relation_key(rel));
+		}
+	}
+	/* Time source is the only node which is linked to components. */
+	if (graph->time_source != NULL) {
+		foreach (const DEG::DepsRelation *rel, graph->time_source->outlinks) {
+			relations->insert(deg_debug_relation_key(rel));
+		}
+	}
+}
+
+bool deg_debug_compare_keys(const char *what,
+                            const DebugKeySet &keys1,
+                            const DebugKeySet &keys2)
+{
+	bool equal = true;
+	foreach (const std::string &key, keys1) {
+		if (keys2.find(key) == keys2.end()) {
+			fprintf(stderr, "%s only in first graph: %s\n", what, key.c_str());
+			equal = false;
+		}
+	}
+	foreach (const std::string &key, keys2) {
+		if (keys1.find(key) == keys1.end()) {
+			fprintf(stderr, "%s only in second graph: %s\n", what, key.c_str());
+			equal = false;
+		}
+	}
+	return equal;
+}
+
+}  /* namespace */
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -51,17 +129,21 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 	BLI_assert(graph2 != NULL);
 	const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
 	const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
-	if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
-		return false;
-	}
-	/* TODO(sergey): Currently we only do real stupid check,
-	 * which is fast but which isn't 100% reliable.
-	 *
-	 * Would be cool to make it more robust, but it's good enough
-	 * for now. Also, proper graph check is actually NP-complex
-	 * problem..
+	/* Compare operations and relations by their names, which is the same for
+	 * both graphs unless they were built differently. Multiple relations
+	 * between the same nodes are only counted once.
 	 */
-	return true;
+	DebugKeySet operations1, operations2;
+	DebugKeySet relations1, relations2;
+	deg_debug_graph_keys(deg_graph1, &operations1, &relations1);
+	deg_debug_graph_keys(deg_graph2, &operations2, &relations2);
+	const bool operations_equal = deg_debug_compare_keys("Operation",
+	                                                     operations1,
+	                                                     operations2);
+	const bool relations_equal = deg_debug_compare_keys("Relation",
+	                                                    relations1,
+	                                                    relations2);
+	return operations_equal && relations_equal;
 }
 
 bool DEG_debug_scene_relations_validate(Main *bmain,
@@ -79,6 +161,19 @@ bool DEG_debug_scene_relations_validate(Main *bmain,
 	return valid;
 }
 
+bool DEG_debug_scene_relations_compare(Main *bmain,
+                                       Scene *scene)
+{
+	if (scene->depsgraph == NULL) {
+		return false;
+	}
+	Depsgraph *depsgraph = DEG_graph_new();
+	DEG_graph_build_from_scene(depsgraph, bmain, scene);
+	const bool equal = DEG_debug_compare(depsgraph, scene->depsgraph);
+	DEG_graph_free(depsgraph);
+	return equal;
+}
+
 bool DEG_debug_consistency_check(Depsgraph *graph)
 {
 	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
@@ -48,6 +48,7 @@ extern "C" {
 #include "BKE_idcode.h"
 #include "BKE_library.h"
 #include "BKE_main.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_node.h"
 
 #define new new_
@@ -181,6 +182,7 @@ void DEG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 	}
 	DEG_DEBUG_PRINTF("%s: id=%s flag=%d\n", __func__, id->name, flag);
 	lib_id_recalc_tag_flag(bmain, id, flag);
+	BKE_modifier_cache_tag_update(id);
 	for (Scene *scene = (Scene *)bmain->scene.first;
 	     scene != NULL;
 	     scene = (Scene *)scene->id.next)
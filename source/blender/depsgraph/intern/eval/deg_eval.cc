@@ -32,13 +32,18 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
 #include "PIL_time.h"
 
 #include "BLI_utildefines.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
+#include "BLI_threads.h"
 
 extern "C" {
+#include "BLI_heap.h"
+
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
 } /* extern "C" */
@@ -47,6 +52,7 @@ extern "C" {
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_timeline.h"
 #include "intern/eval/deg_eval_flush.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
@@ -55,8 +61,12 @@ extern "C" {
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
-/* Unfinished and unused, and takes quite some pre-processing time. */
-#undef USE_EVAL_PRIORITY
+/* Schedule operations by the length of the longest chain of operations
+ * depending on them, estimated from the measured evaluation times. This way
+ * long chains (like rigs) are started first and don't keep a single core busy
+ * at the end of the update.
+ */
+#define USE_EVAL_PRIORITY
 
 /* Use integrated debugger to keep track how much each of the nodes was
  * evaluating.
@@ -65,6 +75,16 @@ extern "C" {
 
 namespace DEG {
 
+#ifdef USE_EVAL_PRIORITY
+/* Weight of the latest measurement in the moving average of the evaluation
+ * time of an operation.
+ */
+#define EVAL_TIME_AVERAGE_WEIGHT 0.25f
+
+/* Cost in seconds of operations which were never evaluated yet. */
+#define EVAL_TIME_DEFAULT 1e-5f
+#endif
+
 /* ********************** */
 /* Evaluation Entrypoints */
 
@@ -79,6 +99,18 @@ struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
 	unsigned int layers;
+	/* Timeline to record evaluated operations to, NULL if not recording. */
+	DepsgraphTimeline *timeline;
+#ifdef USE_EVAL_PRIORITY
+	/* Ready operations, ordered by priority. Every one of them has a task
+	 * pushed without data, which evaluates the operation with the highest
+	 * priority at the time the task starts. This way all workers take the
+	 * longest critical path first, regardless of the order in which the
+	 * scheduler runs or steals tasks.
+	 */
+	Heap *ready_heap;
+	SpinLock ready_lock;
+#endif
 };
 
 static void deg_task_run_func(TaskPool *pool,
@@ -89,6 +121,15 @@ static void deg_task_run_func(TaskPool *pool,
 	        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
 	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(taskdata);
 
+#ifdef USE_EVAL_PRIORITY
+	if (node == NULL) {
+		BLI_spin_lock(&state->ready_lock);
+		node = (OperationDepsNode *)BLI_heap_popmin(state->ready_heap);
+		BLI_spin_unlock(&state->ready_lock);
+	}
+	BLI_assert(node != NULL);
+#endif
+
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
 
 	/* Should only be the case for NOOPs, which never get to this point. */
@@ -108,8 +149,8 @@ static void deg_task_run_func(TaskPool *pool,
 	 */
 	if (node->evaluate) {
 			/* Take note of current time. */
-#ifdef USE_DEBUGGER
 		double start_time = PIL_check_seconds_timer();
+#ifdef USE_DEBUGGER
 		DepsgraphDebug::task_started(state->graph, node);
 #endif
 
@@ -117,11 +158,25 @@ static void deg_task_run_func(TaskPool *pool,
 		node->evaluate(state->eval_ctx);
 
 			/* Note how long this took. */
-#ifdef USE_DEBUGGER
 		double end_time = PIL_check_seconds_timer();
+		if (state->timeline != NULL) {
+			state->timeline->add_operation(thread_id, node, start_time, end_time);
+		}
+#ifdef USE_DEBUGGER
 		DepsgraphDebug::task_completed(state->graph,
 		                               node,
 		                               end_time - start_time);
+#endif
+#ifdef USE_EVAL_PRIORITY
+		/* Only the thread evaluating the node writes to it. */
+		const float eval_time = (float)(end_time - start_time);
+		if (node->eval_time < 0.0f) {
+			node->eval_time = eval_time;
+		}
+		else {
+			node->eval_time += EVAL_TIME_AVERAGE_WEIGHT *
+			                   (eval_time - node->eval_time);
+		}
 #endif
 	}
 
@@ -181,39 +236,60 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 }
 
 #ifdef USE_EVAL_PRIORITY
-static void calculate_eval_priority(OperationDepsNode *node)
+/* Priority of a node is the length of the critical path starting at it: its
+ * own cost plus the longest path through the nodes which depend on it.
+ */
+static void calculate_eval_priority(OperationDepsNode *node,
+                                    const unsigned int layers)
 {
 	if (node->done) {
 		return;
 	}
 	node->done = 1;
 
-	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
-		/* XXX standard cost of a node, could be estimated somewhat later on */
-		const float cost = 1.0f;
-		/* NOOP nodes have no cost */
-		node->eval_priority = node->is_noop() ? cost : 0.0f;
-
+	IDDepsNode *id_node = node->owner->owner;
+	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+	    (id_node->layers & layers) != 0)
+	{
+		float children_priority = 0.0f;
 		foreach (DepsRelation *rel, node->outlinks) {
+			if (rel->flag & DEPSREL_FLAG_CYCLIC) {
+				continue;
+			}
 			OperationDepsNode *to = (OperationDepsNode *)rel->to;
 			BLI_assert(to->type == DEG_NODE_TYPE_OPERATION);
-			calculate_eval_priority(to);
-			node->eval_priority += to->eval_priority;
+			calculate_eval_priority(to, layers);
+			children_priority = std::max(children_priority, to->eval_priority);
 		}
+
+		/* NOOP nodes have no cost. */
+		float cost = 0.0f;
+		if (!node->is_noop()) {
+			cost = (node->eval_time < 0.0f) ? EVAL_TIME_DEFAULT
+			                                : node->eval_time;
+		}
+		node->eval_priority = cost + children_priority;
 	}
 	else {
 		node->eval_priority = 0.0f;
 	}
 }
+
+static bool eval_priority_less(const OperationDepsNode *a,
+                               const OperationDepsNode *b)
+{
+	return a->eval_priority < b->eval_priority;
+}
 #endif
 
-/* Schedule a node if it needs evaluation.
+/* Check whether a node needs evaluation and all its parents are done, and
+ * mark it as scheduled if so.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
-                          OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+static bool schedule_node_ready(unsigned int layers,
+                                OperationDepsNode *node,
+                                bool dec_parents)
 {
 	unsigned int id_layers = node->owner->owner->layers;
 
@@ -228,22 +304,76 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 		if (node->num_links_pending == 0) {
 			bool is_scheduled = atomic_fetch_and_or_uint8(
 			        (uint8_t *)&node->scheduled, (uint8_t)true);
-			if (!is_scheduled) {
-				if (node->is_noop()) {
-					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
-				}
-				else {
-					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
-				}
+			return !is_scheduled;
+		}
+	}
+	return false;
+}
+
+/* Collect children of a node which became ready for evaluation. */
+static void collect_ready_children(OperationDepsNode *node,
+                                   const unsigned int layers,
+                                   vector<OperationDepsNode *> *ready_nodes)
+{
+	foreach (DepsRelation *rel, node->outlinks) {
+		OperationDepsNode *child = (OperationDepsNode *)rel->to;
+		BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
+		if (child->scheduled) {
+			/* Happens when having cyclic dependencies. */
+			continue;
+		}
+		if (schedule_node_ready(layers,
+		                        child,
+		                        (rel->flag & DEPSREL_FLAG_CYCLIC) == 0))
+		{
+			if (child->is_noop()) {
+				/* skip NOOP node, its children might be ready right away */
+				collect_ready_children(child, layers, ready_nodes);
 			}
+			else {
+				ready_nodes->push_back(child);
+			}
+		}
+	}
+}
+
+/* Push tasks for the ready nodes, children are scheduled once a task is
+ * completed.
+ *   num_direct: Number of nodes at the start of the list which are pushed as
+ *               they are, the others go to the ready heap.
+ */
+static void push_nodes(TaskPool *pool,
+                       const vector<OperationDepsNode *> &nodes,
+                       const int num_direct,
+                       const int thread_id)
+{
+	const int num_nodes = nodes.size();
+#ifdef USE_EVAL_PRIORITY
+	if (num_nodes > num_direct) {
+		DepsgraphEvalState *state =
+		        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
+		BLI_spin_lock(&state->ready_lock);
+		for (int i = num_direct; i < num_nodes; i++) {
+			BLI_heap_insert(state->ready_heap,
+			                -nodes[i]->eval_priority,
+			                nodes[i]);
 		}
+		BLI_spin_unlock(&state->ready_lock);
+	}
+#endif
+	for (int i = 0; i < num_nodes; i++) {
+#ifdef USE_EVAL_PRIORITY
+		OperationDepsNode *node = (i < num_direct) ? nodes[i] : NULL;
+#else
+		OperationDepsNode *node = nodes[i];
+		UNUSED_VARS(num_direct);
+#endif
+		BLI_task_pool_push_from_thread(pool,
+		                               deg_task_run_func,
+		                               node,
+		                               false,
+		                               TASK_PRIORITY_HIGH,
+		                               thread_id);
 	}
 }
 
@@ -251,31 +381,43 @@ static void schedule_graph(TaskPool *pool,
                            Depsgraph *graph,
                            const unsigned int layers)
 {
+	vector<OperationDepsNode *> ready_nodes;
 	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+		if (schedule_node_ready(layers, node, false)) {
+			if (node->is_noop()) {
+				collect_ready_children(node, layers, &ready_nodes);
+			}
+			else {
+				ready_nodes.push_back(node);
+			}
+		}
 	}
+	/* All root nodes go through the ready heap. */
+	push_nodes(pool, ready_nodes, 0, 0);
 }
 
 static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
+                              Depsgraph * /*graph*/,
                               OperationDepsNode *node,
                               const unsigned int layers,
                               const int thread_id)
 {
-	foreach (DepsRelation *rel, node->outlinks) {
-		OperationDepsNode *child = (OperationDepsNode *)rel->to;
-		BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
-		if (child->scheduled) {
-			/* Happens when having cyclic dependencies. */
-			continue;
-		}
-		schedule_node(pool,
-		              graph,
-		              layers,
-		              child,
-		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+	vector<OperationDepsNode *> ready_nodes;
+	collect_ready_children(node, layers, &ready_nodes);
+#ifdef USE_EVAL_PRIORITY
+	/* The first task pushed from a worker is the one it runs next, so the
+	 * child with the longest critical path is pushed directly and continues
+	 * on this thread. The other ones go to the ready heap, both the worker's
+	 * own deque and the thieves pop tasks in an order unrelated to priority.
+	 */
+	if (ready_nodes.size() > 1) {
+		std::iter_swap(ready_nodes.begin(),
+		               std::max_element(ready_nodes.begin(),
+		                                ready_nodes.end(),
+		                                eval_priority_less));
 	}
+#endif
+	push_nodes(pool, ready_nodes, 1, thread_id);
 }
 
 /**
@@ -311,6 +453,14 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
 	state.layers = layers;
+	state.timeline = NULL;
+	if (graph->timeline != NULL && graph->timeline->is_recording) {
+		state.timeline = graph->timeline;
+	}
+#ifdef USE_EVAL_PRIORITY
+	state.ready_heap = BLI_heap_new();
+	BLI_spin_init(&state.ready_lock);
+#endif
 
 	TaskScheduler *task_scheduler;
 	bool need_free_scheduler;
@@ -324,6 +474,12 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		need_free_scheduler = false;
 	}
 
+	if (state.timeline != NULL) {
+		state.timeline->begin_evaluation(
+		        eval_ctx->ctime,
+		        BLI_task_scheduler_num_threads(task_scheduler));
+	}
+
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 
 	calculate_pending_parents(graph, layers);
@@ -336,7 +492,7 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	/* Calculate priority for operation nodes. */
 #ifdef USE_EVAL_PRIORITY
 	foreach (OperationDepsNode *node, graph->operations) {
-		calculate_eval_priority(node);
+		calculate_eval_priority(node, layers);
 	}
 #endif
 
@@ -345,6 +501,16 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+#ifdef USE_EVAL_PRIORITY
+	BLI_assert(BLI_heap_is_empty(state.ready_heap));
+	BLI_heap_free(state.ready_heap, NULL);
+	BLI_spin_end(&state.ready_lock);
+#endif
+
+	if (state.timeline != NULL) {
+		state.timeline->end_evaluation();
+	}
+
 	/* Clear any uncleared tags - just in case. */
 	deg_graph_clear_tags(graph);
 
@@ -165,14 +165,14 @@ string ComponentDepsNode::identifier() const
 
 OperationDepsNode *ComponentDepsNode::find_operation(OperationIDKey key) const
 {
-	OperationDepsNode *node;
+	OperationDepsNode *node = NULL;
 	if (operations_map != NULL) {
 		node = (OperationDepsNode *)BLI_ghash_lookup(operations_map, &key);
 	}
 	else {
-		BLI_assert(key.name_tag == -1);
 		foreach (OperationDepsNode *op_node, operations) {
 			if (op_node->opcode == key.opcode &&
+			    op_node->name_tag == key.name_tag &&
 			    STREQ(op_node->name, key.name))
 			{
 				node = op_node;
@@ -251,6 +251,7 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 	op_node->evaluate = op;
 	op_node->opcode = opcode;
 	op_node->name = name;
+	op_node->name_tag = name_tag;
 
 	return op_node;
 }
@@ -347,6 +348,12 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	if (operations_map == NULL) {
+		/* Already finalized, happens when relations are updated
+		 * incrementally.
+		 */
+		return;
+	}
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
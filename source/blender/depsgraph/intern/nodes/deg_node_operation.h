@@ -74,11 +74,21 @@ struct OperationDepsNode : public DepsNode {
 
 	/* How many inlinks are we still waiting on before we can be evaluated. */
 	uint32_t num_links_pending;
+	/* Length of the critical path starting at this operation, in seconds. */
 	float eval_priority;
+	/* Moving average of the evaluation time in seconds, negative when the
+	 * operation was not evaluated yet.
+	 */
+	float eval_time;
 	bool scheduled;
 
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
+	/* Tag which distinguishes operations with the same name, such as drivers
+	 * of different array elements. Kept for lookups after the component
+	 * dropped its operations map.
+	 */
+	int name_tag;
 
 	/* (eDepsOperation_Flag) extra settings affecting evaluation. */
 	int flag;
@@ -2776,6 +2776,14 @@ void init_userdef_do_versions(void)
 		U.uiflag |= USER_LOCK_CURSOR_ADJUST;
 	}
 
+	if (!USER_VERSION_ATLEAST(279, 2)) {
+		U.compositor_cache_limit = 1024;
+	}
+
+	if (!USER_VERSION_ATLEAST(279, 3)) {
+		U.modifier_cache_limit = 256;
+	}
+
 	/**
 	 * Include next version bump.
 	 *
@@ -172,7 +172,13 @@ ModifierData *ED_object_modifier_add(ReportList *reports, Main *bmain, Scene *sc
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	if (modifier_typeAffectsSceneRelations(type)) {
+		/* Collision and effector relations of other objects are affected. */
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DAG_id_relations_tag_update(bmain, &ob->id);
+	}
 
 	return new_md;
 }
@@ -297,11 +303,6 @@ static bool object_modifier_remove(Main *bmain, Object *ob, ModifierData *md,
 	else if (md->type == eModifierType_Collision) {
 		if (ob->pd)
 			ob->pd->deflect = 0;
-
-		*r_sort_depsgraph = true;
-	}
-	else if (md->type == eModifierType_Surface) {
-		*r_sort_depsgraph = true;
 	}
 	else if (md->type == eModifierType_Multires) {
 		/* Delete MDisps layer if not used by another multires modifier */
@@ -314,14 +315,16 @@ static bool object_modifier_remove(Main *bmain, Object *ob, ModifierData *md,
 			modifier_skin_customdata_delete(ob);
 	}
 
+	if (modifier_typeAffectsSceneRelations(md->type)) {
+		*r_sort_depsgraph = true;
+	}
+
 	if (ELEM(md->type, eModifierType_Softbody, eModifierType_Cloth) &&
 	    BLI_listbase_is_empty(&ob->particlesystem))
 	{
 		ob->mode &= ~OB_MODE_PARTICLE_EDIT;
 	}
 
-	DAG_relations_tag_update(bmain);
-
 	BLI_remlink(&ob->modifiers, md);
 	modifier_free(md);
 	BKE_object_free_derived_caches(ob);
@@ -342,7 +345,12 @@ bool ED_object_modifier_remove(ReportList *reports, Main *bmain, Object *ob, Mod
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	if (sort_depsgraph) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DAG_id_relations_tag_update(bmain, &ob->id);
+	}
 
 	return 1;
 }
@@ -366,7 +374,12 @@ void ED_object_modifier_clear(Main *bmain, Object *ob)
 	}
 
 	DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
-	DAG_relations_tag_update(bmain);
+	if (sort_depsgraph) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DAG_id_relations_tag_update(bmain, &ob->id);
+	}
 }
 
 int ED_object_modifier_move_up(ReportList *reports, Object *ob, ModifierData *md)
@@ -44,6 +44,7 @@
 #include "BLT_translation.h"
 
 #include "BKE_anim.h"
+#include "BKE_blender_undo.h"
 #include "BKE_blender_version.h"
 #include "BKE_curve.h"
 #include "BKE_displist.h"
@@ -382,6 +383,7 @@ static void stats_string(Scene *scene)
 	SceneStatsFmt stats_fmt;
 	Object *ob = (scene->basact) ? scene->basact->object : NULL;
 	uintptr_t mem_in_use, mmap_in_use;
+	size_t undo_in_use;
 	char memstr[MAX_INFO_MEM_LEN];
 	char gpumemstr[MAX_INFO_MEM_LEN] = "";
 	char *s;
@@ -389,6 +391,7 @@ static void stats_string(Scene *scene)
 
 	mem_in_use = MEM_get_memory_in_use();
 	mmap_in_use = MEM_get_mapped_memory_in_use();
+	undo_in_use = BKE_undo_memory_get();
 
 
 	/* Generate formatted numbers */
@@ -422,7 +425,10 @@ static void stats_string(Scene *scene)
 	ofs = BLI_snprintf(memstr, MAX_INFO_MEM_LEN, IFACE_(" | Mem:%.2fM"),
 	                    (double)((mem_in_use - mmap_in_use) >> 10) / 1024.0);
 	if (mmap_in_use)
-		BLI_snprintf(memstr + ofs, MAX_INFO_MEM_LEN - ofs, IFACE_(" (%.2fM)"), (double)((mmap_in_use) >> 10) / 1024.0);
+		ofs += BLI_snprintf(memstr + ofs, MAX_INFO_MEM_LEN - ofs, IFACE_(" (%.2fM)"), (double)((mmap_in_use) >> 10) / 1024.0);
+	/* global undo steps, part of the memory above */
+	if (undo_in_use)
+		BLI_snprintf(memstr + ofs, MAX_INFO_MEM_LEN - ofs, IFACE_(" | Undo:%.2fM"), (double)((undo_in_use) >> 10) / 1024.0);
 
 	if (GPU_mem_stats_supported()) {
 		int gpu_free_mem, gpu_tot_memory;
@@ -32,6 +32,9 @@
  *  \author Sergey Sharybin
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 
@@ -48,6 +51,17 @@ typedef void  *(*MovieCacheGetPriorityDataFP) (void *userkey);
 typedef int    (*MovieCacheGetItemPriorityFP) (void *last_userkey, void *priority_data);
 typedef void   (*MovieCachePriorityDeleterFP) (void *priority_data);
 
+/* counters of all movie caches together, for profiling */
+typedef struct MovieCacheStats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t puts;
+	uint64_t evictions;
+	uint64_t shard_lock_contention;    /* times a thread had to wait for the lock of a cache shard */
+	uint64_t limiter_lock_contention;  /* times a thread had to wait for the lock of the cache limiter */
+	size_t memory_in_use;
+} MovieCacheStats;
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -58,6 +72,8 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+/* cost is the time in seconds it took to calculate ibuf, expensive items are freed last */
+void IMB_moviecache_put_ex(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf, float cost);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey);
 bool IMB_moviecache_has_frame(struct MovieCache *cache, void *userkey);
@@ -69,6 +85,9 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
 
 void IMB_moviecache_get_cache_segments(struct MovieCache *cache, int proxy, int render_flags, int *totseg_r, int **points_r);
 
+void IMB_moviecache_get_stats(MovieCacheStats *r_stats);
+void IMB_moviecache_reset_stats(void);
+
 struct MovieCacheIter;
 struct MovieCacheIter *IMB_moviecacheIter_new(struct MovieCache *cache);
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter);
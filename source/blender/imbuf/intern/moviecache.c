@@ -43,6 +43,8 @@
 #include "BLI_mempool.h"
 #include "BLI_threads.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf_types.h"
@@ -61,10 +63,37 @@
 static MEM_CacheLimiterC *limitor = NULL;
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
+static MovieCacheStats moviecache_stats = {0};
+
+/* Items are spread over shards by the hash of their key, every shard has its own
+ * lock so threads working on different frames don't wait for each other.
+ *
+ * Locks are always taken in the order limitor_lock, then a shard lock. Code which
+ * holds a shard lock never waits for the limitor lock, since freeing items from
+ * the limiter locks the shard of the freed item. */
+#define MOVIECACHE_SHARDS 16
+
+/* cost of items put without a known cost, about the time to read a frame from disk */
+#define MOVIECACHE_DEFAULT_COST 0.02f
+
+typedef struct MovieCacheShard {
+	ThreadMutex lock;
+
+	GHash *hash;
+
+	struct BLI_mempool *keys_pool;
+	struct BLI_mempool *items_pool;
+	struct BLI_mempool *userkeys_pool;
+
+	/* number of items freed by the cache limiter which still have a key in the hash */
+	int totunused;
+	int pad;
+} MovieCacheShard;
+
 typedef struct MovieCache {
 	char name[64];
 
-	GHash *hash;
+	MovieCacheShard shards[MOVIECACHE_SHARDS];
 	GHashHashFP hashfp;
 	GHashCmpFP cmpfp;
 	MovieCacheGetKeyDataFP getdatafp;
@@ -73,10 +102,6 @@ typedef struct MovieCache {
 	MovieCacheGetItemPriorityFP getitempriorityfp;
 	MovieCachePriorityDeleterFP prioritydeleterfp;
 
-	struct BLI_mempool *keys_pool;
-	struct BLI_mempool *items_pool;
-	struct BLI_mempool *userkeys_pool;
-
 	int keysize;
 
 	void *last_userkey;
@@ -87,16 +112,54 @@ typedef struct MovieCache {
 
 typedef struct MovieCacheKey {
 	MovieCache *cache_owner;
+	MovieCacheShard *shard;
 	void *userkey;
 } MovieCacheKey;
 
 typedef struct MovieCacheItem {
 	MovieCache *cache_owner;
+	MovieCacheShard *shard;
 	ImBuf *ibuf;
 	MEM_CacheLimiterHandleC *c_handle;
 	void *priority_data;
+	float cost;
+	int pad;
 } MovieCacheItem;
 
+typedef struct MovieCacheIter {
+	MovieCache *cache;
+	int shard;
+	GHashIterator gh_iter;
+} MovieCacheIter;
+
+static void moviecache_lock(ThreadMutex *lock, uint64_t *contention)
+{
+	if (!BLI_mutex_trylock(lock)) {
+		atomic_add_and_fetch_uint64(contention, 1);
+		BLI_mutex_lock(lock);
+	}
+}
+
+static void moviecache_limitor_lock(void)
+{
+	moviecache_lock(&limitor_lock, &moviecache_stats.limiter_lock_contention);
+}
+
+static void moviecache_shard_lock(MovieCacheShard *shard)
+{
+	moviecache_lock(&shard->lock, &moviecache_stats.shard_lock_contention);
+}
+
+static MovieCacheShard *moviecache_shard_get(MovieCache *cache, const void *userkey)
+{
+	unsigned int hash = cache->hashfp(userkey);
+
+	/* lower bits are used by the GHash buckets too, so mix in the higher bits */
+	hash ^= (hash >> 16) ^ (hash >> 8);
+
+	return &cache->shards[hash % MOVIECACHE_SHARDS];
+}
+
 static unsigned int moviecache_hashhash(const void *keyv)
 {
 	const MovieCacheKey *key = keyv;
@@ -116,9 +179,9 @@ static void moviecache_keyfree(void *val)
 {
 	MovieCacheKey *key = val;
 
-	BLI_mempool_free(key->cache_owner->userkeys_pool, key->userkey);
+	BLI_mempool_free(key->shard->userkeys_pool, key->userkey);
 
-	BLI_mempool_free(key->cache_owner->keys_pool, key);
+	BLI_mempool_free(key->shard->keys_pool, key);
 }
 
 static void moviecache_valfree(void *val)
@@ -137,14 +200,19 @@ static void moviecache_valfree(void *val)
 		cache->prioritydeleterfp(item->priority_data);
 	}
 
-	BLI_mempool_free(item->cache_owner->items_pool, item);
+	BLI_mempool_free(item->shard->items_pool, item);
 }
 
-static void check_unused_keys(MovieCache *cache)
+/* shard must be locked */
+static void check_unused_keys(MovieCacheShard *shard)
 {
 	GHashIterator gh_iter;
 
-	BLI_ghashIterator_init(&gh_iter, cache->hash);
+	if (shard->totunused == 0) {
+		return;
+	}
+
+	BLI_ghashIterator_init(&gh_iter, shard->hash);
 
 	while (!BLI_ghashIterator_done(&gh_iter)) {
 		const MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
@@ -156,12 +224,14 @@ static void check_unused_keys(MovieCache *cache)
 		remove = !item->ibuf;
 
 		if (remove) {
-			PRINT("%s: cache '%s' remove item %p without buffer\n", __func__, cache->name, item);
+			PRINT("%s: cache '%s' remove item %p without buffer\n", __func__, item->cache_owner->name, item);
 		}
 
 		if (remove)
-			BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
+			BLI_ghash_remove(shard->hash, key, moviecache_keyfree, moviecache_valfree);
 	}
+
+	shard->totunused = 0;
 }
 
 static int compare_int(const void *av, const void *bv)
@@ -177,14 +247,23 @@ static void IMB_moviecache_destructor(void *p)
 
 	if (item && item->ibuf) {
 		MovieCache *cache = item->cache_owner;
+		MovieCacheShard *shard = item->shard;
 
 		PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
+		moviecache_shard_lock(shard);
+
 		IMB_freeImBuf(item->ibuf);
 
 		item->ibuf = NULL;
 		item->c_handle = NULL;
 
+		shard->totunused++;
+
+		BLI_mutex_unlock(&shard->lock);
+
+		atomic_add_and_fetch_uint64(&moviecache_stats.evictions, 1);
+
 		/* force cached segments to be updated */
 		if (cache->points) {
 			MEM_freeN(cache->points);
@@ -265,6 +344,13 @@ static int get_item_priority(void *item_v, int default_priority)
 	return priority;
 }
 
+static float get_item_cost(void *item_v)
+{
+	MovieCacheItem *item = (MovieCacheItem *) item_v;
+
+	return item->cost;
+}
+
 static bool get_item_destroyable(void *item_v)
 {
 	MovieCacheItem *item = (MovieCacheItem *) item_v;
@@ -287,6 +373,7 @@ void IMB_moviecache_init(void)
 
 	MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
 	MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+	MEM_CacheLimiter_ItemCost_Func_set(limitor, get_item_cost);
 }
 
 void IMB_moviecache_destruct(void)
@@ -298,6 +385,7 @@ void IMB_moviecache_destruct(void)
 MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp)
 {
 	MovieCache *cache;
+	int i;
 
 	PRINT("%s: cache '%s' create\n", __func__, name);
 
@@ -305,10 +393,15 @@ MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP has
 
 	BLI_strncpy(cache->name, name, sizeof(cache->name));
 
-	cache->keys_pool = BLI_mempool_create(sizeof(MovieCacheKey), 0, 64, BLI_MEMPOOL_NOP);
-	cache->items_pool = BLI_mempool_create(sizeof(MovieCacheItem), 0, 64, BLI_MEMPOOL_NOP);
-	cache->userkeys_pool = BLI_mempool_create(keysize, 0, 64, BLI_MEMPOOL_NOP);
-	cache->hash = BLI_ghash_new(moviecache_hashhash, moviecache_hashcmp, "MovieClip ImBuf cache hash");
+	for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+		MovieCacheShard *shard = &cache->shards[i];
+
+		BLI_mutex_init(&shard->lock);
+		shard->keys_pool = BLI_mempool_create(sizeof(MovieCacheKey), 0, 64, BLI_MEMPOOL_NOP);
+		shard->items_pool = BLI_mempool_create(sizeof(MovieCacheItem), 0, 64, BLI_MEMPOOL_NOP);
+		shard->userkeys_pool = BLI_mempool_create(keysize, 0, 64, BLI_MEMPOOL_NOP);
+		shard->hash = BLI_ghash_new(moviecache_hashhash, moviecache_hashcmp, "MovieClip ImBuf cache hash");
+	}
 
 	cache->keysize = keysize;
 	cache->hashfp = hashfp;
@@ -334,54 +427,66 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
 	cache->prioritydeleterfp = prioritydeleterfp;
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+/* limitor_lock must be locked */
+static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
 {
+	MovieCacheShard *shard = moviecache_shard_get(cache, userkey);
 	MovieCacheKey *key;
 	MovieCacheItem *item;
-
-	if (!limitor)
-		IMB_moviecache_init();
+	int i;
 
 	IMB_refImBuf(ibuf);
 
-	key = BLI_mempool_alloc(cache->keys_pool);
+	moviecache_shard_lock(shard);
+
+	key = BLI_mempool_alloc(shard->keys_pool);
 	key->cache_owner = cache;
-	key->userkey = BLI_mempool_alloc(cache->userkeys_pool);
+	key->shard = shard;
+	key->userkey = BLI_mempool_alloc(shard->userkeys_pool);
 	memcpy(key->userkey, userkey, cache->keysize);
 
-	item = BLI_mempool_alloc(cache->items_pool);
+	item = BLI_mempool_alloc(shard->items_pool);
 
 	PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache-> name, ibuf, item);
 
 	item->ibuf = ibuf;
 	item->cache_owner = cache;
+	item->shard = shard;
 	item->c_handle = NULL;
 	item->priority_data = NULL;
+	item->cost = (cost > 0.0f) ? cost : MOVIECACHE_DEFAULT_COST;
 
 	if (cache->getprioritydatafp) {
 		item->priority_data = cache->getprioritydatafp(userkey);
 	}
 
-	BLI_ghash_reinsert(cache->hash, key, item, moviecache_keyfree, moviecache_valfree);
+	BLI_ghash_reinsert(shard->hash, key, item, moviecache_keyfree, moviecache_valfree);
+
+	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+	MEM_CacheLimiter_ref(item->c_handle);
+
+	BLI_mutex_unlock(&shard->lock);
 
 	if (cache->last_userkey) {
 		memcpy(cache->last_userkey, userkey, cache->keysize);
 	}
 
-	if (need_lock)
-		BLI_mutex_lock(&limitor_lock);
-
-	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
-
-	MEM_CacheLimiter_ref(item->c_handle);
+	/* frees items of any cache, which locks their shards */
 	MEM_CacheLimiter_enforce_limits(limitor);
 	MEM_CacheLimiter_unref(item->c_handle);
 
-	if (need_lock)
-		BLI_mutex_unlock(&limitor_lock);
+	atomic_add_and_fetch_uint64(&moviecache_stats.puts, 1);
 
 	/* cache limiter can't remove unused keys which points to destoryed values */
-	check_unused_keys(cache);
+	for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+		shard = &cache->shards[i];
+
+		if (shard->totunused) {
+			moviecache_shard_lock(shard);
+			check_unused_keys(shard);
+			BLI_mutex_unlock(&shard->lock);
+		}
+	}
 
 	if (cache->points) {
 		MEM_freeN(cache->points);
@@ -391,7 +496,17 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-	do_moviecache_put(cache, userkey, ibuf, true);
+	IMB_moviecache_put_ex(cache, userkey, ibuf, 0.0f);
+}
+
+void IMB_moviecache_put_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
+{
+	if (!limitor)
+		IMB_moviecache_init();
+
+	moviecache_limitor_lock();
+	do_moviecache_put(cache, userkey, ibuf, cost);
+	BLI_mutex_unlock(&limitor_lock);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
@@ -399,14 +514,17 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
 	size_t mem_in_use, mem_limit, elem_size;
 	bool result = false;
 
+	if (!limitor)
+		IMB_moviecache_init();
+
 	elem_size = IMB_get_size_in_memory(ibuf);
 	mem_limit = MEM_CacheLimiter_get_maximum();
 
-	BLI_mutex_lock(&limitor_lock);
+	moviecache_limitor_lock();
 	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
 	if (mem_in_use + elem_size <= mem_limit) {
-		do_moviecache_put(cache, userkey, ibuf, false);
+		do_moviecache_put(cache, userkey, ibuf, 0.0f);
 		result = true;
 	}
 
@@ -417,49 +535,86 @@ bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibu
 
 ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 {
+	MovieCacheShard *shard = moviecache_shard_get(cache, userkey);
 	MovieCacheKey key;
 	MovieCacheItem *item;
+	ImBuf *ibuf = NULL;
 
 	key.cache_owner = cache;
+	key.shard = shard;
 	key.userkey = userkey;
-	item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
+
+	moviecache_shard_lock(shard);
+
+	item = (MovieCacheItem *)BLI_ghash_lookup(shard->hash, &key);
 
 	if (item) {
 		if (item->ibuf) {
-			BLI_mutex_lock(&limitor_lock);
+			/* thread safe with cost based freeing, so the limitor is not locked */
 			MEM_CacheLimiter_touch(item->c_handle);
-			BLI_mutex_unlock(&limitor_lock);
 
 			IMB_refImBuf(item->ibuf);
 
-			return item->ibuf;
+			ibuf = item->ibuf;
 		}
 	}
 
-	return NULL;
+	BLI_mutex_unlock(&shard->lock);
+
+	if (ibuf) {
+		atomic_add_and_fetch_uint64(&moviecache_stats.hits, 1);
+	}
+	else {
+		atomic_add_and_fetch_uint64(&moviecache_stats.misses, 1);
+	}
+
+	return ibuf;
 }
 
 bool IMB_moviecache_has_frame(MovieCache *cache, void *userkey)
 {
+	MovieCacheShard *shard = moviecache_shard_get(cache, userkey);
 	MovieCacheKey key;
 	MovieCacheItem *item;
+	bool result;
 
 	key.cache_owner = cache;
+	key.shard = shard;
 	key.userkey = userkey;
-	item = (MovieCacheItem *)BLI_ghash_lookup(cache->hash, &key);
 
-	return item != NULL;
+	moviecache_shard_lock(shard);
+
+	item = (MovieCacheItem *)BLI_ghash_lookup(shard->hash, &key);
+	/* keys of freed items are only removed on the next put */
+	result = (item != NULL && item->ibuf != NULL);
+
+	BLI_mutex_unlock(&shard->lock);
+
+	return result;
 }
 
 void IMB_moviecache_free(MovieCache *cache)
 {
+	int i;
+
 	PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
-	BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
+	/* freeing items unmanages them from the limitor */
+	moviecache_limitor_lock();
 
-	BLI_mempool_destroy(cache->keys_pool);
-	BLI_mempool_destroy(cache->items_pool);
-	BLI_mempool_destroy(cache->userkeys_pool);
+	for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+		MovieCacheShard *shard = &cache->shards[i];
+
+		BLI_ghash_free(shard->hash, moviecache_keyfree, moviecache_valfree);
+
+		BLI_mempool_destroy(shard->keys_pool);
+		BLI_mempool_destroy(shard->items_pool);
+		BLI_mempool_destroy(shard->userkeys_pool);
+
+		BLI_mutex_end(&shard->lock);
+	}
+
+	BLI_mutex_unlock(&limitor_lock);
 
 	if (cache->points)
 		MEM_freeN(cache->points);
@@ -472,24 +627,37 @@ void IMB_moviecache_free(MovieCache *cache)
 
 void IMB_moviecache_cleanup(MovieCache *cache, bool (cleanup_check_cb) (ImBuf *ibuf, void *userkey, void *userdata), void *userdata)
 {
-	GHashIterator gh_iter;
+	int i;
+
+	moviecache_limitor_lock();
 
-	check_unused_keys(cache);
+	for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+		MovieCacheShard *shard = &cache->shards[i];
+		GHashIterator gh_iter;
 
-	BLI_ghashIterator_init(&gh_iter, cache->hash);
+		moviecache_shard_lock(shard);
 
-	while (!BLI_ghashIterator_done(&gh_iter)) {
-		MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-		MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+		check_unused_keys(shard);
 
-		BLI_ghashIterator_step(&gh_iter);
+		BLI_ghashIterator_init(&gh_iter, shard->hash);
+
+		while (!BLI_ghashIterator_done(&gh_iter)) {
+			MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+			MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+
+			BLI_ghashIterator_step(&gh_iter);
 
-		if (cleanup_check_cb(item->ibuf, key->userkey, userdata)) {
-			PRINT("%s: cache '%s' remove item %p\n", __func__, cache->name, item);
+			if (cleanup_check_cb(item->ibuf, key->userkey, userdata)) {
+				PRINT("%s: cache '%s' remove item %p\n", __func__, cache->name, item);
 
-			BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
+				BLI_ghash_remove(shard->hash, key, moviecache_keyfree, moviecache_valfree);
+			}
 		}
+
+		BLI_mutex_unlock(&shard->lock);
 	}
+
+	BLI_mutex_unlock(&limitor_lock);
 }
 
 /* get segments of cached frames. useful for debugging cache policies */
@@ -513,25 +681,42 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 		*points_r = cache->points;
 	}
 	else {
-		int totframe = BLI_ghash_size(cache->hash);
-		int *frames = MEM_callocN(totframe * sizeof(int), "movieclip cache frames");
-		int a, totseg = 0;
+		int totframe = 0;
+		int *frames;
+		int a, i, totseg = 0;
 		GHashIterator gh_iter;
 
+		/* no shard lock waits for another one, so locking all of them in order is fine */
+		for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+			moviecache_shard_lock(&cache->shards[i]);
+			totframe += BLI_ghash_size(cache->shards[i].hash);
+		}
+
+		frames = MEM_callocN(totframe * sizeof(int), "movieclip cache frames");
+
 		a = 0;
-		GHASH_ITER(gh_iter, cache->hash) {
-			MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
-			MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
-			int framenr, curproxy, curflags;
+		for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+			GHASH_ITER(gh_iter, cache->shards[i].hash) {
+				MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+				MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+				int framenr, curproxy, curflags;
 
-			if (item->ibuf) {
-				cache->getdatafp(key->userkey, &framenr, &curproxy, &curflags);
+				if (item->ibuf) {
+					cache->getdatafp(key->userkey, &framenr, &curproxy, &curflags);
 
-				if (curproxy == proxy && curflags == render_flags)
-					frames[a++] = framenr;
+					if (curproxy == proxy && curflags == render_flags)
+						frames[a++] = framenr;
+				}
 			}
 		}
 
+		for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+			BLI_mutex_unlock(&cache->shards[i].lock);
+		}
+
+		/* only the frames that were found */
+		totframe = a;
+
 		qsort(frames, totframe, sizeof(int), compare_int);
 
 		/* count */
@@ -575,39 +760,80 @@ void IMB_moviecache_get_cache_segments(MovieCache *cache, int proxy, int render_
 	}
 }
 
+void IMB_moviecache_get_stats(MovieCacheStats *r_stats)
+{
+	*r_stats = moviecache_stats;
+
+	r_stats->memory_in_use = 0;
+
+	if (limitor) {
+		moviecache_limitor_lock();
+		r_stats->memory_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+		BLI_mutex_unlock(&limitor_lock);
+	}
+}
+
+void IMB_moviecache_reset_stats(void)
+{
+	memset(&moviecache_stats, 0, sizeof(moviecache_stats));
+}
+
+/* skip to the first item, starting at the current shard */
+static void moviecacheIter_skip_empty(MovieCacheIter *iter)
+{
+	while (iter->shard < MOVIECACHE_SHARDS && BLI_ghashIterator_done(&iter->gh_iter)) {
+		iter->shard++;
+
+		if (iter->shard < MOVIECACHE_SHARDS) {
+			BLI_ghashIterator_init(&iter->gh_iter, iter->cache->shards[iter->shard].hash);
+		}
+	}
+}
+
 struct MovieCacheIter *IMB_moviecacheIter_new(MovieCache *cache)
 {
-	GHashIterator *iter;
+	MovieCacheIter *iter;
+	int i;
+
+	for (i = 0; i < MOVIECACHE_SHARDS; i++) {
+		moviecache_shard_lock(&cache->shards[i]);
+		check_unused_keys(&cache->shards[i]);
+		BLI_mutex_unlock(&cache->shards[i].lock);
+	}
 
-	check_unused_keys(cache);
-	iter = BLI_ghashIterator_new(cache->hash);
+	iter = MEM_mallocN(sizeof(MovieCacheIter), "MovieCacheIter");
+	iter->cache = cache;
+	iter->shard = 0;
+	BLI_ghashIterator_init(&iter->gh_iter, cache->shards[0].hash);
+	moviecacheIter_skip_empty(iter);
 
-	return (struct MovieCacheIter *) iter;
+	return iter;
 }
 
 void IMB_moviecacheIter_free(struct MovieCacheIter *iter)
 {
-	BLI_ghashIterator_free((GHashIterator *) iter);
+	MEM_freeN(iter);
 }
 
 bool IMB_moviecacheIter_done(struct MovieCacheIter *iter)
 {
-	return BLI_ghashIterator_done((GHashIterator *) iter);
+	return iter->shard >= MOVIECACHE_SHARDS;
 }
 
 void IMB_moviecacheIter_step(struct MovieCacheIter *iter)
 {
-	BLI_ghashIterator_step((GHashIterator *) iter);
+	BLI_ghashIterator_step(&iter->gh_iter);
+	moviecacheIter_skip_empty(iter);
 }
 
 ImBuf *IMB_moviecacheIter_getImBuf(struct MovieCacheIter *iter)
 {
-	MovieCacheItem *item = BLI_ghashIterator_getValue((GHashIterator *) iter);
+	MovieCacheItem *item = BLI_ghashIterator_getValue(&iter->gh_iter);
 	return item->ibuf;
 }
 
 void *IMB_moviecacheIter_getUserKey(struct MovieCacheIter *iter)
 {
-	MovieCacheKey *key = BLI_ghashIterator_getKey((GHashIterator *) iter);
+	MovieCacheKey *key = BLI_ghashIterator_getKey(&iter->gh_iter);
 	return key->userkey;
 }
@@ -206,6 +206,7 @@ typedef struct PointCache {
 
 	struct PTCacheEdit *edit;
 	void (*free_edit)(struct PTCacheEdit *edit);	/* free callback */
+	struct PTCacheArchive *archive;	/* single file disk cache (runtime only) */
 } PointCache;
 
 typedef struct SBVertex {
@@ -412,6 +413,9 @@ typedef struct SoftBody {
 /* high resolution cache is saved for smoke for backwards compatibility, so set this flag to know it's a "fake" cache */
 #define PTCACHE_FAKE_SMOKE			(1<<12)
 #define PTCACHE_IGNORE_CLEAR		(1<<13)
+/* disk cache: all frames in one file, optionally stored as difference to a key frame */
+#define PTCACHE_DISK_SINGLE_FILE	(1<<14)
+#define PTCACHE_DISK_DELTA			(1<<15)
 
 /* PTCACHE_OUTDATED + PTCACHE_FRAMES_SKIPPED */
 #define PTCACHE_REDO_NEEDED			258
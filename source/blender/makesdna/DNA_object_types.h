@@ -299,6 +299,9 @@ typedef struct Object {
 	LodLevel *currentlod;
 
 	struct PreviewImage *preview;
+
+	/* Runtime cache of intermediate modifier stack results, not stored in the file */
+	struct ModifierStackCache *modifier_cache;
 } Object;
 
 /* Warning, this is not used anymore because hooks are now modifiers */
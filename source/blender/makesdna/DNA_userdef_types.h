@@ -579,7 +579,11 @@ typedef struct UserDef {
 	struct WalkNavigation walk_navigation;
 
 	short opensubdiv_compute_type;
-	char pad5[6];
+	char pad5[2];
+
+	int compositor_cache_limit;	/* memory limit of cached compositor buffers (in megabytes) */
+	int modifier_cache_limit;	/* memory limit of cached modifier stack results (in megabytes) */
+	int pad6;
 } UserDef;
 
 extern UserDef U; /* from blenkernel blender.c */
@@ -751,28 +751,18 @@ static eSDNA_Type sdna_type_nr(const char *dna_type)
  * Note there is no optimization for the case where otype and ctype are the same:
  * assumption is that caller will handle this case.
  *
- * \param ctype  Name of type to convert to
- * \param otype  Name of type to convert from
- * \param name  Field name to extract array-size information
+ * \param ctypenr  Type to convert to
+ * \param otypenr  Type to convert from
+ * \param arrlen  Number of array elements to convert
  * \param curdata  Where to put converted data
  * \param olddata  Data of type otype to convert
  */
 static void cast_elem(
-        const char *ctype, const char *otype, const char *name,
+        const eSDNA_Type ctypenr, const eSDNA_Type otypenr, int arrlen,
         char *curdata, const char *olddata)
 {
 	double val = 0.0;
-	int arrlen, curlen = 1, oldlen = 1;
-
-	eSDNA_Type ctypenr, otypenr;
-
-	arrlen = DNA_elem_array_size(name);
-
-	if ( (otypenr = sdna_type_nr(otype)) == -1 ||
-	     (ctypenr = sdna_type_nr(ctype)) == -1)
-	{
-		return;
-	}
+	int curlen, oldlen;
 
 	/* define lengths */
 	oldlen = DNA_elem_type_size(otypenr);
@@ -836,23 +826,17 @@ static void cast_elem(
  *
  * \param curlen  Pointer length to conver to
  * \param oldlen  Length of pointers in olddata
- * \param name  Field name to extract array-size information
+ * \param arrlen  Number of array elements to convert
  * \param curdata  Where to put converted data
  * \param olddata  Data to convert
  */
-static void cast_pointer(int curlen, int oldlen, const char *name, char *curdata, const char *olddata)
+static void cast_pointer(int curlen, int oldlen, int arrlen, char *curdata, const char *olddata)
 {
 	int64_t lval;
-	int arrlen;
-	
-	arrlen = DNA_elem_array_size(name);
 	
 	while (arrlen > 0) {
 	
-		if (curlen == oldlen) {
-			memcpy(curdata, olddata, curlen);
-		}
-		else if (curlen == 4 && oldlen == 8) {
+		if (curlen == 4 && oldlen == 8) {
 			lval = *((int64_t *)olddata);
 
 			/* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
@@ -863,10 +847,6 @@ static void cast_pointer(int curlen, int oldlen, const char *name, char *curdata
 		else if (curlen == 8 && oldlen == 4) {
 			*((int64_t *)curdata) = *((int *)olddata);
 		}
-		else {
-			/* for debug */
-			printf("errpr: illegal pointersize!\n");
-		}
 		
 		olddata += oldlen;
 		curdata += curlen;
@@ -892,27 +872,25 @@ static int elem_strcmp(const char *name, const char *oname)
 }
 
 /**
- * Returns the address of the data for the specified field within olddata
- * according to the struct format pointed to by old, or NULL if no such
+ * Returns the offset of the specified field within a struct laid out
+ * according to the struct format pointed to by old, or -1 if no such
  * field can be found.
  *
  * \param sdna  Old SDNA
  * \param type  Current field type name
  * \param name  Current field name
  * \param old  Pointer to struct information in sdna
- * \param olddata  Struct data
  * \param sppo  Optional place to return pointer to field info in sdna
- * \return Data address.
+ * \return Offset in bytes.
  */
-static const char *find_elem(
+static int find_elem_offset(
         const SDNA *sdna,
         const char *type,
         const char *name,
         const short *old,
-        const char *olddata,
         const short **sppo)
 {
-	int a, elemcount, len;
+	int a, elemcount, offset;
 	const char *otype, *oname;
 	
 	/* without arraypart, so names can differ: return old namenr and type */
@@ -920,47 +898,196 @@ static const char *find_elem(
 	/* in old is the old struct */
 	elemcount = old[1];
 	old += 2;
+	offset = 0;
 	for (a = 0; a < elemcount; a++, old += 2) {
 
 		otype = sdna->types[old[0]];
 		oname = sdna->names[old[1]];
 
-		len = elementsize(sdna, old[0], old[1]);
-
 		if (elem_strcmp(name, oname) == 0) {  /* name equal */
 			if (strcmp(type, otype) == 0) {   /* type equal */
 				if (sppo) *sppo = old;
-				return olddata;
+				return offset;
 			}
 			
-			return NULL;
+			return -1;
 		}
 		
-		olddata += len;
+		offset += elementsize(sdna, old[0], old[1]);
+	}
+	return -1;
+}
+
+/**
+ * Returns the address of the data for the specified field within olddata
+ * according to the struct format pointed to by old, or NULL if no such
+ * field can be found.
+ *
+ * \param sdna  Old SDNA
+ * \param type  Current field type name
+ * \param name  Current field name
+ * \param old  Pointer to struct information in sdna
+ * \param olddata  Struct data
+ * \param sppo  Optional place to return pointer to field info in sdna
+ * \return Data address.
+ */
+static const char *find_elem(
+        const SDNA *sdna,
+        const char *type,
+        const char *name,
+        const short *old,
+        const char *olddata,
+        const short **sppo)
+{
+	const int offset = find_elem_offset(sdna, type, name, old, sppo);
+	return (offset != -1) ? olddata + offset : NULL;
+}
+
+/**
+ * Old to new struct conversion is done in two passes: when a file is opened the differences
+ * between both SDNAs are resolved once per struct type into a flat list of steps, which only
+ * contain offsets and sizes. Converting a block then runs the steps without any name lookups.
+ */
+typedef enum eReconstructStepType {
+	/* Copy bytes as-is. */
+	RECONSTRUCT_STEP_MEMCPY = 0,
+	/* Convert an array of primitive values to another primitive type. */
+	RECONSTRUCT_STEP_CAST_PRIMITIVE,
+	/* Convert an array of pointers to the pointer size of the current Blender. */
+	RECONSTRUCT_STEP_CAST_POINTER,
+	/* Null-terminate a truncated string. */
+	RECONSTRUCT_STEP_TERMINATE_STRING,
+} eReconstructStepType;
+
+typedef struct ReconstructStep {
+	char type;  /* eReconstructStepType */
+	char cur_typenr, old_typenr;  /* eSDNA_Type, only for RECONSTRUCT_STEP_CAST_PRIMITIVE */
+	char pad;
+	int cur_offset, old_offset;
+	/* Number of bytes for RECONSTRUCT_STEP_MEMCPY, array length for the cast steps. */
+	int len;
+} ReconstructStep;
+
+typedef struct ReconstructStruct {
+	ReconstructStep *steps;
+	int steps_len, steps_alloc;
+	/* Size of a single struct in the current and old SDNA. */
+	int cur_len, old_len;
+} ReconstructStruct;
+
+typedef struct DNA_ReconstructInfo {
+	const SDNA *oldsdna;
+	const SDNA *newsdna;
+	/* One item for each struct in oldsdna, steps are only filled in for SDNA_CMP_NOT_EQUAL. */
+	ReconstructStruct *structs;
+} DNA_ReconstructInfo;
+
+static ReconstructStep *reconstruct_step_add(ReconstructStruct *rs, const eReconstructStepType type)
+{
+	ReconstructStep *step;
+
+	if (rs->steps_len == rs->steps_alloc) {
+		rs->steps_alloc = rs->steps_alloc ? rs->steps_alloc * 2 : 16;
+		rs->steps = MEM_reallocN(rs->steps, sizeof(*rs->steps) * rs->steps_alloc);
+	}
+
+	step = &rs->steps[rs->steps_len++];
+	memset(step, 0, sizeof(*step));
+	step->type = type;
+	return step;
+}
+
+static void reconstruct_step_add_memcpy(ReconstructStruct *rs, int cur_offset, int old_offset, int len)
+{
+	ReconstructStep *step;
+
+	if (len <= 0) {
+		return;
+	}
+
+	/* merge with the previous copy when both source and destination are contiguous,
+	 * so unchanged runs of fields end up as a single memcpy */
+	if (rs->steps_len != 0) {
+		step = &rs->steps[rs->steps_len - 1];
+		if ((step->type == RECONSTRUCT_STEP_MEMCPY) &&
+		    (step->cur_offset + step->len == cur_offset) &&
+		    (step->old_offset + step->len == old_offset))
+		{
+			step->len += len;
+			return;
+		}
+	}
+
+	step = reconstruct_step_add(rs, RECONSTRUCT_STEP_MEMCPY);
+	step->cur_offset = cur_offset;
+	step->old_offset = old_offset;
+	step->len = len;
+}
+
+static void reconstruct_step_add_cast_elem(
+        ReconstructStruct *rs, const char *ctype, const char *otype, int arrlen,
+        int cur_offset, int old_offset)
+{
+	ReconstructStep *step;
+	eSDNA_Type ctypenr, otypenr;
+
+	if ( (otypenr = sdna_type_nr(otype)) == -1 ||
+	     (ctypenr = sdna_type_nr(ctype)) == -1)
+	{
+		return;
+	}
+
+	step = reconstruct_step_add(rs, RECONSTRUCT_STEP_CAST_PRIMITIVE);
+	step->cur_typenr = ctypenr;
+	step->old_typenr = otypenr;
+	step->cur_offset = cur_offset;
+	step->old_offset = old_offset;
+	step->len = arrlen;
+}
+
+static void reconstruct_step_add_cast_pointer(
+        ReconstructStruct *rs, int curlen, int oldlen, int arrlen,
+        int cur_offset, int old_offset)
+{
+	ReconstructStep *step;
+
+	if (curlen == oldlen) {
+		reconstruct_step_add_memcpy(rs, cur_offset, old_offset, curlen * arrlen);
+	}
+	else if ((curlen == 4 && oldlen == 8) || (curlen == 8 && oldlen == 4)) {
+		step = reconstruct_step_add(rs, RECONSTRUCT_STEP_CAST_POINTER);
+		step->cur_offset = cur_offset;
+		step->old_offset = old_offset;
+		step->len = arrlen;
+	}
+	else {
+		/* for debug */
+		printf("errpr: illegal pointersize!\n");
 	}
-	return NULL;
 }
 
 /**
- * Converts the contents of a single field of a struct, of a non-struct type,
+ * Adds the steps converting a single field of a struct, of a non-struct type,
  * from oldsdna to newsdna format.
  *
  * \param newsdna  SDNA of current Blender
  * \param oldsdna  SDNA of Blender that saved file
  * \param type  current field type name
  * \param name  current field name
- * \param curdata  put field data converted to newsdna here
+ * \param cur_offset  offset of the field in the converted data
  * \param old  pointer to struct info in oldsdna
- * \param olddata  struct contents laid out according to oldsdna
+ * \param old_offset  offset of the old struct contents laid out according to oldsdna
+ * \param rs  steps are appended here
  */
 static void reconstruct_elem(
         const SDNA *newsdna,
         const SDNA *oldsdna,
         const char *type,
         const char *name,
-        char *curdata,
+        int cur_offset,
         const short *old,
-        const char *olddata)
+        int old_offset,
+        ReconstructStruct *rs)
 {
 	/* rules: test for NAME:
 	 *      - name equal:
@@ -993,13 +1120,17 @@ static void reconstruct_elem(
 		if (strcmp(name, oname) == 0) { /* name equal */
 			
 			if (ispointer(name)) {  /* pointer of functionpointer afhandelen */
-				cast_pointer(newsdna->pointerlen, oldsdna->pointerlen, name, curdata, olddata);
+				reconstruct_step_add_cast_pointer(
+				        rs, newsdna->pointerlen, oldsdna->pointerlen, DNA_elem_array_size(name),
+				        cur_offset, old_offset);
 			}
 			else if (strcmp(type, otype) == 0) {    /* type equal */
-				memcpy(curdata, olddata, len);
+				reconstruct_step_add_memcpy(rs, cur_offset, old_offset, len);
 			}
 			else {
-				cast_elem(type, otype, name, curdata, olddata);
+				reconstruct_step_add_cast_elem(
+				        rs, type, otype, DNA_elem_array_size(name),
+				        cur_offset, old_offset);
 			}
 
 			return;
@@ -1012,34 +1143,35 @@ static void reconstruct_elem(
 				oldsize = DNA_elem_array_size(oname);
 
 				if (ispointer(name)) {  /* handle pointer or functionpointer */
-					cast_pointer(newsdna->pointerlen, oldsdna->pointerlen,
-					             cursize > oldsize ? oname : name,
-					             curdata, olddata);
+					reconstruct_step_add_cast_pointer(
+					        rs, newsdna->pointerlen, oldsdna->pointerlen, cursize > oldsize ? oldsize : cursize,
+					        cur_offset, old_offset);
 				}
 				else if (strcmp(type, otype) == 0) {  /* type equal */
 					mul = len / oldsize; /* size of single old array element */
 					mul *= (cursize < oldsize) ? cursize : oldsize; /* smaller of sizes of old and new arrays */
-					memcpy(curdata, olddata, mul);
+					reconstruct_step_add_memcpy(rs, cur_offset, old_offset, mul);
 					
 					if (oldsize > cursize && strcmp(type, "char") == 0) {
 						/* string had to be truncated, ensure it's still null-terminated */
-						curdata[mul - 1] = '\0';
+						ReconstructStep *step = reconstruct_step_add(rs, RECONSTRUCT_STEP_TERMINATE_STRING);
+						step->cur_offset = cur_offset + mul - 1;
 					}
 				}
 				else {
-					cast_elem(type, otype,
-					          cursize > oldsize ? oname : name,
-					          curdata, olddata);
+					reconstruct_step_add_cast_elem(
+					        rs, type, otype, cursize > oldsize ? oldsize : cursize,
+					        cur_offset, old_offset);
 				}
 				return;
 			}
 		}
-		olddata += len;
+		old_offset += len;
 	}
 }
 
 /**
- * Converts the contents of an entire struct from oldsdna to newsdna format.
+ * Adds the steps converting the contents of an entire struct from oldsdna to newsdna format.
  *
  * \param newsdna  SDNA of current Blender
  * \param oldsdna  SDNA of Blender that saved file
@@ -1047,9 +1179,10 @@ static void reconstruct_elem(
  *
  * Result from DNA_struct_get_compareflags to avoid needless conversions.
  * \param oldSDNAnr  Index of old struct definition in oldsdna
- * \param data  Struct contents laid out according to oldsdna
+ * \param old_offset  Offset of the struct contents laid out according to oldsdna
  * \param curSDNAnr  Index of current struct definition in newsdna
- * \param cur  Where to put converted struct contents
+ * \param cur_offset  Offset where to put converted struct contents
+ * \param rs  steps are appended here
  */
 static void reconstruct_struct(
         const SDNA *newsdna,
@@ -1057,9 +1190,10 @@ static void reconstruct_struct(
         const char *compflags,
 
         int oldSDNAnr,
-        const char *data,
+        int old_offset,
         int curSDNAnr,
-        char *cur)
+        int cur_offset,
+        ReconstructStruct *rs)
 {
 	/* Recursive!
 	 * Per element from cur_struct, read data from old_struct.
@@ -1068,8 +1202,7 @@ static void reconstruct_struct(
 	int a, elemcount, elen, eleno, mul, mulo, firststructtypenr;
 	const short *spo, *spc, *sppo;
 	const char *type;
-	const char *cpo;
-	char *cpc;
+	int cpo, cpc;
 	const char *name, *nameo;
 
 	unsigned int oldsdna_index_last = UINT_MAX;
@@ -1083,7 +1216,7 @@ static void reconstruct_struct(
 		/* if recursive: test for equal */
 		spo = oldsdna->structs[oldSDNAnr];
 		elen = oldsdna->typelens[spo[0]];
-		memcpy(cur, data, elen);
+		reconstruct_step_add_memcpy(rs, cur_offset, old_offset, elen);
 		
 		return;
 	}
@@ -1096,7 +1229,7 @@ static void reconstruct_struct(
 	elemcount = spc[1];
 
 	spc += 2;
-	cpc = cur;
+	cpc = cur_offset;
 	for (a = 0; a < elemcount; a++, spc += 2) {  /* convert each field */
 		type = newsdna->types[spc[0]];
 		name = newsdna->names[spc[1]];
@@ -1107,9 +1240,12 @@ static void reconstruct_struct(
 		if (spc[0] >= firststructtypenr && !ispointer(name)) {
 			/* struct field type */
 			/* where does the old struct data start (and is there an old one?) */
-			cpo = (char *)find_elem(oldsdna, type, name, spo, data, &sppo);
+			sppo = NULL;
+			cpo = find_elem_offset(oldsdna, type, name, spo, &sppo);
 			
-			if (cpo) {
+			if (cpo != -1) {
+				cpo += old_offset;
+
 				oldSDNAnr = DNA_struct_find_nr_ex(oldsdna, type, &oldsdna_index_last);
 				curSDNAnr = DNA_struct_find_nr_ex(newsdna, type, &cursdna_index_last);
 				
@@ -1124,7 +1260,7 @@ static void reconstruct_struct(
 				eleno /= mulo;
 				
 				while (mul--) {
-					reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
+					reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc, rs);
 					cpo += eleno;
 					cpc += elen;
 					
@@ -1132,6 +1268,8 @@ static void reconstruct_struct(
 					mulo--;
 					if (mulo <= 0) break;
 				}
+				/* skip remaining elements of a new array larger than old */
+				cpc += elen * (mul > 0 ? mul : 0);
 			}
 			else {
 				cpc += elen;  /* skip field no longer present */
@@ -1139,12 +1277,42 @@ static void reconstruct_struct(
 		}
 		else {
 			/* non-struct field type */
-			reconstruct_elem(newsdna, oldsdna, type, name, cpc, spo, data);
+			reconstruct_elem(newsdna, oldsdna, type, name, cpc, spo, old_offset, rs);
 			cpc += elen;
 		}
 	}
 }
 
+/**
+ * Runs the steps made by #reconstruct_struct for a single struct.
+ */
+static void reconstruct_struct_exec(
+        const DNA_ReconstructInfo *reconstruct_info, const ReconstructStruct *rs,
+        char *cur, const char *old)
+{
+	const int curlen = reconstruct_info->newsdna->pointerlen;
+	const int oldlen = reconstruct_info->oldsdna->pointerlen;
+	const ReconstructStep *step = rs->steps;
+
+	for (int a = 0; a < rs->steps_len; a++, step++) {
+		switch ((eReconstructStepType)step->type) {
+			case RECONSTRUCT_STEP_MEMCPY:
+				memcpy(cur + step->cur_offset, old + step->old_offset, step->len);
+				break;
+			case RECONSTRUCT_STEP_CAST_PRIMITIVE:
+				cast_elem(step->cur_typenr, step->old_typenr, step->len,
+				          cur + step->cur_offset, old + step->old_offset);
+				break;
+			case RECONSTRUCT_STEP_CAST_POINTER:
+				cast_pointer(curlen, oldlen, step->len, cur + step->cur_offset, old + step->old_offset);
+				break;
+			case RECONSTRUCT_STEP_TERMINATE_STRING:
+				cur[step->cur_offset] = '\0';
+				break;
+		}
+	}
+}
+
 /**
  * Does endian swapping on the fields of a struct value.
  *
@@ -1234,49 +1402,112 @@ void DNA_struct_switch_endian(const SDNA *oldsdna, int oldSDNAnr, char *data)
 }
 
 /**
- * \param newsdna  SDNA of current Blender
+ * Resolves the differences between oldsdna and newsdna for every struct which needs converting,
+ * see #DNA_struct_reconstruct.
+ *
  * \param oldsdna  SDNA of Blender that saved file
- * \param compflags
+ * \param newsdna  SDNA of current Blender
+ * \param compflags  Result from #DNA_struct_get_compareflags
+ */
+DNA_ReconstructInfo *DNA_reconstruct_info_create(
+        const SDNA *oldsdna, const SDNA *newsdna, const char *compflags)
+{
+	DNA_ReconstructInfo *reconstruct_info = MEM_callocN(sizeof(*reconstruct_info), __func__);
+	unsigned int newsdna_index_last = 0;
+
+	reconstruct_info->oldsdna = oldsdna;
+	reconstruct_info->newsdna = newsdna;
+	reconstruct_info->structs = MEM_callocN(sizeof(*reconstruct_info->structs) * oldsdna->nr_structs, __func__);
+
+	for (int oldSDNAnr = 0; oldSDNAnr < oldsdna->nr_structs; oldSDNAnr++) {
+		ReconstructStruct *rs = &reconstruct_info->structs[oldSDNAnr];
+		const short *spo, *spc;
+		int curSDNAnr;
+
+		if (compflags[oldSDNAnr] != SDNA_CMP_NOT_EQUAL) {
+			continue;
+		}
+
+		/* oldSDNAnr == structnr, we're looking for the corresponding 'cur' number */
+		spo = oldsdna->structs[oldSDNAnr];
+		curSDNAnr = DNA_struct_find_nr_ex(newsdna, oldsdna->types[spo[0]], &newsdna_index_last);
+		if (curSDNAnr == -1) {
+			continue;
+		}
+		spc = newsdna->structs[curSDNAnr];
+
+		rs->old_len = oldsdna->typelens[spo[0]];
+		rs->cur_len = newsdna->typelens[spc[0]];
+
+		reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, 0, curSDNAnr, 0, rs);
+	}
+
+	return reconstruct_info;
+}
+
+void DNA_reconstruct_info_free(DNA_ReconstructInfo *reconstruct_info)
+{
+	const int nr_structs = reconstruct_info->oldsdna->nr_structs;
+
+	for (int a = 0; a < nr_structs; a++) {
+		MEM_SAFE_FREE(reconstruct_info->structs[a].steps);
+	}
+	MEM_freeN(reconstruct_info->structs);
+	MEM_freeN(reconstruct_info);
+}
+
+/**
+ * \return The size of a single reconstructed struct, zero when the struct
+ * can't be converted (it's not in the current SDNA or it needs no converting).
+ */
+int DNA_struct_reconstruct_size(const DNA_ReconstructInfo *reconstruct_info, int oldSDNAnr)
+{
+	return reconstruct_info->structs[oldSDNAnr].cur_len;
+}
+
+/**
+ * Converts the blocks in range [block_start, block_end) into \a cur, which must be zero initialized
+ * and hold all \a blocks. Different ranges of the same array can be converted in parallel.
  *
- * Result from DNA_struct_get_compareflags to avoid needless conversions
+ * \param reconstruct_info  Result from #DNA_reconstruct_info_create
+ * \param oldSDNAnr  Index of struct info within oldsdna
+ * \param data  Array of struct data laid out according to oldsdna
+ * \param cur  Array of converted struct data
+ */
+void DNA_struct_reconstruct_range(
+        const DNA_ReconstructInfo *reconstruct_info, int oldSDNAnr,
+        int block_start, int block_end, const void *data, void *cur)
+{
+	const ReconstructStruct *rs = &reconstruct_info->structs[oldSDNAnr];
+	const char *cpo = (const char *)data + (size_t)block_start * rs->old_len;
+	char *cpc = (char *)cur + (size_t)block_start * rs->cur_len;
+
+	for (int a = block_start; a < block_end; a++) {
+		reconstruct_struct_exec(reconstruct_info, rs, cpc, cpo);
+		cpc += rs->cur_len;
+		cpo += rs->old_len;
+	}
+}
+
+/**
+ * \param reconstruct_info  Result from #DNA_reconstruct_info_create
  * \param oldSDNAnr  Index of struct info within oldsdna
  * \param blocks  The number of array elements
  * \param data  Array of struct data
  * \return An allocated reconstructed struct
  */
 void *DNA_struct_reconstruct(
-        const SDNA *newsdna, const SDNA *oldsdna,
-        const char *compflags, int oldSDNAnr, int blocks, const void *data)
+        const DNA_ReconstructInfo *reconstruct_info, int oldSDNAnr, int blocks, const void *data)
 {
-	int a, curSDNAnr, curlen = 0, oldlen;
-	const short *spo, *spc;
-	char *cur, *cpc;
-	const char *cpo;
-	const char *type;
-	
-	/* oldSDNAnr == structnr, we're looking for the corresponding 'cur' number */
-	spo = oldsdna->structs[oldSDNAnr];
-	type = oldsdna->types[spo[0]];
-	oldlen = oldsdna->typelens[spo[0]];
-	curSDNAnr = DNA_struct_find_nr(newsdna, type);
+	const int curlen = DNA_struct_reconstruct_size(reconstruct_info, oldSDNAnr);
+	char *cur;
 
-	/* init data and alloc */
-	if (curSDNAnr != -1) {
-		spc = newsdna->structs[curSDNAnr];
-		curlen = newsdna->typelens[spc[0]];
-	}
 	if (curlen == 0) {
 		return NULL;
 	}
 
-	cur = MEM_callocN(blocks * curlen, "reconstruct");
-	cpc = cur;
-	cpo = data;
-	for (a = 0; a < blocks; a++) {
-		reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
-		cpc += curlen;
-		cpo += oldlen;
-	}
+	cur = MEM_callocN((size_t)blocks * curlen, "reconstruct");
+	DNA_struct_reconstruct_range(reconstruct_info, oldSDNAnr, 0, blocks, data, cur);
 
 	return cur;
 }
@@ -1289,9 +1520,8 @@ int DNA_elem_offset(SDNA *sdna, const char *stype, const char *vartype, const ch
 {
 	const int SDNAnr = DNA_struct_find_nr(sdna, stype);
 	const short * const spo = sdna->structs[SDNAnr];
-	const char * const cp = find_elem(sdna, vartype, name, spo, NULL, NULL);
 	BLI_assert(SDNAnr != -1);
-	return (int)((intptr_t)cp);
+	return find_elem_offset(sdna, vartype, name, spo, NULL);
 }
 
 bool DNA_struct_find(const SDNA *sdna, const char *stype)
@@ -1305,9 +1535,9 @@ bool DNA_struct_elem_find(const SDNA *sdna, const char *stype, const char *varty
 	
 	if (SDNAnr != -1) {
 		const short * const spo = sdna->structs[SDNAnr];
-		const char * const cp = find_elem(sdna, vartype, name, spo, NULL, NULL);
+		const int offset = find_elem_offset(sdna, vartype, name, spo, NULL);
 		
-		if (cp) {
+		if (offset != -1) {
 			return true;
 		}
 	}
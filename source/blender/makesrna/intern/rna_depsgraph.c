@@ -42,6 +42,9 @@
 
 #ifdef RNA_RUNTIME
 
+#include "BKE_main.h"
+#include "BKE_report.h"
+
 #include "DEG_depsgraph_build.h"
 #include "DEG_depsgraph_debug.h"
 
@@ -55,11 +58,49 @@ static void rna_Depsgraph_debug_graphviz(Depsgraph *graph, const char *filename)
 	fclose(f);
 }
 
+static void rna_Depsgraph_debug_timeline_begin(Depsgraph *graph)
+{
+	DEG_debug_timeline_begin(graph);
+}
+
+static void rna_Depsgraph_debug_timeline_end(Depsgraph *graph)
+{
+	DEG_debug_timeline_end(graph);
+}
+
+static void rna_Depsgraph_debug_timeline_export(Depsgraph *graph, ReportList *reports, const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open file '%s' for writing", filename);
+		return;
+	}
+	if (!DEG_debug_timeline_write_chrome_trace(graph, f)) {
+		BKE_report(reports, RPT_WARNING, "No evaluation timeline was recorded");
+	}
+	fclose(f);
+}
+
+static void rna_Depsgraph_debug_timeline_stats(Depsgraph *graph, int num_slowest, char *result)
+{
+	DEG_debug_timeline_stats(graph, num_slowest, result, STATS_MAX_SIZE);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *graph)
 {
 	DEG_graph_tag_relations_update(graph);
 }
 
+static int rna_Depsgraph_debug_relations_update(Depsgraph *UNUSED(graph), ID *id, Main *bmain)
+{
+	return DEG_debug_scene_relations_update_incremental(bmain, (struct Scene *)id);
+}
+
+static int rna_Depsgraph_debug_relations_validate(Depsgraph *UNUSED(graph), ID *id, Main *bmain)
+{
+	return DEG_debug_scene_relations_compare(bmain, (struct Scene *)id);
+}
+
 static void rna_Depsgraph_debug_stats(Depsgraph *graph, char *result)
 {
 	size_t outer, ops, rels;
@@ -87,12 +128,47 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 
 	func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
+	func = RNA_def_function(srna, "debug_relations_update", "rna_Depsgraph_debug_relations_update");
+	RNA_def_function_ui_description(func, "Update relations tagged for update, like a scene update does");
+	RNA_def_function_flag(func, FUNC_USE_SELF_ID | FUNC_USE_MAIN);
+	parm = RNA_def_boolean(func, "result", 0, "",
+	                       "False if the graph was built from scratch instead of updating the tagged relations only");
+	RNA_def_function_return(func, parm);
+
+	func = RNA_def_function(srna, "debug_relations_validate", "rna_Depsgraph_debug_relations_validate");
+	RNA_def_function_ui_description(func, "Compare the graph with one built from scratch, differences are printed");
+	RNA_def_function_flag(func, FUNC_USE_SELF_ID | FUNC_USE_MAIN);
+	parm = RNA_def_boolean(func, "result", 0, "", "True if both graphs have the same operations and relations");
+	RNA_def_function_return(func, parm);
+
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
 	RNA_def_function_ui_description(func, "Report the number of elements in the Dependency Graph");
 	/* weak!, no way to return dynamic string type */
 	parm = RNA_def_string(func, "result", NULL, STATS_MAX_SIZE, "result", "");
 	RNA_def_parameter_flags(parm, PROP_THICK_WRAP, 0); /* needed for string return value */
 	RNA_def_function_output(func, parm);
+
+	func = RNA_def_function(srna, "debug_timeline_begin", "rna_Depsgraph_debug_timeline_begin");
+	RNA_def_function_ui_description(func, "Start recording the timeline of evaluated operations");
+
+	func = RNA_def_function(srna, "debug_timeline_end", "rna_Depsgraph_debug_timeline_end");
+	RNA_def_function_ui_description(func, "Stop recording the timeline of evaluated operations");
+
+	func = RNA_def_function(srna, "debug_timeline_export", "rna_Depsgraph_debug_timeline_export");
+	RNA_def_function_ui_description(func, "Export the recorded timeline as Chrome trace JSON");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the trace, to be loaded into chrome://tracing");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
+	func = RNA_def_function(srna, "debug_timeline_stats", "rna_Depsgraph_debug_timeline_stats");
+	RNA_def_function_ui_description(func, "Report timings and parallel efficiency of the recorded timeline");
+	RNA_def_int(func, "num_slowest", 10, 0, INT_MAX, "",
+	            "Number of slowest operations to list", 0, 100);
+	/* weak!, no way to return dynamic string type */
+	parm = RNA_def_string(func, "result", NULL, STATS_MAX_SIZE, "result", "");
+	RNA_def_parameter_flags(parm, PROP_THICK_WRAP, 0); /* needed for string return value */
+	RNA_def_function_output(func, parm);
 }
 
 void RNA_def_depsgraph(BlenderRNA *brna)
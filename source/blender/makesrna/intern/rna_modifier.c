@@ -459,8 +459,15 @@ static void rna_Modifier_update(Main *UNUSED(bmain), Scene *UNUSED(scene), Point
 
 static void rna_Modifier_dependency_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
+	ModifierData *md = ptr->data;
+
 	rna_Modifier_update(bmain, scene, ptr);
-	DAG_relations_tag_update(bmain);
+	if (modifier_typeAffectsSceneRelations(md->type)) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		DAG_id_relations_tag_update(bmain, ptr->id.data);
+	}
 }
 
 /* Vertex Groups */
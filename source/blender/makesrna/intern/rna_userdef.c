@@ -101,6 +101,7 @@ static const EnumPropertyItem rna_enum_language_default_items[] = {
 #include "BKE_depsgraph.h"
 #include "BKE_global.h"
 #include "BKE_main.h"
+#include "BKE_modifier_cache.h"
 #include "BKE_idprop.h"
 #include "BKE_pbvh.h"
 #include "BKE_paint.h"
@@ -354,6 +355,16 @@ static void rna_Userdef_memcache_update(Main *UNUSED(bmain), Scene *UNUSED(scene
 	MEM_CacheLimiter_set_maximum(((size_t) U.memcachelimit) * 1024 * 1024);
 }
 
+static int rna_Userdef_modifier_cache_memory_get(PointerRNA *UNUSED(ptr))
+{
+	return (int)(BKE_modifier_cache_memory_in_use() / 1024);
+}
+
+static int rna_Userdef_modifier_cache_hits_get(PointerRNA *UNUSED(ptr))
+{
+	return (int)BKE_modifier_cache_hits();
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
 	Object *ob;
@@ -4058,6 +4069,32 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "compositor_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "compositor_cache_limit");
+	RNA_def_property_range(prop, 0, (sizeof(void *) == 8) ? 1024 * 32 : 1024); /* 32 bit 2 GB, 64 bit 32 GB */
+	RNA_def_property_ui_text(prop, "Compositor Cache Limit",
+	                         "Memory limit for buffers kept between compositor updates, so unchanged parts of the "
+	                         "node tree are not calculated again (in megabytes, 0 to disable)");
+
+	prop = RNA_def_property(srna, "modifier_cache_limit", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "modifier_cache_limit");
+	RNA_def_property_range(prop, 0, (sizeof(void *) == 8) ? 1024 * 32 : 1024); /* 32 bit 2 GB, 64 bit 32 GB */
+	RNA_def_property_ui_text(prop, "Modifier Cache Limit",
+	                         "Memory limit for results of expensive modifiers kept between updates, so modifiers "
+	                         "in front of a changed one are not calculated again (in megabytes, 0 to disable)");
+
+	prop = RNA_def_property(srna, "modifier_cache_memory", PROP_INT, PROP_NONE);
+	RNA_def_property_int_funcs(prop, "rna_Userdef_modifier_cache_memory_get", NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Modifier Cache Memory",
+	                         "Memory used by results of modifiers kept in the modifier cache (in kilobytes)");
+
+	prop = RNA_def_property(srna, "modifier_cache_hits", PROP_INT, PROP_NONE);
+	RNA_def_property_int_funcs(prop, "rna_Userdef_modifier_cache_hits_get", NULL, NULL);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_ui_text(prop, "Modifier Cache Hits",
+	                         "Number of modifier stack evaluations which continued from a cached result");
+
 	prop = RNA_def_property(srna, "frame_server_port", PROP_INT, PROP_NONE);
 	RNA_def_property_int_sdna(prop, NULL, "frameserverport");
 	RNA_def_property_range(prop, 0, 32727);
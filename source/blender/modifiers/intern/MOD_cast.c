@@ -134,23 +134,97 @@ static void updateDepsgraph(ModifierData *md,
 	}
 }
 
+typedef struct CastUserdata {
+	/*const*/ CastModifierData *cmd;
+	short flag;
+	bool has_radius;
+	bool use_ctrl_ob;
+	float len;
+	float center[3];
+	float mat[4][4], imat[4][4];
+	float bb[8][3];
+} CastUserdata;
+
+/* Transform into the space of the control object, and back. */
+static void cast_co_to_ctrl_space(CastUserdata *data, float co[3])
+{
+	if (data->use_ctrl_ob) {
+		if (data->flag & MOD_CAST_USE_OB_TRANSFORM) {
+			mul_m4_v3(data->mat, co);
+		}
+		else {
+			sub_v3_v3(co, data->center);
+		}
+	}
+}
+
+static void cast_co_from_ctrl_space(CastUserdata *data, float co[3])
+{
+	if (data->use_ctrl_ob) {
+		if (data->flag & MOD_CAST_USE_OB_TRANSFORM) {
+			mul_m4_v3(data->imat, co);
+		}
+		else {
+			add_v3_v3(co, data->center);
+		}
+	}
+}
+
+static void sphere_do_task(void *userdata, const int UNUSED(i), float co[3], const float weight)
+{
+	CastUserdata *data = userdata;
+	CastModifierData *cmd = data->cmd;
+	const short flag = data->flag;
+	const float len = data->len;
+	float fac = cmd->fac;
+	float facm = 1.0f - fac;
+	float vec[3], tmp_co[3];
+
+	copy_v3_v3(tmp_co, co);
+	cast_co_to_ctrl_space(data, tmp_co);
+
+	copy_v3_v3(vec, tmp_co);
+
+	if (cmd->type == MOD_CAST_TYPE_CYLINDER)
+		vec[2] = 0.0f;
+
+	if (data->has_radius) {
+		if (len_v3(vec) > cmd->radius) return;
+	}
+
+	if (weight == 0.0f) {
+		return;
+	}
+
+	fac *= weight;
+	facm = 1.0f - fac;
+
+	normalize_v3(vec);
+
+	if (flag & MOD_CAST_X)
+		tmp_co[0] = fac * vec[0] * len + facm * tmp_co[0];
+	if (flag & MOD_CAST_Y)
+		tmp_co[1] = fac * vec[1] * len + facm * tmp_co[1];
+	if (flag & MOD_CAST_Z)
+		tmp_co[2] = fac * vec[2] * len + facm * tmp_co[2];
+
+	cast_co_from_ctrl_space(data, tmp_co);
+
+	copy_v3_v3(co, tmp_co);
+}
+
 static void sphere_do(
         CastModifierData *cmd, Object *ob, DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts)
 {
-	MDeformVert *dvert = NULL;
-
+	CastUserdata data = {NULL};
 	Object *ctrl_ob = NULL;
+	MDeformVert *dvert;
+	int defgrp_index;
 
-	int i, defgrp_index;
-	bool has_radius = false;
+	int i;
 	short flag, type;
 	float len = 0.0f;
-	float fac = cmd->fac;
-	float facm = 1.0f - fac;
-	const float fac_orig = fac;
-	float vec[3], center[3] = {0.0f, 0.0f, 0.0f};
-	float mat[4][4], imat[4][4];
 
 	flag = cmd->flag;
 	type = cmd->type; /* projection type: sphere or cylinder */
@@ -165,13 +239,13 @@ static void sphere_do(
 	 * we use its location, transformed to ob's local space */
 	if (ctrl_ob) {
 		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-			invert_m4_m4(imat, ctrl_ob->obmat);
-			mul_m4_m4m4(mat, imat, ob->obmat);
-			invert_m4_m4(imat, mat);
+			invert_m4_m4(data.imat, ctrl_ob->obmat);
+			mul_m4_m4m4(data.mat, data.imat, ob->obmat);
+			invert_m4_m4(data.imat, data.mat);
 		}
 
 		invert_m4_m4(ob->imat, ob->obmat);
-		mul_v3_m4v3(center, ob->imat, ctrl_ob->obmat[3]);
+		mul_v3_m4v3(data.center, ob->imat, ctrl_ob->obmat[3]);
 	}
 
 	/* now we check which options the user wants */
@@ -179,7 +253,7 @@ static void sphere_do(
 	/* 1) (flag was checked in the "if (ctrl_ob)" block above) */
 	/* 2) cmd->radius > 0.0f: only the vertices within this radius from
 	 * the center of the effect should be deformed */
-	if (cmd->radius > FLT_EPSILON) has_radius = 1;
+	if (cmd->radius > FLT_EPSILON) data.has_radius = true;
 
 	/* 3) if we were given a vertex group name,
 	 * only those vertices should be affected */
@@ -194,83 +268,121 @@ static void sphere_do(
 
 	if (len <= 0) {
 		for (i = 0; i < numVerts; i++) {
-			len += len_v3v3(center, vertexCos[i]);
+			len += len_v3v3(data.center, vertexCos[i]);
 		}
 		len /= numVerts;
 
 		if (len == 0.0f) len = 10.0f;
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		float tmp_co[3];
+	data.cmd = cmd;
+	data.flag = flag;
+	data.use_ctrl_ob = (ctrl_ob != NULL);
+	data.len = len;
 
-		copy_v3_v3(tmp_co, vertexCos[i]);
-		if (ctrl_ob) {
-			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(mat, tmp_co);
-			}
-			else {
-				sub_v3_v3(tmp_co, center);
-			}
-		}
+	BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, sphere_do_task);
+}
 
-		copy_v3_v3(vec, tmp_co);
+static void cuboid_do_task(void *userdata, const int UNUSED(i), float co[3], const float weight)
+{
+	CastUserdata *data = userdata;
+	CastModifierData *cmd = data->cmd;
+	const short flag = data->flag;
+	float fac = cmd->fac;
+	float facm = 1.0f - fac;
+	int octant, coord;
+	float d[3], dmax, apex[3], fbb;
+	float tmp_co[3];
+
+	copy_v3_v3(tmp_co, co);
+	cast_co_to_ctrl_space(data, tmp_co);
+
+	if (data->has_radius) {
+		if (fabsf(tmp_co[0]) > cmd->radius ||
+		    fabsf(tmp_co[1]) > cmd->radius ||
+		    fabsf(tmp_co[2]) > cmd->radius)
+		{
+			return;
+		}
+	}
 
-		if (type == MOD_CAST_TYPE_CYLINDER)
-			vec[2] = 0.0f;
+	if (weight == 0.0f) {
+		return;
+	}
 
-		if (has_radius) {
-			if (len_v3(vec) > cmd->radius) continue;
-		}
+	fac *= weight;
+	facm = 1.0f - fac;
+
+	/* The algo used to project the vertices to their
+	 * bounding box (bb) is pretty simple:
+	 * for each vertex v:
+	 * 1) find in which octant v is in;
+	 * 2) find which outer "wall" of that octant is closer to v;
+	 * 3) calculate factor (var fbb) to project v to that wall;
+	 * 4) project. */
+
+	/* find in which octant this vertex is in */
+	octant = 0;
+	if (tmp_co[0] > 0.0f) octant += 1;
+	if (tmp_co[1] > 0.0f) octant += 2;
+	if (tmp_co[2] > 0.0f) octant += 4;
+
+	/* apex is the bb's vertex at the chosen octant */
+	copy_v3_v3(apex, data->bb[octant]);
+
+	/* find which bb plane is closest to this vertex ... */
+	d[0] = tmp_co[0] / apex[0];
+	d[1] = tmp_co[1] / apex[1];
+	d[2] = tmp_co[2] / apex[2];
+
+	/* ... (the closest has the higher (closer to 1) d value) */
+	dmax = d[0];
+	coord = 0;
+	if (d[1] > dmax) {
+		dmax = d[1];
+		coord = 1;
+	}
+	if (d[2] > dmax) {
+		/* dmax = d[2]; */ /* commented, we don't need it */
+		coord = 2;
+	}
 
-		if (dvert) {
-			const float weight = defvert_find_weight(&dvert[i], defgrp_index);
-			if (weight == 0.0f) {
-				continue;
-			}
+	/* ok, now we know which coordinate of the vertex to use */
 
-			fac = fac_orig * weight;
-			facm = 1.0f - fac;
-		}
+	if (fabsf(tmp_co[coord]) < FLT_EPSILON) /* avoid division by zero */
+		return;
 
-		normalize_v3(vec);
+	/* finally, this is the factor we wanted, to project the vertex
+	 * to its bounding box (bb) */
+	fbb = apex[coord] / tmp_co[coord];
 
-		if (flag & MOD_CAST_X)
-			tmp_co[0] = fac * vec[0] * len + facm * tmp_co[0];
-		if (flag & MOD_CAST_Y)
-			tmp_co[1] = fac * vec[1] * len + facm * tmp_co[1];
-		if (flag & MOD_CAST_Z)
-			tmp_co[2] = fac * vec[2] * len + facm * tmp_co[2];
+	/* calculate the new vertex position */
+	if (flag & MOD_CAST_X)
+		tmp_co[0] = facm * tmp_co[0] + fac * tmp_co[0] * fbb;
+	if (flag & MOD_CAST_Y)
+		tmp_co[1] = facm * tmp_co[1] + fac * tmp_co[1] * fbb;
+	if (flag & MOD_CAST_Z)
+		tmp_co[2] = facm * tmp_co[2] + fac * tmp_co[2] * fbb;
 
-		if (ctrl_ob) {
-			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(imat, tmp_co);
-			}
-			else {
-				add_v3_v3(tmp_co, center);
-			}
-		}
+	cast_co_from_ctrl_space(data, tmp_co);
 
-		copy_v3_v3(vertexCos[i], tmp_co);
-	}
+	copy_v3_v3(co, tmp_co);
 }
 
 static void cuboid_do(
         CastModifierData *cmd, Object *ob, DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts)
 {
-	MDeformVert *dvert = NULL;
+	CastUserdata data = {NULL};
 	Object *ctrl_ob = NULL;
+	MDeformVert *dvert;
+	int defgrp_index;
 
-	int i, defgrp_index;
-	bool has_radius = false;
+	int i;
 	short flag;
-	float fac = cmd->fac;
-	float facm = 1.0f - fac;
-	const float fac_orig = fac;
-	float min[3], max[3], bb[8][3];
-	float center[3] = {0.0f, 0.0f, 0.0f};
-	float mat[4][4], imat[4][4];
+	float min[3], max[3];
+	float (*bb)[3] = data.bb;
+	float *center = data.center;
 
 	flag = cmd->flag;
 
@@ -281,7 +393,7 @@ static void cuboid_do(
 	/* 1) (flag was checked in the "if (ctrl_ob)" block above) */
 	/* 2) cmd->radius > 0.0f: only the vertices within this radius from
 	 * the center of the effect should be deformed */
-	if (cmd->radius > FLT_EPSILON) has_radius = 1;
+	if (cmd->radius > FLT_EPSILON) data.has_radius = true;
 
 	/* 3) if we were given a vertex group name,
 	 * only those vertices should be affected */
@@ -289,16 +401,16 @@ static void cuboid_do(
 
 	if (ctrl_ob) {
 		if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-			invert_m4_m4(imat, ctrl_ob->obmat);
-			mul_m4_m4m4(mat, imat, ob->obmat);
-			invert_m4_m4(imat, mat);
+			invert_m4_m4(data.imat, ctrl_ob->obmat);
+			mul_m4_m4m4(data.mat, data.imat, ob->obmat);
+			invert_m4_m4(data.imat, data.mat);
 		}
 
 		invert_m4_m4(ob->imat, ob->obmat);
 		mul_v3_m4v3(center, ob->imat, ctrl_ob->obmat[3]);
 	}
 
-	if ((flag & MOD_CAST_SIZE_FROM_RADIUS) && has_radius) {
+	if ((flag & MOD_CAST_SIZE_FROM_RADIUS) && data.has_radius) {
 		for (i = 0; i < 3; i++) {
 			min[i] = -cmd->radius;
 			max[i] = cmd->radius;
@@ -353,103 +465,12 @@ static void cuboid_do(
 	bb[0][2] = bb[1][2] = bb[2][2] = bb[3][2] = min[2];
 	bb[4][2] = bb[5][2] = bb[6][2] = bb[7][2] = max[2];
 
-	/* ready to apply the effect, one vertex at a time */
-	for (i = 0; i < numVerts; i++) {
-		int octant, coord;
-		float d[3], dmax, apex[3], fbb;
-		float tmp_co[3];
+	data.cmd = cmd;
+	data.flag = flag;
+	data.use_ctrl_ob = (ctrl_ob != NULL);
 
-		copy_v3_v3(tmp_co, vertexCos[i]);
-		if (ctrl_ob) {
-			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(mat, tmp_co);
-			}
-			else {
-				sub_v3_v3(tmp_co, center);
-			}
-		}
-
-		if (has_radius) {
-			if (fabsf(tmp_co[0]) > cmd->radius ||
-			    fabsf(tmp_co[1]) > cmd->radius ||
-			    fabsf(tmp_co[2]) > cmd->radius)
-			{
-				continue;
-			}
-		}
-
-		if (dvert) {
-			const float weight = defvert_find_weight(&dvert[i], defgrp_index);
-			if (weight == 0.0f) {
-				continue;
-			}
-
-			fac = fac_orig * weight;
-			facm = 1.0f - fac;
-		}
-
-		/* The algo used to project the vertices to their
-		 * bounding box (bb) is pretty simple:
-		 * for each vertex v:
-		 * 1) find in which octant v is in;
-		 * 2) find which outer "wall" of that octant is closer to v;
-		 * 3) calculate factor (var fbb) to project v to that wall;
-		 * 4) project. */
-
-		/* find in which octant this vertex is in */
-		octant = 0;
-		if (tmp_co[0] > 0.0f) octant += 1;
-		if (tmp_co[1] > 0.0f) octant += 2;
-		if (tmp_co[2] > 0.0f) octant += 4;
-
-		/* apex is the bb's vertex at the chosen octant */
-		copy_v3_v3(apex, bb[octant]);
-
-		/* find which bb plane is closest to this vertex ... */
-		d[0] = tmp_co[0] / apex[0];
-		d[1] = tmp_co[1] / apex[1];
-		d[2] = tmp_co[2] / apex[2];
-
-		/* ... (the closest has the higher (closer to 1) d value) */
-		dmax = d[0];
-		coord = 0;
-		if (d[1] > dmax) {
-			dmax = d[1];
-			coord = 1;
-		}
-		if (d[2] > dmax) {
-			/* dmax = d[2]; */ /* commented, we don't need it */
-			coord = 2;
-		}
-
-		/* ok, now we know which coordinate of the vertex to use */
-
-		if (fabsf(tmp_co[coord]) < FLT_EPSILON) /* avoid division by zero */
-			continue;
-
-		/* finally, this is the factor we wanted, to project the vertex
-		 * to its bounding box (bb) */
-		fbb = apex[coord] / tmp_co[coord];
-
-		/* calculate the new vertex position */
-		if (flag & MOD_CAST_X)
-			tmp_co[0] = facm * tmp_co[0] + fac * tmp_co[0] * fbb;
-		if (flag & MOD_CAST_Y)
-			tmp_co[1] = facm * tmp_co[1] + fac * tmp_co[1] * fbb;
-		if (flag & MOD_CAST_Z)
-			tmp_co[2] = facm * tmp_co[2] + fac * tmp_co[2] * fbb;
-
-		if (ctrl_ob) {
-			if (flag & MOD_CAST_USE_OB_TRANSFORM) {
-				mul_m4_v3(imat, tmp_co);
-			}
-			else {
-				add_v3_v3(tmp_co, center);
-			}
-		}
-
-		copy_v3_v3(vertexCos[i], tmp_co);
-	}
+	/* ready to apply the effect, one vertex at a time */
+	BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, cuboid_do_task);
 }
 
 static void deformVerts(ModifierData *md, Object *ob,
@@ -154,11 +154,6 @@ static void updateDepsgraph(ModifierData *md,
 }
 
 struct HookData_cb {
-	float (*vertexCos)[3];
-
-	MDeformVert *dvert;
-	int defgrp_index;
-
 	struct CurveMapping *curfalloff;
 
 	char  falloff_type;
@@ -173,6 +168,12 @@ struct HookData_cb {
 
 	float mat_uniform[3][3];
 	float mat[4][4];
+
+	/* Original indices of the vertices and how often each of them is hooked,
+	 * only used when the vertices are looked up by original index. */
+	const int *origindex_ar;
+	int *indexar_count;
+	int indexar_count_len;
 };
 
 static float hook_falloff(
@@ -243,9 +244,8 @@ finally:
 	}
 }
 
-static void hook_co_apply(struct HookData_cb *hd, const int j)
+static void hook_co_apply(struct HookData_cb *hd, float co[3], const float weight)
 {
-	float *co = hd->vertexCos[j];
 	float fac;
 
 	if (hd->use_falloff) {
@@ -267,9 +267,7 @@ static void hook_co_apply(struct HookData_cb *hd, const int j)
 	}
 
 	if (fac) {
-		if (hd->dvert) {
-			fac *= defvert_find_weight(&hd->dvert[j], hd->defgrp_index);
-		}
+		fac *= weight;
 
 		if (fac) {
 			float co_tmp[3];
@@ -279,6 +277,26 @@ static void hook_co_apply(struct HookData_cb *hd, const int j)
 	}
 }
 
+static void hook_co_apply_cb(void *userdata, const int j, float co[3], const float weight)
+{
+	struct HookData_cb *hd = userdata;
+	int count = 1;
+
+	if (hd->origindex_ar) {
+		const int j_orig = hd->origindex_ar[j];
+
+		if (j_orig < 0 || j_orig >= hd->indexar_count_len) {
+			return;
+		}
+		count = hd->indexar_count[j_orig];
+	}
+
+	/* indices listed more than once apply the hook again */
+	while (count--) {
+		hook_co_apply(hd, co, weight);
+	}
+}
+
 static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
                            float (*vertexCos)[3], int numVerts)
 {
@@ -286,6 +304,8 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 	float dmat[4][4];
 	int i, *index_pt;
 	struct HookData_cb hd;
+	MDeformVert *dvert;
+	int defgrp_index;
 	
 	if (hmd->curfalloff == NULL) {
 		/* should never happen, but bad lib linking could cause it */
@@ -296,9 +316,9 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		curvemapping_initialize(hmd->curfalloff);
 	}
 
+	modifier_get_vgroup(ob, dm, hmd->name, &dvert, &defgrp_index);
+
 	/* Generic data needed for applying per-vertex calculations (initialize all members) */
-	hd.vertexCos = vertexCos;
-	modifier_get_vgroup(ob, dm, hmd->name, &hd.dvert, &hd.defgrp_index);
 
 	hd.curfalloff = hmd->curfalloff;
 
@@ -310,6 +330,10 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 	hd.use_falloff = (hd.falloff_sq != 0.0f);
 	hd.use_uniform = (hmd->flag & MOD_HOOK_UNIFORM_SPACE) != 0;
 
+	hd.origindex_ar = NULL;
+	hd.indexar_count = NULL;
+	hd.indexar_count_len = 0;
+
 	if (hd.use_uniform) {
 		copy_m3_m4(hd.mat_uniform, hmd->parentinv);
 		mul_v3_m3v3(hd.cent, hd.mat_uniform, hmd->cent);
@@ -349,30 +373,32 @@ static void deformVerts_do(HookModifierData *hmd, Object *ob, DerivedMesh *dm,
 		
 		/* if DerivedMesh is present and has original index data, use it */
 		if (dm && (origindex_ar = dm->getVertDataArray(dm, CD_ORIGINDEX))) {
+			/* count the hooks of the original vertices, so each vertex only has to do a lookup */
+			hd.indexar_count = MEM_callocN(sizeof(*hd.indexar_count) * numVerts, __func__);
+			hd.indexar_count_len = numVerts;
+
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
-				if (*index_pt < numVerts) {
-					int j;
-					
-					for (j = 0; j < numVerts; j++) {
-						if (origindex_ar[j] == *index_pt) {
-							hook_co_apply(&hd, j);
-						}
-					}
+				if (*index_pt >= 0 && *index_pt < numVerts) {
+					hd.indexar_count[*index_pt]++;
 				}
 			}
+
+			hd.origindex_ar = origindex_ar;
+			BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &hd, hook_co_apply_cb);
+
+			MEM_freeN(hd.indexar_count);
 		}
 		else { /* missing dm or ORIGINDEX */
 			for (i = 0, index_pt = hmd->indexar; i < hmd->totindex; i++, index_pt++) {
 				if (*index_pt < numVerts) {
-					hook_co_apply(&hd, *index_pt);
+					const float weight = dvert ? defvert_find_weight(&dvert[*index_pt], defgrp_index) : 1.0f;
+					hook_co_apply(&hd, vertexCos[*index_pt], weight);
 				}
 			}
 		}
 	}
-	else if (hd.dvert) {  /* vertex group hook */
-		for (i = 0; i < numVerts; i++) {
-			hook_co_apply(&hd, i);
-		}
+	else if (dvert) {  /* vertex group hook */
+		BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &hd, hook_co_apply_cb);
 	}
 }
 
@@ -141,12 +141,59 @@ static void simpleDeform_bend(const float factor, const float dcut[3], float r_c
 }
 
 
+typedef struct SimpleDeformUserdata {
+	/*const*/ SimpleDeformModifierData *smd;
+	const SpaceTransform *transf;
+	void (*simpleDeform_callback)(const float factor, const float dcut[3], float co[3]);
+	bool invert_vgroup;
+	int limit_axis;
+	float smd_limit[2];
+	float smd_factor;
+} SimpleDeformUserdata;
+
+static void SimpleDeformModifier_do_task(void *userdata, const int UNUSED(i), float vco[3], float weight)
+{
+	static const float lock_axis[2] = {0.0f, 0.0f};
+
+	SimpleDeformUserdata *data = userdata;
+	SimpleDeformModifierData *smd = data->smd;
+	const SpaceTransform *transf = data->transf;
+
+	if (data->invert_vgroup) {
+		weight = 1.0f - weight;
+	}
+
+	if (weight != 0.0f) {
+		float co[3], dcut[3] = {0.0f, 0.0f, 0.0f};
+
+		if (transf) {
+			BLI_space_transform_apply(transf, vco);
+		}
+
+		copy_v3_v3(co, vco);
+
+		/* Apply axis limits */
+		if (smd->mode != MOD_SIMPLEDEFORM_MODE_BEND) { /* Bend mode shoulnt have any lock axis */
+			if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_X) axis_limit(0, lock_axis, co, dcut);
+			if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_Y) axis_limit(1, lock_axis, co, dcut);
+		}
+		axis_limit(data->limit_axis, data->smd_limit, co, dcut);
+
+		data->simpleDeform_callback(data->smd_factor, dcut, co);  /* apply deform */
+		interp_v3_v3v3(vco, vco, co, weight);  /* Use vertex weight has coef of linear interpolation */
+
+		if (transf) {
+			BLI_space_transform_invert(transf, vco);
+		}
+	}
+}
+
 /* simple deform modifier */
 static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object *ob, struct DerivedMesh *dm,
                                     float (*vertexCos)[3], int numVerts)
 {
-	static const float lock_axis[2] = {0.0f, 0.0f};
-
+	SimpleDeformUserdata data;
+	bool invert_vgroup;
 	int i;
 	int limit_axis = 0;
 	float smd_limit[2], smd_factor;
@@ -214,39 +261,26 @@ static void SimpleDeformModifier_do(SimpleDeformModifierData *smd, struct Object
 	}
 
 	modifier_get_vgroup(ob, dm, smd->vgroup_name, &dvert, &vgroup);
-	const bool invert_vgroup = (smd->flag & MOD_SIMPLEDEFORM_FLAG_INVERT_VGROUP) != 0;
+	invert_vgroup = (smd->flag & MOD_SIMPLEDEFORM_FLAG_INVERT_VGROUP) != 0;
 
-	for (i = 0; i < numVerts; i++) {
-		float weight = defvert_array_find_weight_safe(dvert, i, vgroup);
-
-		if (invert_vgroup) {
-			weight = 1.0f - weight;
+	/* Without weights all vertices have the same weight: 1.0 without a vgroup and 0.0 for an empty one,
+	 * nothing is deformed when it's 0.0 after inverting (see defvert_array_find_weight_safe). */
+	if (dvert == NULL) {
+		if ((vgroup != -1) != invert_vgroup) {
+			return;
 		}
+		invert_vgroup = false;
+	}
 
-		if (weight != 0.0f) {
-			float co[3], dcut[3] = {0.0f, 0.0f, 0.0f};
-
-			if (transf) {
-				BLI_space_transform_apply(transf, vertexCos[i]);
-			}
-
-			copy_v3_v3(co, vertexCos[i]);
-
-			/* Apply axis limits */
-			if (smd->mode != MOD_SIMPLEDEFORM_MODE_BEND) { /* Bend mode shoulnt have any lock axis */
-				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_X) axis_limit(0, lock_axis, co, dcut);
-				if (smd->axis & MOD_SIMPLEDEFORM_LOCK_AXIS_Y) axis_limit(1, lock_axis, co, dcut);
-			}
-			axis_limit(limit_axis, smd_limit, co, dcut);
-
-			simpleDeform_callback(smd_factor, dcut, co);  /* apply deform */
-			interp_v3_v3v3(vertexCos[i], vertexCos[i], co, weight);  /* Use vertex weight has coef of linear interpolation */
+	data.smd = smd;
+	data.transf = transf;
+	data.simpleDeform_callback = simpleDeform_callback;
+	data.invert_vgroup = invert_vgroup;
+	data.limit_axis = limit_axis;
+	copy_v2_v2(data.smd_limit, smd_limit);
+	data.smd_factor = smd_factor;
 
-			if (transf) {
-				BLI_space_transform_invert(transf, vertexCos[i]);
-			}
-		}
-	}
+	BKE_deform_verts_parallel(vertexCos, numVerts, dvert, vgroup, &data, SimpleDeformModifier_do_task);
 }
 
 
@@ -36,11 +36,13 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "MEM_guardedalloc.h"
 
 #include "BKE_cdderivedmesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_particle.h"
 #include "BKE_deform.h"
 
@@ -91,29 +93,76 @@ static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
 	return dataMask;
 }
 
+typedef struct SmoothUserdata {
+	/*const*/ SmoothModifierData *smd;
+	float (*vertexCos)[3];
+	const MEdge *medges;
+	const MeshElemMap *vert_to_edge;
+	float (*ftmp)[3];
+	unsigned char *uctmp;
+} SmoothUserdata;
+
+/* Sum of the edge centers around each vertex. Gathered per vertex from its
+ * edges, in the same order they used to be scattered by the edges.
+ * Like the scattered sums they are never cleared, each iteration adds to the sums of the previous ones. */
+static void smoothModifier_gather_task(void *userdata, const int i)
+{
+	SmoothUserdata *data = userdata;
+	float (*vertexCos)[3] = data->vertexCos;
+	const MeshElemMap *map = &data->vert_to_edge[i];
+	float *fp = data->ftmp[i];
+	int uc = data->uctmp[i];
+	int j;
+
+	for (j = 0; j < map->count && uc < 255; j++) {
+		const MEdge *me = &data->medges[map->indices[j]];
+		float fvec[3];
+
+		mid_v3_v3v3(fvec, vertexCos[me->v1], vertexCos[me->v2]);
+		add_v3_v3(fp, fvec);
+		uc++;
+	}
+
+	data->uctmp[i] = (unsigned char)uc;
+}
+
+static void smoothModifier_apply_task(void *userdata, const int i, float v[3], const float weight)
+{
+	SmoothUserdata *data = userdata;
+	const short flag = data->smd->flag;
+	float *fp = data->ftmp[i];
+	float f, fm, facw;
+
+	if (weight <= 0.0f) return;
+
+	f = data->smd->fac * weight;
+	fm = 1.0f - f;
+
+	/* fp is the sum of uctmp[i] verts, so must be averaged */
+	facw = 0.0f;
+	if (data->uctmp[i])
+		facw = f / (float)data->uctmp[i];
+
+	if (flag & MOD_SMOOTH_X)
+		v[0] = fm * v[0] + facw * fp[0];
+	if (flag & MOD_SMOOTH_Y)
+		v[1] = fm * v[1] + facw * fp[1];
+	if (flag & MOD_SMOOTH_Z)
+		v[2] = fm * v[2] + facw * fp[2];
+}
+
 static void smoothModifier_do(
         SmoothModifierData *smd, Object *ob, DerivedMesh *dm,
         float (*vertexCos)[3], int numVerts)
 {
-	MDeformVert *dvert = NULL;
+	SmoothUserdata data = {NULL};
+	MeshElemMap *vert_to_edge = NULL;
+	int *vert_to_edge_mem = NULL;
 	MEdge *medges = NULL;
+	MDeformVert *dvert;
+	int defgrp_index;
 
-	int i, j, numDMEdges, defgrp_index;
-	unsigned char *uctmp;
-	float *ftmp, fac, facm;
-
-	ftmp = (float *)MEM_callocN(3 * sizeof(float) * numVerts,
-	                            "smoothmodifier_f");
-	if (!ftmp) return;
-	uctmp = (unsigned char *)MEM_callocN(sizeof(unsigned char) * numVerts,
-	                                     "smoothmodifier_uc");
-	if (!uctmp) {
-		if (ftmp) MEM_freeN(ftmp);
-		return;
-	}
-
-	fac = smd->fac;
-	facm = 1 - fac;
+	int j, numDMEdges;
 
 	if (dm->getNumVerts(dm) == numVerts) {
 		medges = dm->getEdgeArray(dm);
@@ -124,95 +173,29 @@ static void smoothModifier_do(
 		numDMEdges = 0;
 	}
 
+	/* Vertices gather the centers of their edges, rather than edges adding
+	 * them to their vertices, so vertices can be smoothed in parallel. */
+	BKE_mesh_vert_edge_map_create(&vert_to_edge, &vert_to_edge_mem, medges, numVerts, numDMEdges);
+
+	data.smd = smd;
+	data.vertexCos = vertexCos;
+	data.medges = medges;
+	data.vert_to_edge = vert_to_edge;
+	data.ftmp = MEM_callocN(sizeof(*data.ftmp) * numVerts, "smoothmodifier_f");
+	data.uctmp = MEM_callocN(sizeof(*data.uctmp) * numVerts, "smoothmodifier_uc");
+
 	modifier_get_vgroup(ob, dm, smd->defgrp_name, &dvert, &defgrp_index);
 
-	/* NOTICE: this can be optimized a little bit by moving the
-	 * if (dvert) out of the loop, if needed */
 	for (j = 0; j < smd->repeat; j++) {
-		for (i = 0; i < numDMEdges; i++) {
-			float fvec[3];
-			float *v1, *v2;
-			unsigned int idx1, idx2;
-
-			idx1 = medges[i].v1;
-			idx2 = medges[i].v2;
-
-			v1 = vertexCos[idx1];
-			v2 = vertexCos[idx2];
-
-			mid_v3_v3v3(fvec, v1, v2);
-
-			v1 = &ftmp[idx1 * 3];
-			v2 = &ftmp[idx2 * 3];
-
-			if (uctmp[idx1] < 255) {
-				uctmp[idx1]++;
-				add_v3_v3(v1, fvec);
-			}
-			if (uctmp[idx2] < 255) {
-				uctmp[idx2]++;
-				add_v3_v3(v2, fvec);
-			}
-		}
-
-		if (dvert) {
-			MDeformVert *dv = dvert;
-			for (i = 0; i < numVerts; i++, dv++) {
-				float f, fm, facw, *fp, *v;
-				short flag = smd->flag;
-
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
-
-
-				f = defvert_find_weight(dv, defgrp_index);
-				if (f <= 0.0f) continue;
-
-				f *= fac;
-				fm = 1.0f - f;
-
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = f / (float)uctmp[i];
-
-				if (flag & MOD_SMOOTH_X)
-					v[0] = fm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = fm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = fm * v[2] + facw * fp[2];
-			}
-		}
-		else { /* no vertex group */
-			for (i = 0; i < numVerts; i++) {
-				float facw, *fp, *v;
-				short flag = smd->flag;
-
-				v = vertexCos[i];
-				fp = &ftmp[i * 3];
-
-				/* fp is the sum of uctmp[i] verts, so must be averaged */
-				facw = 0.0f;
-				if (uctmp[i]) 
-					facw = fac / (float)uctmp[i];
-
-				if (flag & MOD_SMOOTH_X)
-					v[0] = facm * v[0] + facw * fp[0];
-				if (flag & MOD_SMOOTH_Y)
-					v[1] = facm * v[1] + facw * fp[1];
-				if (flag & MOD_SMOOTH_Z)
-					v[2] = facm * v[2] + facw * fp[2];
-			}
-
-		}
-
-		memset(ftmp, 0, 3 * sizeof(float) * numVerts);
-		memset(uctmp, 0, sizeof(unsigned char) * numVerts);
+		/* all edge centers are taken before any vertex moves */
+		BLI_task_parallel_range(0, numVerts, &data, smoothModifier_gather_task, numVerts > DEFORM_VERTS_THREADED_MIN);
+		BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, smoothModifier_apply_task);
 	}
 
-	MEM_freeN(ftmp);
-	MEM_freeN(uctmp);
+	MEM_freeN(data.ftmp);
+	MEM_freeN(data.uctmp);
+	MEM_freeN(vert_to_edge);
+	MEM_freeN(vert_to_edge_mem);
 }
 
 static void deformVerts(ModifierData *md, Object *ob, DerivedMesh *derivedData,
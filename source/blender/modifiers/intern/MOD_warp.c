@@ -39,6 +39,7 @@
 #include "BKE_library_query.h"
 #include "BKE_modifier.h"
 #include "BKE_deform.h"
+#include "BKE_image.h"
 #include "BKE_texture.h"
 #include "BKE_colortools.h"
 
@@ -176,6 +177,102 @@ static void updateDepsgraph(ModifierData *md,
 	}
 }
 
+typedef struct WarpUserdata {
+	/*const*/ WarpModifierData *wmd;
+	struct ImagePool *pool;
+	float (*tex_co)[3];
+	float strength;
+	float falloff_radius_sq;
+	float mat_from[4][4];
+	float mat_from_inv[4][4];
+	float mat_final[4][4];
+	float mat_unit[4][4];
+} WarpUserdata;
+
+static void warpModifier_do_task(void *userdata, const int i, float co[3], const float vgroup_weight)
+{
+	WarpUserdata *data = userdata;
+	WarpModifierData *wmd = data->wmd;
+	float fac = 1.0f, weight;
+
+	if (wmd->falloff_type == eWarp_Falloff_None ||
+	    ((fac = len_squared_v3v3(co, data->mat_from[3])) < data->falloff_radius_sq &&
+	     (fac = (wmd->falloff_radius - sqrtf(fac)) / wmd->falloff_radius)))
+	{
+		/* skip if not in the vert group */
+		weight = vgroup_weight * data->strength;
+		if (weight <= 0.0f) {
+			return;
+		}
+
+
+		/* closely match PROP_SMOOTH and similar */
+		switch (wmd->falloff_type) {
+			case eWarp_Falloff_None:
+				fac = 1.0f;
+				break;
+			case eWarp_Falloff_Curve:
+				fac = curvemapping_evaluateF(wmd->curfalloff, 0, fac);
+				break;
+			case eWarp_Falloff_Sharp:
+				fac = fac * fac;
+				break;
+			case eWarp_Falloff_Smooth:
+				fac = 3.0f * fac * fac - 2.0f * fac * fac * fac;
+				break;
+			case eWarp_Falloff_Root:
+				fac = sqrtf(fac);
+				break;
+			case eWarp_Falloff_Linear:
+				/* pass */
+				break;
+			case eWarp_Falloff_Const:
+				fac = 1.0f;
+				break;
+			case eWarp_Falloff_Sphere:
+				fac = sqrtf(2 * fac - fac * fac);
+				break;
+			case eWarp_Falloff_InvSquare:
+				fac = fac * (2.0f - fac);
+				break;
+		}
+
+		fac *= weight;
+
+		if (data->tex_co) {
+			TexResult texres;
+			texres.nor = NULL;
+			BKE_texture_get_value_ex(wmd->modifier.scene, wmd->texture, data->tex_co[i], &texres, data->pool, false);
+			fac *= texres.tin;
+		}
+
+		if (fac != 0.0f) {
+			/* into the 'from' objects space */
+			mul_m4_v3(data->mat_from_inv, co);
+
+			if (fac == 1.0f) {
+				mul_m4_v3(data->mat_final, co);
+			}
+			else {
+				if (wmd->flag & MOD_WARP_VOLUME_PRESERVE) {
+					/* interpolate the matrix for nicer locations */
+					float tmat[4][4];
+					blend_m4_m4m4(tmat, data->mat_unit, data->mat_final, fac);
+					mul_m4_v3(tmat, co);
+				}
+				else {
+					float tvec[3];
+					mul_v3_m4v3(tvec, data->mat_final, co);
+					interp_v3_v3v3(co, co, tvec, fac);
+				}
+			}
+
+			/* out of the 'from' objects space */
+			mul_m4_v3(data->mat_from, co);
+		}
+	}
+}
+
 static void warpModifier_do(WarpModifierData *wmd, Object *ob,
                             DerivedMesh *dm, float (*vertexCos)[3], int numVerts)
 {
@@ -190,10 +287,9 @@ static void warpModifier_do(WarpModifierData *wmd, Object *ob,
 
 	const float falloff_radius_sq = SQUARE(wmd->falloff_radius);
 	float strength = wmd->strength;
-	float fac = 1.0f, weight;
-	int i;
 	int defgrp_index;
-	MDeformVert *dvert, *dv = NULL;
+	MDeformVert *dvert;
+	WarpUserdata data = {NULL};
 
 	float (*tex_co)[3] = NULL;
 
@@ -234,7 +330,6 @@ static void warpModifier_do(WarpModifierData *wmd, Object *ob,
 		negate_v3_v3(mat_final[3], loc);
 
 	}
-	weight = strength;
 
 	if (wmd->texture) {
 		tex_co = MEM_mallocN(sizeof(*tex_co) * numVerts, "warpModifier_do tex_co");
@@ -243,87 +338,24 @@ static void warpModifier_do(WarpModifierData *wmd, Object *ob,
 		modifier_init_texture(wmd->modifier.scene, wmd->texture);
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		float *co = vertexCos[i];
-
-		if (wmd->falloff_type == eWarp_Falloff_None ||
-		    ((fac = len_squared_v3v3(co, mat_from[3])) < falloff_radius_sq &&
-		     (fac = (wmd->falloff_radius - sqrtf(fac)) / wmd->falloff_radius)))
-		{
-			/* skip if no vert group found */
-			if (defgrp_index != -1) {
-				dv = &dvert[i];
-				weight = defvert_find_weight(dv, defgrp_index) * strength;
-				if (weight <= 0.0f) {
-					continue;
-				}
-			}
-
-
-			/* closely match PROP_SMOOTH and similar */
-			switch (wmd->falloff_type) {
-				case eWarp_Falloff_None:
-					fac = 1.0f;
-					break;
-				case eWarp_Falloff_Curve:
-					fac = curvemapping_evaluateF(wmd->curfalloff, 0, fac);
-					break;
-				case eWarp_Falloff_Sharp:
-					fac = fac * fac;
-					break;
-				case eWarp_Falloff_Smooth:
-					fac = 3.0f * fac * fac - 2.0f * fac * fac * fac;
-					break;
-				case eWarp_Falloff_Root:
-					fac = sqrtf(fac);
-					break;
-				case eWarp_Falloff_Linear:
-					/* pass */
-					break;
-				case eWarp_Falloff_Const:
-					fac = 1.0f;
-					break;
-				case eWarp_Falloff_Sphere:
-					fac = sqrtf(2 * fac - fac * fac);
-					break;
-				case eWarp_Falloff_InvSquare:
-					fac = fac * (2.0f - fac);
-					break;
-			}
+	data.wmd = wmd;
+	data.tex_co = tex_co;
+	data.strength = strength;
+	data.falloff_radius_sq = falloff_radius_sq;
+	copy_m4_m4(data.mat_from, mat_from);
+	copy_m4_m4(data.mat_from_inv, mat_from_inv);
+	copy_m4_m4(data.mat_final, mat_final);
+	copy_m4_m4(data.mat_unit, mat_unit);
 
-			fac *= weight;
-
-			if (tex_co) {
-				TexResult texres;
-				texres.nor = NULL;
-				BKE_texture_get_value(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, false);
-				fac *= texres.tin;
-			}
-
-			if (fac != 0.0f) {
-				/* into the 'from' objects space */
-				mul_m4_v3(mat_from_inv, co);
+	if (wmd->texture) {
+		data.pool = BKE_image_pool_new();
+		BKE_texture_fetch_images_for_pool(wmd->texture, data.pool);
+	}
 
-				if (fac == 1.0f) {
-					mul_m4_v3(mat_final, co);
-				}
-				else {
-					if (wmd->flag & MOD_WARP_VOLUME_PRESERVE) {
-						/* interpolate the matrix for nicer locations */
-						blend_m4_m4m4(tmat, mat_unit, mat_final, fac);
-						mul_m4_v3(tmat, co);
-					}
-					else {
-						float tvec[3];
-						mul_v3_m4v3(tvec, mat_final, co);
-						interp_v3_v3v3(co, co, tvec, fac);
-					}
-				}
+	BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, warpModifier_do_task);
 
-				/* out of the 'from' objects space */
-				mul_m4_v3(mat_from, co);
-			}
-		}
+	if (data.pool != NULL) {
+		BKE_image_pool_free(data.pool);
 	}
 
 	if (tex_co)
@@ -44,6 +44,7 @@
 
 #include "BKE_deform.h"
 #include "BKE_DerivedMesh.h"
+#include "BKE_image.h"
 #include "BKE_library.h"
 #include "BKE_library_query.h"
 #include "BKE_scene.h"
@@ -182,6 +183,112 @@ static CustomDataMask requiredDataMask(Object *UNUSED(ob), ModifierData *md)
 	return dataMask;
 }
 
+typedef struct WaveUserdata {
+	/*const*/ WaveModifierData *wmd;
+	struct ImagePool *pool;
+	float (*tex_co)[3];
+	MVert *mvert;
+	int wmd_axis;
+	float ctime;
+	float minfac;
+	float lifefac;
+	float falloff_inv;
+} WaveUserdata;
+
+static void waveModifier_do_task(void *userdata, const int i, float co[3], const float def_weight)
+{
+	WaveUserdata *data = userdata;
+	WaveModifierData *wmd = data->wmd;
+	MVert *mvert = data->mvert;
+	const int wmd_axis = data->wmd_axis;
+	const float ctime = data->ctime;
+	const float lifefac = data->lifefac;
+	const float falloff = wmd->falloff;
+	float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
+
+	float x = co[0] - wmd->startx;
+	float y = co[1] - wmd->starty;
+	float amplit = 0.0f;
+
+	/* if this vert isn't in the vgroup, don't deform it */
+	if (def_weight == 0.0f) {
+		return;
+	}
+
+	switch (wmd_axis) {
+		case MOD_WAVE_X | MOD_WAVE_Y:
+			amplit = sqrtf(x * x + y * y);
+			break;
+		case MOD_WAVE_X:
+			amplit = x;
+			break;
+		case MOD_WAVE_Y:
+			amplit = y;
+			break;
+	}
+
+	/* this way it makes nice circles */
+	amplit -= (ctime - wmd->timeoffs) * wmd->speed;
+
+	if (wmd->flag & MOD_WAVE_CYCL) {
+		amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) +
+		         wmd->width;
+	}
+
+	if (falloff != 0.0f) {
+		float dist = 0.0f;
+
+		switch (wmd_axis) {
+			case MOD_WAVE_X | MOD_WAVE_Y:
+				dist = sqrtf(x * x + y * y);
+				break;
+			case MOD_WAVE_X:
+				dist = fabsf(x);
+				break;
+			case MOD_WAVE_Y:
+				dist = fabsf(y);
+				break;
+		}
+
+		falloff_fac = (1.0f - (dist * data->falloff_inv));
+		CLAMP(falloff_fac, 0.0f, 1.0f);
+	}
+
+	/* GAUSSIAN */
+	if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
+		amplit = amplit * wmd->narrow;
+		amplit = (float)(1.0f / expf(amplit * amplit) - data->minfac);
+
+		/*apply texture*/
+		if (wmd->texture) {
+			TexResult texres;
+			texres.nor = NULL;
+			BKE_texture_get_value_ex(wmd->modifier.scene, wmd->texture, data->tex_co[i], &texres, data->pool, false);
+			amplit *= texres.tin;
+		}
+
+		/*apply weight & falloff */
+		amplit *= def_weight * falloff_fac;
+
+		if (mvert) {
+			/* move along normals */
+			if (wmd->flag & MOD_WAVE_NORM_X) {
+				co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
+			}
+			if (wmd->flag & MOD_WAVE_NORM_Y) {
+				co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
+			}
+			if (wmd->flag & MOD_WAVE_NORM_Z) {
+				co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
+			}
+		}
+		else {
+			/* move along local z axis */
+			co[2] += lifefac * amplit;
+		}
+	}
+}
+
 static void waveModifier_do(WaveModifierData *md, 
                             Scene *scene, Object *ob, DerivedMesh *dm,
                             float (*vertexCos)[3], int numVerts)
@@ -196,7 +303,6 @@ static void waveModifier_do(WaveModifierData *md,
 	float (*tex_co)[3] = NULL;
 	const int wmd_axis = wmd->flag & (MOD_WAVE_X | MOD_WAVE_Y);
 	const float falloff = wmd->falloff;
-	float falloff_fac = 1.0f; /* when falloff == 0.0f this stays at 1.0f */
 
 	if ((wmd->flag & MOD_WAVE_NORM) && (ob->type == OB_MESH))
 		mvert = dm->getVertArray(dm);
@@ -238,97 +344,27 @@ static void waveModifier_do(WaveModifierData *md,
 	if (lifefac != 0.0f) {
 		/* avoid divide by zero checks within the loop */
 		float falloff_inv = falloff ? 1.0f / falloff : 1.0f;
-		int i;
-
-		for (i = 0; i < numVerts; i++) {
-			float *co = vertexCos[i];
-			float x = co[0] - wmd->startx;
-			float y = co[1] - wmd->starty;
-			float amplit = 0.0f;
-			float def_weight = 1.0f;
-
-			/* get weights */
-			if (dvert) {
-				def_weight = defvert_find_weight(&dvert[i], defgrp_index);
-
-				/* if this vert isn't in the vgroup, don't deform it */
-				if (def_weight == 0.0f) {
-					continue;
-				}
-			}
 
-			switch (wmd_axis) {
-				case MOD_WAVE_X | MOD_WAVE_Y:
-					amplit = sqrtf(x * x + y * y);
-					break;
-				case MOD_WAVE_X:
-					amplit = x;
-					break;
-				case MOD_WAVE_Y:
-					amplit = y;
-					break;
-			}
+		WaveUserdata data = {NULL};
 
-			/* this way it makes nice circles */
-			amplit -= (ctime - wmd->timeoffs) * wmd->speed;
+		data.wmd = wmd;
+		data.tex_co = tex_co;
+		data.mvert = mvert;
+		data.wmd_axis = wmd_axis;
+		data.ctime = ctime;
+		data.minfac = minfac;
+		data.lifefac = lifefac;
+		data.falloff_inv = falloff_inv;
 
-			if (wmd->flag & MOD_WAVE_CYCL) {
-				amplit = (float)fmodf(amplit - wmd->width, 2.0f * wmd->width) +
-				         wmd->width;
-			}
+		if (wmd->texture) {
+			data.pool = BKE_image_pool_new();
+			BKE_texture_fetch_images_for_pool(wmd->texture, data.pool);
+		}
 
-			if (falloff != 0.0f) {
-				float dist = 0.0f;
-
-				switch (wmd_axis) {
-					case MOD_WAVE_X | MOD_WAVE_Y:
-						dist = sqrtf(x * x + y * y);
-						break;
-					case MOD_WAVE_X:
-						dist = fabsf(x);
-						break;
-					case MOD_WAVE_Y:
-						dist = fabsf(y);
-						break;
-				}
-
-				falloff_fac = (1.0f - (dist * falloff_inv));
-				CLAMP(falloff_fac, 0.0f, 1.0f);
-			}
+		BKE_deform_verts_parallel(vertexCos, numVerts, dvert, defgrp_index, &data, waveModifier_do_task);
 
-			/* GAUSSIAN */
-			if ((falloff_fac != 0.0f) && (amplit > -wmd->width) && (amplit < wmd->width)) {
-				amplit = amplit * wmd->narrow;
-				amplit = (float)(1.0f / expf(amplit * amplit) - minfac);
-
-				/*apply texture*/
-				if (wmd->texture) {
-					TexResult texres;
-					texres.nor = NULL;
-					BKE_texture_get_value(wmd->modifier.scene, wmd->texture, tex_co[i], &texres, false);
-					amplit *= texres.tin;
-				}
-
-				/*apply weight & falloff */
-				amplit *= def_weight * falloff_fac;
-
-				if (mvert) {
-					/* move along normals */
-					if (wmd->flag & MOD_WAVE_NORM_X) {
-						co[0] += (lifefac * amplit) * mvert[i].no[0] / 32767.0f;
-					}
-					if (wmd->flag & MOD_WAVE_NORM_Y) {
-						co[1] += (lifefac * amplit) * mvert[i].no[1] / 32767.0f;
-					}
-					if (wmd->flag & MOD_WAVE_NORM_Z) {
-						co[2] += (lifefac * amplit) * mvert[i].no[2] / 32767.0f;
-					}
-				}
-				else {
-					/* move along local z axis */
-					co[2] += lifefac * amplit;
-				}
-			}
+		if (data.pool != NULL) {
+			BKE_image_pool_free(data.pool);
 		}
 	}
 
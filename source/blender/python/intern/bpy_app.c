@@ -55,6 +55,8 @@
 
 #include "DNA_ID.h"
 
+#include "IMB_moviecache.h"
+
 #include "UI_interface_icons.h"
 
 /* for notifiers */
@@ -347,6 +349,36 @@ static PyObject *bpy_app_autoexec_fail_message_get(PyObject *UNUSED(self), void
 	return PyC_UnicodeFromByte(G.autoexec_fail);
 }
 
+PyDoc_STRVAR(bpy_app_moviecache_stats_doc,
+"Dictionary of counters of the image, movie clip and sequencer caches: hits, misses, puts, evictions, "
+"shard_lock_contention, limiter_lock_contention and memory_in_use (read-only)"
+);
+static PyObject *bpy_app_moviecache_stats_get(PyObject *UNUSED(self), void *UNUSED(closure))
+{
+	MovieCacheStats stats;
+	PyObject *ret = PyDict_New();
+	PyObject *item;
+
+	IMB_moviecache_get_stats(&stats);
+
+#define DICT_SET_ITEM(name, value) \
+	item = PyLong_FromUnsignedLongLong(value); \
+	PyDict_SetItemString(ret, name, item); \
+	Py_DECREF(item)
+
+	DICT_SET_ITEM("hits", stats.hits);
+	DICT_SET_ITEM("misses", stats.misses);
+	DICT_SET_ITEM("puts", stats.puts);
+	DICT_SET_ITEM("evictions", stats.evictions);
+	DICT_SET_ITEM("shard_lock_contention", stats.shard_lock_contention);
+	DICT_SET_ITEM("limiter_lock_contention", stats.limiter_lock_contention);
+	DICT_SET_ITEM("memory_in_use", stats.memory_in_use);
+
+#undef DICT_SET_ITEM
+
+	return ret;
+}
+
 
 static PyGetSetDef bpy_app_getsets[] = {
 	{(char *)"debug",           bpy_app_debug_get, bpy_app_debug_set, (char *)bpy_app_debug_doc, (void *)G_DEBUG},
@@ -369,6 +401,8 @@ static PyGetSetDef bpy_app_getsets[] = {
 	{(char *)"render_icon_size", bpy_app_preview_render_size_get, NULL, (char *)bpy_app_preview_render_size_doc, (void *)ICON_SIZE_ICON},
 	{(char *)"render_preview_size", bpy_app_preview_render_size_get, NULL, (char *)bpy_app_preview_render_size_doc, (void *)ICON_SIZE_PREVIEW},
 
+	{(char *)"moviecache_stats", bpy_app_moviecache_stats_get, NULL, (char *)bpy_app_moviecache_stats_doc, NULL},
+
 	/* security */
 	{(char *)"autoexec_fail", bpy_app_global_flag_get, NULL, NULL, (void *)G_SCRIPT_AUTOEXEC_FAIL},
 	{(char *)"autoexec_fail_quiet", bpy_app_global_flag_get, NULL, NULL, (void *)G_SCRIPT_AUTOEXEC_FAIL_QUIET},
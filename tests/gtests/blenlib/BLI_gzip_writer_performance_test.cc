@@ -0,0 +1,91 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+#define TEST_FILE "BLI_gzip_writer_performance_test.gz"
+
+/* Size of the 'file' being saved. */
+#define DATA_SIZE (256 << 20)
+
+/* Size of single writes, similar to what writefile.c does when flushing its buffer. */
+#define WRITE_SIZE (128 << 10)
+
+/* Fill with data resembling a .blend file: arrays of floats (mesh coordinates)
+ * mixed with zero filled and repeated struct data. */
+static char *gzip_benchmark_data_create(void)
+{
+	char *data = (char *)MEM_mallocN(DATA_SIZE, __func__);
+	float *fl = (float *)data;
+	const int fl_len = DATA_SIZE / sizeof(float);
+
+	for (int i = 0; i < fl_len; i++) {
+		switch ((i >> 10) & 3) {
+			case 0:
+			case 1:
+				fl[i] = (float)(i % 4099) * 0.001f;
+				break;
+			case 2:
+				fl[i] = 0.0f;
+				break;
+			default:
+				fl[i] = (float)(i & 15);
+				break;
+		}
+	}
+	return data;
+}
+
+static double gzip_benchmark_run(const char *data, TaskScheduler *scheduler)
+{
+	const double time_start = PIL_check_seconds_timer();
+
+	GzipWriter *gw = BLI_gzip_writer_open(TEST_FILE, 1, scheduler);
+	EXPECT_TRUE(gw != NULL);
+	for (size_t offset = 0; offset < DATA_SIZE; offset += WRITE_SIZE) {
+		BLI_gzip_writer_write(gw, data + offset, MIN2(WRITE_SIZE, DATA_SIZE - offset));
+	}
+	EXPECT_TRUE(BLI_gzip_writer_close(gw));
+
+	const double time = PIL_check_seconds_timer() - time_start;
+
+	BLI_delete(TEST_FILE, false, false);
+	return time;
+}
+
+TEST(gzip_writer, SavePerformance)
+{
+	const int threads[] = {1, 4, 16};
+	char *data = gzip_benchmark_data_create();
+	double time_single = 0.0;
+
+	BLI_threadapi_init();
+
+	printf("\n========== Compressed save (%d MB) ==========\n", DATA_SIZE >> 20);
+	printf("Threads    Wall time (s)    Speedup\n");
+
+	for (int i = 0; i < ARRAY_SIZE(threads); i++) {
+		/* a single thread compresses on the calling thread, like gzwrite() did */
+		TaskScheduler *scheduler = (threads[i] > 1) ? BLI_task_scheduler_create(threads[i]) : NULL;
+		const double time = gzip_benchmark_run(data, scheduler);
+
+		if (scheduler) {
+			BLI_task_scheduler_free(scheduler);
+		}
+		if (i == 0) {
+			time_single = time;
+		}
+		printf("%-10d %-16.3f %.2fx\n", threads[i], time, time_single / time);
+	}
+
+	MEM_freeN(data);
+}
@@ -0,0 +1,130 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_gzip_reader.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+}
+
+#define TEST_FILE "BLI_gzip_writer_test.gz"
+
+/* A bit more than 5 chunks, with runs of repeated data so it compresses. */
+#define TEST_DATA_SIZE ((5 << 20) + 12345)
+
+static char *gzip_test_data_create(void)
+{
+	char *data = (char *)MEM_mallocN(TEST_DATA_SIZE, __func__);
+	uint32_t x = 1;
+
+	for (int i = 0; i < TEST_DATA_SIZE; i++) {
+		if ((i & 1023) < 512) {
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+		}
+		data[i] = (char)x;
+	}
+	return data;
+}
+
+static void gzip_test_file_write(const char *data, TaskScheduler *scheduler)
+{
+	GzipWriter *gw = BLI_gzip_writer_open(TEST_FILE, 1, scheduler);
+	ASSERT_TRUE(gw != NULL);
+
+	/* write in pieces of varying size, crossing chunk boundaries */
+	size_t offset = 0, len = 1;
+	while (offset < TEST_DATA_SIZE) {
+		len = MIN2(len, TEST_DATA_SIZE - offset);
+		EXPECT_TRUE(BLI_gzip_writer_write(gw, data + offset, len));
+		offset += len;
+		len = len * 3 + 7;
+	}
+	EXPECT_TRUE(BLI_gzip_writer_close(gw));
+}
+
+static void gzip_writer_roundtrip(TaskScheduler *scheduler)
+{
+	char *data = gzip_test_data_create();
+	gzip_test_file_write(data, scheduler);
+
+	int size;
+	char *result = BLI_file_ungzip_to_mem(TEST_FILE, &size);
+	EXPECT_EQ(TEST_DATA_SIZE, size);
+	ASSERT_TRUE(result != NULL);
+	EXPECT_EQ(0, memcmp(data, result, TEST_DATA_SIZE));
+
+	MEM_freeN(result);
+	MEM_freeN(data);
+	BLI_delete(TEST_FILE, false, false);
+}
+
+TEST(gzip_writer, Empty)
+{
+	GzipWriter *gw = BLI_gzip_writer_open(TEST_FILE, 1, NULL);
+	ASSERT_TRUE(gw != NULL);
+	EXPECT_TRUE(BLI_gzip_writer_close(gw));
+	EXPECT_TRUE(BLI_exists(TEST_FILE));
+	BLI_delete(TEST_FILE, false, false);
+}
+
+TEST(gzip_writer, Single)
+{
+	gzip_writer_roundtrip(NULL);
+}
+
+TEST(gzip_writer, Threaded)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+	gzip_writer_roundtrip(scheduler);
+	BLI_task_scheduler_free(scheduler);
+}
+
+/* Reading the multi-member file from memory, as BLO_read_from_memory does. */
+TEST(gzip_reader, MemoryMultiMember)
+{
+	char *data = gzip_test_data_create();
+	gzip_test_file_write(data, NULL);
+
+	size_t comp_len;
+	char *comp = (char *)BLI_file_read_binary_as_mem(TEST_FILE, 0, &comp_len);
+	ASSERT_TRUE(comp != NULL);
+
+	GzipMemReader *gr = BLI_gzip_mem_reader_open(comp, comp_len);
+	ASSERT_TRUE(gr != NULL);
+
+	char *result = (char *)MEM_mallocN(TEST_DATA_SIZE, __func__);
+	size_t offset = 0, len = 1;
+	while (offset < TEST_DATA_SIZE) {
+		len = MIN2(len, TEST_DATA_SIZE - offset);
+		EXPECT_EQ(len, BLI_gzip_mem_reader_read(gr, result + offset, len));
+		offset += len;
+		len = len * 5 + 3;
+	}
+	EXPECT_EQ(0, memcmp(data, result, TEST_DATA_SIZE));
+
+	/* end of the data */
+	char extra[16];
+	EXPECT_EQ((size_t)0, BLI_gzip_mem_reader_read(gr, extra, sizeof(extra)));
+	EXPECT_FALSE(BLI_gzip_mem_reader_has_error(gr));
+	BLI_gzip_mem_reader_close(gr);
+
+	/* truncated in the middle of a member */
+	gr = BLI_gzip_mem_reader_open(comp, comp_len / 2);
+	ASSERT_TRUE(gr != NULL);
+	EXPECT_GT((size_t)TEST_DATA_SIZE, BLI_gzip_mem_reader_read(gr, result, TEST_DATA_SIZE));
+	EXPECT_TRUE(BLI_gzip_mem_reader_has_error(gr));
+	BLI_gzip_mem_reader_close(gr);
+
+	MEM_freeN(result);
+	MEM_freeN(comp);
+	MEM_freeN(data);
+	BLI_delete(TEST_FILE, false, false);
+}
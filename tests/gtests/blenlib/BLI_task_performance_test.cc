@@ -0,0 +1,128 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* Depth of the tree of tasks spawned from worker threads, similar to what
+ * dependency graph evaluation does when scheduling children of a node. */
+#define SPAWN_DEPTH 18
+
+/* Number of tasks pushed from the main thread. */
+#define FLAT_NUM_TASKS 200000
+
+/* Amount of "work" done by each task, kept small on purpose so scheduling
+ * overhead dominates. */
+#define TASK_WORK_ITERATIONS 64
+
+static uint32_t task_do_work(int seed)
+{
+	uint32_t x = (uint32_t)seed + 1;
+	for (int i = 0; i < TASK_WORK_ITERATIONS; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+	return x;
+}
+
+static void task_spawn_func(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+	uint32_t *result = (uint32_t *)BLI_task_pool_userdata(pool);
+
+	atomic_add_and_fetch_uint32(result, task_do_work(depth) & 1);
+
+	if (depth > 0) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_spawn_func, SET_INT_IN_POINTER(depth - 1),
+			                               false, TASK_PRIORITY_LOW, threadid);
+		}
+	}
+}
+
+static void task_flat_func(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	uint32_t *result = (uint32_t *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32(result, task_do_work(GET_INT_FROM_POINTER(taskdata)) & 1);
+}
+
+static double task_spawn_run(TaskScheduler *scheduler)
+{
+	uint32_t result = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &result);
+	const double time_start = PIL_check_seconds_timer();
+
+	BLI_task_pool_push(pool, task_spawn_func, SET_INT_IN_POINTER(SPAWN_DEPTH), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	const double time = PIL_check_seconds_timer() - time_start;
+	BLI_task_pool_free(pool);
+	return time;
+}
+
+static double task_flat_run(TaskScheduler *scheduler)
+{
+	uint32_t result = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &result);
+	const double time_start = PIL_check_seconds_timer();
+
+	for (int i = 0; i < FLAT_NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_flat_func, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+
+	const double time = PIL_check_seconds_timer() - time_start;
+	BLI_task_pool_free(pool);
+	return time;
+}
+
+static void task_scheduler_benchmark(const char *id, double (*run)(TaskScheduler *), const int num_tasks)
+{
+	const int max_threads = max_ii(BLI_system_thread_count(), 2);
+
+	printf("\n========== %s (%d tasks) ==========\n", id, num_tasks);
+	printf("Threads    Global queue (tasks/s)    Work stealing (tasks/s)    Speedup\n");
+
+	for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+		double throughput[2];
+
+		for (int use_work_stealing = 0; use_work_stealing < 2; use_work_stealing++) {
+			TaskScheduler *scheduler = BLI_task_scheduler_create_ex(num_threads, use_work_stealing != 0);
+			/* Best of several runs, to filter out noise. */
+			double best_time = run(scheduler);
+			for (int i = 0; i < 4; i++) {
+				const double time = run(scheduler);
+				if (time < best_time) {
+					best_time = time;
+				}
+			}
+			throughput[use_work_stealing] = (double)num_tasks / best_time;
+			BLI_task_scheduler_free(scheduler);
+		}
+
+		printf("%-10d %-25.0f %-26.0f %.2fx\n",
+		       num_threads, throughput[0], throughput[1], throughput[1] / throughput[0]);
+	}
+}
+
+TEST(task, SchedulerSpawnPerformance)
+{
+	BLI_threadapi_init();
+	task_scheduler_benchmark("Spawn from workers", task_spawn_run, (1 << (SPAWN_DEPTH + 1)) - 1);
+}
+
+TEST(task, SchedulerFlatPerformance)
+{
+	BLI_threadapi_init();
+	task_scheduler_benchmark("Push from main thread", task_flat_run, FLAT_NUM_TASKS);
+}
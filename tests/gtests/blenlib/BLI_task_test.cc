@@ -74,3 +74,52 @@ TEST(task, MempoolIter)
 
 	BLI_mempool_destroy(mempool);
 }
+
+/* *** Task pool with spawning tasks *** */
+
+#define SPAWN_DEPTH 12
+
+static void task_spawn_func(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+	int *count = (int *)BLI_task_pool_userdata(pool);
+
+	atomic_add_and_fetch_uint32((uint32_t *)count, 1);
+
+	if (depth > 0) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_spawn_func, SET_INT_IN_POINTER(depth - 1),
+			                               false, TASK_PRIORITY_LOW, threadid);
+		}
+	}
+}
+
+static void task_pool_spawn_test(const bool use_work_stealing)
+{
+	for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create_ex(num_threads, use_work_stealing);
+		int count = 0;
+		TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+
+		BLI_task_pool_push(pool, task_spawn_func, SET_INT_IN_POINTER(SPAWN_DEPTH), false, TASK_PRIORITY_LOW);
+		BLI_task_pool_work_and_wait(pool);
+
+		/* Every task of the full binary tree must have been run exactly once. */
+		EXPECT_EQ(count, (1 << (SPAWN_DEPTH + 1)) - 1);
+
+		BLI_task_pool_free(pool);
+		BLI_task_scheduler_free(scheduler);
+	}
+}
+
+TEST(task, PoolSpawn)
+{
+	BLI_threadapi_init();
+	task_pool_spawn_test(false);
+}
+
+TEST(task, PoolSpawnWorkStealing)
+{
+	BLI_threadapi_init();
+	task_pool_spawn_test(true);
+}
@@ -0,0 +1,86 @@
+# Apache License, Version 2.0
+
+# Tests for loading .blend files, uncompressed files are memory mapped and
+# their blocks are read straight from the mapping.
+#
+# ./blender.bin --background -noaudio --factory-startup \
+#     --python tests/python/bl_blendfile_load.py -- --verbose
+
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+import bpy
+
+
+def scene_data():
+    scene = bpy.context.scene
+    return (
+        sorted(ob.name for ob in scene.objects),
+        [tuple(v.co) for v in bpy.data.meshes["Cube"].vertices],
+        tuple(bpy.data.objects["Cube"].location),
+        scene.frame_end,
+    )
+
+
+class BlendfileLoadTest(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+
+        scene = bpy.context.scene
+        scene.frame_end = 123
+        ob = bpy.data.objects["Cube"]
+        ob.location = (1.0, 2.0, 3.0)
+        ob.data.vertices[0].co = (-2.0, -2.0, -2.0)
+        self.expected = scene_data()
+
+        self.tempdir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+        shutil.rmtree(self.tempdir)
+
+    def save(self, name, compress):
+        filepath = os.path.join(self.tempdir, name)
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=compress, copy=True)
+
+        with open(filepath, 'rb') as f:
+            magic = f.read(7)
+        if compress:
+            self.assertEqual(magic[:2], b"\x1f\x8b")
+        else:
+            self.assertEqual(magic, b"BLENDER")
+        return filepath
+
+    def test_uncompressed(self):
+        filepath = self.save("uncompressed.blend", compress=False)
+        bpy.ops.wm.read_factory_settings()
+
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        self.assertEqual(scene_data(), self.expected)
+
+    def test_compressed(self):
+        filepath = self.save("compressed.blend", compress=True)
+        bpy.ops.wm.read_factory_settings()
+
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        self.assertEqual(scene_data(), self.expected)
+
+    def test_uncompressed_library(self):
+        filepath = self.save("library.blend", compress=False)
+        bpy.ops.wm.read_factory_settings()
+
+        with bpy.data.libraries.load(filepath) as (data_from, data_to):
+            self.assertIn("Cube", data_from.meshes)
+            data_to.meshes = ["Cube"]
+
+        me = data_to.meshes[0]
+        self.assertEqual([tuple(v.co) for v in me.vertices], self.expected[1])
+
+
+if __name__ == "__main__":
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,253 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Times the evaluation of deform modifiers and shape keys on a dense mesh,
+# to compare the performance of the deform kernels between builds.
+#
+# The number of threads can be set with -t, the mesh size with --size:
+#
+# ./blender.bin --background --factory-startup -t 1 \
+#     --python tests/python/bl_deform_modifiers_performance.py -- --size 1000
+#
+# With --baseline the timings are written to a file on the first run, later
+# runs fail when a deform got slower than the timing in the file.
+#
+
+import json
+import os
+import sys
+import time
+
+import bpy
+
+# -----------------------------------------------------------------------------
+# utility functions
+
+
+def parse_args():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser(description="Benchmark deform modifiers")
+    parser.add_argument("--size", type=int, default=1000,
+                        help="Number of vertices along each side of the grid")
+    parser.add_argument("--repeat", type=int, default=5,
+                        help="Number of evaluations, the fastest one is reported")
+    parser.add_argument("--baseline", default="",
+                        help="File with the timings to compare with, written when it doesn't exist")
+    parser.add_argument("--tolerance", type=float, default=1.5,
+                        help="Factor a deform may be slower than its baseline timing")
+    return parser.parse_args(argv)
+
+
+def scene_clear(scene):
+    for ob in list(scene.objects):
+        scene.objects.unlink(ob)
+        bpy.data.objects.remove(ob)
+
+
+def grid_add(scene, size):
+    bpy.ops.mesh.primitive_grid_add(x_subdivisions=size, y_subdivisions=size, radius=1.0)
+    ob = scene.objects.active
+    vgroup = ob.vertex_groups.new(name="Group")
+    vgroup.add(list(range(len(ob.data.vertices))), 0.75, 'REPLACE')
+    return ob
+
+
+def evaluate_time(scene, ob, repeat):
+    best = None
+    for _ in range(repeat):
+        time_start = time.time()
+        me = ob.to_mesh(scene, True, 'PREVIEW')
+        time_end = time.time()
+        bpy.data.meshes.remove(me)
+        best = time_end - time_start if best is None else min(best, time_end - time_start)
+    return best
+
+
+# -----------------------------------------------------------------------------
+# deform setups, each one gets a fresh grid object
+
+
+def setup_lattice(scene, ob):
+    bpy.ops.object.add(type='LATTICE')
+    lattice = scene.objects.active
+    lattice.scale = (1.5, 1.5, 1.5)
+    lattice.data.points_u = lattice.data.points_v = lattice.data.points_w = 4
+    lattice.data.points[0].co_deform.z = 1.0
+    mod = ob.modifiers.new("Lattice", 'LATTICE')
+    mod.object = lattice
+
+
+def setup_lattice_vgroup(scene, ob):
+    setup_lattice(scene, ob)
+    ob.modifiers["Lattice"].vertex_group = "Group"
+
+
+def setup_curve(scene, ob):
+    bpy.ops.curve.primitive_bezier_circle_add(radius=2.0)
+    curve = scene.objects.active
+    mod = ob.modifiers.new("Curve", 'CURVE')
+    mod.object = curve
+
+
+def setup_shape_keys_relative(scene, ob):
+    ob.shape_key_add(name="Basis")
+    for i in range(8):
+        key = ob.shape_key_add(name="Key%d" % i)
+        for point in key.data[::7]:
+            point.co.z += 0.1
+        key.value = 0.5
+        key.vertex_group = "Group" if i % 2 else ""
+
+
+def setup_shape_keys_absolute(scene, ob):
+    setup_shape_keys_relative(scene, ob)
+    key = ob.data.shape_keys
+    key.use_relative = False
+    key.eval_time = 25.0
+
+
+def setup_cast(scene, ob):
+    mod = ob.modifiers.new("Cast", 'CAST')
+    mod.cast_type = 'SPHERE'
+    mod.factor = 0.5
+
+
+def setup_cast_cuboid(scene, ob):
+    mod = ob.modifiers.new("Cast", 'CAST')
+    mod.cast_type = 'CUBOID'
+    mod.factor = 0.5
+    mod.vertex_group = "Group"
+
+
+def setup_wave(scene, ob):
+    mod = ob.modifiers.new("Wave", 'WAVE')
+    mod.use_normal = True
+    mod.falloff_radius = 1.0
+
+
+def setup_simple_deform(scene, ob):
+    mod = ob.modifiers.new("SimpleDeform", 'SIMPLE_DEFORM')
+    mod.deform_method = 'TWIST'
+    mod.vertex_group = "Group"
+
+
+def setup_hook(scene, ob):
+    bpy.ops.object.add(type='EMPTY')
+    empty = scene.objects.active
+    empty.location = (0.0, 0.0, 0.5)
+    mod = ob.modifiers.new("Hook", 'HOOK')
+    mod.object = empty
+    mod.vertex_group = "Group"
+    mod.falloff_type = 'SMOOTH'
+    mod.falloff_radius = 1.0
+
+
+def setup_warp(scene, ob):
+    bpy.ops.object.add(type='EMPTY')
+    empty_from = scene.objects.active
+    bpy.ops.object.add(type='EMPTY')
+    empty_to = scene.objects.active
+    empty_to.location = (0.0, 0.0, 0.5)
+    mod = ob.modifiers.new("Warp", 'WARP')
+    mod.object_from = empty_from
+    mod.object_to = empty_to
+    mod.falloff_type = 'SMOOTH'
+    mod.falloff_radius = 1.0
+
+
+def setup_smooth(scene, ob):
+    mod = ob.modifiers.new("Smooth", 'SMOOTH')
+    mod.iterations = 4
+
+
+SETUPS = (
+    ("Lattice", setup_lattice),
+    ("Lattice (vertex group)", setup_lattice_vgroup),
+    ("Curve", setup_curve),
+    ("Shape Keys (relative)", setup_shape_keys_relative),
+    ("Shape Keys (absolute)", setup_shape_keys_absolute),
+    ("Cast (sphere)", setup_cast),
+    ("Cast (cuboid)", setup_cast_cuboid),
+    ("Wave", setup_wave),
+    ("Simple Deform", setup_simple_deform),
+    ("Hook", setup_hook),
+    ("Warp", setup_warp),
+    ("Smooth", setup_smooth),
+)
+
+
+def baseline_compare(timings, baseline, tolerance):
+    # ignore differences below a millisecond, they are noise for fast deforms
+    slower = []
+    for name, deform_time in sorted(timings.items()):
+        baseline_time = baseline.get(name)
+        if baseline_time is not None and deform_time > baseline_time * tolerance + 1.0:
+            slower.append(name)
+            print("%s is slower than its baseline: %.2f ms, was %.2f ms" % (name, deform_time, baseline_time))
+    return slower
+
+
+def main():
+    args = parse_args()
+    scene = bpy.context.scene
+    timings = {}
+
+    scene_clear(scene)
+    ob = grid_add(scene, args.size)
+    num_verts = len(ob.data.vertices)
+    # time of converting the mesh without any deformation
+    base_time = evaluate_time(scene, ob, args.repeat)
+
+    print("Vertices: %d, threads: %d" % (num_verts, scene.render.threads))
+    print("%-24s %10s" % ("Deform", "Time (ms)"))
+
+    for name, setup in SETUPS:
+        scene_clear(scene)
+        ob = grid_add(scene, args.size)
+        setup(scene, ob)
+        scene.objects.active = ob
+        scene.update()
+
+        deform_time = max(evaluate_time(scene, ob, args.repeat) - base_time, 0.0) * 1000.0
+        timings[name] = deform_time
+        print("%-24s %10.2f" % (name, deform_time))
+
+    if not args.baseline:
+        return
+
+    if not os.path.exists(args.baseline):
+        with open(args.baseline, 'w') as f:
+            json.dump({"size": args.size, "timings": timings}, f, indent=1, sort_keys=True)
+        print("Written baseline timings to %r" % args.baseline)
+        return
+
+    with open(args.baseline, 'r') as f:
+        baseline = json.load(f)
+    if baseline["size"] != args.size:
+        print("Baseline timings are for a grid of size %d, not %d" % (baseline["size"], args.size))
+        sys.exit(1)
+    if baseline_compare(timings, baseline["timings"], args.tolerance):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
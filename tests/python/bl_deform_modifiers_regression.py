@@ -0,0 +1,390 @@
+# Apache License, Version 2.0
+
+# Tests for the threaded deform modifiers and shape keys, with and without a
+# vertex group:
+# - a grid large enough to be deformed in threads must match a mesh with only
+#   some of its vertices, few enough to be deformed in a single thread.
+# - simple deforms must match the same deform written in Python.
+#
+# ./blender.bin --background -noaudio --factory-startup \
+#     --python tests/python/bl_deform_modifiers_regression.py -- --verbose
+
+import sys
+import unittest
+
+import bpy
+from mathutils import Vector
+
+# 1089 vertices, more than deform kernels need to use threads
+GRID_SIZE = 33
+GRID_STEP = 2.0 / (GRID_SIZE - 1)
+PLACES = 4
+
+# -----------------------------------------------------------------------------
+# utility functions
+
+
+def scene_clear(scene):
+    for ob in list(scene.objects):
+        scene.objects.unlink(ob)
+        bpy.data.objects.remove(ob)
+
+
+def grid_index(co):
+    return int(round((co[1] + 1.0) / GRID_STEP)) * GRID_SIZE + int(round((co[0] + 1.0) / GRID_STEP))
+
+
+def grid_faces():
+    return [(y * GRID_SIZE + x, y * GRID_SIZE + x + 1, (y + 1) * GRID_SIZE + x + 1, (y + 1) * GRID_SIZE + x)
+            for y in range(GRID_SIZE - 1) for x in range(GRID_SIZE - 1)]
+
+
+def grid_subset():
+    # the border, which bounds the grid for deforms depending on its size, and a third of the inner vertices
+    return [y * GRID_SIZE + x
+            for y in range(GRID_SIZE) for x in range(GRID_SIZE)
+            if x in {0, GRID_SIZE - 1} or y in {0, GRID_SIZE - 1} or (y * GRID_SIZE + x) % 3 == 0]
+
+
+def grid_coords(indices):
+    # a saddle, its bounds are on the border of the grid
+    coords = []
+    for i in indices:
+        x = -1.0 + (i % GRID_SIZE) * GRID_STEP
+        y = -1.0 + (i // GRID_SIZE) * GRID_STEP
+        coords.append(Vector((x, y, 0.25 * x * y)))
+    return coords
+
+
+def vgroup_weight(index):
+    # varying weights, some vertices are not in the group at all
+    return None if index % 7 == 0 else (index % 5) / 4.0
+
+
+def grid_add(scene, indices=None, use_vgroup=True):
+    # the whole grid with faces, or some of its vertices only
+    if indices is None:
+        indices = range(GRID_SIZE * GRID_SIZE)
+        faces = grid_faces()
+    else:
+        faces = []
+
+    me = bpy.data.meshes.new("Grid")
+    me.from_pydata(grid_coords(indices), [], faces)
+    me.update(calc_edges=True)
+    ob = bpy.data.objects.new("Grid", me)
+    scene.objects.link(ob)
+    scene.objects.active = ob
+
+    if use_vgroup:
+        vgroup = ob.vertex_groups.new(name="Group")
+        for v, index in zip(me.vertices, indices):
+            weight = vgroup_weight(index)
+            if weight is not None:
+                vgroup.add([v.index], weight, 'REPLACE')
+    return ob
+
+
+def evaluated_coords(scene, ob):
+    me = ob.to_mesh(scene, True, 'PREVIEW')
+    coords = [v.co.copy() for v in me.vertices]
+    bpy.data.meshes.remove(me)
+    return coords
+
+
+# -----------------------------------------------------------------------------
+# deform setups, each one gets a fresh grid object and the vertex group to use
+
+
+def setup_lattice(scene, ob, vgroup):
+    bpy.ops.object.add(type='LATTICE')
+    lattice = scene.objects.active
+    lattice.scale = (1.5, 1.5, 1.5)
+    lattice.data.points_u = lattice.data.points_v = lattice.data.points_w = 4
+    lattice.data.points[0].co_deform.z = 1.0
+    lattice.data.points[21].co_deform.x += 0.5
+    mod = ob.modifiers.new("Lattice", 'LATTICE')
+    mod.object = lattice
+    mod.vertex_group = vgroup
+
+
+def setup_curve(scene, ob, vgroup):
+    bpy.ops.curve.primitive_bezier_circle_add(radius=2.0)
+    curve = scene.objects.active
+    mod = ob.modifiers.new("Curve", 'CURVE')
+    mod.object = curve
+    mod.vertex_group = vgroup
+
+
+def setup_shape_keys_relative(scene, ob, vgroup):
+    ob.shape_key_add(name="Basis")
+    for i in range(4):
+        key = ob.shape_key_add(name="Key%d" % i)
+        for point in key.data:
+            if grid_index(point.co) % 5 == i:
+                point.co.z += 0.1 * (i + 1)
+        key.value = 0.5
+        key.vertex_group = vgroup if i % 2 else ""
+
+
+def setup_shape_keys_absolute(scene, ob, vgroup):
+    setup_shape_keys_relative(scene, ob, vgroup)
+    key = ob.data.shape_keys
+    key.use_relative = False
+    key.eval_time = 25.0
+
+
+def setup_cast(scene, ob, vgroup):
+    mod = ob.modifiers.new("Cast", 'CAST')
+    mod.cast_type = 'SPHERE'
+    mod.factor = 0.5
+    # without a size it's the average distance of all vertices
+    mod.size = 0.8
+    mod.vertex_group = vgroup
+
+
+def setup_cast_cuboid(scene, ob, vgroup):
+    mod = ob.modifiers.new("Cast", 'CAST')
+    mod.cast_type = 'CUBOID'
+    mod.factor = 0.5
+    mod.radius = 0.75
+    mod.vertex_group = vgroup
+
+
+def setup_wave(scene, ob, vgroup):
+    # the vertices of the subset have no faces to get normals from
+    mod = ob.modifiers.new("Wave", 'WAVE')
+    mod.falloff_radius = 1.0
+    mod.time_offset = -5.0
+    mod.vertex_group = vgroup
+
+
+def setup_simple_deform(scene, ob, vgroup):
+    mod = ob.modifiers.new("SimpleDeform", 'SIMPLE_DEFORM')
+    mod.deform_method = 'TWIST'
+    mod.vertex_group = vgroup
+
+
+def setup_simple_deform_bend(scene, ob, vgroup):
+    mod = ob.modifiers.new("SimpleDeform", 'SIMPLE_DEFORM')
+    mod.deform_method = 'BEND'
+    mod.vertex_group = vgroup
+
+
+def setup_hook(scene, ob, vgroup):
+    bpy.ops.object.add(type='EMPTY')
+    empty = scene.objects.active
+    empty.location = (0.0, 0.0, 0.5)
+    mod = ob.modifiers.new("Hook", 'HOOK')
+    mod.object = empty
+    mod.vertex_group = vgroup
+    mod.falloff_type = 'SMOOTH'
+    mod.falloff_radius = 1.0
+
+
+def setup_warp(scene, ob, vgroup):
+    bpy.ops.object.add(type='EMPTY')
+    empty_from = scene.objects.active
+    bpy.ops.object.add(type='EMPTY')
+    empty_to = scene.objects.active
+    empty_to.location = (0.0, 0.0, 0.5)
+    mod = ob.modifiers.new("Warp", 'WARP')
+    mod.object_from = empty_from
+    mod.object_to = empty_to
+    mod.falloff_type = 'SMOOTH'
+    mod.falloff_radius = 1.0
+    mod.vertex_group = vgroup
+
+
+SETUPS = (
+    ("Lattice", setup_lattice),
+    ("Curve", setup_curve),
+    ("ShapeKeysRelative", setup_shape_keys_relative),
+    ("ShapeKeysAbsolute", setup_shape_keys_absolute),
+    ("CastSphere", setup_cast),
+    ("CastCuboid", setup_cast_cuboid),
+    ("Wave", setup_wave),
+    ("SimpleDeformTwist", setup_simple_deform),
+    ("SimpleDeformBend", setup_simple_deform_bend),
+    ("Hook", setup_hook),
+    ("Warp", setup_warp),
+)
+
+
+# -----------------------------------------------------------------------------
+# deforms written in Python
+
+
+def shape_keys_relative_reference(ob):
+    key_blocks = ob.data.shape_keys.key_blocks
+    coords = [point.co.copy() for point in key_blocks[0].data]
+
+    for key in key_blocks[1:]:
+        for i, (point, point_ref) in enumerate(zip(key.data, key.relative_key.data)):
+            weight = key.value
+            if key.vertex_group:
+                weight *= vgroup_weight(i) or 0.0
+            coords[i] += (point.co - point_ref.co) * weight
+    return coords
+
+
+def smooth_reference(ob, factor, repeat, use_vgroup):
+    # the edges add their centers to their vertices, the sums are never cleared
+    coords = [v.co.copy() for v in ob.data.vertices]
+    edges = [tuple(e.vertices) for e in ob.data.edges]
+    sums = [Vector() for co in coords]
+    counts = [0] * len(coords)
+
+    for _ in range(repeat):
+        for edge in edges:
+            center = (coords[edge[0]] + coords[edge[1]]) * 0.5
+            for i in edge:
+                if counts[i] < 255:
+                    counts[i] += 1
+                    sums[i] += center
+
+        for i, co in enumerate(coords):
+            fac = factor
+            if use_vgroup:
+                fac *= vgroup_weight(i) or 0.0
+                if fac <= 0.0:
+                    continue
+            if counts[i]:
+                coords[i] = co * (1.0 - fac) + sums[i] * (fac / counts[i])
+            else:
+                coords[i] = co * (1.0 - fac)
+    return coords
+
+
+class DeformModifiersRegressionTest(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+        self.scene = bpy.context.scene
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+
+    def assertCoordsEqual(self, coords_a, coords_b, msg):
+        self.assertEqual(len(coords_a), len(coords_b), msg)
+        for i, (co_a, co_b) in enumerate(zip(coords_a, coords_b)):
+            for a, b in zip(co_a, co_b):
+                self.assertAlmostEqual(a, b, places=PLACES, msg="%s, vertex %d" % (msg, i))
+
+    def evaluate(self, setup, vgroup, indices=None):
+        scene_clear(self.scene)
+        ob = grid_add(self.scene, indices)
+        setup(self.scene, ob, vgroup)
+        self.scene.objects.active = ob
+        self.scene.update()
+        return ob, evaluated_coords(self.scene, ob)
+
+    def test_threaded(self):
+        # the deformed vertices don't depend on other vertices
+        indices = grid_subset()
+        self.assertLess(len(indices), 1000)
+        coords_rest = grid_coords(indices)
+
+        for name, setup in SETUPS:
+            for vgroup in ("", "Group"):
+                msg = name + vgroup
+                coords = self.evaluate(setup, vgroup)[1]
+                coords_subset = self.evaluate(setup, vgroup, indices)[1]
+                self.assertCoordsEqual(coords_subset, [coords[i] for i in indices], msg)
+                # without indices or a vertex group the hook deforms nothing
+                if vgroup or name != "Hook":
+                    self.assertNotEqual(coords_subset, coords_rest, msg)
+
+    def test_shape_keys_relative(self):
+        for vgroup in ("", "Group"):
+            ob, coords = self.evaluate(setup_shape_keys_relative, vgroup)
+            self.assertCoordsEqual(coords, shape_keys_relative_reference(ob), vgroup)
+
+    def test_smooth(self):
+        def setup_smooth(scene, ob, vgroup):
+            # smooth a bumpy grid, a flat one doesn't change
+            for v in ob.data.vertices:
+                v.co.z = 0.1 * ((v.index * 7) % 11)
+            mod = ob.modifiers.new("Smooth", 'SMOOTH')
+            mod.factor = 0.75
+            mod.iterations = 4
+            mod.vertex_group = vgroup
+
+        for vgroup in ("", "Group"):
+            ob, coords = self.evaluate(setup_smooth, vgroup)
+            reference = smooth_reference(ob, 0.75, 4, bool(vgroup))
+            self.assertCoordsEqual(coords, reference, vgroup)
+
+    def test_vgroup_without_weights(self):
+        # a vertex group name on a mesh without weights deforms nothing
+        for name, setup in (("Lattice", setup_lattice), ("Hook", setup_hook)):
+            scene_clear(self.scene)
+            ob = grid_add(self.scene, use_vgroup=False)
+            ob.vertex_groups.new(name="Group")
+            expected = evaluated_coords(self.scene, ob)
+            setup(self.scene, ob, "Group")
+            self.scene.objects.active = ob
+            self.scene.update()
+            self.assertCoordsEqual(evaluated_coords(self.scene, ob), expected, name)
+
+
+class HookIndicesTest(unittest.TestCase):
+    # Hooks to vertex indices, added in edit mode. Each vertex is listed once,
+    # duplicate indices only exist in old files.
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+        self.scene = bpy.context.scene
+        scene_clear(self.scene)
+        self.ob = grid_add(self.scene, use_vgroup=False)
+        self.hooked = {i for i in range(len(self.ob.data.vertices)) if i % 4 == 0}
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+
+    def hook_add(self):
+        for v in self.ob.data.vertices:
+            v.select = v.index in self.hooked
+        bpy.ops.object.mode_set(mode='EDIT')
+        bpy.ops.object.hook_add_newob()
+        bpy.ops.object.mode_set(mode='OBJECT')
+        self.scene.objects.active = self.ob
+        return self.ob.modifiers[0].object
+
+    def assertHookMoved(self, empty, expected):
+        self.scene.update()
+        coords_orig = evaluated_coords(self.scene, self.ob)
+
+        offset = Vector((0.25, -0.5, 1.0))
+        empty.location += offset
+        self.scene.update()
+        coords = evaluated_coords(self.scene, self.ob)
+
+        moved = set()
+        for i, (co, co_orig) in enumerate(zip(coords, coords_orig)):
+            if (co - co_orig).length > 1e-5:
+                moved.add(i)
+                for a, b in zip(co - co_orig, offset):
+                    self.assertAlmostEqual(a, b, places=5)
+        self.assertEqual(moved, expected)
+
+    def test_indices(self):
+        empty = self.hook_add()
+        self.assertHookMoved(empty, self.hooked)
+
+    def test_original_indices(self):
+        # behind a mirror the hook looks the vertices up by their original index
+        empty = self.hook_add()
+        mod = self.ob.modifiers.new("Mirror", 'MIRROR')
+        mod.use_mirror_merge = False
+        bpy.ops.object.modifier_move_up(modifier="Mirror")
+        self.assertEqual([mod.type for mod in self.ob.modifiers], ['MIRROR', 'HOOK'])
+
+        # the mirrored copies follow the original vertices
+        totvert = len(self.ob.data.vertices)
+        self.assertHookMoved(empty, self.hooked | {i + totvert for i in self.hooked})
+
+
+if __name__ == "__main__":
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,146 @@
+# Apache License, Version 2.0
+
+# Tests for the incremental update of dependency graph relations: the graph
+# updated for the tagged objects must match a graph built from scratch.
+#
+# ./blender.bin --background -noaudio --factory-startup --enable-new-depsgraph \
+#     --python tests/python/bl_depsgraph_incremental_relations.py -- --verbose
+
+import sys
+import unittest
+
+import bpy
+
+
+def object_add(scene, name, data):
+    ob = bpy.data.objects.new(name, data)
+    scene.objects.link(ob)
+    return ob
+
+
+class DepsgraphIncrementalRelationsTest(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+
+        scene = bpy.context.scene
+        self.scene = scene
+        self.cube = bpy.data.objects["Cube"]
+        self.lattice = object_add(scene, "Lattice", bpy.data.lattices.new("Lattice"))
+        self.empty = object_add(scene, "Empty", None)
+        self.empty_other = object_add(scene, "EmptyOther", None)
+        self.armature = object_add(scene, "Armature", bpy.data.armatures.new("Armature"))
+        self.curve = object_add(scene, "Curve", bpy.data.curves.new("Curve", 'CURVE'))
+        # objects sharing the mesh of the cube
+        self.instance = object_add(scene, "Instance", self.cube.data)
+        self.plane = object_add(scene, "Plane", bpy.data.meshes.new("Plane"))
+
+        # start from an up to date graph
+        scene.update()
+        self.depsgraph = scene.depsgraph
+        if self.depsgraph is None:
+            self.skipTest("new dependency graph is not enabled")
+        self.assertTrue(self.depsgraph.debug_relations_update())
+        self.assertTrue(self.depsgraph.debug_relations_validate())
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+
+    def assertIncremental(self):
+        self.assertTrue(self.depsgraph.debug_relations_update())
+        self.assertTrue(self.depsgraph.debug_relations_validate())
+
+    def assertFullRebuild(self):
+        self.assertFalse(self.depsgraph.debug_relations_update())
+        self.assertTrue(self.depsgraph.debug_relations_validate())
+
+    def test_modifier_add(self):
+        mod = self.cube.modifiers.new("Lattice", 'LATTICE')
+        self.assertIncremental()
+        mod.object = self.lattice
+        self.assertIncremental()
+
+    def test_modifier_object_change(self):
+        mod = self.cube.modifiers.new("Hook", 'HOOK')
+        mod.object = self.empty
+        self.assertIncremental()
+        mod.object = self.empty_other
+        self.assertIncremental()
+        mod.object = None
+        self.assertIncremental()
+
+    def test_modifier_remove(self):
+        mod = self.cube.modifiers.new("Armature", 'ARMATURE')
+        mod.object = self.armature
+        self.assertIncremental()
+        self.cube.modifiers.remove(mod)
+        self.assertIncremental()
+
+    def test_modifier_chain(self):
+        # lattice deformed by a hook, the cube deformed by the lattice
+        mod = self.lattice.modifiers.new("Hook", 'HOOK')
+        mod.object = self.empty
+        self.assertIncremental()
+        mod = self.cube.modifiers.new("Lattice", 'LATTICE')
+        mod.object = self.lattice
+        self.assertIncremental()
+        mod = self.cube.modifiers.new("Curve", 'CURVE')
+        mod.object = self.curve
+        self.assertIncremental()
+
+    def test_modifier_shared_data(self):
+        mod = self.instance.modifiers.new("Hook", 'HOOK')
+        mod.object = self.empty
+        self.assertIncremental()
+        mod = self.cube.modifiers.new("Lattice", 'LATTICE')
+        mod.object = self.lattice
+        self.assertIncremental()
+
+    def test_constraint(self):
+        con = self.cube.constraints.new('COPY_LOCATION')
+        con.target = self.empty
+        self.assertIncremental()
+        con.target = self.plane
+        self.assertIncremental()
+        self.cube.constraints.remove(con)
+        self.assertIncremental()
+
+    def test_parent(self):
+        self.plane.parent = self.empty
+        self.depsgraph.debug_relations_update()
+        self.assertTrue(self.depsgraph.debug_relations_validate())
+        mod = self.plane.modifiers.new("Lattice", 'LATTICE')
+        mod.object = self.lattice
+        self.assertIncremental()
+
+    def test_collision(self):
+        # collision objects are looked up in the whole scene
+        self.plane.modifiers.new("Collision", 'COLLISION')
+        self.assertFullRebuild()
+        mod = self.cube.modifiers.new("Hook", 'HOOK')
+        mod.object = self.empty
+        self.assertIncremental()
+        self.plane.modifiers.remove(self.plane.modifiers["Collision"])
+        self.assertFullRebuild()
+
+    def test_cloth(self):
+        self.cube.modifiers.new("Cloth", 'CLOTH')
+        self.assertFullRebuild()
+
+    def test_smoke(self):
+        mod = self.cube.modifiers.new("Smoke", 'SMOKE')
+        self.assertFullRebuild()
+        mod.smoke_type = 'DOMAIN'
+        self.depsgraph.debug_relations_update()
+        self.assertTrue(self.depsgraph.debug_relations_validate())
+        self.plane.modifiers.new("Smoke", 'SMOKE').smoke_type = 'FLOW'
+        self.assertFullRebuild()
+
+    def test_dynamic_paint(self):
+        self.cube.modifiers.new("DynamicPaint", 'DYNAMIC_PAINT')
+        self.assertFullRebuild()
+
+
+if __name__ == "__main__":
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
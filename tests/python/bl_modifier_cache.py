@@ -0,0 +1,172 @@
+# Apache License, Version 2.0
+
+# Tests for the cache of intermediate results of the modifier stack: results
+# evaluated with the cache must match the ones evaluated without it, and the
+# cache must actually be used.
+#
+# ./blender.bin --background -noaudio --factory-startup \
+#     --python tests/python/bl_modifier_cache.py -- --verbose
+
+import sys
+import unittest
+
+import bmesh
+import bpy
+
+
+def evaluated_coords(scene, ob):
+    bm = bmesh.new()
+    bm.from_object(ob, scene)
+    coords = [tuple(v.co) for v in bm.verts]
+    bm.free()
+    return coords
+
+
+def reference_coords(scene, ob):
+    # converting to a mesh evaluates the stack without the cache
+    me = ob.to_mesh(scene, True, 'PREVIEW')
+    coords = [tuple(v.co) for v in me.vertices]
+    bpy.data.meshes.remove(me)
+    return coords
+
+
+def sphere_add(scene, name, location=(0.0, 0.0, 0.0)):
+    bpy.ops.mesh.primitive_uv_sphere_add(segments=32, ring_count=16, location=location)
+    ob = scene.objects.active
+    ob.name = name
+    # expensive enough to be cached, followed by a cheap modifier to tweak
+    mod = ob.modifiers.new("Subsurf", 'SUBSURF')
+    mod.levels = 3
+    mod = ob.modifiers.new("Cast", 'CAST')
+    mod.factor = 0.25
+    return ob
+
+
+class ModifierCacheTest(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+
+        self.system = bpy.context.user_preferences.system
+        self.system.modifier_cache_limit = 256
+
+        self.scene = bpy.context.scene
+        self.ob = sphere_add(self.scene, "Sphere")
+        self.scene.update()
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+
+    def evaluate(self, ob):
+        ob.update_tag(refresh={'DATA'})
+        self.scene.update()
+        return evaluated_coords(self.scene, ob)
+
+    def assertCoordsEqual(self, coords_a, coords_b):
+        self.assertEqual(len(coords_a), len(coords_b))
+        for co_a, co_b in zip(coords_a, coords_b):
+            for a, b in zip(co_a, co_b):
+                self.assertAlmostEqual(a, b, places=5)
+
+    def assertCachedEqual(self, ob=None):
+        ob = ob or self.ob
+        cached = self.evaluate(ob)
+        self.assertCoordsEqual(cached, reference_coords(self.scene, ob))
+
+    def assertCacheHit(self, ob=None, hit=True):
+        hits = self.system.modifier_cache_hits
+        self.assertCachedEqual(ob)
+        self.assertEqual(self.system.modifier_cache_hits > hits, hit)
+
+    def test_tweak(self):
+        self.evaluate(self.ob)
+        self.assertGreater(self.system.modifier_cache_memory, 0)
+        self.ob.modifiers["Cast"].factor = 0.75
+        self.assertCacheHit()
+
+    def test_disabled(self):
+        self.system.modifier_cache_limit = 0
+        self.evaluate(self.ob)
+        self.assertEqual(self.system.modifier_cache_memory, 0)
+        self.ob.modifiers["Cast"].factor = 0.75
+        self.assertCacheHit(hit=False)
+
+    def test_mesh_tag_update(self):
+        # only results depending on the tagged mesh are freed
+        other = sphere_add(self.scene, "Other", (3.0, 0.0, 0.0))
+        self.evaluate(self.ob)
+        self.evaluate(other)
+        memory = self.system.modifier_cache_memory
+
+        other.data.update()
+        self.assertLess(self.system.modifier_cache_memory, memory)
+        self.assertCacheHit(other, hit=False)
+        self.ob.modifiers["Cast"].factor = 0.75
+        self.assertCacheHit()
+
+    def test_tweak_cached_modifier(self):
+        self.evaluate(self.ob)
+        self.ob.modifiers["Subsurf"].levels = 2
+        self.assertCacheHit(hit=False)
+
+    def test_simplify(self):
+        # the subdivision level is limited by scene settings
+        self.evaluate(self.ob)
+        self.scene.render.use_simplify = True
+        self.scene.render.simplify_subdivision = 1
+        self.assertCachedEqual()
+        self.scene.render.use_simplify = False
+        self.assertCachedEqual()
+
+    def test_target_replaced(self):
+        # a freed object replaced by another one, possibly at the same address
+        empty = bpy.data.objects.new("Target", None)
+        self.scene.objects.link(empty)
+        # the hook goes in front of the cached subdivision
+        self.ob.modifiers.clear()
+        mod = self.ob.modifiers.new("Hook", 'HOOK')
+        mod.object = empty
+        mod.center = (0.0, 0.0, 1.0)
+        mod.falloff_type = 'SMOOTH'
+        mod.falloff_radius = 0.5
+        self.ob.modifiers.new("Subsurf", 'SUBSURF').levels = 3
+        self.ob.modifiers.new("Cast", 'CAST')
+        self.evaluate(self.ob)
+
+        self.scene.objects.unlink(empty)
+        bpy.data.objects.remove(empty)
+        empty = bpy.data.objects.new("Target", None)
+        empty.location = (0.0, 0.0, 0.5)
+        self.scene.objects.link(empty)
+        self.ob.modifiers["Hook"].object = empty
+        self.assertCachedEqual()
+
+    def test_mesh_replaced(self):
+        self.evaluate(self.ob)
+        me_old = self.ob.data
+        me = me_old.copy()
+        for v in me.vertices:
+            v.co *= 2.0
+        self.ob.data = me
+        bpy.data.meshes.remove(me_old)
+        me.name = "Sphere"
+        self.assertCachedEqual()
+
+    def test_shared_limit(self):
+        # results of all objects share the memory limit, evaluating more
+        # objects than fit frees results of the other objects
+        self.system.modifier_cache_limit = 8
+        obs = [self.ob] + [sphere_add(self.scene, "Sphere%d" % i, (i * 3.0, 0.0, 0.0)) for i in range(1, 6)]
+        for ob in obs:
+            self.evaluate(ob)
+        for ob in obs:
+            ob.modifiers["Cast"].factor = 0.5
+            self.assertCachedEqual(ob)
+        for ob in reversed(obs):
+            ob.modifiers["Cast"].factor = 0.75
+            self.assertCachedEqual(ob)
+
+
+if __name__ == "__main__":
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
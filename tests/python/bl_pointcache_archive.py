@@ -0,0 +1,147 @@
+# Apache License, Version 2.0
+
+# Tests for the single file disk cache of particles and other point caches.
+#
+# ./blender.bin --background -noaudio --factory-startup \
+#     --python tests/python/bl_pointcache_archive.py -- --verbose
+
+import os
+import shutil
+import sys
+import tempfile
+import unittest
+
+import bpy
+
+FRAMES = (1, 5, 12, 24)
+
+
+def particle_system():
+    return bpy.data.objects["Cube"].particle_systems[0]
+
+
+def particle_locations():
+    scene = bpy.context.scene
+    result = []
+    for frame in FRAMES:
+        scene.frame_set(frame)
+        result.append([tuple(p.location) for p in particle_system().particles if p.alive_state == 'ALIVE'])
+    return result
+
+
+def bake():
+    bpy.ops.ptcache.free_bake_all()
+    bpy.ops.ptcache.bake_all(bake=True)
+
+
+class PointCacheArchiveTest(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings()
+
+        scene = bpy.context.scene
+        scene.frame_start = 1
+        scene.frame_end = FRAMES[-1]
+
+        ob = bpy.data.objects["Cube"]
+        ob.modifiers.new("Particles", 'PARTICLE_SYSTEM')
+        settings = particle_system().settings
+        settings.count = 500
+        settings.frame_start = 1
+        settings.frame_end = 10
+        settings.lifetime = 100
+
+        self.tempdir = tempfile.mkdtemp()
+        self.filepath = os.path.join(self.tempdir, "pointcache.blend")
+        self.cachedir = os.path.join(self.tempdir, "blendcache_pointcache")
+        bpy.ops.wm.save_as_mainfile(filepath=self.filepath)
+
+    def tearDown(self):
+        bpy.ops.wm.read_factory_settings()
+        shutil.rmtree(self.tempdir)
+
+    def cache_files(self):
+        return sorted(os.listdir(self.cachedir)) if os.path.isdir(self.cachedir) else []
+
+    def use_archive(self, compression='NO', use_frame_delta=False):
+        point_cache = particle_system().point_cache
+        point_cache.use_disk_cache = True
+        point_cache.use_single_file = True
+        point_cache.compression = compression
+        point_cache.use_frame_delta = use_frame_delta
+
+    def assertLocationsEqual(self, locations_a, locations_b):
+        self.assertEqual(len(locations_a), len(locations_b))
+        for frame, points_a, points_b in zip(FRAMES, locations_a, locations_b):
+            self.assertEqual(len(points_a), len(points_b), "frame %d" % frame)
+            self.assertGreater(len(points_a), 0, "frame %d" % frame)
+            for co_a, co_b in zip(points_a, points_b):
+                for a, b in zip(co_a, co_b):
+                    self.assertAlmostEqual(a, b, places=5, msg="frame %d" % frame)
+
+    def bake_and_compare(self, compression='NO', use_frame_delta=False):
+        bake()
+        expected = particle_locations()
+
+        self.use_archive(compression, use_frame_delta)
+        bake()
+
+        # all frames go into one archive, there are no per frame files
+        files = self.cache_files()
+        self.assertEqual(len(files), 1, files)
+        self.assertTrue(files[0].endswith(".bphysarc"), files)
+
+        self.assertLocationsEqual(expected, particle_locations())
+        return expected
+
+    def test_uncompressed(self):
+        self.bake_and_compare()
+
+    def test_compressed(self):
+        self.bake_and_compare('LIGHT')
+
+    def test_compressed_frame_delta(self):
+        self.bake_and_compare('LIGHT', use_frame_delta=True)
+
+    def test_reload(self):
+        expected = self.bake_and_compare('LIGHT', use_frame_delta=True)
+
+        bpy.ops.wm.save_mainfile()
+        bpy.ops.wm.open_mainfile(filepath=self.filepath)
+
+        self.assertTrue(particle_system().point_cache.is_baked)
+        self.assertLocationsEqual(expected, particle_locations())
+
+    def test_replaced_file(self):
+        # an archive replaced by another one of the same size must be read again
+        expected = self.bake_and_compare()
+        filename = os.path.join(self.cachedir, self.cache_files()[0])
+        filename_copy = os.path.join(self.tempdir, "copy.bphysarc")
+        shutil.copyfile(filename, filename_copy)
+
+        particle_system().seed += 1
+        bake()
+        locations_other = particle_locations()
+        self.assertEqual(os.path.getsize(filename), os.path.getsize(filename_copy))
+
+        shutil.copyfile(filename_copy, filename)
+        self.assertLocationsEqual(expected, particle_locations())
+
+        self.assertNotEqual(expected, locations_other)
+
+    def test_free_bake(self):
+        self.use_archive()
+        bake()
+        expected = particle_locations()
+
+        # freeing the bake removes the archive
+        bpy.ops.ptcache.free_bake_all()
+        self.assertEqual(self.cache_files(), [])
+
+        bake()
+        self.assertLocationsEqual(expected, particle_locations())
+
+
+if __name__ == "__main__":
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()